@@ -25,6 +25,10 @@ uniform vec4 uniform_material_color;
 uniform sampler2D uniform_sampler_diffuse;
 uniform int uniform_has_sampler_diffuse;
 
+// the texture array the diffuse texture is packed in, and its layer (-1 if it is bound to uniform_sampler_diffuse)
+uniform sampler2DArray uniform_sampler_diffuse_array;
+uniform int uniform_layer_diffuse;
+
 // the ambient light color
 uniform vec4 uniform_ambient_light_color;
 
@@ -34,7 +38,10 @@ void main(void)
 	vec4 diffuse_tex = uniform_material_color;
 	if (uniform_has_sampler_diffuse > 0)
 	{
-		diffuse_tex = diffuse_tex * texture(uniform_sampler_diffuse, texcoord.xy);
+		if (uniform_layer_diffuse >= 0)
+			diffuse_tex = diffuse_tex * texture(uniform_sampler_diffuse_array, vec3(texcoord.xy, uniform_layer_diffuse));
+		else
+			diffuse_tex = diffuse_tex * texture(uniform_sampler_diffuse, texcoord.xy);
 		// alpha testing
 		if (diffuse_tex.a < 1.0) 
 		{
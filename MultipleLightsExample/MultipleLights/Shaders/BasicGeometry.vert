@@ -17,7 +17,7 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texcoord0;
 layout(location = 3) in vec2 texcoord1;
-layout(location = 4) in vec3 tangent;
+layout(location = 4) in vec4 tangent;   // w: handedness, the bitangent is cross(normal, tangent.xyz) * tangent.w
 
 uniform mat4 uniform_m;
 uniform mat4 uniform_v;
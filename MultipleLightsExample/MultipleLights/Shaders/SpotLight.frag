@@ -40,6 +40,10 @@ in vec2 texcoord;
 uniform sampler2D uniform_sampler_diffuse;
 uniform int uniform_has_sampler_diffuse;
 
+// the texture array the diffuse texture is packed in, and its layer (-1 if it is bound to uniform_sampler_diffuse)
+uniform sampler2DArray uniform_sampler_diffuse_array;
+uniform int uniform_layer_diffuse;
+
 void main(void)
 {
 	// get the diffuse for this fragment based on the interpolated uv coordinates
@@ -56,7 +60,10 @@ void main(void)
 	vec4 diffuse_tex = uniform_material_color;
 	if (uniform_has_sampler_diffuse > 0)
 	{
-		diffuse_tex = diffuse_tex * texture(uniform_sampler_diffuse, texcoord.xy);
+		if (uniform_layer_diffuse >= 0)
+			diffuse_tex = diffuse_tex * texture(uniform_sampler_diffuse_array, vec3(texcoord.xy, uniform_layer_diffuse));
+		else
+			diffuse_tex = diffuse_tex * texture(uniform_sampler_diffuse, texcoord.xy);
 		// alpha testing
 		// if the alpha value is below a threshold then skip drawing the pixel
 		// discard does just this, is similar to return in C++
@@ -13,11 +13,13 @@
 //                                                    //
 //----------------------------------------------------//
 
+// the layouts of the attributes are described in VertexFormat.h: when the vertices are compact, the normal is
+// octahedral in normal.xy, and the positions are moved to the bounds of the mesh by uniform_m
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texcoord0;
 layout(location = 3) in vec2 texcoord1;
-layout(location = 4) in vec3 tangent;
+layout(location = 4) in vec4 tangent;   // w: handedness, the bitangent is cross(normal, tangent.xyz) * tangent.w
 
 uniform mat4 uniform_m;
 uniform mat4 uniform_v;
@@ -25,6 +27,9 @@ uniform mat4 uniform_p;
 
 uniform mat4 uniform_normal_matrix_ecs;
 
+// whether the normals are octahedral
+uniform int uniform_compact_vertices;
+
 // the normal that is passed to the fragment shader
 out vec3 normal_ecs_v;
 
@@ -35,12 +40,23 @@ out vec3 position_ecs_v;
 // to the fragment shader
 out vec2 texcoord;
 
+// the same as decodeOctahedral in VertexFormat.cpp
+vec3 decodeOctahedral(vec2 p)
+{
+	vec3 v = vec3(p.xy, 1.0 - abs(p.x) - abs(p.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
 void main(void)
 {
+	vec3 n = (uniform_compact_vertices != 0) ? decodeOctahedral(normal.xy) : normal;
+
 // transform the vertex normal with the normal matrix
 // we can do this in the fragment shader but since this is a per-vertex evaluation
 // so we do it in the vertex shader to save instructions
-	normal_ecs_v = vec3(uniform_normal_matrix_ecs * vec4(normal, 0.0)).xyz;
+	normal_ecs_v = vec3(uniform_normal_matrix_ecs * vec4(n, 0.0)).xyz;
 
 // for shading from omni lights, we also need the current vertex in the fragment shader
 	position_ecs_v = vec3(uniform_v * uniform_m * vec4(position, 1.0)).xyz;
@@ -0,0 +1,971 @@
+//----------------------------------------------------//
+//                                                    //
+// File: Benchmark.cpp                                //
+// Headless benchmarks of the asset loaders, run with //
+// the -benchmark command line argument               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "HelpLib.h"        // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "Benchmark.h"      // - Header file for the benchmarks
+#include "ThreadPool.h"     // - Header file for the ThreadPool class
+#include "OBJ/OBJMaterial.h" // - Header file for the OBJMaterial class
+#include "OBJ/OBJLoader.h"  // - Header file for the OBJLoader class
+#include "OBJ/OGLMesh.h"    // - Header file for the OGLMesh class
+#include "OBJ/Texture.h"    // - Header file for the Texture class
+#include "OBJ/TGA.h"        // - Header file for the TGA class
+#include "OBJ/PixelConvert.h" // - Header file for the pixel format conversions
+#include "OBJ/MipChain.h"   // - Header file for the mipmap generation
+#include "OBJ/MipCache.h"   // - Header file for the MipCache class
+#include "OBJ/BlockCompress.h" // - Header file for the block compression
+#include "OBJ/OBJTokenizer.h" // - Header file for the .obj/.mtl tokenizer
+#include "OBJ/LoadStats.h"  // - Header file for the LoadStats class
+
+#include <chrono>           // - Header file for timing
+
+// defines /////////////////////////////////////////
+#define BENCHMARK_DEFAULT_TRIANGLES     10000000
+#define BENCHMARK_PATH                  "."
+#define BENCHMARK_OBJ_FILE              "benchmark_grid.obj"
+#define BENCHMARK_MTL_FILE              "benchmark_grid.mtl"
+#define BENCHMARK_ROWS_PER_GROUP        64
+#define BENCHMARK_LOADER_MAX_TRIANGLES  50000000
+#define BENCHMARK_LOADER_GROUPS         64
+#define BENCHMARK_LOADER_MATERIALS      8
+#define BENCHMARK_WRITE_BUFFER_SIZE     (4 * 1024 * 1024)
+#define BENCHMARK_PARSER_ITERATIONS     50
+#define BENCHMARK_TGA_RAW_FILE          "benchmark_raw.tga"
+#define BENCHMARK_TGA_RLE_FILE          "benchmark_rle.tga"
+#define BENCHMARK_TGA_SIZE              2048
+#define BENCHMARK_TGA_TILE              64
+#define BENCHMARK_TGA_ITERATIONS        10
+#define BENCHMARK_MIP_FILE              "benchmark_mip.tga"
+#define BENCHMARK_MIP_ITERATIONS        5
+#define BENCHMARK_BLOCK_ITERATIONS      3
+
+// the bundled assets used by the number parser benchmark
+static const char* s_data_files[][2] =
+{
+    { "..\\..\\Data\\Other",   "light_source.obj" },
+    { "..\\..\\Data\\Other",   "light_source.mtl" },
+    { "..\\..\\Data\\Other",   "plane_white.obj" },
+    { "..\\..\\Data\\Other",   "plane_white.mtl" },
+    { "..\\..\\Data\\Other",   "sphere_map.obj" },
+    { "..\\..\\Data\\Other",   "sphere_map.mtl" },
+    { "..\\..\\Data\\Other",   "sphere_earth.obj" },
+    { "..\\..\\Data\\Other",   "sphere_earth.mtl" },
+    { "..\\..\\Data\\Other",   "terrain.obj" },
+    { "..\\..\\Data\\Other",   "terrain.mtl" },
+    { "..\\..\\Data\\Pirates", "treasure.obj" },
+    { "..\\..\\Data\\Pirates", "treasure.mtl" },
+    { "..\\..\\Data\\Pirates", "skeleton.obj" },
+    { "..\\..\\Data\\Pirates", "skeleton.mtl" },
+};
+
+// the bundled textures used by the TGA benchmark
+static const char* s_texture_files[][2] =
+{
+    { "..\\..\\Data\\Other",   "terrain.tga" },
+    { "..\\..\\Data\\Other",   "earth.tga" },
+    { "..\\..\\Data\\Pirates", "chest.tga" },
+    { "..\\..\\Data\\Pirates", "treasure_map.tga" },
+};
+
+// the previous way of parsing numbers (strtof/strtol, which depend on the locale), used as a reference
+static const char* referenceParseFloat(const char* p, const char* end, flt& value)
+{
+    p = skipBlanks(p, end);
+    const char* e = tokenEnd(p, end);
+    char number[64];
+    size_t length = glm::min(size_t(e - p), sizeof(number) - 1);
+    memcpy(number, p, length);
+    number[length] = NULL_TERMINATED_CHAR;
+    value = strtof(number, NULL);
+    return e;
+}
+
+static const char* referenceParseFaceTuple(const char* p, const char* end, long& iv, long& it, long& in)
+{
+    p = skipBlanks(p, end);
+    const char* e = tokenEnd(p, end);
+    char tuple[64];
+    size_t length = glm::min(size_t(e - p), sizeof(tuple) - 1);
+    memcpy(tuple, p, length);
+    tuple[length] = NULL_TERMINATED_CHAR;
+    char* next;
+    it = in = 0;
+    iv = strtol(tuple, &next, 10);
+    if (*next == '/')
+    {
+        if (next[1] != '/')
+            it = strtol(next + 1, &next, 10);
+        else
+            ++next;
+        if (*next == '/')
+            in = strtol(next + 1, &next, 10);
+    }
+    return e;
+}
+
+// parse all the numbers of the vertex, face and material records of a file.
+// the parsed values are appended to floats and indices
+static void parseNumbers(const char* data, size_t size, bool use_reference, std::vector<flt>& floats, std::vector<long>& indices)
+{
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end)
+    {
+        p = skipBlanks(p, end);
+        const char* keyword = p;
+        const char* keyword_end = tokenEnd(p, end);
+        p = keyword_end;
+
+        int num_floats = 0;
+        if (tokenEquals(keyword, keyword_end, "v") || tokenEquals(keyword, keyword_end, "vn") ||
+            tokenEquals(keyword, keyword_end, "Kd") || tokenEquals(keyword, keyword_end, "Ks") || tokenEquals(keyword, keyword_end, "Ke"))
+            num_floats = 3;
+        else if (tokenEquals(keyword, keyword_end, "vt"))
+            num_floats = 2;
+        else if (tokenEquals(keyword, keyword_end, "Ns") || tokenEquals(keyword, keyword_end, "d"))
+            num_floats = 1;
+        else if (tokenEquals(keyword, keyword_end, "f"))
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                long iv, it, in;
+                p = use_reference ? referenceParseFaceTuple(p, end, iv, it, in) : parseFaceTuple(p, end, iv, it, in);
+                indices.push_back(iv);
+                indices.push_back(it);
+                indices.push_back(in);
+            }
+        }
+
+        for (int i = 0; i < num_floats; ++i)
+        {
+            flt value;
+            p = use_reference ? referenceParseFloat(p, end, value) : parseFloat(p, end, value);
+            floats.push_back(value);
+        }
+
+        p = skipLine(p, end);
+    }
+}
+
+void BenchmarkNumberParser(void)
+{
+    double reference_ms = 0, parser_ms = 0, total_mb = 0;
+    size_t total_floats = 0, total_indices = 0, mismatches = 0;
+    std::vector<flt> floats, reference_floats;
+    std::vector<long> indices, reference_indices;
+
+    for (size_t f = 0; f < sizeof(s_data_files) / sizeof(s_data_files[0]); ++f)
+    {
+        MappedFile file;
+        std::string filename = std::string(s_data_files[f][0]) + "\\" + s_data_files[f][1];
+        if (!mapFile(filename, file))
+        {
+            PrintToOutputWindow("%s not found in path %s", s_data_files[f][1], s_data_files[f][0]);
+            continue;
+        }
+
+        // timed runs of both parsers. The same vectors are reused, so only parsing is measured
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            std::vector<flt>& out_floats = (pass == 0) ? reference_floats : floats;
+            std::vector<long>& out_indices = (pass == 0) ? reference_indices : indices;
+            std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < BENCHMARK_PARSER_ITERATIONS; ++i)
+            {
+                out_floats.clear();
+                out_indices.clear();
+                parseNumbers(file.data, file.size, pass == 0, out_floats, out_indices);
+            }
+            double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+            if (pass == 0)
+                reference_ms += elapsed_ms;
+            else
+                parser_ms += elapsed_ms;
+        }
+
+        // the results must match the reference exactly (bitwise for floats)
+        size_t file_mismatches = 0;
+        if (floats.size() != reference_floats.size() || indices.size() != reference_indices.size())
+            file_mismatches = glm::max(floats.size(), reference_floats.size()) + glm::max(indices.size(), reference_indices.size());
+        else
+        {
+            for (size_t i = 0; i < floats.size(); ++i)
+                file_mismatches += memcmp(&floats[i], &reference_floats[i], sizeof(flt)) != 0;
+            for (size_t i = 0; i < indices.size(); ++i)
+                file_mismatches += indices[i] != reference_indices[i];
+        }
+
+        PrintToOutputWindow("Number parser: %-18s %8lu floats, %8lu indices, mismatches: %lu", s_data_files[f][1], (unsigned long)floats.size(), (unsigned long)indices.size(), (unsigned long)file_mismatches);
+        total_mb += BENCHMARK_PARSER_ITERATIONS * file.size / (1024.0 * 1024.0);
+        total_floats += floats.size();
+        total_indices += indices.size();
+        mismatches += file_mismatches;
+        unmapFile(file);
+    }
+
+    PrintToOutputWindow("Number parser: strtof/strtol: %.2f MB/s, new parser: %.2f MB/s, speedup: %.2fx (%lu floats, %lu indices, %lu mismatches)",
+        total_mb * 1000.0 / glm::max(reference_ms, 0.001), total_mb * 1000.0 / glm::max(parser_ms, 0.001), reference_ms / glm::max(parser_ms, 0.001),
+        (unsigned long)total_floats, (unsigned long)total_indices, (unsigned long)mismatches);
+}
+
+// write a square grid on the XZ plane, with positions, normals and texture coordinates.
+// returns the size of the file in bytes (0 on failure)
+// the materials of a generated mesh, without textures (mat_0 to mat_<num_materials - 1>)
+static bool writeGridMTL(const std::string& filename, unsigned long num_materials)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, filename.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    for (unsigned long m = 0; m < num_materials; ++m)
+    {
+        float t = (m + 0.5f) / num_materials;
+        fprintf(file, "newmtl mat_%lu\n", m);
+        fprintf(file, "Kd %.6f %.6f %.6f\n", t, 1.0f - t, 0.5f);
+        fprintf(file, "Ks 0.200000 0.200000 0.200000\n");
+        fprintf(file, "Ns %.6f\n", 8.0f + 100.0f * t);
+        fprintf(file, "d 1.000000\n\n");
+    }
+
+    fclose(file);
+    return true;
+}
+
+// a grid mesh of num_triangles triangles, split in num_groups groups of (about) the same number of triangles.
+// with num_materials > 0, the groups use the materials of mtl_filename in turn
+static unsigned long long writeGridOBJ(const std::string& filename, unsigned long num_triangles, unsigned long num_groups,
+                                       unsigned long num_materials = 0, const std::string& mtl_filename = "")
+{
+    FILE* file = nullptr;
+    fopen_s(&file, filename.c_str(), "wb");
+    if (file == nullptr)
+        return 0;
+    setvbuf(file, nullptr, _IOFBF, BENCHMARK_WRITE_BUFFER_SIZE);
+
+    unsigned long cells = (unsigned long)glm::ceil(glm::sqrt(num_triangles / 2.0));
+    cells = glm::max(cells, 1ul);
+    unsigned long row = cells + 1;
+    num_groups = glm::max(num_groups, 1ul);
+
+    fprintf(file, "# %lu x %lu grid\n", cells, cells);
+    if (num_materials > 0)
+        fprintf(file, "mtllib %s\n", mtl_filename.c_str());
+    for (unsigned long z = 0; z < row; ++z)
+        for (unsigned long x = 0; x < row; ++x)
+            fprintf(file, "v %.6f %.6f %.6f\n", x / float(cells) - 0.5f, 0.05f * glm::sin(x * 0.1f) * glm::cos(z * 0.1f), z / float(cells) - 0.5f);
+    for (unsigned long z = 0; z < row; ++z)
+        for (unsigned long x = 0; x < row; ++x)
+            fprintf(file, "vt %.6f %.6f\n", x / float(cells), z / float(cells));
+    fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+
+    // two triangles per cell. Group g starts at triangle g * num_triangles / num_groups
+    unsigned long written = 0;
+    unsigned long group = 0;
+    for (unsigned long z = 0; z < cells && written < num_triangles; ++z)
+    {
+        for (unsigned long x = 0; x < cells && written < num_triangles; ++x)
+        {
+            for (int t = 0; t < 2 && written < num_triangles; ++t, ++written)
+            {
+                if (group < num_groups && written >= (unsigned long long)group * num_triangles / num_groups)
+                {
+                    fprintf(file, "g group_%lu\n", group);
+                    if (num_materials > 0)
+                        fprintf(file, "usemtl mat_%lu\n", group % num_materials);
+                    ++group;
+                }
+                unsigned long i0 = z * row + x + 1, i1 = i0 + 1, i2 = i0 + row, i3 = i2 + 1;
+                if (t == 0)
+                    fprintf(file, "f %lu/%lu/1 %lu/%lu/1 %lu/%lu/1\n", i0, i0, i2, i2, i1, i1);
+                else
+                    fprintf(file, "f %lu/%lu/1 %lu/%lu/1 %lu/%lu/1\n", i1, i1, i2, i2, i3, i3);
+            }
+        }
+    }
+
+    // the files of the largest meshes are over 2 GB
+    unsigned long long size = (unsigned long long)_ftelli64(file);
+    fclose(file);
+    return size;
+}
+
+// FNV-1a hash of a range of bytes
+static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+// hash of all the groups and geometry streams of a mesh (used to check that all runs produce the same output)
+static unsigned long long hashMesh(const OBJMesh& mesh)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t e = 0; e < mesh.elements.size(); ++e)
+    {
+        const PrimitiveGroup& group = mesh.elements[e];
+        hash = (hash ^ (unsigned long long)group.material_index) * 1099511628211ull;
+        hash = (hash ^ (unsigned long long)group.first_primitive) * 1099511628211ull;
+        hash = (hash ^ (unsigned long long)group.num_primitives) * 1099511628211ull;
+    }
+    hash = hashBytes(hash, mesh.positions, mesh.num_positions * sizeof(glm::vec3));
+    hash = hashBytes(hash, mesh.normals, mesh.num_normals * sizeof(glm::vec3));
+    hash = hashBytes(hash, mesh.texcoords, mesh.num_texcoords * sizeof(glm::vec2));
+    hash = hashBytes(hash, mesh.faces, mesh.num_primitives * sizeof(OBJFace));
+    hash = hashBytes(hash, mesh.face_normals, mesh.num_primitives * sizeof(glm::vec3));
+    hash = hashBytes(hash, mesh.face_tangents, mesh.num_primitives * sizeof(glm::vec4));
+    hash = hashBytes(hash, mesh.face_smoothing, mesh.num_primitives * sizeof(unsigned int));
+    return hash;
+}
+
+static void deleteMesh(OBJMesh* mesh)
+{
+    for (size_t i = 0; i < mesh->materials.size(); ++i)
+        SAFE_DELETE(mesh->materials[i]);
+    delete mesh;
+}
+
+void BenchmarkOBJParser(unsigned long num_triangles)
+{
+    std::string filename = std::string(BENCHMARK_PATH) + "\\" + BENCHMARK_OBJ_FILE;
+    PrintToOutputWindow("Writing %s with %lu triangles...", BENCHMARK_OBJ_FILE, num_triangles);
+    // a new group every few rows to exercise the group merging
+    unsigned long rows = (unsigned long)glm::ceil(glm::sqrt(num_triangles / 2.0));
+    unsigned long long size = writeGridOBJ(filename, num_triangles, (rows + BENCHMARK_ROWS_PER_GROUP - 1) / BENCHMARK_ROWS_PER_GROUP);
+    if (size == 0)
+    {
+        PrintToOutputWindow("Could not write %s", filename.c_str());
+        return;
+    }
+    double size_mb = size / (1024.0 * 1024.0);
+
+    // 1 thread first (the reference), then doubling up to all the cores
+    unsigned int max_threads = ThreadPool::getInstance().getNumThreads();
+    std::vector<unsigned int> thread_counts;
+    for (unsigned int threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    double reference_ms = 0;
+    unsigned long long reference_hash = 0;
+    for (size_t i = 0; i < thread_counts.size(); ++i)
+    {
+        OBJLoader loader;
+        loader.setNumThreads(thread_counts[i]);
+
+        std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+        OBJMesh* mesh = loader.loadOBJ(BENCHMARK_OBJ_FILE, BENCHMARK_PATH);
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        if (mesh == nullptr)
+        {
+            PrintToOutputWindow("Benchmark mesh failed to load with %u threads", thread_counts[i]);
+            break;
+        }
+
+        unsigned long long hash = hashMesh(*mesh);
+        if (i == 0)
+        {
+            reference_ms = elapsed_ms;
+            reference_hash = hash;
+        }
+        PrintToOutputWindow("OBJ parser: %2u threads: %9.2f ms, %8.2f MB/s, speedup: %5.2fx, output %s", thread_counts[i], elapsed_ms, size_mb * 1000.0 / glm::max(elapsed_ms, 0.001), reference_ms / glm::max(elapsed_ms, 0.001), (hash == reference_hash) ? "identical" : "DIFFERENT");
+        deleteMesh(mesh);
+    }
+
+    remove(filename.c_str());
+}
+
+void BenchmarkStartup(void)
+{
+    std::vector<std::string> filenames, paths;
+    for (size_t f = 0; f < sizeof(s_data_files) / sizeof(s_data_files[0]); ++f)
+    {
+        std::string filename = s_data_files[f][1];
+        if (filename.substr(filename.size() - 4) != ".obj")
+            continue;
+        filenames.push_back(filename);
+        paths.push_back(s_data_files[f][0]);
+    }
+
+    // the mesh cache is not used, so that the parsers are measured
+    OBJLoader loader;
+    loader.setUseCache(false);
+
+    // one asset after another on the calling thread (the previous way of starting up)
+    std::vector<OGLMesh*> meshes;
+    std::vector<AssetTiming> timeline(filenames.size());
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    loader.setNumThreads(1);
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        AssetTiming& timing = timeline[i];
+        timing.filename = filenames[i];
+        timing.build_start = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        OGLMesh* mesh = loader.buildMesh(filenames[i], paths[i]);
+        timing.build_end = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        // decode the textures one at a time
+        if (mesh != nullptr)
+        {
+            for (size_t m = 0; m < mesh->materials.size(); ++m)
+            {
+                OBJMaterial& mat = *mesh->materials[m];
+                std::string* files[4] = { &mat.m_diffuse_opacity_tex_file, &mat.m_emission_tex_file, &mat.m_normal_tex_file, &mat.m_specular_gloss_tex_file };
+                for (int t = 0; t < 4; ++t)
+                {
+                    if (!files[t]->empty())
+                    {
+                        Texture texture(paths[i] + "\\" + *files[t], false);
+                    }
+                }
+            }
+        }
+        timing.decode_end = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        timing.upload_start = timing.upload_end = timing.decode_end;
+        timing.loaded = mesh != nullptr;
+        meshes.push_back(mesh);
+    }
+    double serial_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    PrintToOutputWindow("Startup, one asset at a time:");
+    OBJLoader::printTimeline(timeline, serial_ms);
+    for (size_t i = 0; i < meshes.size(); ++i)
+        SAFE_DELETE(meshes[i]);
+
+    // all the parses and texture decodes fanned out on the pool
+    loader.setNumThreads(0);
+    start_time = std::chrono::high_resolution_clock::now();
+    loader.buildMeshes(filenames, paths, false, meshes, timeline);
+    double parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    PrintToOutputWindow("Startup, in parallel:");
+    OBJLoader::printTimeline(timeline, parallel_ms);
+    for (size_t i = 0; i < meshes.size(); ++i)
+        SAFE_DELETE(meshes[i]);
+
+    PrintToOutputWindow("Startup speedup: %.2fx", serial_ms / glm::max(parallel_ms, 0.001));
+}
+
+void BenchmarkLoaderPhases(unsigned long max_triangles, unsigned long num_groups, unsigned long num_materials)
+{
+    static const unsigned long s_sizes[] = { 10000, 100000, 1000000, 10000000, 50000000 };
+    std::vector<unsigned long> sizes;
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]) && s_sizes[i] <= max_triangles; ++i)
+        sizes.push_back(s_sizes[i]);
+    if (sizes.empty() || sizes.back() < max_triangles)
+        sizes.push_back(max_triangles);
+
+    std::string filename = std::string(BENCHMARK_PATH) + "\\" + BENCHMARK_OBJ_FILE;
+    std::string mtl_filename = std::string(BENCHMARK_PATH) + "\\" + BENCHMARK_MTL_FILE;
+    if (num_materials > 0 && !writeGridMTL(mtl_filename, num_materials))
+    {
+        PrintToOutputWindow("Could not write %s", mtl_filename.c_str());
+        return;
+    }
+
+    for (size_t i = 0; i < sizes.size(); ++i)
+    {
+        PrintToOutputWindow("Writing %s with %lu triangles, %lu groups and %lu materials...", BENCHMARK_OBJ_FILE, sizes[i], num_groups, num_materials);
+        unsigned long long size = writeGridOBJ(filename, sizes[i], num_groups, num_materials, BENCHMARK_MTL_FILE);
+        if (size == 0)
+        {
+            PrintToOutputWindow("Could not write %s", filename.c_str());
+            break;
+        }
+
+        // the whole CPU side of a load: no mesh cache, no textures and no OpenGL calls
+        OBJLoader loader;
+        loader.setUseCache(false);
+        std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+        OGLMesh* mesh = loader.buildMesh(BENCHMARK_OBJ_FILE, BENCHMARK_PATH);
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        if (mesh == nullptr)
+        {
+            PrintToOutputWindow("Benchmark mesh failed to load with %lu triangles", sizes[i]);
+            break;
+        }
+
+        const LoadStats& stats = mesh->getLoadStats();
+        double triangles = (double)mesh->getNumPrimitives();
+        PrintToOutputWindow("Loader phases, %lu triangles (%.2f MB): %.2f ms, %.0f triangles/s", sizes[i], size / (1024.0 * 1024.0), elapsed_ms, triangles * 1000.0 / glm::max(elapsed_ms, 0.001));
+        for (int p = 0; p < LOAD_PHASE_COUNT; ++p)
+        {
+            const PhaseStats& phase = stats.getPhase(LoadPhase(p));
+            if (phase.calls == 0)
+                continue;
+            double seconds = glm::max(phase.ms, 0.001) / 1000.0;
+            PrintToOutputWindow("  %-14s %10.2f ms %5.1f%% %10.2f MB/s %14.0f triangles/s", LoadStats::getPhaseName(LoadPhase(p)), phase.ms,
+                100.0 * phase.ms / glm::max(elapsed_ms, 0.001), phase.bytes / (1024.0 * 1024.0) / seconds, triangles / seconds);
+        }
+        SAFE_DELETE(mesh);
+    }
+
+    remove(filename.c_str());
+    remove(mtl_filename.c_str());
+}
+
+// write a TGA file of 24 or 32 bit pixels, uncompressed (type 2, bottom-left origin) or
+// run-length packed (type 10). The packed file is stored top to bottom, so that loading it flips it.
+// returns the size of the file in bytes (0 on failure)
+static unsigned long long writeTGA(const std::string& filename, const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int bits, bool rle)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, filename.c_str(), "wb");
+    if (file == nullptr)
+        return 0;
+    setvbuf(file, nullptr, _IOFBF, BENCHMARK_WRITE_BUFFER_SIZE);
+
+    unsigned char header[18] = { 0 };
+    header[2] = rle ? 10 : 2;
+    header[12] = width & 0xFF;
+    header[13] = (width >> 8) & 0xFF;
+    header[14] = height & 0xFF;
+    header[15] = (height >> 8) & 0xFF;
+    header[16] = (unsigned char)bits;
+    header[17] = rle ? TGA_DESCRIPTOR_TOP : 0;
+    fwrite(header, 1, sizeof(header), file);
+
+    unsigned int pixel_size = bits / 8;
+    unsigned int row_size = width * pixel_size;
+    if (!rle)
+        fwrite(pixels, 1, (size_t)row_size * height, file);
+    for (unsigned int y = 0; rle && y < height; ++y)
+    {
+        // packets do not run across rows, as most writers do
+        const unsigned char* row = pixels + (size_t)(height - 1 - y) * row_size;
+        unsigned int x = 0;
+        while (x < width)
+        {
+            unsigned int run = 1;
+            while (x + run < width && run < TGA_RLE_MAX_PACKET && memcmp(row + (x + run) * pixel_size, row + x * pixel_size, pixel_size) == 0)
+                ++run;
+            if (run > 1)
+            {
+                fputc(TGA_RLE_PACKET_FLAG | (run - 1), file);
+                fwrite(row + x * pixel_size, 1, pixel_size, file);
+                x += run;
+                continue;
+            }
+
+            // raw pixels up to the next pair of equal pixels
+            unsigned int count = 1;
+            while (x + count < width && count < TGA_RLE_MAX_PACKET &&
+                   (x + count + 1 >= width || memcmp(row + (x + count) * pixel_size, row + (x + count + 1) * pixel_size, pixel_size) != 0))
+                ++count;
+            fputc(count - 1, file);
+            fwrite(row + x * pixel_size, 1, count * pixel_size, file);
+            x += count;
+        }
+    }
+
+    unsigned long long size = (unsigned long long)_ftelli64(file);
+    fclose(file);
+    return size;
+}
+
+// loads filename iterations times, returns the average time of a load in ms (negative on failure).
+// with use_mapping, uncompressed pixels are used from the mapped file, as Texture does. The decoded pixels are compared with pixels
+static double timeTGALoad(const std::string& filename, const unsigned char* pixels, unsigned int size, bool use_mapping)
+{
+    double total_ms = 0;
+    for (int i = 0; i < BENCHMARK_TGA_ITERATIONS; ++i)
+    {
+        TGA tga;
+        unsigned char* data = nullptr;
+        const unsigned char* mapped_data = nullptr;
+        std::string name = filename;
+        std::string error_msg;
+        std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+        bool loaded = tga.Load(name, &data, error_msg, use_mapping ? &mapped_data : nullptr);
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        const unsigned char* loaded_pixels = (data != nullptr) ? data : mapped_data;
+        bool same = loaded && tga.m_texture_info.size == size && memcmp(loaded_pixels, pixels, size) == 0;
+        SAFE_DELETE_ARRAY_POINTER(data)
+        if (!same)
+        {
+            PrintToOutputWindow("%s %s", filename.c_str(), loaded ? "does not match the source image" : error_msg.c_str());
+            return -1.0;
+        }
+    }
+    return total_ms / BENCHMARK_TGA_ITERATIONS;
+}
+
+// compare the uncompressed and the run-length packed encodings of an image
+static void benchmarkTGA(const std::string& name, const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int bits)
+{
+    std::string raw_filename = std::string(BENCHMARK_PATH) + "\\" + BENCHMARK_TGA_RAW_FILE;
+    std::string rle_filename = std::string(BENCHMARK_PATH) + "\\" + BENCHMARK_TGA_RLE_FILE;
+    unsigned long long raw_size = writeTGA(raw_filename, pixels, width, height, bits, false);
+    unsigned long long rle_size = writeTGA(rle_filename, pixels, width, height, bits, true);
+    if (raw_size == 0 || rle_size == 0)
+    {
+        PrintToOutputWindow("Could not write %s", BENCHMARK_TGA_RLE_FILE);
+        return;
+    }
+
+    // the loaded pixels are BGRA, opaque if the image has no alpha
+    unsigned int pixel_size = bits / 8;
+    unsigned int size = width * height * 4;
+    std::vector<unsigned char> expected(size, 255);
+    for (unsigned int i = 0; i < width * height; ++i)
+        memcpy(&expected[i * 4], pixels + i * pixel_size, pixel_size);
+
+    double raw_ms = timeTGALoad(raw_filename, &expected[0], size, false);
+    double mapped_ms = timeTGALoad(raw_filename, &expected[0], size, true);
+    double rle_ms = timeTGALoad(rle_filename, &expected[0], size, false);
+    remove(raw_filename.c_str());
+    remove(rle_filename.c_str());
+    if (raw_ms < 0 || mapped_ms < 0 || rle_ms < 0)
+        return;
+
+    double mb = size / (1024.0 * 1024.0);
+    PrintToOutputWindow("%-24s %4ux%-4u %2u bit: uncompressed %8.1f KB %8.2f ms %8.1f MB/s (as Texture loads it %8.2f ms) | RLE %8.1f KB (%5.2fx smaller) %8.2f ms %8.1f MB/s | RLE/uncompressed time %.2f",
+        name.c_str(), width, height, bits,
+        raw_size / 1024.0, raw_ms, mb * 1000.0 / glm::max(raw_ms, 0.001), mapped_ms,
+        rle_size / 1024.0, raw_size / (double)rle_size, rle_ms, mb * 1000.0 / glm::max(rle_ms, 0.001), rle_ms / glm::max(raw_ms, 0.001));
+}
+
+void BenchmarkTGADecode(void)
+{
+    // flat-coloured tiles, the kind of texture that is packed well
+    for (unsigned int bits = 24; bits <= 32; bits += 8)
+    {
+        unsigned int pixel_size = bits / 8;
+        std::vector<unsigned char> pixels((size_t)BENCHMARK_TGA_SIZE * BENCHMARK_TGA_SIZE * pixel_size);
+        for (unsigned int y = 0; y < BENCHMARK_TGA_SIZE; ++y)
+        {
+            for (unsigned int x = 0; x < BENCHMARK_TGA_SIZE; ++x)
+            {
+                unsigned int tile = (y / BENCHMARK_TGA_TILE) * (BENCHMARK_TGA_SIZE / BENCHMARK_TGA_TILE) + x / BENCHMARK_TGA_TILE;
+                unsigned char* pixel = &pixels[((size_t)y * BENCHMARK_TGA_SIZE + x) * pixel_size];
+                pixel[0] = (unsigned char)(tile * 37);
+                pixel[1] = (unsigned char)(tile * 91);
+                pixel[2] = (unsigned char)(tile * 13);
+                if (pixel_size == 4)
+                    pixel[3] = 255;
+            }
+        }
+        benchmarkTGA("flat tiles", &pixels[0], BENCHMARK_TGA_SIZE, BENCHMARK_TGA_SIZE, bits);
+    }
+
+    // the bundled (photographic) textures, which are not
+    for (size_t f = 0; f < sizeof(s_texture_files) / sizeof(s_texture_files[0]); ++f)
+    {
+        TGA tga;
+        unsigned char* data = nullptr;
+        std::string filename = std::string(s_texture_files[f][0]) + "\\" + s_texture_files[f][1];
+        std::string error_msg;
+        if (!tga.Load(filename, &data, error_msg))
+        {
+            PrintToOutputWindow("Could not load %s: %s", filename.c_str(), error_msg.c_str());
+            SAFE_DELETE_ARRAY_POINTER(data)
+            continue;
+        }
+        // back to the pixel depth of the file
+        unsigned int pixel_size = tga.m_bits / 8;
+        std::vector<unsigned char> pixels((size_t)tga.m_width * tga.m_height * pixel_size);
+        for (size_t i = 0; i < (size_t)tga.m_width * tga.m_height; ++i)
+            memcpy(&pixels[i * pixel_size], data + i * 4, pixel_size);
+        benchmarkTGA(s_texture_files[f][1], &pixels[0], tga.m_width, tga.m_height, tga.m_bits);
+        SAFE_DELETE_ARRAY_POINTER(data)
+    }
+}
+
+// the conversions done a byte at a time, used as a reference
+static void referenceConvert(PixelFormat format, const unsigned char* src, unsigned char* dst, unsigned int count, const unsigned int* palette)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char* pixel = dst + i * 4;
+        if (format == PIXEL_FORMAT_INDEX8)
+        {
+            unsigned int colour = palette[src[i]];
+            for (int c = 0; c < 4; ++c)
+                pixel[c] = (unsigned char)(colour >> (8 * c));
+        }
+        else if (format == PIXEL_FORMAT_BGR5A1)
+        {
+            unsigned int value = src[i * 2] | (src[i * 2 + 1] << 8);
+            for (int c = 0; c < 3; ++c)
+                pixel[c] = (unsigned char)(((value >> (5 * c)) & 0x1F) * 255 / 31.0f + 0.5f);
+            pixel[3] = (value & 0x8000) ? 255 : 0;
+        }
+        else
+        {
+            pixel[0] = src[i * 3];
+            pixel[1] = src[i * 3 + 1];
+            pixel[2] = src[i * 3 + 2];
+            pixel[3] = 255;
+        }
+    }
+}
+
+void BenchmarkPixelConversion(void)
+{
+    unsigned int width = BENCHMARK_TGA_SIZE, height = BENCHMARK_TGA_SIZE;
+    unsigned int count = width * height;
+    std::vector<unsigned char> src((size_t)count * 4);
+    for (size_t i = 0; i < src.size(); ++i)
+        src[i] = (unsigned char)((i * 2654435761u) >> 13);
+    std::vector<unsigned char> dst((size_t)count * 4), reference((size_t)count * 4);
+    unsigned int palette[256];
+    for (unsigned int i = 0; i < 256; ++i)
+        palette[i] = i * 0x01030507u;
+
+    // each kernel on the whole image as a single row, against the byte at a time reference
+    const PixelFormat formats[3] = { PIXEL_FORMAT_BGR8, PIXEL_FORMAT_BGR5A1, PIXEL_FORMAT_INDEX8 };
+    const char* names[3] = { "BGR8 -> BGRA8", "BGR5A1 -> BGRA8", "index8 -> BGRA8" };
+    for (int f = 0; f < 3; ++f)
+    {
+        std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < BENCHMARK_TGA_ITERATIONS; ++i)
+            referenceConvert(formats[f], &src[0], &reference[0], count, palette);
+        double reference_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count() / BENCHMARK_TGA_ITERATIONS;
+
+        start_time = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < BENCHMARK_TGA_ITERATIONS; ++i)
+        {
+            if (formats[f] == PIXEL_FORMAT_BGR8)        convertRowBGR8ToBGRA8(&src[0], &dst[0], count);
+            else if (formats[f] == PIXEL_FORMAT_BGR5A1) convertRowBGR5A1ToBGRA8(&src[0], &dst[0], count, true);
+            else                                        convertRowIndex8ToBGRA8(&src[0], &dst[0], count, palette);
+        }
+        double kernel_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count() / BENCHMARK_TGA_ITERATIONS;
+
+        double mb = count * 4 / (1024.0 * 1024.0);
+        PrintToOutputWindow("%-16s reference %8.2f ms %8.1f MB/s, kernel %8.2f ms %8.1f MB/s (%5.2fx)%s", names[f],
+            reference_ms, mb * 1000.0 / glm::max(reference_ms, 0.001), kernel_ms, mb * 1000.0 / glm::max(kernel_ms, 0.001),
+            reference_ms / glm::max(kernel_ms, 0.001), memcmp(&dst[0], &reference[0], dst.size()) == 0 ? "" : " OUTPUT DIFFERS");
+    }
+
+    // the in place kernels
+    std::vector<unsigned char> pixels(src);
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < BENCHMARK_TGA_ITERATIONS; ++i)
+        swizzleRowBGRA8(&pixels[0], count);
+    double swizzle_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count() / BENCHMARK_TGA_ITERATIONS;
+    bool swizzled = true;
+    for (unsigned int i = 0; i < count && swizzled; ++i)
+        swizzled = pixels[i * 4] == src[i * 4] && pixels[i * 4 + 2] == src[i * 4 + 2];  // an even number of swizzles
+    pixels = src;
+    start_time = std::chrono::high_resolution_clock::now();
+    premultiplyRowBGRA8(&pixels[0], count);
+    double premultiply_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    bool premultiplied = true;
+    for (unsigned int i = 0; i < count * 4 && premultiplied; ++i)
+        premultiplied = pixels[i] == ((i % 4 == 3) ? src[i] : (unsigned char)(src[i] * src[i - i % 4 + 3] / 255.0f + 0.5f));
+    PrintToOutputWindow("swizzle %8.2f ms%s, premultiply %8.2f ms%s", swizzle_ms, swizzled ? "" : " OUTPUT DIFFERS", premultiply_ms, premultiplied ? "" : " OUTPUT DIFFERS");
+
+    // the whole conversion of an image stored top to bottom, on one thread and on all of them
+    double convert_ms[2];
+    for (int t = 0; t < 2; ++t)
+    {
+        start_time = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < BENCHMARK_TGA_ITERATIONS; ++i)
+            convertPixels(&src[0], PIXEL_FORMAT_BGR8, width, height, PIXEL_FLIP_ROWS, nullptr, &dst[0], (t == 0) ? 1 : 0);
+        convert_ms[t] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count() / BENCHMARK_TGA_ITERATIONS;
+    }
+    PrintToOutputWindow("convertPixels BGR8 -> BGRA8 flipped, %ux%u: 1 thread %8.2f ms, %u threads %8.2f ms", width, height,
+        convert_ms[0], ThreadPool::getInstance().getNumThreads(), convert_ms[1]);
+}
+
+// the time of generating the mipmaps of an image, per megapixel of level 0
+static double timeMipChain(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                           MipFilter filter, MipContent content, unsigned char* chain, unsigned int num_threads)
+{
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < BENCHMARK_MIP_ITERATIONS; ++i)
+        buildMipChain(pixels, width, height, pixel_size, filter, content, chain, num_threads);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count() / BENCHMARK_MIP_ITERATIONS;
+    return ms / (width * (double)height / 1000000.0);
+}
+
+// the time of creating a Texture with mipmaps (without OpenGL)
+static double timeTextureLoad(const std::string& filename, MATERIAL_MAP_TYPE map_type, size_t& upload_size)
+{
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    Texture* texture = new Texture(filename, true, map_type);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    upload_size = texture->loaded() ? texture->get_upload_size() : 0;
+    SAFE_DELETE(texture);
+    return ms;
+}
+
+void BenchmarkMipChain(void)
+{
+    // the box filter of a linear image is the rounded average of 2x2 pixels
+    unsigned int size = 256;
+    std::vector<unsigned char> src((size_t)size * size * 4);
+    for (size_t i = 0; i < src.size(); ++i)
+        src[i] = (unsigned char)((i * 2654435761u) >> 13);
+    std::vector<unsigned char> chain(getMipChainSize(size, size, 4) - src.size());
+    buildMipChain(&src[0], size, size, 4, MIP_FILTER_BOX, MIP_CONTENT_LINEAR, &chain[0]);
+    int max_difference = 0;
+    for (unsigned int y = 0; y < size / 2; ++y)
+    {
+        for (unsigned int x = 0; x < size / 2 * 4; ++x)
+        {
+            const unsigned char* p = &src[(y * 2 * size) * 4 + (x / 4) * 8 + x % 4];
+            int average = (p[0] + p[4] + p[size * 4] + p[size * 4 + 4] + 2) / 4;
+            max_difference = glm::max(max_difference, abs(average - chain[y * size / 2 * 4 + x]));
+        }
+    }
+    PrintToOutputWindow("box filtered level 1 against the average of 2x2 pixels: max difference %d%s", max_difference, (max_difference <= 1) ? "" : " OUTPUT DIFFERS");
+
+    const char* filter_names[3] = { "box", "Kaiser", "Lanczos" };
+    const char* content_names[3] = { "colour", "linear", "normal" };
+    for (size_t f = 0; f < sizeof(s_texture_files) / sizeof(s_texture_files[0]); ++f)
+    {
+        TGA tga;
+        unsigned char* data = nullptr;
+        std::string filename = std::string(s_texture_files[f][0]) + "\\" + s_texture_files[f][1];
+        std::string error_msg;
+        if (!tga.Load(filename, &data, error_msg))
+        {
+            PrintToOutputWindow("Could not load %s: %s", filename.c_str(), error_msg.c_str());
+            SAFE_DELETE_ARRAY_POINTER(data)
+            continue;
+        }
+        unsigned int width = tga.m_width, height = tga.m_height, pixel_size = tga.m_texture_info.bits / 8;
+        chain.resize(getMipChainSize(width, height, pixel_size) - (size_t)width * height * pixel_size);
+
+        // every filter, with and without the conversion to linear space and with the renormalization, on 1 thread and on all of them
+        for (int filter = MIP_FILTER_BOX; filter <= MIP_FILTER_LANCZOS; ++filter)
+        {
+            for (int content = MIP_CONTENT_COLOUR; content <= MIP_CONTENT_NORMAL; ++content)
+            {
+                double ms[2];
+                for (int t = 0; t < 2; ++t)
+                    ms[t] = timeMipChain(data, width, height, pixel_size, (MipFilter)filter, (MipContent)content, &chain[0], (t == 0) ? 1 : 0);
+                PrintToOutputWindow("%-24s %4ux%-4u %-8s %-7s 1 thread %8.2f ms/MP, %u threads %8.2f ms/MP", s_texture_files[f][1], width, height,
+                    filter_names[filter], content_names[content], ms[0], ThreadPool::getInstance().getNumThreads(), ms[1]);
+            }
+        }
+
+        // a Texture generating its mipmaps and writing them to the cache, then reading them from it
+        std::string mip_filename = std::string(BENCHMARK_PATH) + "\\" + BENCHMARK_MIP_FILE;
+        if (writeTGA(mip_filename, data, width, height, pixel_size * 8, false) > 0)
+        {
+            remove(MipCache::getCacheFileName(mip_filename, Texture::get_cache_seed(MPT_MATERIAL_MAP_DIFFUSE_OP, true)).c_str());
+            size_t built_size = 0, cached_size = 0;
+            double built_ms = timeTextureLoad(mip_filename, MPT_MATERIAL_MAP_DIFFUSE_OP, built_size);
+            double cached_ms = timeTextureLoad(mip_filename, MPT_MATERIAL_MAP_DIFFUSE_OP, cached_size);
+            PrintToOutputWindow("%-24s Texture with mipmaps: generated %8.2f ms, from the mipmap cache %8.2f ms (%.1f KB of levels to upload)%s",
+                s_texture_files[f][1], built_ms, cached_ms, cached_size / 1024.0, (built_size == cached_size && built_size > 0) ? "" : " SIZE DIFFERS");
+            remove(MipCache::getCacheFileName(mip_filename, Texture::get_cache_seed(MPT_MATERIAL_MAP_DIFFUSE_OP, true)).c_str());
+            remove(mip_filename.c_str());
+        }
+        SAFE_DELETE_ARRAY_POINTER(data)
+    }
+}
+
+// the time of compressing an image, per megapixel
+static double timeCompressImage(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                                BlockFormat format, unsigned char* blocks, unsigned int num_threads)
+{
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < BENCHMARK_BLOCK_ITERATIONS; ++i)
+        compressImage(pixels, width, height, pixel_size, format, blocks, num_threads);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count() / BENCHMARK_BLOCK_ITERATIONS;
+    return ms / (width * (double)height / 1000000.0);
+}
+
+// the peak signal to noise ratio of the channels a format holds, between an image and its compressed blocks
+static double getBlockPSNR(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                           BlockFormat format, const unsigned char* blocks)
+{
+    // the channels the format does not hold are left as they are in the copy, so they add no error
+    std::vector<unsigned char> decoded(pixels, pixels + (size_t)width * height * pixel_size);
+    decompressImage(blocks, width, height, format, pixel_size, &decoded[0]);
+    unsigned int num_channels = pixel_size;
+    if (pixel_size == 4)
+        num_channels = (format == BLOCK_FORMAT_BC1) ? 3 : (format == BLOCK_FORMAT_BC4) ? 1 : (format == BLOCK_FORMAT_BC5) ? 2 : 4;
+
+    double squared_error = 0.0;
+    for (size_t i = 0; i < decoded.size(); ++i)
+        squared_error += (double)(decoded[i] - pixels[i]) * (decoded[i] - pixels[i]);
+    if (squared_error == 0.0)
+        return 99.99;
+    double mse = squared_error / ((double)width * height * num_channels);
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+void BenchmarkBlockCompression(void)
+{
+    const char* format_names[5] = { "none", "BC1", "BC3", "BC4", "BC5" };
+    for (size_t f = 0; f < sizeof(s_texture_files) / sizeof(s_texture_files[0]); ++f)
+    {
+        TGA tga;
+        unsigned char* data = nullptr;
+        std::string filename = std::string(s_texture_files[f][0]) + "\\" + s_texture_files[f][1];
+        std::string error_msg;
+        if (!tga.Load(filename, &data, error_msg))
+        {
+            PrintToOutputWindow("Could not load %s: %s", filename.c_str(), error_msg.c_str());
+            SAFE_DELETE_ARRAY_POINTER(data)
+            continue;
+        }
+        unsigned int width = tga.m_width, height = tga.m_height, pixel_size = tga.m_texture_info.bits / 8;
+        size_t size = (size_t)width * height * pixel_size;
+
+        // every format on 1 thread and on all of them, and the quality of the result
+        for (int format = BLOCK_FORMAT_BC1; format <= BLOCK_FORMAT_BC5; ++format)
+        {
+            if (pixel_size == 1 && (format == BLOCK_FORMAT_BC1 || format == BLOCK_FORMAT_BC3))
+                continue;
+            std::vector<unsigned char> blocks(getCompressedSize((BlockFormat)format, width, height));
+            double ms[2];
+            for (int t = 0; t < 2; ++t)
+                ms[t] = timeCompressImage(data, width, height, pixel_size, (BlockFormat)format, &blocks[0], (t == 0) ? 1 : 0);
+            double psnr = getBlockPSNR(data, width, height, pixel_size, (BlockFormat)format, &blocks[0]);
+            PrintToOutputWindow("%-24s %4ux%-4u %s 1 thread %8.2f ms/MP, %u threads %8.2f ms/MP, %7.1f KB -> %7.1f KB, PSNR %5.2f dB", s_texture_files[f][1],
+                width, height, format_names[format], ms[0], ThreadPool::getInstance().getNumThreads(), ms[1], size / 1024.0, blocks.size() / 1024.0, psnr);
+        }
+        SAFE_DELETE_ARRAY_POINTER(data)
+    }
+}
+
+bool RunBenchmark(int argc, char* argv[])
+{
+    // only the loader phases, on generated meshes of up to the given size
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (strcmp(argv[arg], "-benchmark-loader") != 0)
+            continue;
+
+        unsigned long values[3] = { BENCHMARK_LOADER_MAX_TRIANGLES, BENCHMARK_LOADER_GROUPS, BENCHMARK_LOADER_MATERIALS };
+        for (int v = 0; v < 3 && arg + 1 + v < argc; ++v)
+            values[v] = strtoul(argv[arg + 1 + v], NULL, 10);
+
+        PrintToOutputWindow("Running the loader benchmark on %u threads", ThreadPool::getInstance().getNumThreads());
+        BenchmarkLoaderPhases(glm::max(values[0], 1ul), values[1], values[2]);
+        return true;
+    }
+
+    int arg = 1;
+    while (arg < argc && strcmp(argv[arg], "-benchmark") != 0)
+        ++arg;
+    if (arg == argc)
+        return false;
+
+    unsigned long num_triangles = BENCHMARK_DEFAULT_TRIANGLES;
+    if (arg + 1 < argc)
+        num_triangles = glm::max(strtoul(argv[arg + 1], NULL, 10), 1ul);
+
+    PrintToOutputWindow("Running benchmarks on %u threads", ThreadPool::getInstance().getNumThreads());
+    BenchmarkNumberParser();
+    BenchmarkStartup();
+    BenchmarkTGADecode();
+    BenchmarkPixelConversion();
+    BenchmarkMipChain();
+    BenchmarkBlockCompression();
+    BenchmarkOBJParser(num_triangles);
+    return true;
+}
\ No newline at end of file
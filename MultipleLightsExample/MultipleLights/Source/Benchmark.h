@@ -0,0 +1,52 @@
+//----------------------------------------------------//
+//                                                    //
+// File: Benchmark.h                                  //
+// Headless benchmarks of the asset loaders, run with //
+// the -benchmark command line argument               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+
+// Runs the benchmarks if -benchmark is found in the command line arguments.
+// Usage: -benchmark [number of triangles]
+// or:    -benchmark-loader [max number of triangles] [number of groups] [number of materials] (loader phases only)
+// Returns true if the benchmarks were run (no window should be created then)
+bool RunBenchmark(int argc, char* argv[]);
+
+// Measures the number parser of the .obj/.mtl tokenizer alone on the bundled Data files,
+// against strtof/strtol, and checks that both give the same values
+void BenchmarkNumberParser(void);
+
+// Measures the startup of the bundled meshes (parsing and texture decoding, without OpenGL uploads),
+// one asset at a time and fanned out on the thread pool, and prints the timeline of each asset
+void BenchmarkStartup(void);
+
+// Measures loading uncompressed and run-length packed TGA files of generated flat-coloured images and of the bundled
+// textures, and prints the size of the files and the time and MB/s of decoding them (the packed ones also flipped),
+// and the time of mapping the uncompressed ones without copying the pixels
+void BenchmarkTGADecode(void);
+
+// Measures the pixel format conversion kernels against byte at a time conversions (and checks that both give the same pixels),
+// and the conversion of a whole image on one thread and on all of them
+void BenchmarkPixelConversion(void);
+
+// Measures generating the mipmaps of the bundled textures with each filter and kind of content, on one thread and on all of them,
+// in ms per megapixel of level 0, and loading a Texture with mipmaps when they are generated and when they are read from the cache.
+// Checks that the box filter gives the average of 2x2 pixels
+void BenchmarkMipChain(void);
+
+// Measures compressing the bundled textures to each block format, on one thread and on all of them, in ms per megapixel,
+// and prints the size of the blocks and the PSNR of the channels each format holds
+void BenchmarkBlockCompression(void);
+
+// Measures the OBJ parser on a generated grid mesh with the given number of triangles,
+// using 1 thread up to all the cores, and checks that all runs produce the same triangles
+void BenchmarkOBJParser(unsigned long num_triangles);
+
+// Measures each phase of loading generated grid meshes (.obj and .mtl, without textures) of 10K triangles and up to
+// max_triangles (10K, 100K, 1M, 10M, 50M), without the mesh cache or OpenGL, and prints the time, MB/s and triangles/s of each phase
+void BenchmarkLoaderPhases(unsigned long max_triangles, unsigned long num_groups, unsigned long num_materials);
\ No newline at end of file
@@ -0,0 +1,67 @@
+//----------------------------------------------------//
+//                                                    //
+// File: FrameStats.cpp                               //
+// FrameStats measures the time spent on each frame   //
+// and reports the frames that uploaded data to       //
+// OpenGL apart from those that did not               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "HelpLib.h"        // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "FrameStats.h"     // - Header file for the FrameStats class
+
+// Constructor
+FrameStats::FrameStats(void):
+    m_frame_start(std::chrono::high_resolution_clock::now())
+{
+    reset();
+}
+
+// other functions
+void FrameStats::beginFrame(void)
+{
+    m_frame_start = std::chrono::high_resolution_clock::now();
+}
+
+void FrameStats::endFrame(unsigned long long uploaded_bytes)
+{
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_frame_start).count();
+    FrameTimes& times = (uploaded_bytes > 0) ? m_uploading : m_idle;
+    times.frames++;
+    times.total_ms += ms;
+    times.max_ms = glm::max(times.max_ms, ms);
+    times.bytes += uploaded_bytes;
+
+    if (++m_frames < FRAME_STATS_INTERVAL)
+        return;
+    if (m_uploading.frames > 0)
+        print();
+    reset();
+}
+
+void FrameStats::print(void) const
+{
+    PrintToOutputWindow("Frame times over %u frames:", m_frames);
+    if (m_idle.frames > 0)
+        PrintToOutputWindow("  %4u frames without uploads: %.3f ms average, %.3f ms max",
+            m_idle.frames, m_idle.total_ms / m_idle.frames, m_idle.max_ms);
+    if (m_uploading.frames > 0)
+        PrintToOutputWindow("  %4u frames with uploads:    %.3f ms average, %.3f ms max, %.2f KB per frame",
+            m_uploading.frames, m_uploading.total_ms / m_uploading.frames, m_uploading.max_ms, m_uploading.bytes / 1024.0 / m_uploading.frames);
+}
+
+void FrameStats::reset(void)
+{
+    m_idle.frames = m_uploading.frames = 0;
+    m_idle.total_ms = m_uploading.total_ms = 0.0;
+    m_idle.max_ms = m_uploading.max_ms = 0.0;
+    m_idle.bytes = m_uploading.bytes = 0;
+    m_frames = 0;
+}
+
+// eof ///////////////////////////////// class FrameStats
\ No newline at end of file
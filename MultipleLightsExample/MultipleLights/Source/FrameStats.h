@@ -0,0 +1,80 @@
+//----------------------------------------------------//
+//                                                    //
+// File: FrameStats.h                                 //
+// FrameStats measures the time spent on each frame   //
+// and reports the frames that uploaded data to       //
+// OpenGL apart from those that did not               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <chrono>           // - Header file for timing the frames
+
+// defines /////////////////////////////////////////
+#define FRAME_STATS_INTERVAL            300         // frames between reports (only the intervals with uploads are reported)
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+struct FrameTimes
+{
+    unsigned int                        frames;
+    double                              total_ms;
+    double                              max_ms;
+    unsigned long long                  bytes;
+};
+
+// the time of a frame is the CPU time from beginFrame to endFrame on the OpenGL thread, which is where the driver copies
+// of the uploads from client memory show up. Not thread-safe
+class FrameStats
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    FrameTimes                          m_idle;             // the frames that did not upload anything
+    FrameTimes                          m_uploading;
+    unsigned int                        m_frames;
+    std::chrono::high_resolution_clock::time_point m_frame_start;
+
+    // private function declarations
+
+
+public:
+    // Constructor
+    FrameStats(void);
+
+    // public function declarations
+    void                                beginFrame(void);
+    // the frame uploaded this many bytes. Every FRAME_STATS_INTERVAL frames the times are printed (if there were uploads) and reset
+    void                                endFrame(unsigned long long uploaded_bytes);
+    void                                print(void) const;
+    void                                reset(void);
+
+    // get functions
+    const FrameTimes&                   getIdleTimes(void) const                    {return m_idle;}
+    const FrameTimes&                   getUploadingTimes(void) const               {return m_uploading;}
+
+    // set functions
+
+};
+
+#endif //FRAMESTATS_H
+
+// eof ///////////////////////////////// class FrameStats
\ No newline at end of file
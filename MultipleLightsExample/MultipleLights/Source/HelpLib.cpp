@@ -128,4 +128,88 @@ bool readFile(std::string& filename, char** data)
         return false;
     }
     return false;
+}
+
+bool mapFile(const std::string& filename, MappedFile& mapped)
+{
+    unmapFile(mapped);
+
+    mapped.file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mapped.file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(mapped.file, &file_size) || file_size.QuadPart == 0)
+    {
+        unmapFile(mapped);
+        return false;
+    }
+
+    // the mapping object and the view keep the file contents accessible until unmapFile is called
+    mapped.mapping = CreateFileMappingA(mapped.file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapped.mapping == NULL)
+    {
+        unmapFile(mapped);
+        return false;
+    }
+
+    mapped.data = (const char*)MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0);
+    if (mapped.data == nullptr)
+    {
+        unmapFile(mapped);
+        return false;
+    }
+
+    mapped.size = (size_t)file_size.QuadPart;
+    return true;
+}
+
+void unmapFile(MappedFile& mapped)
+{
+    if (mapped.data != nullptr)
+        UnmapViewOfFile(mapped.data);
+    if (mapped.mapping != NULL)
+        CloseHandle(mapped.mapping);
+    if (mapped.file != INVALID_HANDLE_VALUE)
+        CloseHandle(mapped.file);
+
+    mapped.data = nullptr;
+    mapped.size = 0;
+    mapped.mapping = NULL;
+    mapped.file = INVALID_HANDLE_VALUE;
+}
+
+unsigned long long hashData(const void* data, size_t size, unsigned long long seed)
+{
+    const unsigned long long prime = 0x9E3779B97F4A7C15ull;
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long long hash = seed ^ (size * prime);
+
+    // 8 bytes at a time, then the remaining bytes
+    size_t words = size / sizeof(unsigned long long);
+    for (size_t i = 0; i < words; ++i)
+    {
+        unsigned long long word;
+        memcpy(&word, bytes + i * sizeof(unsigned long long), sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (size_t i = words * sizeof(unsigned long long); i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * prime;
+        hash ^= hash >> 29;
+    }
+
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool hashFile(const std::string& filename, unsigned long long& hash, unsigned long long seed)
+{
+    MappedFile file;
+    if (!mapFile(filename, file))
+        return false;
+    hash = hashData(file.data, file.size, seed);
+    unmapFile(file);
+    return true;
 }
\ No newline at end of file
@@ -73,4 +73,35 @@ bool glError(void);
 bool checkFrameBufferError(const char* str);
 
 // read a file
-bool readFile(std::string& filename, char** data);
\ No newline at end of file
+bool readFile(std::string& filename, char** data);
+
+// a read-only view of a file mapped in memory
+struct MappedFile
+{
+    const char*                         data;
+    size_t                              size;
+    HANDLE                              file;
+    HANDLE                              mapping;
+
+    MappedFile():
+        data(nullptr),
+        size(0),
+        file(INVALID_HANDLE_VALUE),
+        mapping(nullptr)
+    {
+
+    }
+};
+
+// map a file in memory for reading (no copies are made)
+bool mapFile(const std::string& filename, MappedFile& mapped);
+
+// release a file mapped with mapFile
+void unmapFile(MappedFile& mapped);
+
+// 64-bit hash of a block of memory (used for detecting changed content, not cryptographic)
+// the hash of several blocks can be computed by passing the previous hash as the seed
+unsigned long long hashData(const void* data, size_t size, unsigned long long seed = 0);
+
+// hash the contents of a file (seed is used as in hashData)
+bool hashFile(const std::string& filename, unsigned long long& hash, unsigned long long seed = 0);
\ No newline at end of file
@@ -19,6 +19,9 @@
 // Header file for our OpenGL functions
 #include "Renderer.h"
 
+// Header file for the loader benchmarks
+#include "Benchmark.h"
+
 void main(int argc, char* argv[])
 {
     // This is the entry point of the application.
@@ -35,6 +38,10 @@ void main(int argc, char* argv[])
 
     std::string windowTitle = "OpenGL Multiple Lights Example";
 
+    // when started with -benchmark, run the loader benchmarks without creating a window
+    if (RunBenchmark(argc, argv))
+        exit(EXIT_SUCCESS);
+
     // glutInit initializes the GLUT library.
     // if something goes wrong, this will terminate with an error message
     glutInit(&argc, argv);
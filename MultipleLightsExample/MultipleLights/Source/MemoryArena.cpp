@@ -0,0 +1,101 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MemoryArena.cpp                              //
+// MemoryArena hands out memory from large blocks.    //
+// Allocations are not freed one by one, the arena is //
+// reset as a whole and its memory is reused          //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "MemoryArena.h"    // - Header file for the MemoryArena class
+
+#include <cstdint>          // - Header file for uintptr_t
+
+// Constructor
+MemoryArena::MemoryArena(size_t block_size):
+    m_block_size(block_size),
+    m_offset(0),
+    m_used(0),
+    m_peak(0),
+    m_capacity(0)
+{
+
+}
+
+// Destructor
+MemoryArena::~MemoryArena(void)
+{
+    release();
+}
+
+// other functions
+void MemoryArena::addBlock(size_t size)
+{
+    m_blocks.push_back(new char[size]);
+    m_block_sizes.push_back(size);
+    m_capacity += size;
+    m_offset = 0;
+}
+
+void* MemoryArena::allocate(size_t bytes, size_t alignment)
+{
+    if (bytes == 0)
+        return nullptr;
+
+    // align the address, not the offset, since new only guarantees the default alignment
+    size_t padding = 0;
+    if (!m_blocks.empty())
+    {
+        uintptr_t address = uintptr_t(m_blocks.back() + m_offset);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    if (m_blocks.empty() || m_offset + padding + bytes > m_block_sizes.back())
+    {
+        // the rest of the last block is left unused
+        m_used += m_blocks.empty() ? 0 : m_block_sizes.back() - m_offset;
+        addBlock((bytes + alignment > m_block_size) ? bytes + alignment : m_block_size);
+        uintptr_t address = uintptr_t(m_blocks.back());
+        padding = (alignment - address % alignment) % alignment;
+    }
+
+    char* memory = m_blocks.back() + m_offset + padding;
+    m_offset += padding + bytes;
+    m_used += padding + bytes;
+    if (m_used > m_peak)
+        m_peak = m_used;
+    return memory;
+}
+
+void MemoryArena::reset(void)
+{
+    // several blocks are replaced by one that holds all of them
+    size_t capacity = m_capacity;
+    if (m_blocks.size() > 1 || capacity > MEMORY_ARENA_MAX_RETAINED)
+    {
+        release();
+        if (capacity <= MEMORY_ARENA_MAX_RETAINED)
+            addBlock(capacity);
+    }
+    m_offset = 0;
+    m_used = 0;
+    m_peak = 0;
+}
+
+void MemoryArena::release(void)
+{
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+        delete[] m_blocks[i];
+    m_blocks.clear();
+    m_block_sizes.clear();
+    m_capacity = 0;
+    m_offset = 0;
+    m_used = 0;
+    m_peak = 0;
+}
+
+// eof ///////////////////////////////// class MemoryArena
\ No newline at end of file
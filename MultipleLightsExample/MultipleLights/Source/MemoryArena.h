@@ -0,0 +1,90 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MemoryArena.h                                //
+// MemoryArena hands out memory from large blocks.    //
+// Allocations are not freed one by one, the arena is //
+// reset as a whole and its memory is reused          //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MEMORYARENA_H
+#define MEMORYARENA_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <vector>
+#include <cstddef>
+
+// defines /////////////////////////////////////////
+#define MEMORY_ARENA_BLOCK_SIZE         (1024 * 1024)           // minimum size of a block
+#define MEMORY_ARENA_ALIGNMENT          16                      // minimum alignment of an allocation
+#define MEMORY_ARENA_MAX_RETAINED       (64 * 1024 * 1024)      // reset frees the memory above this size instead of keeping it
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+// not thread-safe. Memory allocated on one thread may be filled by others
+class MemoryArena
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    std::vector<char*>                  m_blocks;
+    std::vector<size_t>                 m_block_sizes;
+    size_t                              m_block_size;
+    size_t                              m_offset;           // in the last block
+    size_t                              m_used;             // bytes handed out since the last reset (including padding and the unused ends of full blocks)
+    size_t                              m_peak;             // the most that m_used reached since the last reset
+    size_t                              m_capacity;         // total size of the blocks
+
+    // private function declarations
+    void                                addBlock(size_t size);
+
+public:
+    // Constructor
+    MemoryArena(size_t block_size = MEMORY_ARENA_BLOCK_SIZE);
+
+    // Destructor
+    ~MemoryArena(void);
+
+    // public function declarations
+
+    // uninitialized memory, valid until the next reset or release. Returns nullptr for 0 bytes
+    void*                               allocate(size_t bytes, size_t alignment = MEMORY_ARENA_ALIGNMENT);
+
+    // uninitialized array of count T. No constructors or destructors are called
+    template <class T>
+    T*                                  allocate(size_t count)                  {return (T*)allocate(count * sizeof(T), (alignof(T) > MEMORY_ARENA_ALIGNMENT) ? alignof(T) : MEMORY_ARENA_ALIGNMENT);}
+
+    // discards all the allocations. The memory is kept (in a single block) for the next use of the arena,
+    // so that filling it again with about the same amount of data makes no allocations
+    void                                reset(void);
+
+    // discards all the allocations and frees the memory
+    void                                release(void);
+
+    // get functions
+    size_t                              getUsed(void) const                     {return m_used;}
+    size_t                              getPeak(void) const                     {return m_peak;}
+    size_t                              getCapacity(void) const                 {return m_capacity;}
+
+    // set functions
+
+};
+
+#endif //MEMORYARENA_H
+
+// eof ///////////////////////////////// class MemoryArena
\ No newline at end of file
@@ -0,0 +1,443 @@
+//----------------------------------------------------//
+//                                                    //
+// File: BlockCompress.cpp                            //
+// Compression of textures to the BC1, BC3, BC4 and   //
+// BC5 block formats on the CPU                       //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "BlockCompress.h"  // - Header file for the block compression
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+#include <cfloat>           // - Header file for FLT_MAX
+
+#ifdef BLOCK_COMPRESS_SSE2
+#include <emmintrin.h>      // - Header file for the SSE2 intrinsics
+#endif
+
+// the weight of the first endpoint in each of the 4 colours of a BC1 block
+static const float s_bc1_weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+// 8 bit channels to RGB565, rounded
+static inline unsigned int packRGB565(const float* rgb)
+{
+    int r = glm::clamp((int)(rgb[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+    int g = glm::clamp((int)(rgb[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+    int b = glm::clamp((int)(rgb[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+    return (unsigned int)((r << 11) | (g << 5) | b);
+}
+
+// RGB565 to 8 bit channels, with the high bits replicated to the low ones as the GPU does
+static inline void unpackRGB565(unsigned int colour, int* rgb)
+{
+    int r = (colour >> 11) & 0x1F, g = (colour >> 5) & 0x3F, b = colour & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// the 4 colours (RGB) of a BC1 block. BC3 blocks always have 4 colours, BC1 blocks only when c0 > c1 (otherwise the 4th is transparent black)
+static void buildPaletteBC1(unsigned int c0, unsigned int c1, bool four_colours, int palette[4][3])
+{
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if (four_colours)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// the nearest of the 4 colours for each of the 16 pixels (given as separate r, g, b arrays), packed 2 bits per pixel.
+// Returns the squared error of the block
+static float selectIndicesBC1(const float* r, const float* g, const float* b, const int palette[4][3], unsigned int& indices)
+{
+    int index[16];
+    float error = 0.0f;
+#ifdef BLOCK_COMPRESS_SSE2
+    // 4 pixels at a time, each compared with the 4 colours
+    __m128 total = _mm_setzero_ps();
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 pr = _mm_loadu_ps(r + i), pg = _mm_loadu_ps(g + i), pb = _mm_loadu_ps(b + i);
+        __m128 best = _mm_setzero_ps();
+        __m128i best_index = _mm_setzero_si128();
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128 dr = _mm_sub_ps(pr, _mm_set1_ps((float)palette[k][0]));
+            __m128 dg = _mm_sub_ps(pg, _mm_set1_ps((float)palette[k][1]));
+            __m128 db = _mm_sub_ps(pb, _mm_set1_ps((float)palette[k][2]));
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            if (k == 0)
+            {
+                best = distance;
+                continue;
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(best, distance);
+            best_index = _mm_or_si128(_mm_andnot_si128(closer, best_index), _mm_and_si128(closer, _mm_set1_epi32(k)));
+        }
+        total = _mm_add_ps(total, best);
+        _mm_storeu_si128((__m128i*)(index + i), best_index);
+    }
+    float totals[4];
+    _mm_storeu_ps(totals, total);
+    error = totals[0] + totals[1] + totals[2] + totals[3];
+#else
+    for (int i = 0; i < 16; ++i)
+    {
+        float best = 0.0f;
+        for (int k = 0; k < 4; ++k)
+        {
+            float dr = r[i] - palette[k][0], dg = g[i] - palette[k][1], db = b[i] - palette[k][2];
+            float distance = dr * dr + dg * dg + db * db;
+            if (k == 0 || distance < best)
+            {
+                best = distance;
+                index[i] = k;
+            }
+        }
+        error += best;
+    }
+#endif
+    indices = 0;
+    for (int i = 0; i < 16; ++i)
+        indices |= (unsigned int)index[i] << (2 * i);
+    return error;
+}
+
+// the colour part of BC1 and BC3 blocks. The endpoints start at the extremes of the pixels along their principal axis and are
+// refined by least squares for the indices they give, as long as the error decreases
+static void encodeColours(const unsigned char* pixels, unsigned char* block)
+{
+    float r[16], g[16], b[16], mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        b[i] = pixels[i * 4];
+        g[i] = pixels[i * 4 + 1];
+        r[i] = pixels[i * 4 + 2];
+        mean[0] += r[i];
+        mean[1] += g[i];
+        mean[2] += b[i];
+    }
+    for (int c = 0; c < 3; ++c)
+        mean[c] /= 16.0f;
+
+    // the principal axis, by power iteration on the covariance matrix
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        float dr = r[i] - mean[0], dg = g[i] - mean[1], db = b[i] - mean[2];
+        cov[0] += dr * dr; cov[1] += dr * dg; cov[2] += dr * db;
+        cov[3] += dg * dg; cov[4] += dg * db; cov[5] += db * db;
+    }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 4; ++iteration)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = glm::max(glm::max(fabsf(x), fabsf(y)), fabsf(z));
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+    int min_pixel = 0, max_pixel = 0;
+    float min_t = FLT_MAX, max_t = -FLT_MAX;
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = r[i] * axis[0] + g[i] * axis[1] + b[i] * axis[2];
+        if (t < min_t) { min_t = t; min_pixel = i; }
+        if (t > max_t) { max_t = t; max_pixel = i; }
+    }
+    float e0[3] = { r[max_pixel], g[max_pixel], b[max_pixel] };
+    float e1[3] = { r[min_pixel], g[min_pixel], b[min_pixel] };
+
+    unsigned int best_c0 = 0, best_c1 = 0, best_indices = 0;
+    float best_error = FLT_MAX;
+    for (int iteration = 0; iteration <= BLOCK_COMPRESS_ITERATIONS; ++iteration)
+    {
+        unsigned int c0 = packRGB565(e0), c1 = packRGB565(e1), indices;
+        int palette[4][3];
+        buildPaletteBC1(c0, c1, true, palette);
+        float error = selectIndicesBC1(r, g, b, palette, indices);
+        if (error >= best_error)
+            break;
+        best_error = error;
+        best_c0 = c0;
+        best_c1 = c1;
+        best_indices = indices;
+        if (iteration == BLOCK_COMPRESS_ITERATIONS || error == 0.0f)
+            break;
+
+        // the endpoints that minimize the error of these indices
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; ++i)
+        {
+            float alpha = s_bc1_weights[(indices >> (2 * i)) & 3], beta = 1.0f - alpha;
+            aa += alpha * alpha;
+            bb += beta * beta;
+            ab += alpha * beta;
+            ax[0] += alpha * r[i]; ax[1] += alpha * g[i]; ax[2] += alpha * b[i];
+            bx[0] += beta * r[i];  bx[1] += beta * g[i];  bx[2] += beta * b[i];
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            break;
+        for (int c = 0; c < 3; ++c)
+        {
+            e0[c] = glm::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+            e1[c] = glm::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+        }
+    }
+
+    // 4 colour blocks need c0 > c1: swapping the endpoints swaps the indices 0 and 1, and 2 and 3
+    if (best_c0 < best_c1)
+    {
+        unsigned int c = best_c0;
+        best_c0 = best_c1;
+        best_c1 = c;
+        best_indices ^= 0x55555555u;
+    }
+    else if (best_c0 == best_c1)
+        best_indices = 0;
+
+    block[0] = (unsigned char)best_c0;
+    block[1] = (unsigned char)(best_c0 >> 8);
+    block[2] = (unsigned char)best_c1;
+    block[3] = (unsigned char)(best_c1 >> 8);
+    memcpy(block + 4, &best_indices, 4);
+}
+
+static void decodeColours(const unsigned char* block, bool four_colours, unsigned char* pixels)
+{
+    unsigned int c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8), indices;
+    memcpy(&indices, block + 4, 4);
+    int palette[4][3];
+    buildPaletteBC1(c0, c1, four_colours || c0 > c1, palette);
+    for (int i = 0; i < 16; ++i)
+    {
+        unsigned int index = (indices >> (2 * i)) & 3;
+        pixels[i * 4]     = (unsigned char)palette[index][2];
+        pixels[i * 4 + 1] = (unsigned char)palette[index][1];
+        pixels[i * 4 + 2] = (unsigned char)palette[index][0];
+        pixels[i * 4 + 3] = (!four_colours && c0 <= c1 && index == 3) ? 0 : 255;
+    }
+}
+
+unsigned int getBlockSize(BlockFormat format)
+{
+    return (format == BLOCK_FORMAT_BC1 || format == BLOCK_FORMAT_BC4) ? 8 : 16;
+}
+
+size_t getCompressedSize(BlockFormat format, unsigned int width, unsigned int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+void encodeBlockBC1(const unsigned char* pixels, unsigned char* block)
+{
+    encodeColours(pixels, block);
+}
+
+void encodeBlockBC3(const unsigned char* pixels, unsigned char* block)
+{
+    unsigned char alpha[16];
+    for (int i = 0; i < 16; ++i)
+        alpha[i] = pixels[i * 4 + 3];
+    encodeBlockBC4(alpha, block);
+    encodeColours(pixels, block + 8);
+}
+
+void encodeBlockBC4(const unsigned char* values, unsigned char* block)
+{
+    int min_value = 255, max_value = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        min_value = glm::min(min_value, (int)values[i]);
+        max_value = glm::max(max_value, (int)values[i]);
+    }
+
+    // the 8 value mode (a0 > a1) spaces the values evenly between the endpoints, so the nearest one is found by rounding the
+    // position of a value between them. A block of one value uses the 6 value mode, whose index 0 is a0
+    block[0] = (unsigned char)max_value;
+    block[1] = (unsigned char)min_value;
+    unsigned long long bits = 0;
+    if (max_value > min_value)
+    {
+        int position[16];
+        float scale = 7.0f / (max_value - min_value);
+#ifdef BLOCK_COMPRESS_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 top = _mm_set1_ps((float)max_value);
+        for (int i = 0; i < 16; i += 4)
+        {
+            int packed;
+            memcpy(&packed, values + i, 4);
+            __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+            __m128 t = _mm_mul_ps(_mm_sub_ps(top, _mm_cvtepi32_ps(v)), _mm_set1_ps(scale));
+            _mm_storeu_si128((__m128i*)(position + i), _mm_cvtps_epi32(t));
+        }
+#else
+        for (int i = 0; i < 16; ++i)
+            position[i] = (int)((max_value - values[i]) * scale + 0.5f);
+#endif
+        // position 0 is a0 (index 0), 7 is a1 (index 1) and the ones in between are the indices 2 to 7
+        for (int i = 0; i < 16; ++i)
+        {
+            unsigned long long index = (position[i] == 0) ? 0 : (position[i] == 7) ? 1 : position[i] + 1;
+            bits |= index << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+void encodeBlockBC5(const unsigned char* red, const unsigned char* green, unsigned char* block)
+{
+    encodeBlockBC4(red, block);
+    encodeBlockBC4(green, block + 8);
+}
+
+void decodeBlockBC1(const unsigned char* block, unsigned char* pixels)
+{
+    decodeColours(block, false, pixels);
+}
+
+void decodeBlockBC3(const unsigned char* block, unsigned char* pixels)
+{
+    unsigned char alpha[16];
+    decodeBlockBC4(block, alpha);
+    decodeColours(block + 8, true, pixels);
+    for (int i = 0; i < 16; ++i)
+        pixels[i * 4 + 3] = alpha[i];
+}
+
+void decodeBlockBC4(const unsigned char* block, unsigned char* values)
+{
+    int a0 = block[0], a1 = block[1];
+    int palette[8] = { a0, a1, 0, 0, 0, 0, 0, 0 };
+    if (a0 > a1)
+    {
+        for (int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+        palette[7] = 255;
+    }
+    unsigned long long bits = 0;
+    for (int i = 0; i < 6; ++i)
+        bits |= (unsigned long long)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; ++i)
+        values[i] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+}
+
+void decodeBlockBC5(const unsigned char* block, unsigned char* red, unsigned char* green)
+{
+    decodeBlockBC4(block, red);
+    decodeBlockBC4(block + 8, green);
+}
+
+void compressImage(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size, BlockFormat format,
+                   unsigned char* blocks, unsigned int num_threads)
+{
+    unsigned int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    unsigned int block_size = getBlockSize(format);
+    size_t num_tasks = (blocks_y + BLOCK_COMPRESS_ROWS_PER_TASK - 1) / BLOCK_COMPRESS_ROWS_PER_TASK;
+    ThreadPool::getInstance().parallelFor(num_tasks, [&](size_t task)
+    {
+        unsigned int first = (unsigned int)(task * BLOCK_COMPRESS_ROWS_PER_TASK);
+        unsigned int last = glm::min(first + BLOCK_COMPRESS_ROWS_PER_TASK, blocks_y);
+        unsigned char block_pixels[64], red[16], green[16];
+        for (unsigned int by = first; by < last; ++by)
+        {
+            for (unsigned int bx = 0; bx < blocks_x; ++bx)
+            {
+                // the pixels past the edge of the image repeat the last row and column
+                for (unsigned int i = 0; i < 16; ++i)
+                {
+                    unsigned int x = glm::min(bx * 4 + i % 4, width - 1), y = glm::min(by * 4 + i / 4, height - 1);
+                    const unsigned char* p = pixels + ((size_t)y * width + x) * pixel_size;
+                    if (pixel_size == 4)
+                        memcpy(block_pixels + i * 4, p, 4);
+                    else
+                        memset(block_pixels + i * 4, p[0], 4);
+                    red[i] = (pixel_size == 4) ? p[2] : p[0];
+                    green[i] = (pixel_size == 4) ? p[1] : p[0];
+                }
+
+                unsigned char* block = blocks + ((size_t)by * blocks_x + bx) * block_size;
+                switch (format)
+                {
+                case BLOCK_FORMAT_BC1:  encodeBlockBC1(block_pixels, block); break;
+                case BLOCK_FORMAT_BC3:  encodeBlockBC3(block_pixels, block); break;
+                case BLOCK_FORMAT_BC4:  encodeBlockBC4(red, block); break;
+                case BLOCK_FORMAT_BC5:  encodeBlockBC5(red, green, block); break;
+                default: break;
+                }
+            }
+        }
+    }, num_threads);
+}
+
+void decompressImage(const unsigned char* blocks, unsigned int width, unsigned int height, BlockFormat format, unsigned int pixel_size,
+                     unsigned char* pixels)
+{
+    unsigned int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    unsigned int block_size = getBlockSize(format);
+    unsigned char block_pixels[64], red[16], green[16];
+    for (unsigned int by = 0; by < blocks_y; ++by)
+    {
+        for (unsigned int bx = 0; bx < blocks_x; ++bx)
+        {
+            const unsigned char* block = blocks + ((size_t)by * blocks_x + bx) * block_size;
+            switch (format)
+            {
+            case BLOCK_FORMAT_BC1:  decodeBlockBC1(block, block_pixels); break;
+            case BLOCK_FORMAT_BC3:  decodeBlockBC3(block, block_pixels); break;
+            case BLOCK_FORMAT_BC4:  decodeBlockBC4(block, red); break;
+            case BLOCK_FORMAT_BC5:  decodeBlockBC5(block, red, green); break;
+            default: return;
+            }
+
+            for (unsigned int i = 0; i < 16; ++i)
+            {
+                unsigned int x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if (x >= width || y >= height)
+                    continue;
+                unsigned char* p = pixels + ((size_t)y * width + x) * pixel_size;
+                if (format == BLOCK_FORMAT_BC1 || format == BLOCK_FORMAT_BC3)
+                    memcpy(p, block_pixels + i * 4, 4);
+                else if (pixel_size == 1)
+                    p[0] = red[i];
+                else
+                {
+                    p[2] = red[i];
+                    if (format == BLOCK_FORMAT_BC5)
+                        p[1] = green[i];
+                }
+            }
+        }
+    }
+}
+
+// eof ///////////////////////////////// BlockCompress
\ No newline at end of file
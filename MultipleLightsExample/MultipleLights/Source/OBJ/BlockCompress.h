@@ -0,0 +1,72 @@
+//----------------------------------------------------//
+//                                                    //
+// File: BlockCompress.h                              //
+// Compression of textures to the BC1, BC3, BC4 and   //
+// BC5 block formats on the CPU                       //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef BLOCKCOMPRESS_H
+#define BLOCKCOMPRESS_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+
+
+// defines /////////////////////////////////////////
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BLOCK_COMPRESS_SSE2
+#endif
+
+#define BLOCK_COMPRESS_ROWS_PER_TASK    4           // number of rows of blocks compressed by each parallel task
+#define BLOCK_COMPRESS_ITERATIONS       2           // least squares refinements of the endpoints of a BC1 block
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+// the formats are stored in 4x4 pixel blocks. Images whose size is not a multiple of 4 have partial blocks at the edges
+enum BlockFormat
+{
+    BLOCK_FORMAT_NONE,                              // not compressed
+    BLOCK_FORMAT_BC1,                               // 8 bytes: RGB565 endpoints and 2 bit indices (DXT1, opaque)
+    BLOCK_FORMAT_BC3,                               // 16 bytes: a BC4 block of the alpha, then a BC1 block of the colour (DXT5)
+    BLOCK_FORMAT_BC4,                               // 8 bytes: 8 bit endpoints and 3 bit indices of one channel (RGTC1)
+    BLOCK_FORMAT_BC5                                // 16 bytes: a BC4 block of the red channel, then one of the green channel (RGTC2)
+};
+
+// bytes of a 4x4 block of a format
+unsigned int getBlockSize(BlockFormat format);
+
+// bytes of a width x height image compressed to a format
+size_t getCompressedSize(BlockFormat format, unsigned int width, unsigned int height);
+
+// the block encoders and decoders. pixels are the 16 BGRA8 pixels of a 4x4 block, row by row, and values are 16 single channel values
+void encodeBlockBC1(const unsigned char* pixels, unsigned char* block);
+void encodeBlockBC3(const unsigned char* pixels, unsigned char* block);
+void encodeBlockBC4(const unsigned char* values, unsigned char* block);
+void encodeBlockBC5(const unsigned char* red, const unsigned char* green, unsigned char* block);
+void decodeBlockBC1(const unsigned char* block, unsigned char* pixels);
+void decodeBlockBC3(const unsigned char* block, unsigned char* pixels);
+void decodeBlockBC4(const unsigned char* block, unsigned char* values);
+void decodeBlockBC5(const unsigned char* block, unsigned char* red, unsigned char* green);
+
+// compresses width x height pixels of pixel_size bytes (BGRA8 for BC1 and BC3, BGRA8 or R8 for BC4 and BC5) to a format.
+// BC4 keeps the red channel (the only one of R8 pixels) and BC5 the red and green channels. The rows of blocks are compressed in parallel
+void compressImage(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size, BlockFormat format,
+                   unsigned char* blocks, unsigned int num_threads = 0);
+
+// decompresses the blocks of a width x height image to pixels of pixel_size bytes, laid out as compressImage reads them.
+// Only the channels the format holds are written
+void decompressImage(const unsigned char* blocks, unsigned int width, unsigned int height, BlockFormat format, unsigned int pixel_size,
+                     unsigned char* pixels);
+
+#endif //BLOCKCOMPRESS_H
+
+// eof ///////////////////////////////// BlockCompress
\ No newline at end of file
@@ -0,0 +1,370 @@
+//----------------------------------------------------//
+//                                                    //
+// File: IndexOptimizer.cpp                           //
+// Reordering of the triangles of a welded mesh for   //
+// the post-transform vertex cache and for less       //
+// overdraw, and of its vertices for fetching         //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "IndexOptimizer.h" // - Header file for the index optimization
+
+#include <algorithm>        // - Header file for sort, unique and lower_bound
+
+// defines /////////////////////////////////////////
+#define FORSYTH_CACHE_DECAY_POWER   1.5f            // how fast the score of a cached vertex falls with its position
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f           // the score of the vertices of the last triangle (lower, so that strips do not run backwards)
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f            // the boost of the vertices with few triangles left, so that no triangle is left alone
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+#define FORSYTH_MAX_VALENCE         32              // vertices with more triangles left get the boost of this many
+#define OPTIMIZER_NO_VERTEX         0xFFFFFFFFu     // a vertex that has not been given its new index yet
+
+void VertexCacheStats::add(const VertexCacheStats& stats)
+{
+    triangles += stats.triangles;
+    vertices += stats.vertices;
+    transforms += stats.transforms;
+    acmr = (triangles > 0) ? transforms / float(triangles) : 0.0f;
+    atvr = (vertices > 0) ? transforms / float(vertices) : 0.0f;
+}
+
+// the indices of a range as ids from 0 to the number of distinct vertices it uses, so that the per-vertex arrays
+// of a group are as large as the group and not as the mesh. Returns the number of distinct vertices
+static GLuint localIndices(const GLuint* indices, GLuint num_indices, std::vector<GLuint>& local)
+{
+    std::vector<GLuint> sorted(indices, indices + num_indices);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    local.resize(num_indices);
+    for (GLuint i = 0; i < num_indices; ++i)
+        local[i] = GLuint(std::lower_bound(sorted.begin(), sorted.end(), indices[i]) - sorted.begin());
+    return GLuint(sorted.size());
+}
+
+// a FIFO cache that keeps the last size transformed vertices. added holds the transform of each vertex plus one (0 if
+// it was never transformed), so nothing is moved when a vertex is added, and the cache is emptied by moving the base
+class FIFOCache
+{
+public:
+    FIFOCache(GLuint num_vertices, GLuint size):
+        m_added(num_vertices, 0),
+        m_size(size),
+        m_transforms(0),
+        m_base(0)
+    {
+    }
+
+    // returns whether the vertex was transformed
+    bool                                fetch(GLuint v)
+    {
+        if (m_added[v] > m_base && m_transforms - (m_added[v] - 1) <= m_size)
+            return false;
+        m_added[v] = ++m_transforms;
+        return true;
+    }
+    void                                clear(void)             {m_base = m_transforms;}
+    GLuint                              getTransforms(void) const {return m_transforms;}
+
+private:
+    std::vector<GLuint>                 m_added;
+    GLuint                              m_size;
+    GLuint                              m_transforms;
+    GLuint                              m_base;
+};
+
+VertexCacheStats analyzeVertexCache(const GLuint* indices, GLuint num_indices, GLuint cache_size)
+{
+    VertexCacheStats stats;
+    memset(&stats, 0, sizeof(stats));
+    std::vector<GLuint> local;
+    stats.triangles = num_indices / 3;
+    stats.vertices = localIndices(indices, num_indices, local);
+
+    FIFOCache cache(stats.vertices, cache_size);
+    for (GLuint i = 0; i < num_indices; ++i)
+        cache.fetch(local[i]);
+    stats.transforms = cache.getTransforms();
+    stats.acmr = (stats.triangles > 0) ? stats.transforms / float(stats.triangles) : 0.0f;
+    stats.atvr = (stats.vertices > 0) ? stats.transforms / float(stats.vertices) : 0.0f;
+    return stats;
+}
+
+// the score of a vertex at a position of the LRU cache (-1 if it is not cached), with remaining triangles left to draw
+static float vertexScore(int cache_position, GLuint remaining)
+{
+    struct ScoreTables
+    {
+        float                           cache[VERTEX_CACHE_OPTIMIZE_SIZE];
+        float                           valence[FORSYTH_MAX_VALENCE + 1];
+    };
+    static const ScoreTables tables = []()
+    {
+        ScoreTables t;
+        for (int i = 0; i < VERTEX_CACHE_OPTIMIZE_SIZE; ++i)
+        {
+            // the vertices of the last triangle get a fixed score, whichever of them is used
+            if (i < 3)
+                t.cache[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+            else
+                t.cache[i] = powf(1.0f - float(i - 3) / float(VERTEX_CACHE_OPTIMIZE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+        }
+        t.valence[0] = 0.0f;
+        for (int i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+            t.valence[i] = FORSYTH_VALENCE_BOOST_SCALE * powf(float(i), -FORSYTH_VALENCE_BOOST_POWER);
+        return t;
+    }();
+
+    if (remaining == 0)
+        return -1.0f;
+    float score = (cache_position >= 0) ? tables.cache[cache_position] : 0.0f;
+    return score + tables.valence[glm::min(remaining, GLuint(FORSYTH_MAX_VALENCE))];
+}
+
+void optimizeVertexCache(GLuint* indices, GLuint num_indices)
+{
+    GLuint num_triangles = num_indices / 3;
+    if (num_triangles < 2)
+        return;
+
+    std::vector<GLuint> local;
+    GLuint num_vertices = localIndices(indices, num_indices, local);
+
+    // the triangles of each vertex in compressed rows (as in generateTangents). The first remaining[v] ones of the row of v
+    // are the ones not drawn yet
+    std::vector<GLuint> offsets(num_vertices + 1, 0);
+    std::vector<GLuint> vertex_triangles(num_indices);
+    std::vector<GLuint> remaining(num_vertices, 0);
+    for (GLuint i = 0; i < num_indices; ++i)
+        remaining[local[i]]++;
+    for (GLuint v = 0; v < num_vertices; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<GLuint> cursors(offsets.begin(), offsets.end() - 1);
+    for (GLuint i = 0; i < num_indices; ++i)
+        vertex_triangles[cursors[local[i]]++] = i / 3;
+
+    std::vector<int> cache_position(num_vertices, -1);
+    std::vector<float> vertex_scores(num_vertices);
+    std::vector<float> triangle_scores(num_triangles, 0.0f);
+    std::vector<char> drawn(num_triangles, 0);
+    for (GLuint v = 0; v < num_vertices; ++v)
+        vertex_scores[v] = vertexScore(-1, remaining[v]);
+    GLuint best = 0;
+    for (GLuint t = 0; t < num_triangles; ++t)
+    {
+        triangle_scores[t] = vertex_scores[local[t * 3]] + vertex_scores[local[t * 3 + 1]] + vertex_scores[local[t * 3 + 2]];
+        if (triangle_scores[t] > triangle_scores[best])
+            best = t;
+    }
+
+    std::vector<GLuint> cache, new_cache;
+    cache.reserve(VERTEX_CACHE_OPTIMIZE_SIZE + 3);
+    new_cache.reserve(VERTEX_CACHE_OPTIMIZE_SIZE + 3);
+    std::vector<GLuint> ordered(num_triangles * 3);
+    GLuint next = 0;
+    for (GLuint k = 0; k < num_triangles; ++k)
+    {
+        // when no cached vertex has triangles left, the next one not drawn in the original order is taken. Forsyth takes the
+        // best of all of them, but that makes the optimization quadratic for meshes with many pieces
+        if (best == OPTIMIZER_NO_VERTEX)
+        {
+            while (drawn[next])
+                next++;
+            best = next;
+        }
+
+        drawn[best] = 1;
+        new_cache.clear();
+        for (int c = 0; c < 3; ++c)
+        {
+            ordered[k * 3 + c] = indices[best * 3 + c];
+
+            // the triangle is moved past the remaining ones of the row of each of its vertices
+            GLuint v = local[best * 3 + c];
+            GLuint* row = &vertex_triangles[offsets[v]];
+            for (GLuint j = 0; j < remaining[v]; ++j)
+            {
+                if (row[j] == best)
+                {
+                    std::swap(row[j], row[remaining[v] - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+            if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+                new_cache.push_back(v);
+        }
+
+        // the vertices of the triangle move to the front of the cache, and the last ones fall out of it
+        size_t num_triangle_vertices = new_cache.size();
+        for (size_t i = 0; i < cache.size(); ++i)
+            if (std::find(new_cache.begin(), new_cache.begin() + num_triangle_vertices, cache[i]) == new_cache.begin() + num_triangle_vertices)
+                new_cache.push_back(cache[i]);
+        for (size_t i = 0; i < new_cache.size(); ++i)
+        {
+            GLuint v = new_cache[i];
+            cache_position[v] = (i < VERTEX_CACHE_OPTIMIZE_SIZE) ? int(i) : -1;
+            vertex_scores[v] = vertexScore(cache_position[v], remaining[v]);
+        }
+
+        // only the triangles of the vertices whose score changed are scored again, and the best of them is drawn next
+        best = OPTIMIZER_NO_VERTEX;
+        float best_score = -1.0f;
+        for (size_t i = 0; i < new_cache.size(); ++i)
+        {
+            GLuint v = new_cache[i];
+            const GLuint* row = &vertex_triangles[offsets[v]];
+            for (GLuint j = 0; j < remaining[v]; ++j)
+            {
+                GLuint t = row[j];
+                triangle_scores[t] = vertex_scores[local[t * 3]] + vertex_scores[local[t * 3 + 1]] + vertex_scores[local[t * 3 + 2]];
+                if (triangle_scores[t] > best_score)
+                {
+                    best_score = triangle_scores[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (new_cache.size() > VERTEX_CACHE_OPTIMIZE_SIZE)
+            new_cache.resize(VERTEX_CACHE_OPTIMIZE_SIZE);
+        cache.swap(new_cache);
+    }
+    memcpy(indices, ordered.data(), num_indices * sizeof(GLuint));
+}
+
+void optimizeOverdraw(GLuint* indices, GLuint num_indices, const VertexData* vertices, float threshold)
+{
+    GLuint num_triangles = num_indices / 3;
+    if (num_triangles < 2)
+        return;
+
+    std::vector<GLuint> local;
+    GLuint num_vertices = localIndices(indices, num_indices, local);
+    FIFOCache cache(num_vertices, VERTEX_CACHE_SIZE);
+    auto misses = [&](GLuint t)
+    {
+        return GLuint(cache.fetch(local[t * 3])) + GLuint(cache.fetch(local[t * 3 + 1])) + GLuint(cache.fetch(local[t * 3 + 2]));
+    };
+
+    // the cache starts over where all the vertices of a triangle miss it, so the triangles can be reordered there for free
+    std::vector<GLuint> hard_starts;
+    for (GLuint t = 0; t < num_triangles; ++t)
+        if (misses(t) == 3 || t == 0)
+            hard_starts.push_back(t);
+    hard_starts.push_back(num_triangles);
+
+    // the triangles between two such points are split further where the ACMR of the cluster so far, starting with an
+    // empty cache, is close enough to the one of all of them
+    std::vector<GLuint> starts;
+    for (size_t h = 0; h + 1 < hard_starts.size(); ++h)
+    {
+        GLuint first = hard_starts[h], last = hard_starts[h + 1];
+        cache.clear();
+        GLuint hard_misses = 0;
+        for (GLuint t = first; t < last; ++t)
+            hard_misses += misses(t);
+        float limit = threshold * hard_misses / float(last - first);
+
+        cache.clear();
+        starts.push_back(first);
+        GLuint cluster_misses = 0;
+        for (GLuint t = first; t + 1 < last; ++t)
+        {
+            cluster_misses += misses(t);
+            if (cluster_misses <= limit * (t + 1 - starts.back()))
+            {
+                starts.push_back(t + 1);
+                cluster_misses = 0;
+                cache.clear();
+            }
+        }
+    }
+    starts.push_back(num_triangles);
+    size_t num_clusters = starts.size() - 1;
+    if (num_clusters < 2)
+        return;
+
+    // the area weighted centroid and normal of each cluster, and the centroid of all of them
+    auto position = [&](GLuint i)
+    {
+        const GLfloat* p = vertices[indices[i]].position;
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+    std::vector<glm::vec3> centroids(num_clusters), normals(num_clusters);
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    for (size_t c = 0; c < num_clusters; ++c)
+    {
+        glm::vec3 centroid(0.0f), mean(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (GLuint t = starts[c]; t < starts[c + 1]; ++t)
+        {
+            glm::vec3 a = position(t * 3), b = position(t * 3 + 1), d = position(t * 3 + 2);
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float triangle_area = glm::length(n);
+            glm::vec3 center = (a + b + d) / 3.0f;
+            centroid += center * triangle_area;
+            mean += center;
+            normal += n;
+            area += triangle_area;
+        }
+        // a cluster of degenerate triangles is placed at their mean
+        centroids[c] = (area > 0.0f) ? centroid / area : mean / float(starts[c + 1] - starts[c]);
+        normals[c] = normal;
+        mesh_centroid += centroid;
+        mesh_area += area;
+    }
+    if (mesh_area <= 0.0f)
+        return;
+    mesh_centroid /= mesh_area;
+
+    // the clusters that face away from the centroid the most are drawn first
+    std::vector<float> keys(num_clusters);
+    std::vector<GLuint> order(num_clusters);
+    for (size_t c = 0; c < num_clusters; ++c)
+    {
+        float length = glm::length(normals[c]);
+        keys[c] = (length > 0.0f) ? glm::dot(centroids[c] - mesh_centroid, normals[c] / length) : 0.0f;
+        order[c] = GLuint(c);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](GLuint a, GLuint b) { return keys[a] > keys[b]; });
+
+    std::vector<GLuint> ordered;
+    ordered.reserve(num_indices);
+    for (size_t c = 0; c < num_clusters; ++c)
+        ordered.insert(ordered.end(), indices + starts[order[c]] * 3, indices + starts[order[c] + 1] * 3);
+    memcpy(indices, ordered.data(), num_indices * sizeof(GLuint));
+}
+
+void optimizeVertexFetch(std::vector<VertexData>& vertices, GLuint* indices, GLuint num_indices)
+{
+    std::vector<GLuint> remap(vertices.size(), OPTIMIZER_NO_VERTEX);
+    std::vector<VertexData> ordered;
+    ordered.reserve(vertices.size());
+    for (GLuint i = 0; i < num_indices; ++i)
+    {
+        GLuint v = indices[i];
+        if (remap[v] == OPTIMIZER_NO_VERTEX)
+        {
+            remap[v] = GLuint(ordered.size());
+            ordered.push_back(vertices[v]);
+        }
+        indices[i] = remap[v];
+    }
+
+    // the vertices that no triangle uses are kept at the end
+    for (size_t v = 0; v < vertices.size(); ++v)
+        if (remap[v] == OPTIMIZER_NO_VERTEX)
+            ordered.push_back(vertices[v]);
+    vertices.swap(ordered);
+}
+
+// eof ///////////////////////////////// IndexOptimizer
\ No newline at end of file
@@ -0,0 +1,64 @@
+//----------------------------------------------------//
+//                                                    //
+// File: IndexOptimizer.h                             //
+// Reordering of the triangles of a welded mesh for   //
+// the post-transform vertex cache and for less       //
+// overdraw, and of its vertices for fetching         //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef INDEXOPTIMIZER_H
+#define INDEXOPTIMIZER_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+// HelpLib.h should be included first (for glm and the GL types)
+
+
+// defines /////////////////////////////////////////
+#define INDEX_OPTIMIZATION          1               // 0 keeps the triangles and the vertices in the order of the file
+#define VERTEX_CACHE_OPTIMIZE_SIZE  32              // entries of the LRU cache the triangles are ordered for
+#define VERTEX_CACHE_SIZE           16              // entries of the FIFO post-transform cache ACMR and ATVR are measured with
+#define OVERDRAW_THRESHOLD          1.05f           // the clusters ordered for overdraw may raise the ACMR of a group by at most this factor
+
+// forward declarations ////////////////////////////
+struct VertexData;
+
+// class declarations //////////////////////////////
+
+// the efficiency of the post-transform vertex cache for a list of triangles, drawn on its own
+struct VertexCacheStats
+{
+    GLuint                              triangles;
+    GLuint                              vertices;           // the distinct vertices the triangles use
+    GLuint                              transforms;         // the vertices the cache missed
+    float                               acmr;               // average cache miss ratio: transforms per triangle (3 at worst, about 0.5 for a large grid)
+    float                               atvr;               // average transform to vertex ratio: transforms per vertex (1 at best)
+
+    void                                add(const VertexCacheStats& stats);
+};
+
+// simulates a FIFO cache of cache_size vertices
+VertexCacheStats analyzeVertexCache(const GLuint* indices, GLuint num_indices, GLuint cache_size = VERTEX_CACHE_SIZE);
+
+// orders the triangles so that they reuse the vertices of an LRU cache of VERTEX_CACHE_OPTIMIZE_SIZE vertices
+// (Forsyth, "Linear-Speed Vertex Cache Optimisation"). The indices of a triangle keep their winding
+void optimizeVertexCache(GLuint* indices, GLuint num_indices);
+
+// splits the triangles, in their cache order, into clusters and draws the ones that face out of the mesh first, so that
+// they occlude the others from most directions (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw"). A cluster ends where the cache starts over, or where the ACMR of the cluster is within threshold of the one of
+// the triangles between two such points
+void optimizeOverdraw(GLuint* indices, GLuint num_indices, const VertexData* vertices, float threshold = OVERDRAW_THRESHOLD);
+
+// orders the vertices by their first use in the indices, and remaps the indices to them
+void optimizeVertexFetch(std::vector<VertexData>& vertices, GLuint* indices, GLuint num_indices);
+
+#endif //INDEXOPTIMIZER_H
+
+// eof ///////////////////////////////// IndexOptimizer
\ No newline at end of file
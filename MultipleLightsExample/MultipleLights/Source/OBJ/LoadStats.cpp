@@ -0,0 +1,96 @@
+//----------------------------------------------------//
+//                                                    //
+// File: LoadStats.cpp                                //
+// Time, bytes and items of each phase of loading a   //
+// mesh, gathered with scoped timers                  //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "LoadStats.h"      // - Header file for the LoadStats class
+
+// Constructor
+LoadStats::LoadStats(void)
+{
+    reset();
+}
+
+// other functions
+void LoadStats::add(LoadPhase phase, double ms, unsigned long long bytes, unsigned long long items)
+{
+    PhaseStats& stats = m_phases[phase];
+    stats.ms += ms;
+    stats.bytes += bytes;
+    stats.items += items;
+    stats.calls++;
+}
+
+void LoadStats::merge(const LoadStats& other)
+{
+    for (int i = 0; i < LOAD_PHASE_COUNT; ++i)
+    {
+        const PhaseStats& stats = other.m_phases[i];
+        if (stats.calls > 0)
+        {
+            m_phases[i].ms += stats.ms;
+            m_phases[i].bytes += stats.bytes;
+            m_phases[i].items += stats.items;
+            m_phases[i].calls += stats.calls;
+        }
+    }
+}
+
+void LoadStats::reset(void)
+{
+    memset(m_phases, 0, sizeof(m_phases));
+}
+
+double LoadStats::getTotalMs(void) const
+{
+    double total_ms = 0;
+    for (int i = 0; i < LOAD_PHASE_COUNT; ++i)
+        total_ms += m_phases[i].ms;
+    return total_ms;
+}
+
+const char* LoadStats::getPhaseName(LoadPhase phase)
+{
+    static const char* names[LOAD_PHASE_COUNT] =
+    {
+        "cache read",
+        "parse",
+        "materials",
+        "merge",
+        "faces",
+        "weld",
+        "tangents",
+        "index optimization",
+        "simplification",
+        "cache write",
+        "texture decode",
+        "upload"
+    };
+    return names[phase];
+}
+
+void LoadStats::print(const std::string& name) const
+{
+    PrintToOutputWindow("%-24s %10s %12s %10s %14s", name.c_str(), "ms", "MB", "MB/s", "items/s");
+    for (int i = 0; i < LOAD_PHASE_COUNT; ++i)
+    {
+        const PhaseStats& stats = m_phases[i];
+        if (stats.calls == 0)
+            continue;
+        double seconds = glm::max(stats.ms, 0.001) / 1000.0;
+        double mb = stats.bytes / (1024.0 * 1024.0);
+        PrintToOutputWindow("  %-22s %10.2f %12.2f %10.2f %14.0f", getPhaseName(LoadPhase(i)), stats.ms, mb, mb / seconds, stats.items / seconds);
+    }
+    PrintToOutputWindow("  %-22s %10.2f", "total", getTotalMs());
+}
+
+// eof ///////////////////////////////// class LoadStats
\ No newline at end of file
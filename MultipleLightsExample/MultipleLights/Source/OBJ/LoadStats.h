@@ -0,0 +1,134 @@
+//----------------------------------------------------//
+//                                                    //
+// File: LoadStats.h                                  //
+// Time, bytes and items of each phase of loading a   //
+// mesh, gathered with scoped timers                  //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef LOADSTATS_H
+#define LOADSTATS_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <chrono>           // - Header file for timing the phases
+#include <string>
+
+// defines /////////////////////////////////////////
+
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+// the phases do not overlap, so their times add up to the time spent loading a mesh
+enum LoadPhase
+{
+    LOAD_PHASE_CACHE_READ,          // mapping and validating the mesh cache (bytes: cache file)
+    LOAD_PHASE_PARSE,               // tokenizing the .obj file (bytes: .obj file, items: faces)
+    LOAD_PHASE_MATERIALS,           // parsing the .mtl files (bytes: .mtl files, items: materials)
+    LOAD_PHASE_MERGE,               // concatenating the parsed chunks into the attribute streams (bytes: streams)
+    LOAD_PHASE_FACES,               // resolving the faces and their plane normals and tangents (bytes: face streams, items: faces)
+    LOAD_PHASE_WELD,                // welding and building the vertex and index data (bytes: final buffers, items: face corners)
+    LOAD_PHASE_TANGENTS,            // smoothed normals and vertex tangents (items: vertices)
+    LOAD_PHASE_OPTIMIZE,            // reordering the triangles and the vertices (items: triangles)
+    LOAD_PHASE_SIMPLIFY,            // building the levels of detail (items: triangles)
+    LOAD_PHASE_CACHE_WRITE,         // writing the mesh cache (bytes: final buffers)
+    LOAD_PHASE_TEXTURE_DECODE,      // reading the texture files (bytes: decoded texels, items: textures)
+    LOAD_PHASE_UPLOAD,              // OpenGL buffer and texture calls, CPU side only (bytes: uploaded)
+    LOAD_PHASE_COUNT
+};
+
+struct PhaseStats
+{
+    double                              ms;
+    unsigned long long                  bytes;
+    unsigned long long                  items;
+    unsigned int                        calls;              // number of times the phase was recorded
+};
+
+// not thread-safe. Each phase is recorded by one thread at a time
+class LoadStats
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    PhaseStats                          m_phases[LOAD_PHASE_COUNT];
+
+    // private function declarations
+
+
+public:
+    // Constructor
+    LoadStats(void);
+
+    // public function declarations
+    void                                add(LoadPhase phase, double ms, unsigned long long bytes, unsigned long long items);
+    // adds the phases of other to these (e.g. the phases of a loader to those of the mesh it built)
+    void                                merge(const LoadStats& other);
+    void                                reset(void);
+    // prints the recorded phases with their throughput (MB/s of their bytes and items per second)
+    void                                print(const std::string& name) const;
+
+    // get functions
+    const PhaseStats&                   getPhase(LoadPhase phase) const         {return m_phases[phase];}
+    double                              getTotalMs(void) const;
+    static const char*                  getPhaseName(LoadPhase phase);
+
+    // set functions
+
+};
+
+// records the time from its construction to its destruction in a phase of a LoadStats
+class ScopedPhaseTimer
+{
+private:
+    // private variable declarations
+    LoadStats&                          m_stats;
+    LoadPhase                           m_phase;
+    unsigned long long                  m_bytes;
+    unsigned long long                  m_items;
+    std::chrono::high_resolution_clock::time_point m_start_time;
+
+public:
+    // Constructor
+    ScopedPhaseTimer(LoadStats& stats, LoadPhase phase, unsigned long long bytes = 0, unsigned long long items = 0) :
+        m_stats(stats),
+        m_phase(phase),
+        m_bytes(bytes),
+        m_items(items),
+        m_start_time(std::chrono::high_resolution_clock::now())
+    {
+
+    }
+
+    // Destructor
+    ~ScopedPhaseTimer(void)
+    {
+        m_stats.add(m_phase, getElapsedMs(), m_bytes, m_items);
+    }
+
+    // get functions
+    double                              getElapsedMs(void) const                {return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_start_time).count();}
+
+    // set functions
+    // for phases whose amount of work is only known at their end
+    void                                setBytes(unsigned long long bytes)      {m_bytes = bytes;}
+    void                                setItems(unsigned long long items)      {m_items = items;}
+};
+
+#endif //LOADSTATS_H
+
+// eof ///////////////////////////////// class LoadStats
\ No newline at end of file
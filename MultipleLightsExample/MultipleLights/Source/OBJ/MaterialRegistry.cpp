@@ -0,0 +1,231 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MaterialRegistry.cpp                         //
+// MaterialRegistry shares identical materials across //
+// meshes and gives each one a small global ID        //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OBJMaterial.h"    // - Header file for the OBJMaterial class
+#include "MaterialRegistry.h" // - Header file for the MaterialRegistry class
+#include "TextureCache.h"   // - Header file for the TextureCache class
+
+// Constructor
+MaterialRegistry::MaterialRegistry(void)
+{
+    // the texture cache is created first, so that it is destroyed after the materials that release their textures to it
+    TextureCache::getInstance();
+}
+
+// Destructor
+MaterialRegistry::~MaterialRegistry(void)
+{
+    for (size_t i = 0; i < m_entries.size(); ++i)
+        SAFE_DELETE(m_entries[i].material);
+}
+
+// other functions
+MaterialRegistry& MaterialRegistry::getInstance(void)
+{
+    static MaterialRegistry registry;
+    return registry;
+}
+
+unsigned long long MaterialRegistry::hashMaterial(const OBJMaterial& material, const std::string& path)
+{
+    float properties[11] =
+    {
+        material.m_diffuse.x, material.m_diffuse.y, material.m_diffuse.z,
+        material.m_specular.x, material.m_specular.y, material.m_specular.z,
+        material.m_emission.x, material.m_emission.y, material.m_emission.z,
+        material.m_gloss, material.m_opacity
+    };
+    unsigned long long hash = hashData(properties, sizeof(properties));
+    hash = hashData(material.m_name.data(), material.m_name.size(), hash);
+    // the texture files are only the same files if they are relative to the same path
+    const std::string* files[4] = { &material.m_diffuse_opacity_tex_file, &material.m_specular_gloss_tex_file, &material.m_emission_tex_file, &material.m_normal_tex_file };
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!files[i]->empty())
+            hash = hashData(files[i]->data(), files[i]->size(), hashData(path.data(), path.size(), hash));
+        else
+            hash = hashData(&i, sizeof(i), hash);
+    }
+    return hash;
+}
+
+bool MaterialRegistry::sameContent(const Entry& entry, const OBJMaterial& material, const std::string& path, unsigned int name_id) const
+{
+    const OBJMaterial& other = *entry.material;
+    bool has_textures = !material.m_diffuse_opacity_tex_file.empty() || !material.m_specular_gloss_tex_file.empty() ||
+                        !material.m_emission_tex_file.empty() || !material.m_normal_tex_file.empty();
+    return entry.name_id == name_id &&
+           other.m_diffuse == material.m_diffuse &&
+           other.m_specular == material.m_specular &&
+           other.m_emission == material.m_emission &&
+           other.m_gloss == material.m_gloss &&
+           other.m_opacity == material.m_opacity &&
+           other.m_diffuse_opacity_tex_file == material.m_diffuse_opacity_tex_file &&
+           other.m_specular_gloss_tex_file == material.m_specular_gloss_tex_file &&
+           other.m_emission_tex_file == material.m_emission_tex_file &&
+           other.m_normal_tex_file == material.m_normal_tex_file &&
+           (!has_textures || entry.path == path);
+}
+
+unsigned int MaterialRegistry::internNameLocked(const std::string& name)
+{
+    std::unordered_map<std::string, unsigned int>::iterator it = m_name_ids.find(name);
+    if (it != m_name_ids.end())
+        return it->second;
+
+    unsigned int name_id = (unsigned int)m_names.size();
+    m_names.push_back(name);
+    m_name_ids[name] = name_id;
+    return name_id;
+}
+
+MaterialID MaterialRegistry::acquire(OBJMaterial* material, const std::string& path)
+{
+    // the hash is computed outside of the lock
+    unsigned long long hash = hashMaterial(*material, path);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    unsigned int name_id = internNameLocked(material->m_name);
+
+    typedef std::unordered_multimap<unsigned long long, MaterialID>::iterator LookupIterator;
+    std::pair<LookupIterator, LookupIterator> range = m_lookup.equal_range(hash);
+    for (LookupIterator it = range.first; it != range.second; ++it)
+    {
+        Entry& entry = m_entries[it->second];
+        if (sameContent(entry, *material, path, name_id))
+        {
+            entry.references++;
+            lock.unlock();
+            SAFE_DELETE(material);
+            return it->second;
+        }
+    }
+
+    MaterialID id;
+    if (!m_free_ids.empty())
+    {
+        id = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+    else
+    {
+        id = (MaterialID)m_entries.size();
+        m_entries.push_back(Entry());
+    }
+
+    Entry& entry = m_entries[id];
+    entry.material = material;
+    entry.path = path;
+    entry.name_id = name_id;
+    entry.hash = hash;
+    entry.references = 1;
+    entry.texture_state = MATERIAL_TEXTURES_NOT_DECODED;
+    m_lookup.insert(std::make_pair(hash, id));
+    return id;
+}
+
+void MaterialRegistry::release(MaterialID id)
+{
+    OBJMaterial* material = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (id >= m_entries.size() || m_entries[id].material == nullptr)
+            return;
+
+        Entry& entry = m_entries[id];
+        if (--entry.references > 0)
+            return;
+
+        typedef std::unordered_multimap<unsigned long long, MaterialID>::iterator LookupIterator;
+        std::pair<LookupIterator, LookupIterator> range = m_lookup.equal_range(entry.hash);
+        for (LookupIterator it = range.first; it != range.second; ++it)
+        {
+            if (it->second == id)
+            {
+                m_lookup.erase(it);
+                break;
+            }
+        }
+        material = entry.material;
+        entry.material = nullptr;
+        entry.path.clear();
+        m_free_ids.push_back(id);
+    }
+
+    // the textures of the material are released along with it
+    SAFE_DELETE(material);
+}
+
+bool MaterialRegistry::claimTextureDecode(MaterialID id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Entry& entry = m_entries[id];
+    if (entry.texture_state != MATERIAL_TEXTURES_NOT_DECODED)
+        return false;
+    entry.texture_state = MATERIAL_TEXTURES_DECODING;
+    return true;
+}
+
+void MaterialRegistry::finishTextureDecode(MaterialID id)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_entries[id].texture_state = MATERIAL_TEXTURES_DECODED;
+    }
+    m_decoded.notify_all();
+}
+
+void MaterialRegistry::waitTextureDecode(MaterialID id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_decoded.wait(lock, [this, id] { return m_entries[id].texture_state != MATERIAL_TEXTURES_DECODING; });
+}
+
+OBJMaterial* MaterialRegistry::getMaterial(MaterialID id) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return (id < m_entries.size()) ? m_entries[id].material : nullptr;
+}
+
+unsigned int MaterialRegistry::getNameID(const std::string& name)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return internNameLocked(name);
+}
+
+std::string MaterialRegistry::getName(unsigned int name_id) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return (name_id < m_names.size()) ? m_names[name_id] : std::string();
+}
+
+unsigned int MaterialRegistry::getNumMaterials(void) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return (unsigned int)(m_entries.size() - m_free_ids.size());
+}
+
+unsigned int MaterialRegistry::getNumReferences(void) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    unsigned int references = 0;
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (m_entries[i].material != nullptr)
+            references += m_entries[i].references;
+    }
+    return references;
+}
+
+// eof ///////////////////////////////// class MaterialRegistry
\ No newline at end of file
@@ -0,0 +1,123 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MaterialRegistry.h                           //
+// MaterialRegistry shares identical materials across //
+// meshes and gives each one a small global ID        //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MATERIALREGISTRY_H
+#define MATERIALREGISTRY_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+// defines /////////////////////////////////////////
+#define MATERIAL_REGISTRY_NO_ID     0xFFFFFFFFu
+
+// forward declarations ////////////////////////////
+class OBJMaterial;
+
+// class declarations //////////////////////////////
+
+// global ID of a material. IDs are reused once all the meshes that used a material are released
+typedef unsigned int MaterialID;
+
+enum MaterialTextureState
+{
+    MATERIAL_TEXTURES_NOT_DECODED,
+    MATERIAL_TEXTURES_DECODING,         // a mesh decodes them on a worker thread
+    MATERIAL_TEXTURES_DECODED
+};
+
+// the process-wide set of materials. Materials with the same (interned) name, reflectance properties and
+// texture files (in the same path) are stored once and are reference counted. Thread-safe
+class MaterialRegistry
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    struct Entry
+    {
+        OBJMaterial*                    material;           // nullptr for a free ID
+        std::string                     path;               // the path the texture files are relative to
+        unsigned int                    name_id;
+        unsigned long long              hash;
+        unsigned int                    references;
+        MaterialTextureState            texture_state;
+    };
+
+    // private variable declarations
+    mutable std::mutex                  m_mutex;
+    std::condition_variable             m_decoded;
+    std::vector<Entry>                  m_entries;          // indexed by MaterialID
+    std::vector<MaterialID>             m_free_ids;
+    std::unordered_multimap<unsigned long long, MaterialID> m_lookup; // content hash -> materials
+    std::unordered_map<std::string, unsigned int> m_name_ids;
+    std::vector<std::string>            m_names;            // interned names, indexed by name ID
+
+    // private function declarations
+    unsigned int                        internNameLocked(const std::string& name);
+    bool                                sameContent(const Entry& entry, const OBJMaterial& material, const std::string& path, unsigned int name_id) const;
+
+public:
+    // Constructor
+    MaterialRegistry(void);
+
+    // Destructor (deletes the materials that are still referenced)
+    ~MaterialRegistry(void);
+
+    // public function declarations
+
+    // the process-wide registry
+    static MaterialRegistry&            getInstance(void);
+
+    // takes over a material whose texture files are relative to path. If an identical one is registered,
+    // material is deleted and the existing one is referenced instead. Returns the ID of the registered material
+    MaterialID                          acquire(OBJMaterial* material, const std::string& path);
+
+    // releases a reference to a material. The material is deleted with its last reference
+    void                                release(MaterialID id);
+
+    // a shared material has its textures decoded by a single mesh. Returns true if the caller should decode the
+    // textures of the material now (and call finishTextureDecode after that), false if another mesh has done or is doing so
+    bool                                claimTextureDecode(MaterialID id);
+    void                                finishTextureDecode(MaterialID id);
+    // waits until a material claimed by another mesh has its textures decoded.
+    // a mesh should only wait after it has finished the decodes it claimed, so that no two meshes wait on each other
+    void                                waitTextureDecode(MaterialID id);
+
+    // hash of the name, the reflectance properties and the texture files of a material (not of its texture data)
+    static unsigned long long           hashMaterial(const OBJMaterial& material, const std::string& path);
+
+    // get functions
+    OBJMaterial*                        getMaterial(MaterialID id) const;
+    unsigned int                        getNameID(const std::string& name);
+    std::string                         getName(unsigned int name_id) const;
+    // number of materials currently registered
+    unsigned int                        getNumMaterials(void) const;
+    // number of references to all the materials (the materials the meshes would have without sharing)
+    unsigned int                        getNumReferences(void) const;
+
+    // set functions
+
+};
+
+#endif //MATERIALREGISTRY_H
+
+// eof ///////////////////////////////// class MaterialRegistry
\ No newline at end of file
@@ -0,0 +1,352 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MeshCache.cpp                                //
+// MeshCache stores the final vertex, index, element  //
+// and material data of an OGLMesh in a binary file,  //
+// which is mapped in memory on the next load         //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "MeshCache.h"      // - Header file for the MeshCache class
+
+// file writing helpers ////////////////////////////
+
+static void writeString(FILE* file, const std::string& str)
+{
+    unsigned int length = (unsigned int)str.size();
+    fwrite(&length, sizeof(length), 1, file);
+    fwrite(str.data(), 1, length, file);
+}
+
+// pad the file with zeros up to the next section and return its offset
+static unsigned long long alignSection(FILE* file)
+{
+    static const char zeros[MESH_CACHE_ALIGNMENT] = { 0 };
+    unsigned long long offset = (unsigned long long)ftell(file);
+    size_t padding = (size_t)((MESH_CACHE_ALIGNMENT - offset % MESH_CACHE_ALIGNMENT) % MESH_CACHE_ALIGNMENT);
+    fwrite(zeros, 1, padding, file);
+    return offset + padding;
+}
+
+// read a length-prefixed string. Returns false if it does not fit in the data
+static bool readString(const char*& p, const char* end, std::string& str)
+{
+    unsigned int length;
+    if (end - p < (ptrdiff_t)sizeof(length))
+        return false;
+    memcpy(&length, p, sizeof(length));
+    p += sizeof(length);
+    if (end - p < (ptrdiff_t)length)
+        return false;
+    str.assign(p, length);
+    p += length;
+    return true;
+}
+
+// a section of count items of item_size bytes fits in the file after offset (checked without overflowing)
+static bool fitsInFile(unsigned long long offset, unsigned long long count, unsigned long long item_size, unsigned long long file_size)
+{
+    return offset <= file_size && (item_size == 0 || count <= (file_size - offset) / item_size);
+}
+
+// the element groups of a cache whose sections fit in the file must draw within the index data, with one of the materials,
+// and the indices of each group must be within its vertex range, which must be within the vertex data
+static bool validateElements(const MeshCacheHeader& header, const char* data)
+{
+    const char* indices = data + header.indexdata_offset;
+    unsigned long long num_groups = (unsigned long long)header.num_elements * header.num_lods;
+    for (unsigned long long i = 0; i < num_groups; ++i)
+    {
+        ElementGroup element;
+        memcpy(&element, data + header.elements_offset + i * sizeof(ElementGroup), sizeof(element));
+        if (element.material_index >= header.num_materials ||
+            (unsigned long long)element.start_index + (unsigned long long)element.triangles * 3 > header.num_indexdata)
+            return false;
+        if (element.triangles == 0)
+            continue;
+        if (element.min_vertex > element.max_vertex || element.max_vertex >= header.num_vertexdata)
+            return false;
+        for (GLuint k = element.start_index; k < element.start_index + element.triangles * 3; ++k)
+        {
+            GLuint index = (header.index_type == GL_UNSIGNED_SHORT) ? GLuint(((const GLushort*)indices)[k]) : ((const GLuint*)indices)[k];
+            if (index < element.min_vertex || index > element.max_vertex)
+                return false;
+        }
+    }
+    return true;
+}
+
+// other functions
+std::string MeshCache::getCacheFileName(const std::string& filename, const std::string& path)
+{
+    return path + "\\" + filename + MESH_CACHE_EXTENSION;
+}
+
+bool MeshCache::hashSources(const std::string& path, const std::vector<std::string>& sources, unsigned long long& hash)
+{
+    hash = 0;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (!hashFile(path + "\\" + sources[i], hash, hash))
+            return false;
+    }
+    return true;
+}
+
+bool MeshCache::writeMesh(OGLMesh& mesh, const std::vector<std::string>& sources, flt weld_epsilon)
+{
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!hashSources(mesh.m_path, sources, header.source_hash))
+        return false;
+
+    std::string cache_file = getCacheFileName(mesh.m_fileName, mesh.m_path);
+    FILE* file = nullptr;
+    fopen_s(&file, cache_file.c_str(), "wb");
+    if (file == nullptr)
+    {
+        PrintToOutputWindow("Could not write mesh cache %s", cache_file.c_str());
+        return false;
+    }
+
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.weld_epsilon = weld_epsilon;
+    header.vertex_size = mesh.vertex_format.stride;
+    header.num_sources = (unsigned int)sources.size();
+    header.num_vertexdata = mesh.num_vertexdata;
+    header.num_indexdata = mesh.num_indexdata;
+    header.index_type = mesh.index_type;
+    header.num_elements = mesh.num_elements;
+    header.num_materials = (unsigned int)mesh.materials.size();
+    header.num_primitives = mesh.num_total_primitives;
+    header.vertex_format = mesh.vertex_format.flags;
+    header.format_flags = VERTEX_FORMAT_FLAGS;
+    header.index_optimization = INDEX_OPTIMIZATION;
+    header.lod_count = MESH_LOD_COUNT;
+    header.lod_reduction = MESH_LOD_REDUCTION;
+    header.lod_min_triangles = MESH_LOD_MIN_TRIANGLES;
+    header.num_lods = mesh.num_lods;
+    memcpy(header.lod_errors, mesh.lod_errors, sizeof(header.lod_errors));
+    for (int k = 0; k < 3; ++k)
+    {
+        header.position_offset[k] = mesh.position_offset[k];
+        header.position_scale[k] = mesh.position_scale[k];
+    }
+
+    // the header is written again at the end, when the offsets are known
+    fwrite(&header, sizeof(header), 1, file);
+
+    header.sources_offset = alignSection(file);
+    for (size_t i = 0; i < sources.size(); ++i)
+        writeString(file, sources[i]);
+
+    header.vertexdata_offset = alignSection(file);
+    fwrite(mesh.vertexdata, mesh.vertex_format.stride, mesh.num_vertexdata, file);
+
+    header.indexdata_offset = alignSection(file);
+    fwrite(mesh.indexdata, mesh.index_size, mesh.num_indexdata, file);
+
+    header.elements_offset = alignSection(file);
+    fwrite(mesh.elements, sizeof(ElementGroup), mesh.num_elements * mesh.num_lods, file);
+
+    header.materials_offset = alignSection(file);
+    for (size_t i = 0; i < mesh.materials.size(); ++i)
+    {
+        OBJMaterial& mat = *mesh.materials[i];
+        MeshCacheMaterial record;
+        for (int c = 0; c < 3; ++c)
+        {
+            record.diffuse[c] = mat.m_diffuse[c];
+            record.specular[c] = mat.m_specular[c];
+            record.emission[c] = mat.m_emission[c];
+        }
+        record.gloss = mat.m_gloss;
+        record.opacity = mat.m_opacity;
+        fwrite(&record, sizeof(record), 1, file);
+        writeString(file, mat.m_name);
+        writeString(file, mat.m_diffuse_opacity_tex_file);
+        writeString(file, mat.m_specular_gloss_tex_file);
+        writeString(file, mat.m_emission_tex_file);
+        writeString(file, mat.m_normal_tex_file);
+    }
+
+    header.file_size = (unsigned long long)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+
+    if (!ok)
+    {
+        PrintToOutputWindow("Could not write mesh cache %s", cache_file.c_str());
+        remove(cache_file.c_str());
+        return false;
+    }
+
+    PrintToOutputWindow("Wrote mesh cache %s (%.2f KB)", cache_file.c_str(), header.file_size / 1024.0);
+    return true;
+}
+
+bool MeshCache::readMesh(OGLMesh& mesh, flt weld_epsilon)
+{
+    std::string cache_file = getCacheFileName(mesh.m_fileName, mesh.m_path);
+    MappedFile file;
+    if (!mapFile(cache_file, file))
+        return false;
+
+    const char* data = file.data;
+    const char* end = file.data + file.size;
+    MeshCacheHeader header;
+    bool valid = file.size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, data, sizeof(header));
+        valid = header.magic == MESH_CACHE_MAGIC && header.version == MESH_CACHE_VERSION &&
+                header.file_size == file.size && header.format_flags == VERTEX_FORMAT_FLAGS &&
+                header.index_optimization == INDEX_OPTIMIZATION && header.lod_count == MESH_LOD_COUNT &&
+                header.lod_reduction == MESH_LOD_REDUCTION && header.lod_min_triangles == MESH_LOD_MIN_TRIANGLES &&
+                header.num_lods >= 1 && header.num_lods <= MESH_LOD_MAX_COUNT &&
+                header.vertex_size == getVertexFormat(header.vertex_format).stride &&
+                header.weld_epsilon == weld_epsilon &&
+                (header.index_type == GL_UNSIGNED_SHORT || header.index_type == GL_UNSIGNED_INT) &&
+                fitsInFile(header.vertexdata_offset, header.num_vertexdata, header.vertex_size, file.size) &&
+                fitsInFile(header.indexdata_offset, header.num_indexdata, (header.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint), file.size) &&
+                fitsInFile(header.elements_offset, (unsigned long long)header.num_elements * header.num_lods, sizeof(ElementGroup), file.size) &&
+                header.sources_offset <= file.size && header.materials_offset <= file.size;
+    }
+
+    // the cache is only used if the source files have not changed since it was written
+    std::vector<std::string> sources(valid ? header.num_sources : 0);
+    const char* p = data + (valid ? header.sources_offset : 0);
+    for (size_t i = 0; valid && i < sources.size(); ++i)
+        valid = readString(p, end, sources[i]);
+    unsigned long long source_hash = 0;
+    if (valid)
+        valid = hashSources(mesh.m_path, sources, source_hash) && source_hash == header.source_hash;
+
+    if (!valid)
+    {
+        PrintToOutputWindow("Mesh cache %s is out of date. Rebuilding", cache_file.c_str());
+        unmapFile(file);
+        return false;
+    }
+
+    // the element groups are checked before the footprints, the uploads and the draws read the buffers through them
+    if (!validateElements(header, data))
+    {
+        PrintToOutputWindow("Mesh cache %s is corrupt. Rebuilding", cache_file.c_str());
+        unmapFile(file);
+        return false;
+    }
+
+    mesh.init();
+
+    // materials are small and are copied
+    std::vector<OBJMaterial*> materials;
+    p = data + header.materials_offset;
+    for (unsigned int i = 0; valid && i < header.num_materials; ++i)
+    {
+        OBJMaterial* mat = new OBJMaterial();
+        materials.push_back(mat);
+        MeshCacheMaterial record;
+        valid = end - p >= (ptrdiff_t)sizeof(record);
+        if (!valid)
+            break;
+        memcpy(&record, p, sizeof(record));
+        p += sizeof(record);
+        mat->m_diffuse = glm::vec3(record.diffuse[0], record.diffuse[1], record.diffuse[2]);
+        mat->m_specular = glm::vec3(record.specular[0], record.specular[1], record.specular[2]);
+        mat->m_emission = glm::vec3(record.emission[0], record.emission[1], record.emission[2]);
+        mat->m_gloss = record.gloss;
+        mat->m_opacity = record.opacity;
+        valid = readString(p, end, mat->m_name) &&
+                readString(p, end, mat->m_diffuse_opacity_tex_file) &&
+                readString(p, end, mat->m_specular_gloss_tex_file) &&
+                readString(p, end, mat->m_emission_tex_file) &&
+                readString(p, end, mat->m_normal_tex_file);
+    }
+    if (!valid)
+    {
+        PrintToOutputWindow("Mesh cache %s is corrupt. Rebuilding", cache_file.c_str());
+        for (size_t i = 0; i < materials.size(); ++i)
+            SAFE_DELETE(materials[i]);
+        unmapFile(file);
+        return false;
+    }
+    mesh.setMaterials(materials);
+
+    // the element groups are copied (they are small), the vertex and index data are used in place
+    mesh.num_elements = header.num_elements;
+    mesh.num_lods = header.num_lods;
+    memcpy(mesh.lod_errors, header.lod_errors, sizeof(mesh.lod_errors));
+    size_t num_groups = (size_t)header.num_elements * header.num_lods;
+    mesh.elements = new ElementGroup[num_groups];
+    memcpy(mesh.elements, data + header.elements_offset, num_groups * sizeof(ElementGroup));
+
+    mesh.num_vertexdata = header.num_vertexdata;
+    mesh.num_indexdata = header.num_indexdata;
+    mesh.index_type = header.index_type;
+    mesh.index_size = (header.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    mesh.vertex_format = getVertexFormat(header.vertex_format);
+    mesh.position_offset = glm::vec3(header.position_offset[0], header.position_offset[1], header.position_offset[2]);
+    mesh.position_scale = glm::vec3(header.position_scale[0], header.position_scale[1], header.position_scale[2]);
+    mesh.vertexdata = (GLubyte*)(data + header.vertexdata_offset);
+    mesh.indexdata = (GLubyte*)(data + header.indexdata_offset);
+    mesh.mapped_data = file;
+
+    mesh.num_total_vertices = header.num_vertexdata;
+    mesh.num_total_primitives = header.num_primitives;
+    mesh.num_total_elements = header.num_elements;
+    mesh.weld_epsilon = weld_epsilon;
+    mesh.cached = true;
+
+    return true;
+}
+
+bool MeshCache::readMeshData(OGLMesh& mesh)
+{
+    std::string cache_file = getCacheFileName(mesh.m_fileName, mesh.m_path);
+    MappedFile file;
+    if (!mapFile(cache_file, file))
+        return false;
+
+    // the sources are not hashed again: a cache with the same vertices, indices and element groups holds the uploaded mesh
+    const char* data = file.data;
+    MeshCacheHeader header;
+    bool valid = file.size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, data, sizeof(header));
+        valid = header.magic == MESH_CACHE_MAGIC && header.version == MESH_CACHE_VERSION &&
+                header.file_size == file.size && header.vertex_format == mesh.vertex_format.flags &&
+                header.vertex_size == mesh.vertex_format.stride &&
+                header.weld_epsilon == mesh.weld_epsilon && header.num_vertexdata == (unsigned int)mesh.num_vertexdata &&
+                header.num_indexdata == (unsigned int)mesh.num_indexdata && header.index_type == mesh.index_type &&
+                header.num_elements == (unsigned int)mesh.num_elements && header.num_lods == (unsigned int)mesh.num_lods &&
+                fitsInFile(header.vertexdata_offset, header.num_vertexdata, header.vertex_size, file.size) &&
+                fitsInFile(header.indexdata_offset, header.num_indexdata, mesh.index_size, file.size) &&
+                fitsInFile(header.elements_offset, (unsigned long long)header.num_elements * header.num_lods, sizeof(ElementGroup), file.size) &&
+                memcmp(data + header.elements_offset, mesh.elements, (size_t)header.num_elements * header.num_lods * sizeof(ElementGroup)) == 0;
+    }
+    if (!valid)
+    {
+        PrintToOutputWindow("Mesh cache %s does not hold %s anymore", cache_file.c_str(), mesh.m_fileName.c_str());
+        unmapFile(file);
+        return false;
+    }
+
+    mesh.vertexdata = (GLubyte*)(data + header.vertexdata_offset);
+    mesh.indexdata = (GLubyte*)(data + header.indexdata_offset);
+    mesh.mapped_data = file;
+    return true;
+}
+
+// eof ///////////////////////////////// class MeshCache
\ No newline at end of file
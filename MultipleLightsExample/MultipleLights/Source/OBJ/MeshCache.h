@@ -0,0 +1,122 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MeshCache.h                                  //
+// MeshCache stores the final vertex, index, element  //
+// and material data of an OGLMesh in a binary file,  //
+// which is mapped in memory on the next load         //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+
+
+// defines /////////////////////////////////////////
+#define MESH_CACHE_MAGIC            0x4843534Du     // "MSCH"
+#define MESH_CACHE_VERSION          4               // increase when the layout of the file or of VertexData changes
+#define MESH_CACHE_EXTENSION        ".meshcache"    // the cache is stored next to the .obj file (e.g. skeleton.obj.meshcache)
+#define MESH_CACHE_ALIGNMENT        64              // alignment of each section in the file
+
+// forward declarations ////////////////////////////
+class OGLMesh;
+
+// class declarations //////////////////////////////
+
+// the file starts with this header. Each section starts at its offset from the start of the file:
+// sources:     the .obj and .mtl files the mesh was built from (length-prefixed strings)
+// vertexdata:  num_vertexdata vertices of vertex_format (see VertexFormat.h)
+// indexdata:   num_indexdata indices of index_type
+// elements:    num_elements ElementGroup for each of the num_lods levels of detail
+// materials:   num_materials MeshCacheMaterial, each followed by its name and texture files (length-prefixed strings)
+struct MeshCacheHeader
+{
+    unsigned int                        magic;
+    unsigned int                        version;
+    unsigned long long                  source_hash;        // hash of the contents of all the source files
+    unsigned long long                  file_size;          // detects incomplete files
+    flt                                 weld_epsilon;       // the weld epsilon the mesh was built with
+    unsigned int                        vertex_size;        // the stride of vertex_format
+    unsigned int                        num_sources;
+    unsigned int                        num_vertexdata;
+    unsigned int                        num_indexdata;
+    unsigned int                        index_type;
+    unsigned int                        num_elements;
+    unsigned int                        num_materials;
+    unsigned int                        num_primitives;
+    unsigned int                        vertex_format;      // the flags of the format of the vertices
+    unsigned int                        format_flags;       // VERTEX_FORMAT_FLAGS the mesh was built with (a cache built with other ones is rebuilt)
+    unsigned int                        index_optimization; // INDEX_OPTIMIZATION the mesh was built with
+    float                               position_offset[3]; // the bounds of the positions of a compact format
+    float                               position_scale[3];
+    unsigned int                        lod_count;          // MESH_LOD_COUNT, MESH_LOD_REDUCTION and MESH_LOD_MIN_TRIANGLES the mesh was built with
+    float                               lod_reduction;
+    unsigned int                        lod_min_triangles;
+    unsigned int                        num_lods;           // the levels of detail that were built (their triangles follow the ones of the mesh in indexdata)
+    float                               lod_errors[MESH_LOD_MAX_COUNT];
+    unsigned long long                  sources_offset;
+    unsigned long long                  vertexdata_offset;
+    unsigned long long                  indexdata_offset;
+    unsigned long long                  elements_offset;
+    unsigned long long                  materials_offset;
+};
+
+struct MeshCacheMaterial
+{
+    float                               diffuse[3];
+    float                               specular[3];
+    float                               emission[3];
+    float                               gloss;
+    float                               opacity;
+};
+
+class MeshCache
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+
+
+    // private function declarations
+    static bool                         hashSources(const std::string& path, const std::vector<std::string>& sources, unsigned long long& hash);
+
+public:
+    // public function declarations
+
+    // the name of the cache file of a mesh
+    static std::string                  getCacheFileName(const std::string& filename, const std::string& path);
+
+    // writes the CPU data of a mesh built from the given source files (relative to the path of the mesh)
+    static bool                         writeMesh(OGLMesh& mesh, const std::vector<std::string>& sources, flt weld_epsilon);
+
+    // maps the cache of a mesh and points its CPU data to it. No per-vertex work is done.
+    // returns false if there is no cache, or if it is out of date (the mesh should be rebuilt then)
+    static bool                         readMesh(OGLMesh& mesh, flt weld_epsilon);
+
+    // maps the cache of a mesh whose CPU data has been released (see OGLMesh::releaseCPUData) and points the vertex and index
+    // data to it again. Returns false if there is no cache, or if it does not hold the same mesh anymore
+    static bool                         readMeshData(OGLMesh& mesh);
+
+    // get functions
+
+
+    // set functions
+
+};
+
+#endif //MESHCACHE_H
+
+// eof ///////////////////////////////// class MeshCache
\ No newline at end of file
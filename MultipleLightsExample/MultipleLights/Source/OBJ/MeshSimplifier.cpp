@@ -0,0 +1,527 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MeshSimplifier.cpp                           //
+// Generation of the levels of detail of a welded     //
+// mesh by quadric error edge collapses               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "MeshSimplifier.h" // - Header file for the mesh simplification
+
+#include <algorithm>        // - Header file for find and sort
+#include <queue>            // - Header file for priority_queue
+#include <cfloat>           // - Header file for FLT_MAX
+
+// defines /////////////////////////////////////////
+#define SIMPLIFIER_MIN_AREA_RATIO   1.0e-6f         // a moved triangle may not shrink below this fraction of its area
+
+// the symmetric 4x4 matrix of the sum of the squared distances from a set of planes, and the area of the triangles of the planes
+struct Quadric
+{
+    double                              a00, a01, a02, a11, a12, a22;
+    double                              b0, b1, b2;
+    double                              c;
+    double                              area;
+
+    // the plane of the points x with dot(n, x) + d = 0, with a weight
+    void                                addPlane(const glm::vec3& n, float d, double weight)
+    {
+        a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+        a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+        b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+        c += weight * d * d;
+    }
+    void                                add(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        area += q.area;
+    }
+    double                              evaluate(const glm::vec3& v) const
+    {
+        double x = v.x, y = v.y, z = v.z;
+        return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + a11 * y * y + 2.0 * a12 * y * z + a22 * z * z +
+               2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    }
+};
+
+// the distance of a point from a triangle (Ericson, "Real-Time Collision Detection", 5.1.5)
+static float getTriangleDistance(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return glm::length(ap);
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return glm::length(bp);
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return glm::length(cp);
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+    float denominator = va + vb + vc;
+    if (denominator <= 0.0f)
+        return glm::length(ap);
+    return glm::length(p - (a + ab * (vb / denominator) + ac * (vc / denominator)));
+}
+
+// the collapse of all the vertices at a position onto the ones at a neighbouring position
+struct Collapse
+{
+    double                              cost;
+    GLuint                              from;
+    GLuint                              to;
+
+    bool                                operator>(const Collapse& other) const {return cost > other.cost;}
+};
+
+// the state of the simplification of a mesh: its triangles, grouped by the positions they use. The vertices that share a
+// position (across a UV seam, a normal crease or a material boundary) are collapsed together
+class Simplifier
+{
+public:
+    Simplifier(const VertexData* vertices, const GLuint* indices, const GLuint* group_triangles, GLuint num_groups);
+
+    // collapses edges until the mesh has at most target triangles, or no edge can be collapsed
+    void                                simplify(GLuint target);
+    // the triangles left, in the order of their groups
+    void                                getLevel(SimplifiedLevel& level) const;
+    GLuint                              getNumTriangles(void) const {return m_num_alive;}
+    // the largest distance of a collapsed position from the triangles around the position it ended up at. The other positions
+    // are corners of the triangles, so this is the largest distance of a vertex of the mesh from the triangles left (or more,
+    // when nearer triangles are further around)
+    float                               measureError(void) const;
+
+private:
+    int                                 cornerOf(GLuint t, GLuint p) const;
+    void                                getNeighbours(GLuint p, std::vector<GLuint>& neighbours) const;
+    bool                                isFeatureEdge(GLuint p, GLuint q) const;
+    // whether the vertices at p can be collapsed onto the ones at q, and the vertex each one of them becomes
+    bool                                canCollapse(GLuint p, GLuint q, std::vector<std::pair<GLuint, GLuint> >& wedges);
+    void                                collapse(GLuint p, GLuint q, const std::vector<std::pair<GLuint, GLuint> >& wedges);
+    double                              getCost(GLuint p, GLuint q) const {return glm::max(m_quadrics[p].evaluate(m_positions[q]), 0.0);}
+    void                                pushEdges(GLuint p);
+
+    std::vector<GLuint>                 m_triangles;        // the vertices of each triangle, as they are collapsed
+    std::vector<GLuint>                 m_groups;           // the group of each triangle
+    std::vector<GLuint>                 m_group_starts;     // the first triangle of each group
+    std::vector<char>                   m_alive;
+    GLuint                              m_num_alive;
+    std::vector<GLuint>                 m_vertex_positions; // the position of each vertex
+    std::vector<glm::vec3>              m_positions;
+    std::vector<Quadric>                m_quadrics;         // of each position
+    std::vector<std::vector<GLuint> >   m_position_triangles; // the live triangles of each position (the ones of a collapsed position move to its target)
+    std::vector<char>                   m_removed;          // the collapsed positions
+    std::vector<GLuint>                 m_collapsed_to;     // the position each collapsed position was collapsed onto
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > m_queue;
+    float                               m_error;            // the largest quadric error of a collapse so far (the area-weighted RMS distance from the planes)
+
+    // scratch buffers
+    std::vector<GLuint>                 m_neighbours, m_other_neighbours, m_features;
+};
+
+Simplifier::Simplifier(const VertexData* vertices, const GLuint* indices, const GLuint* group_triangles, GLuint num_groups):
+    m_num_alive(0),
+    m_error(0.0f)
+{
+    GLuint num_triangles = 0;
+    for (GLuint g = 0; g < num_groups; ++g)
+    {
+        m_group_starts.push_back(num_triangles);
+        m_groups.insert(m_groups.end(), group_triangles[g], g);
+        num_triangles += group_triangles[g];
+    }
+    m_group_starts.push_back(num_triangles);
+    m_triangles.assign(indices, indices + num_triangles * 3);
+
+    // the vertices with the same position share it
+    GLuint num_vertices = 0;
+    for (GLuint i = 0; i < num_triangles * 3; ++i)
+        num_vertices = glm::max(num_vertices, m_triangles[i] + 1);
+    m_vertex_positions.assign(num_vertices, 0);
+    std::vector<GLuint> sorted(num_vertices);
+    for (GLuint v = 0; v < num_vertices; ++v)
+        sorted[v] = v;
+    auto less = [&](GLuint a, GLuint b)
+    {
+        const GLfloat* pa = vertices[a].position;
+        const GLfloat* pb = vertices[b].position;
+        return (pa[0] != pb[0]) ? pa[0] < pb[0] : (pa[1] != pb[1]) ? pa[1] < pb[1] : pa[2] < pb[2];
+    };
+    std::sort(sorted.begin(), sorted.end(), less);
+    for (GLuint i = 0; i < num_vertices; ++i)
+    {
+        const GLfloat* p = vertices[sorted[i]].position;
+        if (i == 0 || less(sorted[i - 1], sorted[i]))
+            m_positions.push_back(glm::vec3(p[0], p[1], p[2]));
+        m_vertex_positions[sorted[i]] = (GLuint)m_positions.size() - 1;
+    }
+    GLuint num_positions = (GLuint)m_positions.size();
+
+    Quadric zero;
+    memset(&zero, 0, sizeof(zero));
+    m_quadrics.assign(num_positions, zero);
+    m_position_triangles.resize(num_positions);
+    m_removed.assign(num_positions, 0);
+    m_collapsed_to.assign(num_positions, 0);
+    m_alive.assign(num_triangles, 0);
+
+    // the planes of the triangles, weighted by their area. Triangles with two corners at the same position are left out
+    for (GLuint t = 0; t < num_triangles; ++t)
+    {
+        GLuint a = m_vertex_positions[m_triangles[t * 3]], b = m_vertex_positions[m_triangles[t * 3 + 1]], c = m_vertex_positions[m_triangles[t * 3 + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        m_alive[t] = 1;
+        m_num_alive++;
+        m_position_triangles[a].push_back(t);
+        m_position_triangles[b].push_back(t);
+        m_position_triangles[c].push_back(t);
+
+        glm::vec3 n = glm::cross(m_positions[b] - m_positions[a], m_positions[c] - m_positions[a]);
+        float length = glm::length(n);
+        if (length <= 0.0f)
+            continue;
+        n /= length;
+        for (int k = 0; k < 3; ++k)
+        {
+            Quadric& q = m_quadrics[m_vertex_positions[m_triangles[t * 3 + k]]];
+            q.addPlane(n, -glm::dot(n, m_positions[a]), 0.5 * length);
+            q.area += 0.5 * length;
+        }
+    }
+
+    // the planes through the feature edges, perpendicular to their triangles, keep the features from moving sideways
+    for (GLuint t = 0; t < num_triangles; ++t)
+    {
+        if (!m_alive[t])
+            continue;
+        GLuint corners[3] = { m_vertex_positions[m_triangles[t * 3]], m_vertex_positions[m_triangles[t * 3 + 1]], m_vertex_positions[m_triangles[t * 3 + 2]] };
+        glm::vec3 n = glm::cross(m_positions[corners[1]] - m_positions[corners[0]], m_positions[corners[2]] - m_positions[corners[0]]);
+        if (glm::length(n) <= 0.0f)
+            continue;
+        for (int k = 0; k < 3; ++k)
+        {
+            GLuint p = corners[k], q = corners[(k + 1) % 3];
+            if (!isFeatureEdge(p, q))
+                continue;
+            glm::vec3 edge = m_positions[q] - m_positions[p];
+            glm::vec3 normal = glm::cross(edge, n);
+            float length = glm::length(normal);
+            if (length <= 0.0f)
+                continue;
+            normal /= length;
+            double weight = MESH_LOD_FEATURE_WEIGHT * glm::dot(edge, edge);
+            m_quadrics[p].addPlane(normal, -glm::dot(normal, m_positions[p]), weight);
+            m_quadrics[q].addPlane(normal, -glm::dot(normal, m_positions[p]), weight);
+        }
+    }
+}
+
+int Simplifier::cornerOf(GLuint t, GLuint p) const
+{
+    for (int k = 0; k < 3; ++k)
+        if (m_vertex_positions[m_triangles[t * 3 + k]] == p)
+            return k;
+    return -1;
+}
+
+void Simplifier::getNeighbours(GLuint p, std::vector<GLuint>& neighbours) const
+{
+    neighbours.clear();
+    const std::vector<GLuint>& triangles = m_position_triangles[p];
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        GLuint t = triangles[i];
+        for (int k = 0; k < 3; ++k)
+        {
+            GLuint n = m_vertex_positions[m_triangles[t * 3 + k]];
+            if (n != p && std::find(neighbours.begin(), neighbours.end(), n) == neighbours.end())
+                neighbours.push_back(n);
+        }
+    }
+}
+
+bool Simplifier::isFeatureEdge(GLuint p, GLuint q) const
+{
+    // an edge with other than two triangles, whose triangles belong to different groups, or use different vertices
+    GLuint count = 0, group = 0, vp = 0, vq = 0;
+    const std::vector<GLuint>& triangles = m_position_triangles[p];
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        GLuint t = triangles[i];
+        int cq = cornerOf(t, q);
+        if (cq < 0)
+            continue;
+        GLuint a = m_triangles[t * 3 + cornerOf(t, p)], b = m_triangles[t * 3 + cq];
+        if (count == 0)
+        {
+            group = m_groups[t];
+            vp = a;
+            vq = b;
+        }
+        else if (m_groups[t] != group || a != vp || b != vq)
+            return true;
+        count++;
+    }
+    return count != 2;
+}
+
+bool Simplifier::canCollapse(GLuint p, GLuint q, std::vector<std::pair<GLuint, GLuint> >& wedges)
+{
+    if (m_removed[p] || m_removed[q])
+        return false;
+
+    // a vertex on a feature moves along it only, and one where features meet or end does not move at all
+    getNeighbours(p, m_neighbours);
+    if (std::find(m_neighbours.begin(), m_neighbours.end(), q) == m_neighbours.end())
+        return false;
+    m_features.clear();
+    for (size_t i = 0; i < m_neighbours.size(); ++i)
+        if (isFeatureEdge(p, m_neighbours[i]))
+            m_features.push_back(m_neighbours[i]);
+    if (!m_features.empty() && (m_features.size() != 2 || std::find(m_features.begin(), m_features.end(), q) == m_features.end()))
+        return false;
+
+    // the positions next to both must be the third corners of the triangles of the edge, or the mesh would fold onto itself
+    getNeighbours(q, m_other_neighbours);
+    GLuint common = 0, edge_triangles = 0;
+    for (size_t i = 0; i < m_neighbours.size(); ++i)
+        if (std::find(m_other_neighbours.begin(), m_other_neighbours.end(), m_neighbours[i]) != m_other_neighbours.end())
+            common++;
+
+    // each vertex at p becomes the vertex at q its triangles of the edge use
+    wedges.clear();
+    const std::vector<GLuint>& triangles = m_position_triangles[p];
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        GLuint t = triangles[i];
+        int cq = cornerOf(t, q);
+        if (cq < 0)
+            continue;
+        edge_triangles++;
+        GLuint wp = m_triangles[t * 3 + cornerOf(t, p)], wq = m_triangles[t * 3 + cq];
+        size_t w = 0;
+        while (w < wedges.size() && wedges[w].first != wp)
+            w++;
+        if (w == wedges.size())
+            wedges.push_back(std::make_pair(wp, wq));
+        else if (wedges[w].second != wq)
+            return false;
+    }
+    if (common != edge_triangles)
+        return false;
+
+    // the triangles that stay must keep their vertices (a vertex at p none of whose triangles reaches q cannot move) and must not flip
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        GLuint t = triangles[i];
+        if (cornerOf(t, q) >= 0)
+            continue;
+        int cp = cornerOf(t, p);
+        GLuint wp = m_triangles[t * 3 + cp];
+        size_t w = 0;
+        while (w < wedges.size() && wedges[w].first != wp)
+            w++;
+        if (w == wedges.size())
+            return false;
+
+        glm::vec3 corners[3];
+        for (int k = 0; k < 3; ++k)
+            corners[k] = m_positions[m_vertex_positions[m_triangles[t * 3 + k]]];
+        glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+        corners[cp] = m_positions[q];
+        glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+        float area_before = glm::length(before);
+        if (area_before > 0.0f && (glm::dot(before, after) <= 0.0f || glm::length(after) < SIMPLIFIER_MIN_AREA_RATIO * area_before))
+            return false;
+    }
+    return true;
+}
+
+void Simplifier::collapse(GLuint p, GLuint q, const std::vector<std::pair<GLuint, GLuint> >& wedges)
+{
+    std::vector<GLuint>& triangles = m_position_triangles[p];
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        GLuint t = triangles[i];
+        if (cornerOf(t, q) >= 0)
+        {
+            // the triangles of the edge are removed, from the lists of q and of their third corner too
+            m_alive[t] = 0;
+            m_num_alive--;
+            for (int k = 0; k < 3; ++k)
+            {
+                GLuint r = m_vertex_positions[m_triangles[t * 3 + k]];
+                if (r == p)
+                    continue;
+                std::vector<GLuint>& others = m_position_triangles[r];
+                others.erase(std::find(others.begin(), others.end(), t));
+            }
+            continue;
+        }
+        int cp = cornerOf(t, p);
+        for (size_t w = 0; w < wedges.size(); ++w)
+            if (wedges[w].first == m_triangles[t * 3 + cp])
+                m_triangles[t * 3 + cp] = wedges[w].second;
+        m_position_triangles[q].push_back(t);
+    }
+    std::vector<GLuint>().swap(triangles);
+
+    m_error = glm::max(m_error, float(sqrt(getCost(p, q) / glm::max(m_quadrics[p].area, 1.0e-30))));
+    m_quadrics[q].add(m_quadrics[p]);
+    m_removed[p] = 1;
+    m_collapsed_to[p] = q;
+}
+
+void Simplifier::pushEdges(GLuint p)
+{
+    getNeighbours(p, m_neighbours);
+    for (size_t i = 0; i < m_neighbours.size(); ++i)
+    {
+        GLuint n = m_neighbours[i];
+        m_queue.push({ getCost(p, n), p, n });
+        m_queue.push({ getCost(n, p), n, p });
+    }
+}
+
+void Simplifier::simplify(GLuint target)
+{
+    // the costs of the queue are updated when they are taken out of it. The collapses that are not possible are dropped, and are
+    // queued again when a neighbouring collapse changes them. When the queue runs out, all the edges are queued once more
+    std::vector<std::pair<GLuint, GLuint> > wedges;
+    bool collapsed = true;
+    while (m_num_alive > target)
+    {
+        if (m_queue.empty())
+        {
+            if (!collapsed)
+                break;
+            collapsed = false;
+            for (GLuint p = 0; p < (GLuint)m_positions.size(); ++p)
+            {
+                if (m_removed[p])
+                    continue;
+                getNeighbours(p, m_neighbours);
+                for (size_t i = 0; i < m_neighbours.size(); ++i)
+                    m_queue.push({ getCost(p, m_neighbours[i]), p, m_neighbours[i] });
+            }
+            continue;
+        }
+
+        Collapse next = m_queue.top();
+        m_queue.pop();
+        if (m_removed[next.from] || m_removed[next.to])
+            continue;
+        double cost = getCost(next.from, next.to);
+        if (cost > next.cost * (1.0 + 1.0e-6) + 1.0e-30)
+        {
+            next.cost = cost;
+            m_queue.push(next);
+            continue;
+        }
+        if (!canCollapse(next.from, next.to, wedges))
+            continue;
+
+        collapse(next.from, next.to, wedges);
+        pushEdges(next.to);
+        collapsed = true;
+    }
+}
+
+float Simplifier::measureError(void) const
+{
+    float error = 0.0f;
+    for (GLuint p = 0; p < (GLuint)m_positions.size(); ++p)
+    {
+        if (!m_removed[p])
+            continue;
+        GLuint root = m_collapsed_to[p];
+        while (m_removed[root])
+            root = m_collapsed_to[root];
+
+        const std::vector<GLuint>& triangles = m_position_triangles[root];
+        float distance = FLT_MAX;
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            const GLuint* corners = &m_triangles[triangles[i] * 3];
+            distance = glm::min(distance, getTriangleDistance(m_positions[p], m_positions[m_vertex_positions[corners[0]]],
+                                                              m_positions[m_vertex_positions[corners[1]]], m_positions[m_vertex_positions[corners[2]]]));
+        }
+        if (!triangles.empty())
+            error = glm::max(error, distance);
+    }
+    return error;
+}
+
+void Simplifier::getLevel(SimplifiedLevel& level) const
+{
+    level.indices.clear();
+    level.group_triangles.assign(m_group_starts.size() - 1, 0);
+    for (GLuint g = 0; g + 1 < (GLuint)m_group_starts.size(); ++g)
+    {
+        for (GLuint t = m_group_starts[g]; t < m_group_starts[g + 1]; ++t)
+        {
+            if (!m_alive[t])
+                continue;
+            level.indices.insert(level.indices.end(), &m_triangles[t * 3], &m_triangles[t * 3] + 3);
+            level.group_triangles[g]++;
+        }
+    }
+    // the quadric error is an average over the planes, so the distance is measured as well
+    level.error = glm::max(m_error, measureError());
+}
+
+void buildLevelsOfDetail(const VertexData* vertices, const GLuint* indices, const GLuint* group_triangles, GLuint num_groups,
+                         std::vector<SimplifiedLevel>& levels, GLuint max_levels, float reduction, GLuint min_triangles)
+{
+    levels.clear();
+    GLuint num_triangles = 0;
+    for (GLuint g = 0; g < num_groups; ++g)
+        num_triangles += group_triangles[g];
+    max_levels = glm::min(max_levels, GLuint(MESH_LOD_MAX_COUNT - 1));
+    if (max_levels == 0 || GLuint(num_triangles * reduction) < min_triangles)
+        return;
+
+    // each level continues the collapses of the previous one
+    Simplifier simplifier(vertices, indices, group_triangles, num_groups);
+    GLuint previous = num_triangles;
+    while (levels.size() < max_levels)
+    {
+        GLuint target = GLuint(previous * reduction);
+        if (target < min_triangles)
+            break;
+        simplifier.simplify(target);
+
+        // a level that removes less than half the triangles it should is not worth its indices (the features are left)
+        GLuint reached = simplifier.getNumTriangles();
+        if (previous - reached < (previous - target) / 2)
+            break;
+        levels.push_back(SimplifiedLevel());
+        simplifier.getLevel(levels.back());
+        // a coarser level is never selected for a smaller error
+        if (levels.size() > 1)
+            levels.back().error = glm::max(levels.back().error, levels[levels.size() - 2].error);
+        previous = reached;
+    }
+}
+
+// eof ///////////////////////////////// MeshSimplifier
\ No newline at end of file
@@ -0,0 +1,57 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MeshSimplifier.h                             //
+// Generation of the levels of detail of a welded     //
+// mesh by quadric error edge collapses               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+// HelpLib.h should be included first (for glm and the GL types)
+
+
+// defines /////////////////////////////////////////
+#define MESH_LOD_MAX_COUNT          8               // the most levels of detail a mesh (and its cache) can have
+#define MESH_LOD_COUNT              5               // the levels of detail built for each mesh, the first of which is the mesh itself (1 builds none)
+#define MESH_LOD_REDUCTION          0.5f            // the triangles of each level relative to the previous one
+#define MESH_LOD_MIN_TRIANGLES      64              // no level with fewer triangles is built
+#define MESH_LOD_FEATURE_WEIGHT     4.0f            // the weight of the planes that keep the borders, the UV seams and the material boundaries in place
+
+// forward declarations ////////////////////////////
+struct VertexData;
+
+// class declarations //////////////////////////////
+
+// a simplified version of a mesh, using a subset of its vertices
+struct SimplifiedLevel
+{
+    std::vector<GLuint>                 indices;            // the triangles, in the order of the groups
+    std::vector<GLuint>                 group_triangles;    // the triangles of each group
+    // the largest distance of a vertex of the mesh from the triangles of the level, in object space (it is measured at the
+    // vertices, so the surface between them may deviate a little more)
+    float                               error;
+};
+
+// builds the levels of detail of a mesh whose triangles are grouped (group g has group_triangles[g] triangles, following the
+// ones of the previous group). Each level has about reduction times the triangles of the previous one, and they are built one
+// from the other by collapsing the edges of the least quadric error (Garland and Heckbert, "Surface Simplification Using Quadric
+// Error Metrics") onto one of their vertices, so the levels use the vertices of the mesh as they are.
+// The open borders, the UV seams and normal creases (where the triangles on the two sides use different vertices) and the
+// boundaries between the groups are only simplified along themselves, and a triangle never changes its group.
+// Stops at max_levels levels (besides the mesh) or when no level of at least min_triangles triangles can be built
+void buildLevelsOfDetail(const VertexData* vertices, const GLuint* indices, const GLuint* group_triangles, GLuint num_groups,
+                         std::vector<SimplifiedLevel>& levels, GLuint max_levels = MESH_LOD_COUNT - 1,
+                         float reduction = MESH_LOD_REDUCTION, GLuint min_triangles = MESH_LOD_MIN_TRIANGLES);
+
+#endif //MESHSIMPLIFIER_H
+
+// eof ///////////////////////////////// MeshSimplifier
\ No newline at end of file
@@ -0,0 +1,260 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MeshStreamer.cpp                             //
+// MeshStreamer loads meshes in the background. Files //
+// are parsed and textures are decoded on worker      //
+// threads and the OpenGL uploads are spread across   //
+// frames within a byte budget                        //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OBJMaterial.h"    // - Header file for the OBJMaterial class
+#include "OBJLoader.h"      // - Header file for the OBJLoader class
+#include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "MeshStreamer.h"   // - Header file for the MeshStreamer class
+#include "TextureStreamer.h" // - Header file for the TextureStreamer class
+#include "ResidencyManager.h" // - Header file for the ResidencyManager class
+
+#include <algorithm>        // - Header file for min
+
+// Constructor
+MeshRequest::MeshRequest(const std::string& filename, const std::string& path, bool use_mipmaps):
+    m_filename(filename),
+    m_path(path),
+    m_use_mipmaps(use_mipmaps),
+    m_state(MESH_REQUEST_QUEUED),
+    m_mesh(nullptr),
+    m_released(false),
+    m_buffers_created(false),
+    m_uploaded_vertex_bytes(0),
+    m_uploaded_index_bytes(0),
+    m_uploaded_bytes(0),
+    m_upload_frames(0),
+    m_request_time(std::chrono::high_resolution_clock::now()),
+    m_load_ms(0)
+{
+
+}
+
+// Constructor
+MeshStreamer::MeshStreamer(size_t upload_budget):
+    m_pool(MESH_STREAMER_NUM_THREADS + 1),
+    m_cancel(false),
+    m_upload_budget(upload_budget),
+    m_uploaded_bytes(0)
+{
+
+}
+
+// Destructor
+MeshStreamer::~MeshStreamer(void)
+{
+    // queued loads exit at once, running ones are waited for
+    m_cancel = true;
+    for (size_t i = 0; i < m_requests.size(); ++i)
+    {
+        if (m_requests[i]->m_task.valid())
+            m_requests[i]->m_task.wait();
+        deleteRequest(m_requests[i]);
+    }
+    m_requests.clear();
+}
+
+// other functions
+MeshRequest* MeshStreamer::requestMesh(const std::string& filename, const std::string& path, bool use_mipmaps)
+{
+    MeshRequest* request = new MeshRequest(filename, path, use_mipmaps);
+    m_requests.push_back(request);
+    request->m_task = m_pool.enqueue([this, request] { loadRequest(request); });
+    return request;
+}
+
+void MeshStreamer::loadRequest(MeshRequest* request)
+{
+    if (m_cancel)
+    {
+        request->m_state = MESH_REQUEST_FAILED;
+        return;
+    }
+
+    request->m_state = MESH_REQUEST_LOADING;
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+
+    // everything here is done on the CPU, the OpenGL calls are made in update
+    OBJLoader loader;
+    OGLMesh* mesh = loader.buildMesh(request->m_filename, request->m_path);
+    if (mesh == nullptr)
+    {
+        PrintToOutputWindow("Could not stream %s", request->m_filename.c_str());
+        request->m_state = MESH_REQUEST_FAILED;
+        return;
+    }
+    mesh->decodeTextures(request->m_use_mipmaps);
+    request->m_mesh = mesh;
+    request->m_load_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_loaded.push_back(request);
+}
+
+size_t MeshStreamer::uploadRequest(MeshRequest* request, size_t budget, bool first)
+{
+    OGLMesh* mesh = request->m_mesh;
+    size_t used = 0;
+
+    if (!request->m_buffers_created)
+    {
+        mesh->uploadToOpenGL(false);
+        request->m_buffers_created = true;
+    }
+
+    // the buffers are filled in parts of at most the remaining budget
+    size_t vertex_bytes = mesh->getVertexDataSize();
+    if (request->m_uploaded_vertex_bytes < vertex_bytes && used < budget)
+    {
+        size_t size = (std::min)(vertex_bytes - request->m_uploaded_vertex_bytes, budget - used);
+        mesh->uploadVertexData(request->m_uploaded_vertex_bytes, size);
+        request->m_uploaded_vertex_bytes += size;
+        used += size;
+    }
+
+    size_t index_bytes = mesh->getIndexDataSize();
+    if (request->m_uploaded_index_bytes < index_bytes && used < budget)
+    {
+        size_t size = (std::min)(index_bytes - request->m_uploaded_index_bytes, budget - used);
+        mesh->uploadIndexData(request->m_uploaded_index_bytes, size);
+        request->m_uploaded_index_bytes += size;
+        used += size;
+    }
+
+    if (request->m_uploaded_vertex_bytes < vertex_bytes || request->m_uploaded_index_bytes < index_bytes)
+        return used;
+
+    // textures are uploaded whole. One that is larger than the budget is uploaded alone, at the start of a frame
+    bool textures_left = true;
+    while (used < budget && textures_left)
+    {
+        size_t size = 0;
+        size_t max_bytes = (first && used == 0) ? (size_t)-1 : budget - used;
+        textures_left = mesh->uploadNextTexture(max_bytes, size);
+        if (size == 0)
+            break;
+        used += size;
+    }
+
+    if (!textures_left)
+    {
+        if (glError())
+        {
+            PrintToOutputWindow("An OpenGL error was generated while streaming %s. Skipping", request->m_filename.c_str());
+            request->m_state = MESH_REQUEST_FAILED;
+        }
+        else
+        {
+            mesh->updated = true;
+            mesh->finishUpload();
+            request->m_state = MESH_REQUEST_READY;
+        }
+    }
+
+    return used;
+}
+
+void MeshStreamer::update(void)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_loaded.empty())
+        {
+            MeshRequest* request = m_loaded.front();
+            m_loaded.pop_front();
+            request->m_state = MESH_REQUEST_UPLOADING;
+            m_uploads.push_back(request);
+        }
+    }
+
+    m_uploaded_bytes = 0;
+    while (!m_uploads.empty() && m_uploaded_bytes < m_upload_budget)
+    {
+        MeshRequest* request = m_uploads.front();
+        if (!request->m_released)
+        {
+            bool first = m_uploaded_bytes == 0;
+            size_t used = uploadRequest(request, m_upload_budget - m_uploaded_bytes, first);
+            m_uploaded_bytes += used;
+            request->m_uploaded_bytes += used;
+            request->m_upload_frames++;
+            // the budget is used up, or the next texture does not fit in the rest of this frame
+            if (request->getState() == MESH_REQUEST_UPLOADING)
+                break;
+
+            if (request->isReady())
+            {
+                double ready_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - request->m_request_time).count();
+                PrintToOutputWindow("Streamed %s mesh. Total elements: %d, total primitives: %d, total vertices: %d. Loaded in %.2f ms, uploaded %.2f KB in %d frame(s), ready %.2f ms after the request",
+                    request->m_filename.c_str(), request->m_mesh->getNumElements(), request->m_mesh->getNumPrimitives(), request->m_mesh->getNumVertices(),
+                    request->m_load_ms, request->m_uploaded_bytes / 1024.0, request->m_upload_frames, ready_ms);
+            }
+        }
+        m_uploads.pop_front();
+    }
+
+    // the finer texture levels get the rest of the budget
+    size_t texture_budget = (m_uploaded_bytes < m_upload_budget) ? m_upload_budget - m_uploaded_bytes : 0;
+    m_uploaded_bytes += TextureStreamer::getInstance().update(texture_budget, m_uploaded_bytes == 0);
+
+    // the evicted meshes and textures drawn in the last frame are restored with what is left, and the least recently drawn
+    // ones are evicted if the GPU memory is over its budget
+    size_t residency_budget = (m_uploaded_bytes < m_upload_budget) ? m_upload_budget - m_uploaded_bytes : 0;
+    m_uploaded_bytes += ResidencyManager::getInstance().update(residency_budget, m_uploaded_bytes == 0);
+
+    // delete the released requests that the workers are done with
+    for (size_t i = 0; i < m_requests.size(); )
+    {
+        MeshRequest* request = m_requests[i];
+        MeshRequestState state = request->getState();
+        bool in_use = state == MESH_REQUEST_QUEUED || state == MESH_REQUEST_LOADING ||
+                      std::find(m_uploads.begin(), m_uploads.end(), request) != m_uploads.end();
+        if (request->m_released && !in_use)
+        {
+            deleteRequest(request);
+            m_requests.erase(m_requests.begin() + i);
+        }
+        else
+            ++i;
+    }
+}
+
+void MeshStreamer::releaseMesh(MeshRequest* request)
+{
+    if (request != nullptr)
+        request->m_released = true;
+}
+
+void MeshStreamer::deleteRequest(MeshRequest* request)
+{
+    if (request->m_mesh != nullptr)
+        request->m_mesh->release();
+    SAFE_DELETE(request->m_mesh);
+    SAFE_DELETE(request);
+}
+
+unsigned int MeshStreamer::getNumPending(void) const
+{
+    unsigned int pending = 0;
+    for (size_t i = 0; i < m_requests.size(); ++i)
+    {
+        MeshRequestState state = m_requests[i]->getState();
+        if (state != MESH_REQUEST_READY && state != MESH_REQUEST_FAILED)
+            ++pending;
+    }
+    return pending;
+}
+
+// eof ///////////////////////////////// class MeshStreamer
\ No newline at end of file
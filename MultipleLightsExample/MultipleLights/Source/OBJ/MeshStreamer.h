@@ -0,0 +1,134 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MeshStreamer.h                               //
+// MeshStreamer loads meshes in the background. Files //
+// are parsed and textures are decoded on worker      //
+// threads and the OpenGL uploads are spread across   //
+// frames within a byte budget                        //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MESHSTREAMER_H
+#define MESHSTREAMER_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+#include <chrono>           // - Header file for timing the requests
+
+// defines /////////////////////////////////////////
+#define MESH_STREAMER_NUM_THREADS       2                   // background loading threads (separate from the parallelFor pool)
+#define MESH_STREAMER_UPLOAD_BUDGET     (2 * 1024 * 1024)   // default bytes uploaded to OpenGL per frame
+
+// forward declarations ////////////////////////////
+class OGLMesh;
+
+// class declarations //////////////////////////////
+
+enum MeshRequestState
+{
+    MESH_REQUEST_QUEUED,        // waiting for a worker thread
+    MESH_REQUEST_LOADING,       // the file is parsed and the textures are decoded on a worker thread
+    MESH_REQUEST_UPLOADING,     // the data is uploaded to OpenGL over one or more frames
+    MESH_REQUEST_READY,         // the mesh can be drawn
+    MESH_REQUEST_FAILED
+};
+
+// handle of a mesh requested from the MeshStreamer. It is owned by the streamer
+class MeshRequest
+{
+    friend class MeshStreamer;
+
+private:
+    // private variable declarations
+    std::string                         m_filename;
+    std::string                         m_path;
+    bool                                m_use_mipmaps;
+    std::atomic<int>                    m_state;
+    OGLMesh*                            m_mesh;
+    std::future<void>                   m_task;
+    bool                                m_released;
+    bool                                m_buffers_created;
+    size_t                              m_uploaded_vertex_bytes;
+    size_t                              m_uploaded_index_bytes;
+    size_t                              m_uploaded_bytes;
+    unsigned int                        m_upload_frames;
+    std::chrono::high_resolution_clock::time_point m_request_time;
+    double                              m_load_ms;          // parse and texture decode time on the worker
+
+    // Constructor
+    MeshRequest(const std::string& filename, const std::string& path, bool use_mipmaps);
+
+public:
+    // get functions
+    MeshRequestState                    getState(void) const                    {return (MeshRequestState)m_state.load();}
+    bool                                isReady(void) const                     {return m_state == MESH_REQUEST_READY;}
+    // the mesh, once it is ready (nullptr before that)
+    OGLMesh*                            getMesh(void) const                     {return isReady() ? m_mesh : nullptr;}
+    const std::string&                  getFileName(void) const                 {return m_filename;}
+};
+
+class MeshStreamer
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    ThreadPool                          m_pool;
+    std::mutex                          m_mutex;
+    std::vector<MeshRequest*>           m_requests;         // all the requests (OpenGL thread only)
+    std::deque<MeshRequest*>            m_loaded;           // loaded by the workers, waiting for upload (guarded by m_mutex)
+    std::deque<MeshRequest*>            m_uploads;          // being uploaded, in request order (OpenGL thread only)
+    std::atomic<bool>                   m_cancel;
+    size_t                              m_upload_budget;
+    size_t                              m_uploaded_bytes;   // in the last frame
+
+    // private function declarations
+    void                                loadRequest(MeshRequest* request);
+    size_t                              uploadRequest(MeshRequest* request, size_t budget, bool first);
+    void                                deleteRequest(MeshRequest* request);
+
+public:
+    // Constructor
+    MeshStreamer(size_t upload_budget = MESH_STREAMER_UPLOAD_BUDGET);
+
+    // Destructor (waits for the running loads. Must be called on the OpenGL thread)
+    ~MeshStreamer(void);
+
+    // public function declarations
+
+    // queue a mesh for loading. Returns immediately
+    MeshRequest*                        requestMesh(const std::string& filename, const std::string& path, bool use_mipmaps);
+
+    // release a requested mesh (at once, or as soon as its worker is done with it)
+    void                                releaseMesh(MeshRequest* request);
+
+    // call once per frame on the OpenGL thread. Uploads the loaded meshes within the upload budget, and then the
+    // texture levels requested from the TextureStreamer (a single texture larger than the budget is uploaded on its own in a frame)
+    void                                update(void);
+
+    // get functions
+    size_t                              getUploadBudget(void) const             {return m_upload_budget;}
+    size_t                              getUploadedBytes(void) const            {return m_uploaded_bytes;}
+    // number of requests that are not ready (or failed) yet
+    unsigned int                        getNumPending(void) const;
+
+    // set functions
+    void                                setUploadBudget(size_t bytes)           {m_upload_budget = (bytes > 0) ? bytes : 1;}
+
+};
+
+#endif //MESHSTREAMER_H
+
+// eof ///////////////////////////////// class MeshStreamer
\ No newline at end of file
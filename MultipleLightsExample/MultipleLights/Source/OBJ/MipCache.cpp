@@ -0,0 +1,145 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MipCache.cpp                                 //
+// MipCache stores all the mipmap levels of a texture //
+// in a binary file next to it, which is mapped in    //
+// memory and uploaded as it is on the next load      //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "MipCache.h"       // - Header file for the MipCache class
+#include "TGA.h"            // - Header file for the TGA class
+
+// file writing helpers ////////////////////////////
+
+// pad the file with zeros up to the next level and return its offset
+static unsigned long long alignSection(FILE* file)
+{
+    static const char zeros[MIP_CACHE_ALIGNMENT] = { 0 };
+    unsigned long long offset = (unsigned long long)ftell(file);
+    size_t padding = (size_t)((MIP_CACHE_ALIGNMENT - offset % MIP_CACHE_ALIGNMENT) % MIP_CACHE_ALIGNMENT);
+    fwrite(zeros, 1, padding, file);
+    return offset + padding;
+}
+
+// other functions
+std::string MipCache::getCacheFileName(const std::string& filename, int seed)
+{
+    return filename + "." + std::to_string(seed) + MIP_CACHE_EXTENSION;
+}
+
+size_t MipCache::getLevelSize(unsigned int width, unsigned int height, unsigned int bits, BlockFormat format, unsigned int level)
+{
+    unsigned int level_width = getMipLevelWidth(width, level), level_height = getMipLevelHeight(height, level);
+    if (format == BLOCK_FORMAT_NONE)
+        return (size_t)level_width * level_height * (bits / 8);
+    return getCompressedSize(format, level_width, level_height);
+}
+
+bool MipCache::writeLevels(const std::string& filename, int seed, unsigned long long source_hash, unsigned int width, unsigned int height,
+                           unsigned int bits, MipFilter filter, MipContent content, BlockFormat format,
+                           const std::vector<const unsigned char*>& levels)
+{
+    if (levels.empty() || levels.size() > MIP_CHAIN_MAX_LEVELS)
+        return false;
+
+    std::string cache_file = getCacheFileName(filename, seed);
+    FILE* file = nullptr;
+    fopen_s(&file, cache_file.c_str(), "wb");
+    if (file == nullptr)
+    {
+        PrintToOutputWindow("Could not write mipmap cache %s", cache_file.c_str());
+        return false;
+    }
+
+    MipCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MIP_CACHE_MAGIC;
+    header.version = MIP_CACHE_VERSION;
+    header.source_hash = source_hash;
+    header.width = width;
+    header.height = height;
+    header.bits = bits;
+    header.num_levels = (unsigned int)levels.size();
+    header.filter = filter;
+    header.content = content;
+    header.format = format;
+
+    // the header is written again at the end, when the offsets are known
+    fwrite(&header, sizeof(header), 1, file);
+    for (unsigned int level = 0; level < header.num_levels; ++level)
+    {
+        header.level_offsets[level] = alignSection(file);
+        fwrite(levels[level], 1, getLevelSize(width, height, bits, format, level), file);
+    }
+
+    header.file_size = (unsigned long long)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+
+    if (!ok)
+    {
+        PrintToOutputWindow("Could not write mipmap cache %s", cache_file.c_str());
+        remove(cache_file.c_str());
+        return false;
+    }
+
+    PrintToOutputWindow("Wrote mipmap cache %s (%.2f KB)", cache_file.c_str(), header.file_size / 1024.0);
+    return true;
+}
+
+bool MipCache::readLevels(const std::string& filename, int seed, unsigned long long source_hash, MipFilter filter, MipContent content,
+                          bool mipmaps, MappedFile& file, unsigned int& width, unsigned int& height, unsigned int& bits,
+                          BlockFormat& format, std::vector<const unsigned char*>& levels)
+{
+    std::string cache_file = getCacheFileName(filename, seed);
+    if (!mapFile(cache_file, file))
+        return false;
+
+    MipCacheHeader header;
+    bool valid = file.size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, file.data, sizeof(header));
+        valid = header.magic == MIP_CACHE_MAGIC && header.version == MIP_CACHE_VERSION && header.file_size == file.size &&
+                header.source_hash == source_hash && header.filter == (unsigned int)filter && header.content == (unsigned int)content &&
+                (header.bits == 8 || header.bits == 32) && header.width > 0 && header.height > 0 && header.format <= BLOCK_FORMAT_BC5 &&
+                header.num_levels == (mipmaps ? getNumMipLevels(header.width, header.height) : 1) && header.num_levels <= MIP_CHAIN_MAX_LEVELS;
+    }
+    for (unsigned int level = 0; valid && level < header.num_levels; ++level)
+    {
+        unsigned long long size = getLevelSize(header.width, header.height, header.bits, (BlockFormat)header.format, level);
+        valid = header.level_offsets[level] >= sizeof(header) && header.level_offsets[level] + size <= file.size;
+    }
+    if (!valid)
+    {
+        PrintToOutputWindow("Mipmap cache %s is out of date. Rebuilding", cache_file.c_str());
+        unmapFile(file);
+        return false;
+    }
+
+    width = header.width;
+    height = header.height;
+    bits = header.bits;
+    format = (BlockFormat)header.format;
+    levels.resize(header.num_levels);
+    for (unsigned int level = 0; level < header.num_levels; ++level)
+        levels[level] = (const unsigned char*)file.data + header.level_offsets[level];
+
+    // one byte of each page is read, so that the file is read now (on the decoding thread) and not by the upload
+    volatile unsigned char touched = 0;
+    for (size_t i = 0; i < file.size; i += TGA_PAGE_SIZE)
+        touched += file.data[i];
+
+    return true;
+}
+
+// eof ///////////////////////////////// class MipCache
\ No newline at end of file
@@ -0,0 +1,102 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MipCache.h                                   //
+// MipCache stores all the mipmap levels of a texture //
+// in a binary file next to it, which is mapped in    //
+// memory and uploaded as it is on the next load      //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MIPCACHE_H
+#define MIPCACHE_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include "MipChain.h"
+#include "BlockCompress.h"
+
+// defines /////////////////////////////////////////
+#define MIP_CACHE_MAGIC             0x4843504Du     // "MPCH"
+#define MIP_CACHE_VERSION           2               // increase when the layout of the file, the filters or the encoders change
+#define MIP_CACHE_EXTENSION         ".mipcache"     // the cache is stored next to the image file (e.g. chest.tga.5.mipcache)
+#define MIP_CACHE_ALIGNMENT         64              // alignment of each level in the file
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+// the file starts with this header. Level i starts at level_offsets[i] from the start of the file, and holds the
+// pixels of the level (bits per pixel, rows bottom to top), or its blocks when it is compressed, the way they are uploaded.
+// A texture without mipmaps has only level 0 (when it is compressed)
+struct MipCacheHeader
+{
+    unsigned int                        magic;
+    unsigned int                        version;
+    unsigned long long                  source_hash;        // hash of the contents of the image file
+    unsigned long long                  file_size;          // detects incomplete files
+    unsigned int                        width;
+    unsigned int                        height;
+    unsigned int                        bits;               // 8 or 32, the pixels the levels were generated from
+    unsigned int                        num_levels;
+    unsigned int                        filter;             // the MipFilter and MipContent the levels were generated with
+    unsigned int                        content;
+    unsigned int                        format;             // the BlockFormat of the levels
+    unsigned int                        padding;
+    unsigned long long                  level_offsets[MIP_CHAIN_MAX_LEVELS];
+};
+
+class MipCache
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+
+
+    // private function declarations
+
+
+public:
+    // public function declarations
+
+    // the name of the cache file of an image, whose levels were generated with the settings of seed (the seed of its hash).
+    // An image used with different settings, e.g. as two map types, has one cache for each
+    static std::string                  getCacheFileName(const std::string& filename, int seed);
+
+    // the bytes of a level of an image
+    static size_t                       getLevelSize(unsigned int width, unsigned int height, unsigned int bits, BlockFormat format, unsigned int level);
+
+    // writes the levels of an image whose file has the given hash, hashed with seed (which should include any setting the levels
+    // depend on). levels holds the pixels, or the blocks, of each level, level 0 first
+    static bool                         writeLevels(const std::string& filename, int seed, unsigned long long source_hash, unsigned int width, unsigned int height,
+                                                    unsigned int bits, MipFilter filter, MipContent content, BlockFormat format,
+                                                    const std::vector<const unsigned char*>& levels);
+
+    // maps the cache of an image and points levels to each level in it. Nothing is copied, filtered or compressed.
+    // mipmaps tells whether all the levels or only level 0 are expected.
+    // returns false if there is no cache, or if it was written for another version of the file or other settings
+    static bool                         readLevels(const std::string& filename, int seed, unsigned long long source_hash, MipFilter filter, MipContent content,
+                                                   bool mipmaps, MappedFile& file, unsigned int& width, unsigned int& height, unsigned int& bits,
+                                                   BlockFormat& format, std::vector<const unsigned char*>& levels);
+
+    // get functions
+
+
+    // set functions
+
+};
+
+#endif //MIPCACHE_H
+
+// eof ///////////////////////////////// class MipCache
\ No newline at end of file
@@ -0,0 +1,398 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MipChain.cpp                                 //
+// Generation of the mipmap levels of a texture on    //
+// the CPU                                            //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "MipChain.h"       // - Header file for the mipmap generation
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+#ifdef MIP_CHAIN_SSE2
+#include <emmintrin.h>      // - Header file for the SSE2 intrinsics
+#endif
+
+// defines /////////////////////////////////////////
+#define MIP_CHAIN_PI                3.14159265358979323846
+#define MIP_CHAIN_SRGB_LUT_SIZE     65536           // entries of the linear to sRGB table (less than 0.05 of a step apart near 0)
+
+// the conversions of 8 bit values to the spaces they are filtered in, and from linear values back to sRGB, built once
+struct SRGBTables
+{
+    float                               to_linear[256];     // sRGB to linear
+    float                               to_unit[256];       // [0, 255] to [0, 1]
+    float                               to_signed[256];     // [0, 255] to [-1, 1]
+    unsigned char                       to_srgb[MIP_CHAIN_SRGB_LUT_SIZE];
+
+    SRGBTables(void)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            to_linear[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            to_unit[i] = c;
+            to_signed[i] = c * 2.0f - 1.0f;
+        }
+        for (int i = 0; i < MIP_CHAIN_SRGB_LUT_SIZE; ++i)
+        {
+            float c = i / (float)(MIP_CHAIN_SRGB_LUT_SIZE - 1);
+            float s = (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+            to_srgb[i] = (unsigned char)(s * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const SRGBTables& getSRGBTables(void)
+{
+    static SRGBTables tables;
+    return tables;
+}
+
+// the source pixels and weights of each pixel of the smaller level, in one dimension
+struct FilterTaps
+{
+    unsigned int                        num_taps;           // per pixel (the unused ones have a weight of 0)
+    std::vector<unsigned int>           indices;            // wrapped around the edges
+    std::vector<float>                  weights;            // they add up to 1
+};
+
+// the modified Bessel function of the first kind of order 0, for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+    {
+        double f = x / (2.0 * k);
+        term *= f * f;
+        sum += term;
+    }
+    return sum;
+}
+
+static double sinc(double x)
+{
+    if (fabs(x) < 1e-8)
+        return 1.0;
+    x *= MIP_CHAIN_PI;
+    return sin(x) / x;
+}
+
+// the windowed sinc filters, at t pixels of the smaller level from the centre
+static double filterWeight(MipFilter filter, double t)
+{
+    if (filter == MIP_FILTER_KAISER)
+    {
+        double x = t / MIP_CHAIN_KAISER_WIDTH;
+        if (fabs(x) >= 1.0)
+            return 0.0;
+        return sinc(t) * besselI0(MIP_CHAIN_KAISER_ALPHA * sqrt(1.0 - x * x)) / besselI0(MIP_CHAIN_KAISER_ALPHA);
+    }
+    double x = t / MIP_CHAIN_LANCZOS_WIDTH;
+    if (fabs(x) >= 1.0)
+        return 0.0;
+    return sinc(t) * sinc(x);
+}
+
+static void buildTaps(MipFilter filter, unsigned int src_size, unsigned int dst_size, FilterTaps& taps)
+{
+    // a dimension that is not reduced (the other one still is) is copied
+    if (src_size == dst_size)
+    {
+        taps.num_taps = 1;
+        taps.indices.resize(dst_size);
+        taps.weights.assign(dst_size, 1.0f);
+        for (unsigned int x = 0; x < dst_size; ++x)
+            taps.indices[x] = x;
+        return;
+    }
+
+    // the box covers the source pixels under the pixel of the smaller level (partially, for odd sizes),
+    // the sinc filters are sampled at the centres of the source pixels. An image that is enlarged (when it is resampled)
+    // is filtered with the filter of a single source pixel
+    double scale = (double)src_size / dst_size;
+    double filter_scale = glm::max(scale, 1.0);
+    double support = filter_scale * ((filter == MIP_FILTER_BOX) ? 0.5 : (filter == MIP_FILTER_KAISER) ? MIP_CHAIN_KAISER_WIDTH : MIP_CHAIN_LANCZOS_WIDTH);
+    std::vector<int> first(dst_size);
+    std::vector<std::vector<double> > weights(dst_size);
+    taps.num_taps = 1;
+    for (unsigned int x = 0; x < dst_size; ++x)
+    {
+        double centre = (x + 0.5) * scale;
+        int begin = (int)floor(centre - support - 0.5);
+        int end = (int)ceil(centre + support + 0.5);
+        double sum = 0.0;
+        for (int i = begin; i < end; ++i)
+        {
+            double w = (filter == MIP_FILTER_BOX) ?
+                glm::max(0.0, glm::min(i + 1.0, centre + support) - glm::max((double)i, centre - support)) :
+                filterWeight(filter, (i + 0.5 - centre) / filter_scale);
+            weights[x].push_back(w);
+            sum += w;
+        }
+        // the taps outside the filter are trimmed
+        while (!weights[x].empty() && weights[x].back() == 0.0)
+            weights[x].pop_back();
+        size_t zeros = 0;
+        while (zeros < weights[x].size() && weights[x][zeros] == 0.0)
+            ++zeros;
+        weights[x].erase(weights[x].begin(), weights[x].begin() + zeros);
+        first[x] = begin + (int)zeros;
+        for (size_t i = 0; i < weights[x].size(); ++i)
+            weights[x][i] /= sum;
+        taps.num_taps = glm::max(taps.num_taps, (unsigned int)weights[x].size());
+    }
+
+    taps.indices.assign((size_t)dst_size * taps.num_taps, 0);
+    taps.weights.assign((size_t)dst_size * taps.num_taps, 0.0f);
+    for (unsigned int x = 0; x < dst_size; ++x)
+    {
+        for (unsigned int k = 0; k < taps.num_taps; ++k)
+        {
+            int i = (first[x] + (int)k) % (int)src_size;
+            taps.indices[(size_t)x * taps.num_taps + k] = (unsigned int)((i < 0) ? i + (int)src_size : i);
+            if (k < weights[x].size())
+                taps.weights[(size_t)x * taps.num_taps + k] = (float)weights[x][k];
+        }
+    }
+}
+
+// 8 bit pixels to floating point, in the space they are filtered in
+static void decodeRow(const unsigned char* src, float* dst, unsigned int count, unsigned int channels, MipContent content, const SRGBTables& tables)
+{
+    if (content == MIP_CONTENT_LINEAR)
+    {
+        for (unsigned int i = 0; i < count * channels; ++i)
+            dst[i] = tables.to_unit[src[i]];
+        return;
+    }
+
+    // alpha is always linear
+    const float* colour = (content == MIP_CONTENT_COLOUR) ? tables.to_linear : tables.to_signed;
+    for (unsigned int x = 0; x < count; ++x, src += 4, dst += 4)
+    {
+        dst[0] = colour[src[0]];
+        dst[1] = colour[src[1]];
+        dst[2] = colour[src[2]];
+        dst[3] = tables.to_unit[src[3]];
+    }
+}
+
+static inline unsigned char quantize(float value)
+{
+    return (unsigned char)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// floating point pixels back to 8 bits. The normals are renormalized in place, so that the next level is filtered from unit normals
+static void encodeRow(float* src, unsigned char* dst, unsigned int count, unsigned int channels, MipContent content, const SRGBTables& tables)
+{
+    if (content == MIP_CONTENT_LINEAR)
+    {
+        for (unsigned int i = 0; i < count * channels; ++i)
+            dst[i] = quantize(src[i]);
+        return;
+    }
+
+    for (unsigned int x = 0; x < count; ++x)
+    {
+        float* p = src + x * 4;
+        unsigned char* q = dst + x * 4;
+        if (content == MIP_CONTENT_NORMAL)
+        {
+            float length = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            if (length > 1e-6f)
+            {
+                p[0] /= length;
+                p[1] /= length;
+                p[2] /= length;
+            }
+            else
+            {
+                // normals that cancel out become the flat normal (blue is the first channel of BGRA)
+                p[0] = 1.0f;
+                p[1] = 0.0f;
+                p[2] = 0.0f;
+            }
+            for (int c = 0; c < 3; ++c)
+                q[c] = quantize(p[c] * 0.5f + 0.5f);
+        }
+        else
+        {
+            for (int c = 0; c < 3; ++c)
+                q[c] = tables.to_srgb[(int)(glm::clamp(p[c], 0.0f, 1.0f) * (MIP_CHAIN_SRGB_LUT_SIZE - 1) + 0.5f)];
+        }
+        q[3] = quantize(p[3]);
+    }
+}
+
+// reduces a row horizontally
+static void filterRow(const float* src, float* dst, unsigned int dst_width, unsigned int channels, const FilterTaps& taps)
+{
+    const unsigned int* index = &taps.indices[0];
+    const float* weight = &taps.weights[0];
+    for (unsigned int x = 0; x < dst_width; ++x, index += taps.num_taps, weight += taps.num_taps)
+    {
+#ifdef MIP_CHAIN_SSE2
+        // the 4 channels of a pixel in one register
+        if (channels == 4)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (unsigned int k = 0; k < taps.num_taps; ++k)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(src + index[k] * 4)));
+            _mm_storeu_ps(dst + x * 4, sum);
+            continue;
+        }
+#endif
+        for (unsigned int c = 0; c < channels; ++c)
+        {
+            float sum = 0.0f;
+            for (unsigned int k = 0; k < taps.num_taps; ++k)
+                sum += weight[k] * src[index[k] * channels + c];
+            dst[x * channels + c] = sum;
+        }
+    }
+}
+
+// reduces the rows (of row_size floats) vertically, for the row y of the smaller level
+static void filterColumns(const float* src, size_t row_size, unsigned int y, const FilterTaps& taps, float* dst)
+{
+    const unsigned int* index = &taps.indices[(size_t)y * taps.num_taps];
+    const float* weight = &taps.weights[(size_t)y * taps.num_taps];
+    size_t i = 0;
+#ifdef MIP_CHAIN_SSE2
+    for (; i + 4 <= row_size; i += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned int k = 0; k < taps.num_taps; ++k)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(src + index[k] * row_size + i)));
+        _mm_storeu_ps(dst + i, sum);
+    }
+#endif
+    for (; i < row_size; ++i)
+    {
+        float sum = 0.0f;
+        for (unsigned int k = 0; k < taps.num_taps; ++k)
+            sum += weight[k] * src[index[k] * row_size + i];
+        dst[i] = sum;
+    }
+}
+
+// filters src_width x src_height pixels, of 8 bits (pixels) or floating point (level), to dst_width x dst_height. The result is
+// written to dst, and kept in floating point in next
+static void filterImage(const unsigned char* pixels, const float* level, unsigned int src_width, unsigned int src_height,
+                        unsigned int pixel_size, MipFilter filter, MipContent content, unsigned int dst_width, unsigned int dst_height,
+                        std::vector<float>& next, unsigned char* dst, unsigned int num_threads)
+{
+    const SRGBTables& tables = getSRGBTables();
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    FilterTaps row_taps, column_taps;
+    buildTaps(filter, src_width, dst_width, row_taps);
+    buildTaps(filter, src_height, dst_height, column_taps);
+    size_t dst_row_size = (size_t)dst_width * pixel_size;
+    std::vector<float> filtered(src_height * dst_row_size);
+    next.resize(dst_height * dst_row_size);
+
+    // the rows of the source are reduced horizontally...
+    size_t num_tasks = (src_height + MIP_CHAIN_ROWS_PER_TASK - 1) / MIP_CHAIN_ROWS_PER_TASK;
+    pool.parallelFor(num_tasks, [&](size_t task)
+    {
+        unsigned int first = (unsigned int)(task * MIP_CHAIN_ROWS_PER_TASK);
+        unsigned int last = glm::min(first + MIP_CHAIN_ROWS_PER_TASK, src_height);
+        std::vector<float> row((pixels != NULL) ? (size_t)src_width * pixel_size : 0);
+        for (unsigned int y = first; y < last; ++y)
+        {
+            const float* src_row = (pixels != NULL) ? &row[0] : &level[(size_t)y * src_width * pixel_size];
+            if (pixels != NULL)
+                decodeRow(pixels + (size_t)y * src_width * pixel_size, &row[0], src_width, pixel_size, content, tables);
+            filterRow(src_row, &filtered[y * dst_row_size], dst_width, pixel_size, row_taps);
+        }
+    }, num_threads);
+
+    // ...then vertically, and each row is written out as soon as it is filtered
+    num_tasks = (dst_height + MIP_CHAIN_ROWS_PER_TASK - 1) / MIP_CHAIN_ROWS_PER_TASK;
+    pool.parallelFor(num_tasks, [&](size_t task)
+    {
+        unsigned int first = (unsigned int)(task * MIP_CHAIN_ROWS_PER_TASK);
+        unsigned int last = glm::min(first + MIP_CHAIN_ROWS_PER_TASK, dst_height);
+        for (unsigned int y = first; y < last; ++y)
+        {
+            filterColumns(&filtered[0], dst_row_size, y, column_taps, &next[y * dst_row_size]);
+            encodeRow(&next[y * dst_row_size], dst + y * dst_row_size, dst_width, pixel_size, content, tables);
+        }
+    }, num_threads);
+}
+
+unsigned int getNumMipLevels(unsigned int width, unsigned int height)
+{
+    unsigned int size = glm::max(width, height);
+    unsigned int num_levels = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        ++num_levels;
+    }
+    return num_levels;
+}
+
+unsigned int getMipLevelWidth(unsigned int width, unsigned int level)
+{
+    return glm::max(width >> level, 1u);
+}
+
+unsigned int getMipLevelHeight(unsigned int height, unsigned int level)
+{
+    return glm::max(height >> level, 1u);
+}
+
+size_t getMipChainSize(unsigned int width, unsigned int height, unsigned int pixel_size)
+{
+    size_t size = 0;
+    unsigned int num_levels = getNumMipLevels(width, height);
+    for (unsigned int level = 0; level < num_levels; ++level)
+        size += (size_t)getMipLevelWidth(width, level) * getMipLevelHeight(height, level) * pixel_size;
+    return size;
+}
+
+unsigned int buildMipChain(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                           MipFilter filter, MipContent content, unsigned char* chain, unsigned int num_threads)
+{
+    unsigned int num_levels = getNumMipLevels(width, height);
+    if (num_levels < 2)
+        return num_levels;
+
+    // colours and normals are only found in 4 byte pixels
+    if (pixel_size != 4)
+        content = MIP_CONTENT_LINEAR;
+
+    // level 0 is converted to floating point a row at a time while it is reduced, the smaller levels are kept in floating point
+    std::vector<float> level, next;
+    unsigned char* dst = chain;
+    for (unsigned int l = 1; l < num_levels; ++l)
+    {
+        unsigned int src_width = getMipLevelWidth(width, l - 1), src_height = getMipLevelHeight(height, l - 1);
+        unsigned int dst_width = getMipLevelWidth(width, l), dst_height = getMipLevelHeight(height, l);
+        filterImage((l == 1) ? pixels : NULL, (l == 1) ? NULL : &level[0], src_width, src_height, pixel_size, filter, content,
+                    dst_width, dst_height, next, dst, num_threads);
+        dst += (size_t)dst_height * dst_width * pixel_size;
+        level.swap(next);
+    }
+    return num_levels;
+}
+
+void resampleImage(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                   MipFilter filter, MipContent content, unsigned int dst_width, unsigned int dst_height, unsigned char* dst, unsigned int num_threads)
+{
+    if (pixel_size != 4)
+        content = MIP_CONTENT_LINEAR;
+    std::vector<float> next;
+    filterImage(pixels, NULL, width, height, pixel_size, filter, content, dst_width, dst_height, next, dst, num_threads);
+}
+
+// eof ///////////////////////////////// MipChain
\ No newline at end of file
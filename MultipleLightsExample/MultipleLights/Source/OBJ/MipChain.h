@@ -0,0 +1,79 @@
+//----------------------------------------------------//
+//                                                    //
+// File: MipChain.h                                   //
+// Generation of the mipmap levels of a texture on    //
+// the CPU                                            //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef MIPCHAIN_H
+#define MIPCHAIN_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+
+
+// defines /////////////////////////////////////////
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_CHAIN_SSE2
+#endif
+
+#define MIP_CHAIN_MAX_LEVELS        16              // TGA images are at most 65535 pixels wide
+#define MIP_CHAIN_ROWS_PER_TASK     16              // number of rows filtered by each parallel task
+#define MIP_CHAIN_KAISER_WIDTH      3.0f            // half width of the Kaiser windowed sinc, in pixels of the smaller level
+#define MIP_CHAIN_KAISER_ALPHA      4.0f
+#define MIP_CHAIN_LANCZOS_WIDTH     3.0f            // Lanczos-3
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+// the filter each level is reduced with
+enum MipFilter
+{
+    MIP_FILTER_BOX,                                 // the average of 2x2 pixels (what glGenerateMipmap does on most drivers)
+    MIP_FILTER_KAISER,                              // sinc with a Kaiser window: sharper, with little ringing
+    MIP_FILTER_LANCZOS                              // sinc with a Lanczos window: sharpest, rings a bit more
+};
+
+// what the pixels hold, which decides the space they are filtered in
+enum MipContent
+{
+    MIP_CONTENT_COLOUR,                             // sRGB colour, filtered in linear space. Alpha is linear
+    MIP_CONTENT_LINEAR,                             // data filtered as it is stored (masks, gloss)
+    MIP_CONTENT_NORMAL                              // tangent space normals in the first 3 channels, renormalized in every level
+};
+
+// number of levels of a width x height image, down to 1x1 (level 0 included)
+unsigned int getNumMipLevels(unsigned int width, unsigned int height);
+
+// width and height of a level
+unsigned int getMipLevelWidth(unsigned int width, unsigned int level);
+unsigned int getMipLevelHeight(unsigned int height, unsigned int level);
+
+// bytes of all the levels of a width x height image of pixel_size bytes per pixel, level 0 included
+size_t getMipChainSize(unsigned int width, unsigned int height, unsigned int pixel_size);
+
+// generates levels 1 to the 1x1 level of width x height pixels of pixel_size bytes (1 or 4). Each level is filtered from the
+// previous one, which is kept in floating point (and in linear space for colours) so that the rounding is not repeated.
+// The levels are written one after the other in chain (getMipChainSize minus the size of level 0 bytes). Textures repeat,
+// so the filter wraps around the edges. The rows of each level are filtered in parallel. Returns the number of levels, level 0 included
+unsigned int buildMipChain(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                           MipFilter filter, MipContent content, unsigned char* chain, unsigned int num_threads = 0);
+
+// resamples width x height pixels of pixel_size bytes (1 or 4) to dst_width x dst_height, smaller or larger in either dimension,
+// with the filter and in the space of the mipmaps (the image repeats, so the filter wraps around the edges). dst holds
+// dst_width x dst_height pixels
+void resampleImage(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int pixel_size,
+                   MipFilter filter, MipContent content, unsigned int dst_width, unsigned int dst_height, unsigned char* dst,
+                   unsigned int num_threads = 0);
+
+#endif //MIPCHAIN_H
+
+// eof ///////////////////////////////// MipChain
\ No newline at end of file
@@ -18,18 +18,33 @@
 #include "OBJMaterial.h"    // - Header file for the OBJMaterial class
 #include "OBJLoader.h"      // - Header file for the OBJLoader class
 #include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "OBJTokenizer.h"   // - Header file for the .obj/.mtl tokenizer
+#include "MeshCache.h"      // - Header file for the MeshCache class
+#include "TextureCache.h"   // - Header file for the TextureCache class
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
 
-#include <iostream>         // - Header file for IO stream
-#include <fstream>          // - Header file for file stream
-#include <sstream>          // - Header file for string stream
+#include <chrono>           // - Header file for timing the loader
+#include <atomic>           // - Header file for atomic flags
+#include <algorithm>        // - Header file for copy and upper_bound
+
+// turn a negative index into a 1-based index relative to the start of the chunk and mark it
+static inline void resolveRelativeIndex(long& index, size_t count, unsigned short bit, unsigned short& relative_mask)
+{
+    if (index < 0)
+    {
+        index += long(count) + 1;
+        relative_mask |= bit;
+    }
+}
 
 // Constructor
 OBJLoader::OBJLoader(void) :
     current_object(nullptr),
+    num_faces(0),
     mtl_filename(""),
-    vertices(nullptr),
-    normals(nullptr),
-    texcoords(nullptr)
+    num_threads(0),
+    weld_epsilon(0),
+    use_cache(true)
 {
 
 }
@@ -51,267 +66,454 @@ void OBJLoader::loadGeometry()
 {
     if (result!=RESULT_OK)
         return;
-    std::ifstream diskfile;
+
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+
+    // map the file in memory instead of buffering it
+    MappedFile file;
     std::string fileNameWithPath = current_object->path + "\\" + current_object->filename;
-    diskfile.open(fileNameWithPath.c_str(), std::ifstream::in);
-    if (diskfile.bad() || !diskfile.is_open())
+    if (!mapFile(fileNameWithPath, file))
     {
         result = RESULT_FILE_NOT_FOUND;
         PrintToOutputWindow("%s not found in path %s", current_object->filename.c_str(), current_object->path.c_str());
         return;
     }
 
-    // buffer the file in memory
-    diskfile.seekg (0, std::ios::end);
-    unsigned int length = diskfile.tellg();
-    diskfile.seekg (0, std::ios::beg);
-    char* buffered_content = new char [length];
-    diskfile.read (buffered_content,length);
-    diskfile.close();
-
-    std::istringstream file = std::istringstream(std::string(buffered_content));
+    if (current_object->materials.empty())
+        current_object->addMaterial(new OBJMaterial()); // add default material
 
-    std::string buf;
+    // walk the file once, gathering the vertex attributes, the faces and the material groups
+    parseGeometry(file.data, file.size);
+    size_t file_size = file.size;
+    unmapFile(file);
 
-    // count attributes
-    unsigned long cn=0, ct=0, cv=0;
-    unsigned long ni=0, ti=0, vi=0;
-    unsigned long max_faces = 0, faces = 0;
-    unsigned long total_faces = 0;
-    while (file.good())
+    if (result != RESULT_OK)
     {
-        file >> std::skipws >> buf;
-        if (buf[0]=='f') // add face
-        {
-            faces++;
-            total_faces++;
-        }
-        else if (buf[0]=='v') // add vertex
-        {
-            if (buf.size()==1)
-                cv++;
-            else if (buf[1]=='n') // add normal
-                cn++;
-            else if (buf[1]=='t') // add texture coordinate pair
-                ct++;
-        }
-        else if ( buf[0]=='g' || (buf[0]=='u' && buf=="usemtl") )
-        {
-            max_faces = faces>max_faces?faces:max_faces;
-            faces=0;
-        }
+        clearBufferData();
+        return;
     }
 
-    PrintToOutputWindow("%s: Total faces: %d, total vertices: %d, total normals: %d, total texcoord pairs: %d", current_object->filename.c_str(), total_faces, cv, cn, ct);
-    max_faces = faces>max_faces?faces:max_faces;
-
-    file.clear();
-    file.str(buffered_content);
-    SAFE_DELETE(buffered_content);
-
-
-    //file = std::istringstream(std::string(buffered_content));
+    PrintToOutputWindow("%s: Total faces: %lu, total vertices: %lu, total normals: %lu, total texcoord pairs: %lu", current_object->filename.c_str(), num_faces, current_object->num_positions, current_object->num_normals, current_object->num_texcoords);
 
-    PrimitiveGroup group(max_faces);
-
-    if (cv == 0)
+    if (current_object->num_positions == 0)
     {
         PrintToOutputWindow("No vertices found for mesh %s.", current_object->filename.c_str());
         result = RESULT_BAD_FORMAT;
+        clearBufferData();
         return;
     }
-    vertices = new glm::vec3[cv];
-    if (cv == 0)
-    {
+    if (current_object->num_normals == 0)
         PrintToOutputWindow("No normals found for mesh %s.", current_object->filename.c_str());
-        result = RESULT_BAD_FORMAT;
-        return;
-    }
-    normals = new glm::vec3[cn];
-    if (cv == 0)
-    {
+    if (current_object->num_texcoords == 0)
         PrintToOutputWindow("No texcoords found for mesh %s.", current_object->filename.c_str());
+
+    // now that all attributes are known, build the faces of each group
+    buildPrimitiveGroups();
+
+    clearBufferData();
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    double size_mb = file_size / (1024.0 * 1024.0);
+    PrintToOutputWindow("%s: Parsed %.2f MB in %.2f ms (%.2f MB/s)", current_object->filename.c_str(), size_mb, elapsed_ms, size_mb * 1000.0 / glm::max(elapsed_ms, 0.001));
+}
+
+// the number of threads to use (0 means all cores)
+static inline unsigned int resolveNumThreads(unsigned int num_threads)
+{
+    return (num_threads == 0) ? ThreadPool::getInstance().getNumThreads() : num_threads;
+}
+
+void OBJLoader::parseGeometry(const char* data, size_t size)
+{
+    // split the file in line-aligned chunks which are parsed in parallel.
+    // small files (or a single thread) result in a single chunk
+    unsigned int threads = resolveNumThreads(num_threads);
+    size_t num_chunks = 1;
+    if (threads > 1)
+        num_chunks = glm::max(glm::min(size / OBJ_MIN_CHUNK_SIZE, size_t(threads) * OBJ_CHUNKS_PER_THREAD), size_t(1));
+
+    chunks.resize(num_chunks);
+    const char* end = data + size;
+    const char* begin = data;
+    for (size_t i = 0; i < num_chunks; ++i)
+    {
+        chunks[i].begin = begin;
+        chunks[i].end = (i + 1 == num_chunks) ? end : skipLine(glm::max(begin, data + size / num_chunks * (i + 1)), end);
+        begin = chunks[i].end;
     }
-    else
-        texcoords = new glm::vec2[ct];
 
-    if (current_object->materials.empty())
-        current_object->materials.push_back(new OBJMaterial()); // add default material
+    {
+        ScopedPhaseTimer timer(stats, LOAD_PHASE_PARSE, size);
+        ThreadPool::getInstance().parallelFor(num_chunks, [&](size_t i) { parseChunk(chunks[i]); }, threads);
+        unsigned long long parsed_faces = 0;
+        for (size_t i = 0; i < num_chunks; ++i)
+            parsed_faces += chunks[i].faces.size();
+        timer.setItems(parsed_faces);
+    }
+    updatePeakMemory();
 
-    OBJMaterial * cur_material = current_object->materials[0]; // track active material
-    int cur_material_index = 0;
+    // concatenate the chunks and apply the material statements in file order
+    mergeChunks();
+}
 
-    unsigned long line=0;
+void OBJLoader::parseChunk(OBJChunk& chunk)
+{
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
 
-    while (file.good())
+    while (p < end)
     {
-        buf.clear();
-        file >> std::skipws >> buf;
-        if (buf=="#")
+        p = skipBlanks(p, end);
+        if (p >= end)
+            break;
+
+        const char* keyword = p;
+        const char* keyword_end = tokenEnd(p, end);
+        size_t keyword_length = keyword_end - keyword;
+        p = keyword_end;
+
+        if (keyword_length == 1 && keyword[0] == 'v') // add vertex
         {
-            char restline[2048];
-            file.getline(restline,2048);
+            glm::vec3 v;
+            p = parseFloat(p, end, v.x);
+            p = parseFloat(p, end, v.y);
+            p = parseFloat(p, end, v.z);
+            chunk.vertices.push_back(v);
         }
-        else if (buf=="mtllib")
+        else if (keyword_length == 2 && keyword[0] == 'v' && keyword[1] == 'n') // add normal
         {
-            // found a new material template library. Append discovered materials
-            std::string mtllib;
-            file >> std::skipws >> mtllib;
-            std::vector<OBJMaterial*> imported_materials;
-            loadMaterials(mtllib, imported_materials);
-            if (result != RESULT_OK)
-            {
-                clearBufferData();
-                return;
-            }
-            for (size_t i=0; i<imported_materials.size(); i++ )
+            glm::vec3 n;
+            p = parseFloat(p, end, n.x);
+            p = parseFloat(p, end, n.y);
+            p = parseFloat(p, end, n.z);
+            chunk.normals.push_back(n);
+        }
+        else if (keyword_length == 2 && keyword[0] == 'v' && keyword[1] == 't') // add texture coordinate pair
+        {
+            glm::vec2 t;
+            p = parseFloat(p, end, t.x);
+            p = parseFloat(p, end, t.y);
+            chunk.texcoords.push_back(t);
+        }
+        else if (keyword_length == 1 && keyword[0] == 'f') // found a face
+        {
+            // only the attribute indices are stored here.
+            // the triangles are built once all the attributes of the file are known
+            FaceIndices face;
+            face.relative_mask = 0;
+            for (int i=0; i<3; i++)
             {
-                current_object->materials.push_back(imported_materials[i]);
+                p = parseFaceTuple(p, end, face.vertex[i], face.texcoord[i], face.normal[i]);
+                resolveRelativeIndex(face.vertex[i], chunk.vertices.size(), 1 << i, face.relative_mask);
+                resolveRelativeIndex(face.texcoord[i], chunk.texcoords.size(), 1 << (3 + i), face.relative_mask);
+                resolveRelativeIndex(face.normal[i], chunk.normals.size(), 1 << (6 + i), face.relative_mask);
             }
+            chunk.faces.push_back(face);
+        }
+        else if (tokenEquals(keyword, keyword_end, "usemtl") ||
+                 tokenEquals(keyword, keyword_end, "mtllib") ||
+                 (keyword_length == 1 && keyword[0] == 'g'))
+        {
+            // materials are resolved when the chunks are merged, since they may be defined in a previous chunk
+            OBJStatement statement;
+            statement.type = (keyword[0] == 'u') ? OBJ_STATEMENT_USEMTL : (keyword[0] == 'm') ? OBJ_STATEMENT_MTLLIB : OBJ_STATEMENT_GROUP;
+            statement.face_offset = (unsigned long)chunk.faces.size();
+            if (statement.type != OBJ_STATEMENT_GROUP)
+                p = parseName(p, end, statement.name);
+            chunk.statements.push_back(statement);
         }
-        else if (buf=="usemtl")
+        else if (keyword_length == 1 && keyword[0] == 's') // smoothing group ("off" is parsed as 0)
         {
-            // add currently filled group to the object and create a new one
-            if (group.num_primitives>0)
+            OBJStatement statement;
+            statement.type = OBJ_STATEMENT_SMOOTHING;
+            statement.face_offset = (unsigned long)chunk.faces.size();
+            long smoothing_group;
+            p = parseIndex(skipBlanks(p, end), end, smoothing_group);
+            statement.smoothing_group = (smoothing_group > 0) ? (unsigned int)smoothing_group : 0;
+            chunk.statements.push_back(statement);
+        }
+        // anything else (comments, object names) is skipped
+
+        p = skipLine(p, end);
+    }
+}
+
+void OBJLoader::mergeChunks()
+{
+    // apply the material and group statements in file order
+    OBJMaterial * cur_material = current_object->materials[0]; // track active material
+    int cur_material_index = 0;
+
+    FaceGroup group = { 0, 0, cur_material_index };
+    unsigned long face_base = 0;
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        for (size_t s = 0; s < chunks[i].statements.size(); ++s)
+        {
+            OBJStatement& statement = chunks[i].statements[s];
+            unsigned long face = face_base + statement.face_offset;
+
+            if (statement.type == OBJ_STATEMENT_MTLLIB)
             {
-                group.resize();
-                current_object->addElement(group);
-                group.clear();
-                group = PrimitiveGroup(max_faces);
+                // found a new material template library. Append discovered materials
+                std::vector<OBJMaterial*> imported_materials;
+                loadMaterials(statement.name, imported_materials);
+                if (result != RESULT_OK)
+                    return;
+                current_object->material_libraries.push_back(statement.name);
+                for (size_t m=0; m<imported_materials.size(); m++ )
+                {
+                    current_object->addMaterial(imported_materials[m]);
+                }
+                continue;
             }
-            // locate material and assign to new group
-            std::string group_mat_name;
-            file >> std::skipws >> group_mat_name;
-            cur_material_index = current_object->findMaterialByName(group_mat_name, &cur_material);
-            if (cur_material == nullptr)
+
+            if (statement.type == OBJ_STATEMENT_SMOOTHING)
             {
-                cur_material = current_object->materials[0];
-                cur_material_index = 0;
+                // smoothing groups do not split the material groups, they are kept as runs of faces
+                if (!smoothing_runs.empty() && smoothing_runs.back().first_face == face)
+                    smoothing_runs.back().smoothing_group = statement.smoothing_group;
+                else if (smoothing_runs.empty() ? statement.smoothing_group != 0 : smoothing_runs.back().smoothing_group != statement.smoothing_group)
+                {
+                    SmoothingRun run = { face, statement.smoothing_group };
+                    smoothing_runs.push_back(run);
+                }
+                continue;
             }
-            group.material_used = cur_material;
-            group.material_index = cur_material_index;
-        }
-        else if (buf=="g")
-        {
-            // add currently filled group to the object and create a new one
-            if (group.num_primitives>0)
+
+            // close the currently filled group and start a new one
+            group.num_faces = face - group.first_face;
+            if (group.num_faces > 0)
+                face_groups.push_back(group);
+            group.first_face = face;
+            group.num_faces = 0;
+
+            if (statement.type == OBJ_STATEMENT_USEMTL)
             {
-                group.resize();
-                current_object->addElement(group);
-                group.clear();
-                group = PrimitiveGroup(max_faces);
+                // locate material and assign to new group
+                cur_material_index = current_object->findMaterialByName(statement.name, &cur_material);
+                if (cur_material == nullptr)
+                {
+                    cur_material = current_object->materials[0];
+                    cur_material_index = 0;
+                }
             }
-            group.material_used = cur_material;
             group.material_index = cur_material_index;
-            char restline[2048];
-            file.getline(restline,2048);
         }
-        else if (buf=="v") // add vertex
+        face_base += (unsigned long)chunks[i].faces.size();
+    }
+
+    group.num_faces = face_base - group.first_face;
+    if (group.num_faces > 0)
+        face_groups.push_back(group);
+
+    // the attribute streams are allocated at their final size. Relative indices of a chunk are offset by the number
+    // of attributes found in the previous chunks (a prefix sum over the chunk counts), which is applied when its faces are built
+    ScopedPhaseTimer timer(stats, LOAD_PHASE_MERGE);
+    unsigned long total_vertices = 0, total_normals = 0, total_texcoords = 0;
+    num_faces = 0;
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].first_face = num_faces;
+        chunks[i].vertex_base = total_vertices;
+        chunks[i].normal_base = total_normals;
+        chunks[i].texcoord_base = total_texcoords;
+        num_faces += (unsigned long)chunks[i].faces.size();
+        total_vertices += (unsigned long)chunks[i].vertices.size();
+        total_normals += (unsigned long)chunks[i].normals.size();
+        total_texcoords += (unsigned long)chunks[i].texcoords.size();
+    }
+    glm::vec3* vertices = arena.allocate<glm::vec3>(total_vertices);
+    glm::vec3* normals = arena.allocate<glm::vec3>(total_normals);
+    glm::vec2* texcoords = arena.allocate<glm::vec2>(total_texcoords);
+    timer.setBytes((total_vertices + total_normals) * sizeof(glm::vec3) + total_texcoords * sizeof(glm::vec2));
+    updatePeakMemory();
+
+    // each chunk is released as soon as it is copied, to keep the peak memory low
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        std::copy(chunks[i].vertices.begin(), chunks[i].vertices.end(), vertices + chunks[i].vertex_base);
+        std::copy(chunks[i].normals.begin(), chunks[i].normals.end(), normals + chunks[i].normal_base);
+        std::copy(chunks[i].texcoords.begin(), chunks[i].texcoords.end(), texcoords + chunks[i].texcoord_base);
+        std::vector<glm::vec3>().swap(chunks[i].vertices);
+        std::vector<glm::vec3>().swap(chunks[i].normals);
+        std::vector<glm::vec2>().swap(chunks[i].texcoords);
+        std::vector<OBJStatement>().swap(chunks[i].statements);
+    }
+
+    current_object->positions = vertices;
+    current_object->num_positions = total_vertices;
+    current_object->normals = normals;
+    current_object->num_normals = total_normals;
+    current_object->texcoords = texcoords;
+    current_object->num_texcoords = total_texcoords;
+}
+
+bool OBJLoader::buildFace(const OBJChunk& chunk, const FaceIndices& indices, OBJFace& face, glm::vec3& area_normal, glm::vec4& tangent, bool& warning) const
+{
+    long cv = (long)current_object->num_positions;
+    long cn = (long)current_object->num_normals;
+    long ct = (long)current_object->num_texcoords;
+
+    glm::vec3 vertex[3];
+    glm::vec2 texcoord[3];
+    bool undefined_normals = false;
+    for (int i=0; i<3; i++) // resolve all triangle vertex attribute tuples
+    {
+        long iv = indices.vertex[i], it = indices.texcoord[i], in = indices.normal[i];
+        if (indices.relative_mask & (1 << i))       iv += chunk.vertex_base;
+        if (indices.relative_mask & (1 << (3 + i))) it += chunk.texcoord_base;
+        if (indices.relative_mask & (1 << (6 + i))) in += chunk.normal_base;
+
+        if (iv<=0 || iv>cv) // undefined vertex index is not allowed: error
+            return false;
+        face.vertex[i] = (unsigned int)(iv-1);
+        vertex[i] = current_object->positions[iv-1];
+
+        face.texcoord[i] = OBJ_NO_INDEX; // no tex coords, invent some;
+        texcoord[i] = glm::vec2(0,0);
+        if (it<0 || it>ct) // illegal tex coord index, keep parsing but issue a warning
         {
-            glm::vec3 v;
-            file >> std::skipws >> v.x >> std::skipws >> v.y >> std::skipws >> v.z;
-            vertices[vi++] = v;
+            warning = true;
         }
-        else if (buf=="vn") // add normal
+        else if (it!=0)
         {
-            glm::vec3 n;
-            file >> std::skipws >> n.x >> std::skipws >> n.y >> std::skipws >> n.z;
-            normals[ni++] = n;
+            face.texcoord[i] = (unsigned int)(it-1);
+            texcoord[i] = current_object->texcoords[it-1];
         }
-        else if (buf=="vt") // add texture coordinate pair
+
+        face.normal[i] = OBJ_NO_INDEX;
+        if (in==0) // no normals defined, use the plane normal (or the smoothed normal of the smoothing group of the face)
         {
-            glm::vec2 t;
-            file >> std::skipws >> t.x >> std::skipws >> t.y;
-            texcoords[ti++] = t;
+            undefined_normals = true;
         }
-        else if (buf=="f") // found a face
+        else if (in<0 || in>cn) // illegal normal index, keep parsing but issue a warning
         {
-            std::string tuple;
-            Triangle tr;
-            bool undefined_normals = false;
-            for (int i=0; i<3; i++) // parse all triangle vertex attribute tuples
-            {
-                file >> std::skipws >> tuple;
+            warning = true;
+            undefined_normals = true;
+        }
+        else
+        {
+            face.normal[i] = (unsigned int)(in-1);
+        }
+    } // for all vertices
+    calcFaceTangent(vertex, texcoord, area_normal, tangent); // compute attributes
+    if (undefined_normals)
+        face.normal[0] = face.normal[1] = face.normal[2] = OBJ_NO_INDEX;
+    return true;
+}
 
-                unsigned long iv=0, it=0, in=0;
-                sscanf_s(tuple.c_str(), "%lu/%lu/%lu", &iv, &it, &in);
-                if (it==0)
-                    sscanf_s(tuple.c_str(), "%lu//%lu", &iv, &in);
+void OBJLoader::buildPrimitiveGroups()
+{
+    ScopedPhaseTimer timer(stats, LOAD_PHASE_FACES, num_faces * (sizeof(OBJFace) + sizeof(glm::vec3) + sizeof(glm::vec4) + sizeof(unsigned int)), num_faces);
 
-                if (iv==0 || iv>cv) // undefined vertex index is not allowed: error
-                {
-                    result = RESULT_BAD_FORMAT;
-                    clearBufferData();
-                    return;
-                }
-                tr.vertex[i] = vertices[iv-1];
+    // a range of faces of a chunk, built by a single task
+    struct FaceBlock
+    {
+        const OBJChunk*     chunk;
+        unsigned long       first_face;
+        unsigned long       num_faces;
+    };
+    std::vector<FaceBlock> blocks;
+
+    // the groups only refer to ranges of the face streams, which are filled in parallel
+    current_object->elements.reserve(face_groups.size());
+    for (size_t g = 0; g < face_groups.size(); ++g)
+    {
+        FaceGroup& face_group = face_groups[g];
 
-                if (it==0) // no tex coords, invent some;
-                {
-                    tr.texcoord[0][i] = glm::vec3(0,0,0);
-                }
-                else if (it>ct) // illegal tex coord index, keep parsing but issue a warning
-                {
-                    result = RESULT_FORMAT_WARNING;
-                    tr.texcoord[0][i] = glm::vec3(0,0,0);
-                }
-                else
-                {
-                    tr.texcoord[0][i] = glm::vec3(texcoords[it-1],0);
-                }
+        PrimitiveGroup& group = current_object->addElement(face_group.first_face);
+        group.material_index = face_group.material_index;
+        group.material_used = current_object->materials[face_group.material_index];
+        group.num_primitives = face_group.num_faces;
+        current_object->num_primitives += group.num_primitives;
+    }
 
-                if (in==0) // no normals defined, use triangle plane normal
-                {
-                    undefined_normals = true;
-                }
-                else if (in>cn) // illegal normal index, keep parsing but issue a warning
-                {
-                    result = RESULT_FORMAT_WARNING;
-                    undefined_normals = true;
-                }
-                else
-                {
-                    tr.normal[i] = normals[in-1];
-                }
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        unsigned long chunk_faces = (unsigned long)chunks[i].faces.size();
+        for (unsigned long f = 0; f < chunk_faces; f += OBJ_TRIANGLES_PER_TASK)
+        {
+            FaceBlock block = { &chunks[i], f, glm::min(chunk_faces - f, (unsigned long)OBJ_TRIANGLES_PER_TASK) };
+            blocks.push_back(block);
+        }
+    }
 
+    OBJFace* faces = arena.allocate<OBJFace>(num_faces);
+    glm::vec3* face_normals = arena.allocate<glm::vec3>(num_faces);
+    glm::vec4* face_tangents = arena.allocate<glm::vec4>(num_faces);
+    unsigned int* face_smoothing = arena.allocate<unsigned int>(num_faces);
+    updatePeakMemory();
 
-            } // for all vertices
-            tr.calcTangentBitangent(); // compute attributes
-            if (undefined_normals)
-            {
-                tr.normal[0] = tr.normal[1] = tr.normal[2] = tr.plane_normal;
-                tr.calcTangentBitangent();
-            }
-            group.addPrimitive(tr);
+    std::atomic<bool> bad_format(false);
+    std::atomic<bool> format_warning(false);
+    ThreadPool::getInstance().parallelFor(blocks.size(), [&](size_t b)
+    {
+        FaceBlock& block = blocks[b];
+        bool warning = false;
+
+        // the last smoothing run that starts at or before the first face of the block
+        unsigned long first = block.chunk->first_face + block.first_face;
+        size_t run = std::upper_bound(smoothing_runs.begin(), smoothing_runs.end(), first,
+            [](unsigned long face, const SmoothingRun& r) { return face < r.first_face; }) - smoothing_runs.begin();
+
+        for (unsigned long f = 0; f < block.num_faces && !bad_format; ++f)
+        {
+            unsigned long face = first + f;
+            if (!buildFace(*block.chunk, block.chunk->faces[block.first_face + f], faces[face], face_normals[face], face_tangents[face], warning))
+                bad_format = true;
+            while (run < smoothing_runs.size() && smoothing_runs[run].first_face <= face)
+                ++run;
+            face_smoothing[face] = (run > 0) ? smoothing_runs[run - 1].smoothing_group : 0;
         }
-        line++;
-    } // while
+        if (warning)
+            format_warning = true;
+    }, resolveNumThreads(num_threads));
+
+    current_object->faces = faces;
+    current_object->face_normals = face_normals;
+    current_object->face_tangents = face_tangents;
+    current_object->face_smoothing = face_smoothing;
+
+    if (bad_format)
+        result = RESULT_BAD_FORMAT;
+    else if (format_warning)
+        result = RESULT_FORMAT_WARNING;
+}
 
-    if (group.num_primitives>0)
+void OBJLoader::updatePeakMemory()
+{
+    // the parsed chunks, the streams and the groups that are alive at this point
+    size_t bytes = arena.getUsed() + face_groups.capacity() * sizeof(FaceGroup) + smoothing_runs.capacity() * sizeof(SmoothingRun) +
+                   chunks.capacity() * sizeof(OBJChunk);
+    for (size_t i = 0; i < chunks.size(); ++i)
     {
-        group.resize();
-        group.material_used = cur_material;
-        group.material_index = cur_material_index;
-        current_object->addElement(group);
-        group.clear();
+        bytes += chunks[i].vertices.capacity() * sizeof(glm::vec3) + chunks[i].normals.capacity() * sizeof(glm::vec3) +
+                 chunks[i].texcoords.capacity() * sizeof(glm::vec2) + chunks[i].faces.capacity() * sizeof(FaceIndices) +
+                 chunks[i].statements.capacity() * sizeof(OBJStatement);
     }
-
-    clearBufferData();
+    current_object->peak_memory = glm::max(current_object->peak_memory, bytes);
 }
 
 void OBJLoader::clearBufferData()
 {
-    SAFE_DELETE_ARRAY_POINTER(vertices);
-    SAFE_DELETE_ARRAY_POINTER(normals);
-    SAFE_DELETE_ARRAY_POINTER(texcoords);
+    // release the intermediate buffers (not just clear them). The streams in the arena belong to the mesh
+    std::vector<OBJChunk>().swap(chunks);
+    std::vector<FaceGroup>().swap(face_groups);
+    std::vector<SmoothingRun>().swap(smoothing_runs);
+    num_faces = 0;
 }
 
-OGLMesh* OBJLoader::loadMesh(std::string filename, std::string path, bool use_mipmaps)
+OBJMesh* OBJLoader::loadOBJ(std::string filename, std::string path)
 {
     if (current_object != nullptr)
         cleanup();
 
-    OGLMesh* oglmesh = nullptr;
+    // the streams of the previous mesh are discarded, their memory is reused
+    arena.reset();
+    stats.reset();
+
     result = RESULT_OK;
     current_object = new OBJMesh();
     current_object->filename = filename;
@@ -325,26 +527,193 @@ OGLMesh* OBJLoader::loadMesh(std::string filename, std::string path, bool use_mi
     {
         PrintToOutputWindow("Obj Mesh %s loading error %d.", current_object->filename.c_str(), result);
         cleanup();
+        return nullptr;
+    }
+
+    PrintToOutputWindow("Obj Mesh %s successfully loaded. Total elements: %d, total primitives: %d",  current_object->filename.c_str(), current_object->num_elements, current_object->num_primitives);
+
+    // the caller owns the mesh from now on
+    OBJMesh* mesh = current_object;
+    current_object = nullptr;
+    return mesh;
+}
+
+OGLMesh* OBJLoader::loadMesh(std::string filename, std::string path, bool use_mipmaps)
+{
+    OGLMesh* oglmesh = buildMesh(filename, path);
+    if (oglmesh == nullptr)
+        return nullptr;
+
+    if (oglmesh->loadDataToOpenGL(use_mipmaps))
+    {
+        PrintToOutputWindow("Loaded %s mesh to OpenGL. Total elements: %d, total primitives: %d, total vertices: %d", filename.c_str(), oglmesh->getNumElements(), oglmesh->getNumPrimitives(), oglmesh->getNumVertices());
     }
     else
     {
-        PrintToOutputWindow("Obj Mesh %s successfully loaded. Total elements: %d, total primitives: %d",  current_object->filename.c_str(), current_object->num_elements, current_object->num_primitives);
-        oglmesh = new OGLMesh(current_object->filename, current_object->path);
-        if (oglmesh->loadToOpenGL(*current_object, use_mipmaps))
+        oglmesh->release();
+        SAFE_DELETE(oglmesh);
+    }
+
+    return oglmesh;
+}
+
+OGLMesh* OBJLoader::buildMesh(std::string filename, std::string path)
+{
+    // a failed cache read (e.g. an out of date cache) is recorded apart, since loadOBJ starts its phases over
+    LoadStats cache_stats;
+    if (use_cache)
+    {
+        std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+        OGLMesh* oglmesh = new OGLMesh(filename, path);
+        bool cached = MeshCache::readMesh(*oglmesh, weld_epsilon);
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        if (cached)
         {
-            PrintToOutputWindow("Loaded %s mesh to OpenGL. Total elements: %d, total primitives: %d, total vertices: %d", current_object->filename.c_str(), oglmesh->getNumElements(), oglmesh->getNumPrimitives(), oglmesh->getNumVertices());
+            PrintToOutputWindow("Read %s from its mesh cache in %.2f ms", filename.c_str(), elapsed_ms);
+            oglmesh->computeFootprints();
+            oglmesh->computeCacheStats();
+            stats.reset();
+            stats.add(LOAD_PHASE_CACHE_READ, elapsed_ms, oglmesh->getVertexDataSize() + oglmesh->getIndexDataSize(), oglmesh->getNumPrimitives());
+            oglmesh->getLoadStats().merge(stats);
+            return oglmesh;
         }
-        else
+        SAFE_DELETE(oglmesh);
+        cache_stats.add(LOAD_PHASE_CACHE_READ, elapsed_ms, 0, 0);
+    }
+
+    OBJMesh* mesh = loadOBJ(filename, path);
+    stats.merge(cache_stats);
+    if (mesh == nullptr)
+        return nullptr;
+
+    // the materials are handed over to the OGLMesh
+    OGLMesh* oglmesh = new OGLMesh(mesh->filename, mesh->path);
+    oglmesh->setWeldEpsilon(weld_epsilon);
+    if (oglmesh->buildVertexData(*mesh))
+    {
+        size_t buffer_memory = oglmesh->getVertexDataSize() + oglmesh->getIndexDataSize();
+        PrintToOutputWindow("%s: Peak memory while building: %.2f KB (%.1f bytes per triangle), final buffers: %.2f KB (%.2fx)",
+            filename.c_str(), mesh->peak_memory / 1024.0, double(mesh->peak_memory) / glm::max(mesh->num_primitives, 1ul),
+            buffer_memory / 1024.0, double(mesh->peak_memory) / glm::max(buffer_memory, size_t(1)));
+
+        if (use_cache)
         {
-            oglmesh->release();
-            SAFE_DELETE(oglmesh);
+            ScopedPhaseTimer timer(stats, LOAD_PHASE_CACHE_WRITE, buffer_memory, oglmesh->getNumPrimitives());
+            std::vector<std::string> sources;
+            sources.push_back(mesh->filename);
+            sources.insert(sources.end(), mesh->material_libraries.begin(), mesh->material_libraries.end());
+            oglmesh->cached = MeshCache::writeMesh(*oglmesh, sources, weld_epsilon);
         }
-        cleanup();
+
+        // the mesh has recorded the welding and the tangents itself
+        oglmesh->getLoadStats().merge(stats);
+    }
+    else
+    {
+        SAFE_DELETE(oglmesh);
     }
+    SAFE_DELETE(mesh);
 
     return oglmesh;
 }
 
+bool OBJLoader::buildMeshes(const std::vector<std::string>& filenames, const std::vector<std::string>& paths, bool use_mipmaps,
+                            std::vector<OGLMesh*>& meshes, std::vector<AssetTiming>& timeline)
+{
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    meshes.assign(filenames.size(), nullptr);
+    timeline.assign(filenames.size(), AssetTiming());
+
+    // each mesh gets its own loader (a loader parses one file at a time). The parse of each file and the
+    // texture decodes of each mesh fan out further on the same pool
+    ThreadPool::getInstance().parallelFor(filenames.size(), [&](size_t i)
+    {
+        AssetTiming& timing = timeline[i];
+        timing.filename = filenames[i];
+        timing.build_start = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+        OBJLoader loader;
+        loader.setNumThreads(num_threads);
+        loader.setWeldEpsilon(weld_epsilon);
+        loader.setUseCache(use_cache);
+        meshes[i] = loader.buildMesh(filenames[i], paths[i]);
+        timing.build_end = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+        if (meshes[i] != nullptr)
+            meshes[i]->decodeTextures(use_mipmaps);
+        timing.decode_end = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        timing.upload_start = timing.upload_end = timing.decode_end;
+        timing.loaded = meshes[i] != nullptr;
+    });
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (meshes[i] == nullptr)
+            return false;
+    }
+    return true;
+}
+
+bool OBJLoader::loadMeshes(const std::vector<std::string>& filenames, const std::vector<std::string>& paths, bool use_mipmaps,
+                           std::vector<OGLMesh*>& meshes)
+{
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    std::vector<AssetTiming> timeline;
+    bool ok = buildMeshes(filenames, paths, use_mipmaps, meshes, timeline);
+
+    // only the OpenGL calls are serialized
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (meshes[i] == nullptr)
+            continue;
+
+        AssetTiming& timing = timeline[i];
+        timing.upload_start = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+        size_t size;
+        if (meshes[i]->uploadToOpenGL())
+        {
+            while (meshes[i]->uploadNextTexture((size_t)-1, size));
+        }
+        if (glError())
+        {
+            PrintToOutputWindow("An OpenGL error was generated while loading %s to the GPU. Skipping", filenames[i].c_str());
+            meshes[i]->release();
+            SAFE_DELETE(meshes[i]);
+            timing.loaded = ok = false;
+        }
+        else
+        {
+            meshes[i]->updated = true;
+            meshes[i]->finishUpload();
+            PrintToOutputWindow("Loaded %s mesh to OpenGL. Total elements: %d, total primitives: %d, total vertices: %d", filenames[i].c_str(), meshes[i]->getNumElements(), meshes[i]->getNumPrimitives(), meshes[i]->getNumVertices());
+        }
+        timing.upload_end = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    }
+
+    printTimeline(timeline, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count());
+    MaterialRegistry& registry = MaterialRegistry::getInstance();
+    PrintToOutputWindow("Materials: %u shared by all the meshes, %u without sharing", registry.getNumMaterials(), registry.getNumReferences());
+    TextureCache& cache = TextureCache::getInstance();
+    PrintToOutputWindow("Textures: %u in the cache, %llu files decoded for %llu texture references", cache.getNumTextures(), cache.getNumDecodes(), cache.getNumAcquires());
+    return ok;
+}
+
+void OBJLoader::printTimeline(const std::vector<AssetTiming>& timeline, double wall_ms)
+{
+    double slowest_ms = 0, total_ms = 0;
+    PrintToOutputWindow("%-24s %-19s  %8s  %-19s  %8s", "Asset timeline (ms)", "build", "decode", "upload", "total");
+    for (size_t i = 0; i < timeline.size(); ++i)
+    {
+        const AssetTiming& timing = timeline[i];
+        double asset_ms = (timing.decode_end - timing.build_start) + (timing.upload_end - timing.upload_start);
+        slowest_ms = glm::max(slowest_ms, asset_ms);
+        total_ms += asset_ms;
+        PrintToOutputWindow("%-24s %8.2f - %8.2f  %8.2f  %8.2f - %8.2f  %8.2f%s", timing.filename.c_str(),
+            timing.build_start, timing.build_end, timing.decode_end, timing.upload_start, timing.upload_end, asset_ms, timing.loaded ? "" : "  FAILED");
+    }
+    PrintToOutputWindow("Wall time: %.2f ms, slowest asset: %.2f ms, sum of all assets: %.2f ms", wall_ms, slowest_ms, total_ms);
+}
+
 void OBJLoader::loadMaterials(std::string& mtllib, std::vector<OBJMaterial*>& material_map)
 {
     if (mtllib.empty())
@@ -354,71 +723,85 @@ void OBJLoader::loadMaterials(std::string& mtllib, std::vector<OBJMaterial*>& ma
         return;
     }
 
-    std::ifstream file;
+    ScopedPhaseTimer timer(stats, LOAD_PHASE_MATERIALS);
+    MappedFile file;
     std::string fileNameWithPath = current_object->path + "\\" + mtllib;
-    file.open(fileNameWithPath.c_str(), std::ifstream::in);
-    if (file.bad() || !file.is_open())
+    if (!mapFile(fileNameWithPath, file))
     {
         result = RESULT_FILE_NOT_FOUND;
         PrintToOutputWindow("%s material not found in path %s", mtllib.c_str(), current_object->path.c_str());
         return;
     }
+    timer.setBytes(file.size);
 
-    std::string buf;
     OBJMaterial default_mat; // setup a dummy material to prevent bad file syntax problems
     OBJMaterial *current_mat = &default_mat;
 
-    while (file.good())
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    while (p < end)
     {
-        file >> std::skipws >> buf;
-        if (buf=="newmtl")
+        p = skipBlanks(p, end);
+        const char* keyword = p;
+        const char* keyword_end = tokenEnd(p, end);
+        p = keyword_end;
+
+        if (tokenEquals(keyword, keyword_end, "newmtl"))
         {
             current_mat = new OBJMaterial();
-            file >> std::skipws >> current_mat->m_name;
+            p = parseName(p, end, current_mat->m_name);
             material_map.push_back(current_mat);
         }
-        else if (buf=="Kd")
+        else if (tokenEquals(keyword, keyword_end, "Kd"))
         {
-            file >> std::skipws >> current_mat->m_diffuse.x >> std::skipws >> current_mat->m_diffuse.y >> std::skipws >> current_mat->m_diffuse.z;
+            p = parseFloat(p, end, current_mat->m_diffuse.x);
+            p = parseFloat(p, end, current_mat->m_diffuse.y);
+            p = parseFloat(p, end, current_mat->m_diffuse.z);
         }
-        else if (buf=="Ke")
+        else if (tokenEquals(keyword, keyword_end, "Ke"))
         {
-            file >> std::skipws >> current_mat->m_emission.x >> std::skipws >> current_mat->m_emission.y >> std::skipws >> current_mat->m_emission.z;
+            p = parseFloat(p, end, current_mat->m_emission.x);
+            p = parseFloat(p, end, current_mat->m_emission.y);
+            p = parseFloat(p, end, current_mat->m_emission.z);
         }
-        else if (buf=="Ks")
+        else if (tokenEquals(keyword, keyword_end, "Ks"))
         {
-            file >> std::skipws >> current_mat->m_specular.x >> std::skipws >> current_mat->m_specular.y >> std::skipws >> current_mat->m_specular.z;
+            p = parseFloat(p, end, current_mat->m_specular.x);
+            p = parseFloat(p, end, current_mat->m_specular.y);
+            p = parseFloat(p, end, current_mat->m_specular.z);
         }
-        else if (buf=="d")
+        else if (tokenEquals(keyword, keyword_end, "d"))
         {
             flt opacity;
-            file >> std::skipws >> opacity;
+            p = parseFloat(p, end, opacity);
             current_mat->m_opacity = opacity;
         }
-        else if (buf=="Ns")
+        else if (tokenEquals(keyword, keyword_end, "Ns"))
         {
             flt shininess;
-            file >> std::skipws >> shininess;
+            p = parseFloat(p, end, shininess);
             current_mat->m_gloss = glm::min(shininess/flt(127),flt(1));
         }
-        else if (buf=="map_Kd")
+        else if (tokenEquals(keyword, keyword_end, "map_Kd"))
         {
-            file >> std::skipws >> current_mat->m_diffuse_opacity_tex_file;
+            p = parseName(p, end, current_mat->m_diffuse_opacity_tex_file);
         }
-        else if (buf=="map_Ks")
+        else if (tokenEquals(keyword, keyword_end, "map_Ks"))
         {
-            file >> std::skipws >> current_mat->m_specular_gloss_tex_file;
+            p = parseName(p, end, current_mat->m_specular_gloss_tex_file);
         }
-        else if (buf=="map_Ke")
+        else if (tokenEquals(keyword, keyword_end, "map_Ke"))
         {
-            file >> std::skipws >> current_mat->m_emission_tex_file;
+            p = parseName(p, end, current_mat->m_emission_tex_file);
         }
-        else if (buf=="map_bump")
+        else if (tokenEquals(keyword, keyword_end, "map_bump"))
         {
-            file >> std::skipws >> current_mat->m_normal_tex_file;
+            p = parseName(p, end, current_mat->m_normal_tex_file);
         }
+
+        p = skipLine(p, end);
     }
-    file.close();
+    unmapFile(file);
 
 
     // add a default material, if none was found
@@ -427,4 +810,5 @@ void OBJLoader::loadMaterials(std::string& mtllib, std::vector<OBJMaterial*>& ma
         material_map.push_back(new OBJMaterial());
         material_map[0]->m_name = "default";
     }
+    timer.setItems(material_map.size());
 }
\ No newline at end of file
@@ -21,8 +21,15 @@
 
 // includes ////////////////////////////////////////
 #include "OBJMaterial.h"
+#include "../MemoryArena.h"
+#include "LoadStats.h"
+
+#include <unordered_map>    // - Header file for the material lookup
 
 // defines /////////////////////////////////////////
+#define OBJ_MIN_CHUNK_SIZE          (1024 * 1024)   // files are split for parallel parsing in parts of at least this size (in bytes)
+#define OBJ_CHUNKS_PER_THREAD       4               // more chunks than threads balance the work when chunks differ in content
+#define OBJ_TRIANGLES_PER_TASK      4096            // number of triangles built by each parallel task
 
 
 // forward declarations ////////////////////////////
@@ -38,147 +45,218 @@ enum resultcode
     RESULT_FORMAT_WARNING
 };
 
-struct Triangle
-{
-    glm::vec3                            plane_normal;
-    flt                                  area;
-    glm::vec3                            tangent[3];
-    glm::vec3                            bitangent[3];
-    glm::vec3                            vertex[3];
-    glm::vec3                            normal[3];
-    glm::vec3                            texcoord[2][3];
-
-    Triangle():
-        plane_normal(glm::vec3(0,1,0)),
-        area(1)
-    {
-        for(int i = 0; i < 3; ++i)
-        {
-            vertex[i] = glm::vec3(0);
-            normal[i] = glm::vec3(0);
-            texcoord[0][i] = glm::vec3(0);
-            texcoord[1][i] = glm::vec3(0);
-        }
-    }
-
-    void calcTangentBitangent()
-    {
-        plane_normal = glm::cross(vertex[1]-vertex[0],vertex[2]-vertex[0]);
-        area = glm::length(plane_normal)/flt(2);
-        plane_normal = glm::normalize(plane_normal);
-
-        // gepap: implementation of the method found in Math. for CG and Game progr., E. Lengyel.
-
-        flt u21, v21, u31, v31, det;
-        u21 = texcoord[0][1].s - texcoord[0][0].s;
-        v21 = texcoord[0][1].t - texcoord[0][0].t;
-        u31 = texcoord[0][2].s - texcoord[0][0].s;
-        v31 = texcoord[0][2].t - texcoord[0][0].t;
-        det = u21 * v31 - u31 * v21;
-        glm::vec3 q2 = vertex[1]-vertex[0];
-        glm::vec3 q3 = vertex[2]-vertex[0];
-        glm::vec3 t;
-
-        if (det!=0.0f)
-        {
-            t.x = (v31*q2.x-v21*q3.x)/det;
-            t.y = (v31*q2.y-v21*q3.y)/det;
-            t.z = (v31*q2.z-v21*q3.z)/det;
-            t = glm::normalize(t);
-        }
-        else
-        {
-            t = glm::vec3(0,0,1);
-            if (glm::abs((glm::dot(plane_normal,t)-1)) < flt(1.0e-07f ))
-                t = glm::vec3(0,1,0);
-            t = glm::cross(t,plane_normal);
-        }
+// attribute indices of a face corner without a texture coordinate or a normal
+#define OBJ_NO_INDEX                0xFFFFFFFFu
 
-        for (short vi = 0; vi < 3; ++vi)
-        {
-            bitangent[vi] = glm::normalize(glm::cross(normal[vi], t));
-            tangent[vi] =   glm::normalize(glm::cross(bitangent[vi], normal[vi]));
-        }
-    }
+// a face of the mesh. The indices are 0-based, into the attribute streams of the mesh.
+// the normals are either all present or all OBJ_NO_INDEX (the plane normal of the face is used then)
+struct OBJFace
+{
+    unsigned int                         vertex[3];
+    unsigned int                         texcoord[3];
+    unsigned int                         normal[3];
 };
 
+// area-weighted plane normal and tangent direction of a triangle. The handedness of its texture mapping
+// (the sign of the bitangent, cross(normal, tangent) * w) is stored in the w of the tangent
+inline void calcFaceTangent(const glm::vec3 vertex[3], const glm::vec2 texcoord[3], glm::vec3& area_normal, glm::vec4& tangent)
+{
+    glm::vec3 q2 = vertex[1]-vertex[0];
+    glm::vec3 q3 = vertex[2]-vertex[0];
+    glm::vec3 cross = glm::cross(q2, q3);
+    area_normal = cross * flt(0.5);
+    flt area = glm::length(cross) * flt(0.5);
+
+    // gepap: implementation of the method found in Math. for CG and Game progr., E. Lengyel.
+    // only the direction of the tangent is needed, so it is not divided by the determinant, just flipped by its sign
+
+    flt u21, v21, u31, v31, det;
+    u21 = texcoord[1].s - texcoord[0].s;
+    v21 = texcoord[1].t - texcoord[0].t;
+    u31 = texcoord[2].s - texcoord[0].s;
+    v31 = texcoord[2].t - texcoord[0].t;
+    det = u21 * v31 - u31 * v21;
+    glm::vec3 t = (v31*q2 - v21*q3) * ((det < 0) ? flt(-1) : flt(1));
+    flt length = glm::length(t);
+
+    // faces without a texture mapping do not contribute to the tangents of their vertices
+    if (det != 0 && length > 0)
+        tangent = glm::vec4(t * (area / length), (det < 0) ? flt(-1) : flt(1));
+    else
+        tangent = glm::vec4(0, 0, 0, 1);
+}
+
+// a range of consecutive faces of the mesh that use the same material
 struct PrimitiveGroup
 {
-    std::vector<Triangle>                primitives;
+    unsigned long                        first_primitive;
     unsigned long                        num_primitives;
-    OBJMaterial*                        material_used;
-    int                                    material_index;
+    OBJMaterial*                         material_used;
+    int                                  material_index;
 
-    PrimitiveGroup(unsigned long hint_size) :
+    PrimitiveGroup(unsigned long first) :
+        first_primitive(first),
+        num_primitives(0),
         material_used(nullptr),
-        material_index(-1), num_primitives(0)
-    {
-        primitives.reserve(hint_size);
-    }
-
-    ~PrimitiveGroup()
+        material_index(-1)
     {
-        primitives.clear();
-    }
 
-    void PrimitiveGroup::addPrimitive(Triangle & prim)
-    {
-        primitives.push_back(prim);
-        num_primitives++;
-    }
-
-    void PrimitiveGroup::resize()
-    {
-        primitives.resize(primitives.size());
-    }
-
-    void PrimitiveGroup::clear()
-    {
-        primitives.clear();
-        num_primitives = 0;
     }
 };
 
+// the geometry is kept in structure-of-arrays streams, which are allocated in the arena of the loader
+// that loaded the mesh. They are valid until the next load of that loader (or until it is destroyed)
 struct OBJMesh
 {
     std::vector<PrimitiveGroup>            elements;
     unsigned long                        num_elements;
     unsigned long                        num_primitives;
     std::vector<OBJMaterial*>            materials;
+    std::unordered_map<std::string, int> material_lookup;    // index of the first material with each name
+    std::vector<std::string>             material_libraries;
     std::string                            filename;
     std::string                            path;
     bool                                loaded;
+    const glm::vec3*                     positions;
+    unsigned long                        num_positions;
+    const glm::vec3*                     normals;
+    unsigned long                        num_normals;
+    const glm::vec2*                     texcoords;
+    unsigned long                        num_texcoords;
+    const OBJFace*                       faces;              // num_primitives faces, in element order
+    const glm::vec3*                     face_normals;       // plane normal of each face, scaled by its area
+    const glm::vec4*                     face_tangents;      // tangent direction of each face, scaled by its area, and its handedness in w
+    const unsigned int*                  face_smoothing;     // smoothing group of each face (0 for none)
+    size_t                               peak_memory;        // the most bytes of intermediate data alive at the same time while building the mesh
 
     OBJMesh():
         num_elements(0),
         num_primitives(0),
-        loaded(false)
+        loaded(false),
+        positions(nullptr),
+        num_positions(0),
+        normals(nullptr),
+        num_normals(0),
+        texcoords(nullptr),
+        num_texcoords(0),
+        faces(nullptr),
+        face_normals(nullptr),
+        face_tangents(nullptr),
+        face_smoothing(nullptr),
+        peak_memory(0)
     {
 
     }
 
     int findMaterialByName(std::string& name, OBJMaterial ** mat)
     {
-        for (unsigned int i= 0; i< materials.size(); i++ )
+        std::unordered_map<std::string, int>::const_iterator it = material_lookup.find(name);
+        if (it != material_lookup.end())
         {
-            if (materials[i]!=nullptr && materials[i]->m_name==name)
-            {
-                *mat = materials[i];
-                return i;
-            }
+            *mat = materials[it->second];
+            return it->second;
         }
         *mat = nullptr;
         return -1;
     }
 
-    void addElement(PrimitiveGroup group)
+    // appends a material. A material with the name of a previous one is kept, but is not found by name
+    void addMaterial(OBJMaterial* mat)
+    {
+        material_lookup.emplace(mat->m_name, (int)materials.size());
+        materials.push_back(mat);
+    }
+
+    // creates a new (empty) group in place and returns it for filling
+    PrimitiveGroup& addElement(unsigned long first_primitive)
     {
-        elements.push_back(group);
+        elements.emplace_back(first_primitive);
         num_elements++;
-        num_primitives+=group.num_primitives;
+        return elements.back();
+    }
+
+    // size of the geometry streams in bytes
+    size_t getStreamMemory(void) const
+    {
+        return num_positions * sizeof(glm::vec3) + num_normals * sizeof(glm::vec3) + num_texcoords * sizeof(glm::vec2) +
+               num_primitives * (sizeof(OBJFace) + sizeof(glm::vec3) + sizeof(glm::vec4) + sizeof(unsigned int));
     }
 };
 
+// attribute indices of a face (1-based, 0 means not present)
+// negative (relative) indices are resolved against the attributes parsed so far. While parsing a chunk,
+// these are only known relative to the start of the chunk and are marked in relative_mask,
+// (bits 0-2 for vertices, 3-5 for texcoords and 6-8 for normals), so that they can be fixed up on merging
+struct FaceIndices
+{
+    long                                 vertex[3];
+    long                                 texcoord[3];
+    long                                 normal[3];
+    unsigned short                       relative_mask;
+};
+
+// a range of consecutive faces sharing the same material
+struct FaceGroup
+{
+    unsigned long                        first_face;
+    unsigned long                        num_faces;
+    int                                  material_index;
+};
+
+// statements that change the material or the group of the following faces
+enum OBJStatementType
+{
+    OBJ_STATEMENT_USEMTL,
+    OBJ_STATEMENT_GROUP,
+    OBJ_STATEMENT_MTLLIB,
+    OBJ_STATEMENT_SMOOTHING
+};
+
+// a statement found while parsing a chunk, along with the number of faces of the chunk that precede it
+struct OBJStatement
+{
+    OBJStatementType                     type;
+    unsigned long                        face_offset;
+    std::string                          name;
+    unsigned int                         smoothing_group;    // s statements only (0 for off)
+};
+
+// the smoothing group of the faces from first_face up to the next run
+struct SmoothingRun
+{
+    unsigned long                        first_face;
+    unsigned int                         smoothing_group;
+};
+
+// the contents of a line-aligned part of the file.
+// chunks are parsed independently and merged in file order afterwards
+struct OBJChunk
+{
+    const char*                          begin;
+    const char*                          end;
+    std::vector<glm::vec3>               vertices;
+    std::vector<glm::vec3>               normals;
+    std::vector<glm::vec2>               texcoords;
+    std::vector<FaceIndices>             faces;
+    std::vector<OBJStatement>            statements;
+    unsigned long                        first_face;         // the position of the chunk in the file, set on merging
+    unsigned long                        vertex_base;
+    unsigned long                        texcoord_base;
+    unsigned long                        normal_base;
+};
+
+// timings of loading a single asset, in ms from the start of a buildMeshes/loadMeshes call
+struct AssetTiming
+{
+    std::string                          filename;
+    double                               build_start;        // parse (or mesh cache read) and welding
+    double                               build_end;
+    double                               decode_end;         // texture decoding
+    double                               upload_start;       // OpenGL uploads (loadMeshes only)
+    double                               upload_end;
+    bool                                 loaded;
+};
+
 class OBJLoader
 {
 protected:
@@ -192,15 +270,27 @@ private:
     // private variable declarations
     resultcode                          result;
     OBJMesh *                           current_object;
-    glm::vec3*                          vertices;
-    glm::vec3*                          normals;
-    glm::vec2*                          texcoords;
+    std::vector<OBJChunk>               chunks;
+    unsigned long                       num_faces;
+    std::vector<FaceGroup>              face_groups;
+    std::vector<SmoothingRun>           smoothing_runs;
+    MemoryArena                         arena;              // the geometry streams of the last mesh, reset on every load
+    LoadStats                           stats;              // the phases of the last load
     virtual void                        cleanup(void);
     std::string                         mtl_filename;
+    unsigned int                        num_threads;
+    flt                                 weld_epsilon;
+    bool                                use_cache;
 
     // private function declarations
     void                                loadMaterials(std::string& mtllib, std::vector<OBJMaterial*>& material_map);
     void                                loadGeometry(void);
+    void                                parseGeometry(const char* data, size_t size);
+    void                                parseChunk(OBJChunk& chunk);
+    void                                mergeChunks(void);
+    void                                buildPrimitiveGroups(void);
+    bool                                buildFace(const OBJChunk& chunk, const FaceIndices& indices, OBJFace& face, glm::vec3& area_normal, glm::vec4& tangent, bool& warning) const;
+    void                                updatePeakMemory(void);
     void                                clearBufferData(void);
 
 public:
@@ -213,10 +303,41 @@ public:
     // public function declarations
     class OGLMesh*                      loadMesh(std::string filename, std::string path, bool use_mipmaps);
 
-    // get functions
+    // parses the file (or reads its mesh cache) and builds the CPU data of the mesh, without any OpenGL calls,
+    // so it can be called from a worker thread. The textures are not loaded. Returns nullptr on failure
+    class OGLMesh*                      buildMesh(std::string filename, std::string path);
+
+    // builds several meshes and decodes their textures at the same time, on the thread pool. No OpenGL calls are made.
+    // meshes receives one mesh per file (nullptr for the ones that failed). Returns false if any failed
+    bool                                buildMeshes(const std::vector<std::string>& filenames, const std::vector<std::string>& paths, bool use_mipmaps,
+                                                    std::vector<class OGLMesh*>& meshes, std::vector<AssetTiming>& timeline);
+
+    // buildMeshes, followed by the OpenGL uploads of all the meshes on the calling thread. Prints the timeline of each asset
+    bool                                loadMeshes(const std::vector<std::string>& filenames, const std::vector<std::string>& paths, bool use_mipmaps,
+                                                   std::vector<class OGLMesh*>& meshes);
 
+    // print the timeline of loading several assets, along with the wall time and the time of the slowest asset
+    static void                         printTimeline(const std::vector<AssetTiming>& timeline, double wall_ms);
+
+    // parses the file without creating any OpenGL resources.
+    // the returned mesh (and its materials) are owned by the caller, but its geometry streams are in the arena of
+    // this loader and are only valid until the next load (or until the loader is destroyed). Returns nullptr on failure
+    OBJMesh*                            loadOBJ(std::string filename, std::string path);
+
+    // get functions
+    resultcode                          getResult(void)                         {return result;}
+    unsigned int                        getNumThreads(void)                     {return num_threads;}
+    bool                                getUseCache(void)                       {return use_cache;}
+    // the phases of the last loadOBJ/buildMesh (buildMesh also adds them to the mesh, see OGLMesh::getLoadStats)
+    const LoadStats&                    getLoadStats(void) const                {return stats;}
 
     // set functions
+    // number of threads used for parsing (0 uses all cores, 1 parses on the calling thread only)
+    void                                setNumThreads(unsigned int threads)     {num_threads = threads;}
+    // vertices of the meshes created by loadMesh that differ by less than epsilon are welded (see OGLMesh::setWeldEpsilon)
+    void                                setWeldEpsilon(flt epsilon)             {weld_epsilon = epsilon;}
+    // loadMesh reads the mesh from its binary cache when it is up to date, and writes the cache after parsing otherwise
+    void                                setUseCache(bool cache)                 {use_cache = cache;}
 
 };
 
@@ -17,6 +17,7 @@
 #include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
 #include "OBJMaterial.h"    // - Header file for the OBJMaterial class
 #include "Texture.h"        // - Header file for the Texture class
+#include "TextureCache.h"   // - Header file for the TextureCache class
 
 // Constructor
 OBJMaterial::OBJMaterial(void):
@@ -37,20 +38,33 @@ m_diffuse_opacity_tex(nullptr),
 m_specular_gloss_tex(nullptr),
 m_emission_tex(nullptr),
 m_normal_tex(nullptr),
+m_sampler_desc(),
 m_name()
 {
-
+    for (int map = 0; map < MPT_MATERIAL_MAP_COUNT; ++map)
+        m_samplers[map] = 0;
 }
 
 // Destructor
 OBJMaterial::~OBJMaterial()
 {
-
+    // the textures may be shared with other materials
+    TextureCache& cache = TextureCache::getInstance();
+    cache.release(m_diffuse_opacity_tex);
+    cache.release(m_specular_gloss_tex);
+    cache.release(m_emission_tex);
+    cache.release(m_normal_tex);
 }
 
 // other functions
 bool OBJMaterial::operator == (OBJMaterial& m)
 {
+    for (int map = 0; map < MPT_MATERIAL_MAP_COUNT; ++map)
+    {
+        if (SamplerRegistry::getKey(m_sampler_desc[map]) != SamplerRegistry::getKey(m.m_sampler_desc[map]))
+            return false;
+    }
+
     return (
         m_diffuse                    ==        m.m_diffuse                    &&
         m_specular                   ==        m.m_specular                   &&
@@ -91,4 +105,23 @@ void OBJMaterial::dump()
         PrintToOutputWindow("\t\temission_tex_file: %s\n", m_emission_tex_file.c_str());
 }
 
+void OBJMaterial::resolveSamplers(void)
+{
+    if (!SAMPLER_OBJECTS)
+        return;
+
+    // in the order of MATERIAL_MAP_TYPE
+    Texture* textures[MPT_MATERIAL_MAP_COUNT] = { m_diffuse_opacity_tex, m_normal_tex, m_specular_gloss_tex, m_emission_tex };
+    for (int map = 0; map < MPT_MATERIAL_MAP_COUNT; ++map)
+    {
+        if (m_samplers[map] != 0 || textures[map] == nullptr || !textures[map]->generated())
+            continue;
+
+        // a mipmap minification filter would make a texture without mipmaps incomplete
+        SamplerDesc desc = m_sampler_desc[map];
+        desc.mipmaps = textures[map]->mipmapped();
+        m_samplers[map] = SamplerRegistry::getInstance().getSampler(desc);
+    }
+}
+
 // eof ///////////////////////////////// class material
\ No newline at end of file
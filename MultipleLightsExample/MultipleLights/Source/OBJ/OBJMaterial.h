@@ -19,7 +19,7 @@
 //using namespace
 
 // includes ////////////////////////////////////////
-
+#include "SamplerRegistry.h"
 
 // defines /////////////////////////////////////////
 
@@ -96,6 +96,8 @@ public:
     class Texture*                      m_specular_gloss_tex;
     class Texture*                      m_emission_tex;
     class Texture*                      m_normal_tex;
+    SamplerDesc                         m_sampler_desc[MPT_MATERIAL_MAP_COUNT]; // how each map is sampled (mipmaps is taken from its texture)
+    GLuint                              m_samplers[MPT_MATERIAL_MAP_COUNT];     // 0 until the texture of the map is generated
     std::string                         m_name;
 
 
@@ -104,6 +106,9 @@ public:
 
     void                                dump();
 
+    // gets the samplers of the maps whose textures have been generated, from the SamplerRegistry (on the OpenGL thread)
+    void                                resolveSamplers(void);
+
     // get functions
 
 
@@ -0,0 +1,302 @@
+//----------------------------------------------------//
+//                                                    //
+// File: OBJTokenizer.h                               //
+// Tokenizer and number parser for .obj/.mtl files.   //
+// Numbers are parsed without locale dependent calls  //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+#ifndef OBJTOKENIZER_H
+#define OBJTOKENIZER_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+// HelpLib.h should be included first (for glm and flt)
+#include <cmath>            // - Header file for pow
+
+// defines /////////////////////////////////////////
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define OBJ_TOKENIZER_SSE2
+#include <emmintrin.h>      // - Header file for the SSE2 intrinsics
+#ifdef _MSC_VER
+#include <intrin.h>         // - Header file for _BitScanForward
+#endif
+#endif
+
+#define OBJ_MAX_MANTISSA_DIGITS     19      // digits that fit in an unsigned 64-bit integer. Any more are only counted
+
+// forward declarations ////////////////////////////
+
+
+// tokenizer functions /////////////////////////////
+// These walk the file contents through a pointer. The contents are never copied.
+
+// skip spaces and tabs (stops at the end of the line)
+static inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        ++p;
+    return p;
+}
+
+// move to the first character of the next line
+static inline const char* skipLine(const char* p, const char* end)
+{
+    const char* eol = (const char*)memchr(p, NEW_LINE_CHAR, end - p);
+    return (eol != nullptr) ? eol + 1 : end;
+}
+
+// find the end of the token starting at p
+static inline const char* tokenEnd(const char* p, const char* end)
+{
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != NEW_LINE_CHAR)
+        ++p;
+    return p;
+}
+
+static inline bool tokenEquals(const char* begin, const char* end, const char* keyword)
+{
+    size_t length = strlen(keyword);
+    return size_t(end - begin) == length && memcmp(begin, keyword, length) == 0;
+}
+
+// read the next token of the line into a string (used for names)
+static inline const char* parseName(const char* p, const char* end, std::string& name)
+{
+    p = skipBlanks(p, end);
+    const char* e = tokenEnd(p, end);
+    name.assign(p, e);
+    return e;
+}
+
+// number parsing //////////////////////////////////
+
+#ifdef OBJ_TOKENIZER_SSE2
+// weights for converting the first n (0-8) digits of a 16-byte block to an integer in three steps:
+// digit pairs (_mm_madd_epi16), pairs of pairs (_mm_madd_epi16) and the two halves (scalar).
+// the weights right-align the n digits, so digits past the run are multiplied by 0
+static const short s_digit_pair_weights[9][8] =
+{
+    {0, 0, 0, 0, 0, 0, 0, 0},
+    {1, 0, 0, 0, 0, 0, 0, 0},
+    {10, 1, 0, 0, 0, 0, 0, 0},
+    {10, 1, 1, 0, 0, 0, 0, 0},
+    {10, 1, 10, 1, 0, 0, 0, 0},
+    {10, 1, 10, 1, 1, 0, 0, 0},
+    {10, 1, 10, 1, 10, 1, 0, 0},
+    {10, 1, 10, 1, 10, 1, 1, 0},
+    {10, 1, 10, 1, 10, 1, 10, 1},
+};
+
+static const short s_digit_quad_weights[9][8] =
+{
+    {0, 0, 0, 0, 0, 0, 0, 0},
+    {1, 0, 0, 0, 0, 0, 0, 0},
+    {1, 0, 0, 0, 0, 0, 0, 0},
+    {10, 1, 0, 0, 0, 0, 0, 0},
+    {100, 1, 0, 0, 0, 0, 0, 0},
+    {100, 1, 1, 0, 0, 0, 0, 0},
+    {100, 1, 1, 0, 0, 0, 0, 0},
+    {100, 1, 10, 1, 0, 0, 0, 0},
+    {100, 1, 100, 1, 0, 0, 0, 0},
+};
+
+static const unsigned int s_digit_half_weights[9][2] =
+{
+    {0, 0},
+    {1, 0},
+    {1, 0},
+    {1, 0},
+    {1, 0},
+    {10, 1},
+    {100, 1},
+    {1000, 1},
+    {10000, 1},
+};
+
+static inline unsigned int countTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+// classify 16 characters at once. Returns the length of the digit run at p (0-16)
+// and converts its first (up to) 8 digits to an integer. 16 bytes must be readable at p
+static inline unsigned int digitRunSSE2(const char* p, unsigned int& value)
+{
+    __m128i chars = _mm_loadu_si128((const __m128i*)p);
+    __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    // a character is a digit if (c - '0') is at most 9 as an unsigned byte
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+    unsigned int run = countTrailingZeros(~(unsigned int)_mm_movemask_epi8(is_digit));
+    unsigned int n = glm::min(run, 8u);
+
+    __m128i digits16 = _mm_unpacklo_epi8(digits, _mm_setzero_si128());
+    __m128i pairs = _mm_madd_epi16(digits16, _mm_loadu_si128((const __m128i*)s_digit_pair_weights[n]));
+    __m128i quads = _mm_madd_epi16(_mm_packs_epi32(pairs, pairs), _mm_loadu_si128((const __m128i*)s_digit_quad_weights[n]));
+    value = (unsigned int)_mm_cvtsi128_si32(quads) * s_digit_half_weights[n][0] +
+            (unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(quads, 4)) * s_digit_half_weights[n][1];
+    return run;
+}
+#endif
+
+// append a run of decimal digits to value (value = value * 10^k + digits).
+// kept is the number of digits accumulated in value so far and total the number of digits seen.
+// only the first OBJ_MAX_MANTISSA_DIGITS digits are accumulated
+static inline const char* parseDigits(const char* p, const char* end, unsigned long long& value, int& kept, int& total)
+{
+    static const unsigned long long powers_of_10[9] = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull };
+
+#ifdef OBJ_TOKENIZER_SSE2
+    // whole blocks of (up to) 8 digits at a time, while 16 bytes can be read
+    while (end - p >= 16)
+    {
+        unsigned int block;
+        unsigned int run = digitRunSSE2(p, block);
+        unsigned int n = glm::min(run, 8u);
+        if (kept + int(n) > OBJ_MAX_MANTISSA_DIGITS)
+            break;
+        value = value * powers_of_10[n] + block;
+        kept += n;
+        total += n;
+        p += n;
+        if (run < 8)
+            return p;
+    }
+#endif
+
+    // digit by digit near the end of the data (or for very long numbers)
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        if (kept < OBJ_MAX_MANTISSA_DIGITS)
+        {
+            value = value * 10 + (*p - '0');
+            ++kept;
+        }
+        ++total;
+        ++p;
+    }
+    return p;
+}
+
+// returns mantissa * 10^exponent as a float.
+// small mantissas and exponents are exact in float, so a single (correctly rounded) operation gives the
+// same result as strtof. Otherwise the value is computed in double and rounded to float
+static inline flt composeFloat(unsigned long long mantissa, int exponent)
+{
+    static const float float_powers_of_10[11] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    static const double double_powers_of_10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    if (mantissa == 0)
+        return flt(0);
+
+    if (mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10)
+    {
+        float m = float(mantissa);
+        return (exponent < 0) ? m / float_powers_of_10[-exponent] : m * float_powers_of_10[exponent];
+    }
+
+    double m = double(mantissa);
+    if (exponent < 0)
+        m = (exponent >= -22) ? m / double_powers_of_10[-exponent] : m / pow(10.0, -exponent);
+    else
+        m = (exponent <= 22) ? m * double_powers_of_10[exponent] : m * pow(10.0, exponent);
+    return flt(m);
+}
+
+// parse a floating point number in the forms [-+]digits[.digits][(e|E)[-+]digits]
+static inline const char* parseFloat(const char* p, const char* end, flt& value)
+{
+    p = skipBlanks(p, end);
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    unsigned long long mantissa = 0;
+    int kept = 0, total = 0;
+    p = parseDigits(p, end, mantissa, kept, total);
+    // integer digits that did not fit in the mantissa only scale it
+    int exponent = total - kept;
+
+    if (p < end && *p == '.')
+    {
+        int kept_integer = kept;
+        p = parseDigits(p + 1, end, mantissa, kept, total);
+        exponent -= kept - kept_integer;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* e = p + 1;
+        bool negative_exponent = false;
+        if (e < end && (*e == '-' || *e == '+'))
+        {
+            negative_exponent = *e == '-';
+            ++e;
+        }
+        unsigned long long exponent_value = 0;
+        int exponent_kept = 0, exponent_total = 0;
+        e = parseDigits(e, end, exponent_value, exponent_kept, exponent_total);
+        if (exponent_total > 0)
+        {
+            int clamped = (exponent_value < 1000ull) ? int(exponent_value) : 1000;
+            exponent += negative_exponent ? -clamped : clamped;
+            p = e;
+        }
+    }
+
+    value = composeFloat(mantissa, exponent);
+    if (negative)
+        value = -value;
+    return tokenEnd(p, end);
+}
+
+// parse a (possibly negative) index (0 is returned if there are no digits)
+static inline const char* parseIndex(const char* p, const char* end, long& value)
+{
+    bool negative = p < end && *p == '-';
+    if (negative)
+        ++p;
+    unsigned long long digits = 0;
+    int kept = 0, total = 0;
+    p = parseDigits(p, end, digits, kept, total);
+    value = negative ? -long(digits) : long(digits);
+    return p;
+}
+
+// parse a face vertex tuple in any of the forms v, v/t, v//n and v/t/n
+static inline const char* parseFaceTuple(const char* p, const char* end, long& iv, long& it, long& in)
+{
+    it = in = 0;
+    p = skipBlanks(p, end);
+    p = parseIndex(p, end, iv);
+    if (p < end && *p == '/')
+    {
+        ++p;
+        if (p < end && *p != '/')
+            p = parseIndex(p, end, it);
+        if (p < end && *p == '/')
+            p = parseIndex(p + 1, end, in);
+    }
+    return tokenEnd(p, end);
+}
+
+#endif //OBJTOKENIZER_H
+
+// eof ///////////////////////////////// OBJTokenizer
\ No newline at end of file
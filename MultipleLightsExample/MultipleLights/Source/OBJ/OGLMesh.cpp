@@ -18,28 +18,99 @@
 #include "OGLMesh.h"        // - Header file for the OGLMesh class
 #include "../ShaderGLSL.h"  // - Header file for the ShaderGLSL class
 #include "Texture.h"        // - Header file for the Texture class
+#include "TextureCache.h"   // - Header file for the TextureCache class
+#include "MeshCache.h"      // - Header file for the MeshCache class
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+#include "TangentSpace.h"   // - Header file for the tangent space generation
+
+#include <chrono>           // - Header file for timing the phases of building the mesh
+#include <algorithm>        // - Header file for find
+#include <cfloat>           // - Header file for FLT_MAX
+
+// defines /////////////////////////////////////////
+#define VERTEX_WELD_FLOATS      14              // attributes of a VertexData compared when welding (all but the padding)
+#define VERTEX_WELD_EMPTY_SLOT  0xFFFFFFFFu     // free slot of the welding hash table
+
+// the value of an attribute used for welding. Without an epsilon, this is the bit pattern of the value (exact match).
+// otherwise values are snapped to a grid of that size, so values that round to the same multiple of epsilon are welded
+static inline unsigned long long weldKey(GLfloat value, flt inv_epsilon)
+{
+    if (inv_epsilon == 0)
+    {
+        unsigned int bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    return (unsigned long long)(long long)glm::floor(value * inv_epsilon + 0.5f);
+}
+
+static inline size_t weldHash(const VertexData& vertex, flt inv_epsilon)
+{
+    const GLfloat* values = (const GLfloat*)&vertex; // the attributes are laid out as consecutive floats
+    unsigned long long hash = 14695981039346656037ull;
+    for (int i = 0; i < VERTEX_WELD_FLOATS; ++i)
+        hash = (hash ^ weldKey(values[i], inv_epsilon)) * 1099511628211ull;
+    return size_t(hash ^ (hash >> 32));
+}
+
+static inline bool weldEqual(const VertexData& a, const VertexData& b, flt inv_epsilon)
+{
+    if (inv_epsilon == 0)
+        return memcmp(&a, &b, VERTEX_WELD_FLOATS * sizeof(GLfloat)) == 0;
+    const GLfloat* values_a = (const GLfloat*)&a;
+    const GLfloat* values_b = (const GLfloat*)&b;
+    for (int i = 0; i < VERTEX_WELD_FLOATS; ++i)
+        if (weldKey(values_a[i], inv_epsilon) != weldKey(values_b[i], inv_epsilon))
+            return false;
+    return true;
+}
+
+// the range of the vertices an element group uses (for glDrawRangeElements)
+static void setVertexRange(ElementGroup& element, const GLuint* indices)
+{
+    element.min_vertex = (element.triangles > 0) ? 0xFFFFFFFFu : 0;
+    element.max_vertex = 0;
+    for (GLuint k = element.start_index; k < element.start_index + element.triangles * 3; ++k)
+    {
+        element.min_vertex = glm::min(element.min_vertex, indices[k]);
+        element.max_vertex = glm::max(element.max_vertex, indices[k]);
+    }
+}
 
 // Constructor
 OGLMesh::OGLMesh(std::string& filename, std::string& path):
+    released(true),
+    updated(false),
     m_fileName(filename),
     m_path(path),
-    num_total_vertices(0),
-    num_total_primitives(0),
-    num_total_elements(0),
+    elements(nullptr),
+    vertexdata(nullptr),
+    indexdata(nullptr),
     num_elements(0),
+    num_lods(1),
     num_vertexdata(0),
-    indexdata(nullptr),
-    vertexdata(nullptr),
-    elements(nullptr),
+    num_indexdata(0),
+    index_type(GL_UNSIGNED_INT),
+    index_size(sizeof(GLuint)),
+    weld_epsilon(0),
+    vertex_format(getVertexFormat(VERTEX_FORMAT_TEXCOORD1)),
+    position_offset(0.0f),
+    position_scale(1.0f),
+    cached(false),
     is_dynamic(false),
-    updated(false)
+    num_total_vertices(0),
+    num_total_primitives(0),
+    num_total_elements(0)
 {
-
+    memset(lod_errors, 0, sizeof(lod_errors));
 }
 
 // Destructor
 OGLMesh::~OGLMesh(void)
 {
+    // only the meshes uploaded on the OpenGL thread are tracked
+    if (residency.tracked)
+        ResidencyManager::getInstance().removeMesh(this);
     init();
 }
 
@@ -57,16 +128,32 @@ void OGLMesh::init()
 
     num_elements = 0;
     num_vertexdata = 0;
+    num_indexdata = 0;
+    if (mapped_data.data != nullptr)
+    {
+        // the data belongs to the mapped mesh cache
+        indexdata = nullptr;
+        vertexdata = nullptr;
+        unmapFile(mapped_data);
+    }
     SAFE_DELETE_ARRAY_POINTER(indexdata);
     SAFE_DELETE_ARRAY_POINTER(vertexdata);
     SAFE_DELETE_ARRAY_POINTER(elements);
+    vertex_format = getVertexFormat(VERTEX_FORMAT_TEXCOORD1);
+    position_offset = glm::vec3(0.0f);
+    position_scale = glm::vec3(1.0f);
+    num_lods = 1;
+    memset(lod_errors, 0, sizeof(lod_errors));
 
-    for (unsigned int i = 0; i < materials.size(); ++i)
+    for (unsigned int i = 0; i < material_ids.size(); ++i)
     {
-        SAFE_DELETE(materials[i]);
+        MaterialRegistry::getInstance().release(material_ids[i]);
     }
 
     materials.clear();
+    material_ids.clear();
+    footprints.clear();
+    cache_stats.clear();
 
     is_dynamic = false;
     updated = false;
@@ -76,31 +163,160 @@ bool OGLMesh::loadToOpenGL(OBJMesh &_mesh, bool use_mipmaps)
 {
     updated = false;
 
-    init();
+    if (!buildVertexData(_mesh))
+        return false;
+
+    return loadDataToOpenGL(use_mipmaps);
+}
+
+bool OGLMesh::loadDataToOpenGL(bool use_mipmaps)
+{
+    updated = false;
 
-    size_t s = _mesh.materials.size();
-    materials.reserve(_mesh.materials.size());
-    for (unsigned int i = 0; i < _mesh.materials.size(); ++i)
+    if (!uploadToOpenGL())
+        return false;
+
+    loadTexturesToOpenGL(use_mipmaps);
+
+    bool hasGLError = glError();
+
+    if (hasGLError)
     {
-        materials.push_back(_mesh.materials[i]);
+        PrintToOutputWindow("An OpenGL error was generated while loading vertex data to the GPU. Skipping");
+        return false;
     }
 
+    updated = true;
+    finishUpload();
+    return true;
+}
+
+void OGLMesh::finishUpload(void)
+{
+    size_t freed_bytes = releaseCPUData();
+    ResidencyManager::getInstance().addMesh(this, freed_bytes);
+}
+
+size_t OGLMesh::releaseCPUData(void)
+{
+    // the data of a dynamic mesh is updated on the CPU
+    if (is_dynamic || vertexdata == nullptr)
+        return 0;
+
+    size_t size = getVertexDataSize() + getIndexDataSize();
+    if (mapped_data.data != nullptr)
+    {
+        indexdata = nullptr;
+        vertexdata = nullptr;
+        unmapFile(mapped_data);
+    }
+    SAFE_DELETE_ARRAY_POINTER(indexdata);
+    SAFE_DELETE_ARRAY_POINTER(vertexdata);
+    return size;
+}
+
+size_t OGLMesh::evict(void)
+{
+    if (!evictable() || released)
+        return 0;
+
+    release();
+    residency.evicted = true;
+    PrintToOutputWindow("Evicted %s (%.2f KB of buffers)", m_fileName.c_str(), getGPUSize() / 1024.0);
+    return getGPUSize();
+}
+
+bool OGLMesh::restore(void)
+{
+    if (!residency.evicted)
+        return true;
+    if (!MeshCache::readMeshData(*this))
+        return false;
+
+    uploadToOpenGL();
+    releaseCPUData();
+    residency.evicted = false;
+    PrintToOutputWindow("Restored %s from its mesh cache (%.2f KB of buffers)", m_fileName.c_str(), getGPUSize() / 1024.0);
+    return true;
+}
+
+bool OGLMesh::buildVertexData(OBJMesh &_mesh)
+{
+    init();
+
+    setMaterials(_mesh.materials);
+    for (unsigned int i = 0; i < _mesh.num_elements; ++i)
+        _mesh.elements[i].material_used = _mesh.materials[_mesh.elements[i].material_index];
+
+    GLint num_expanded = 0;
     for (unsigned int i=0; i<_mesh.num_elements; i++)
     {
         PrimitiveGroup& group = _mesh.elements[i];
         num_elements++;
-        num_vertexdata += group.num_primitives * 3;
+        num_expanded += group.num_primitives * 3;
     }
 
-    // allocate buffers
-    if (num_vertexdata > 0)
+    if (num_expanded==0)
     {
-        indexdata = new GLuint[num_vertexdata];
-        vertexdata = new VertexData[num_vertexdata];
-        elements = new ElementGroup[num_elements];
+        PrintToOutputWindow("No data in mesh to load to OpenGL. Should not get here. Exiting");
+        return false;
     }
 
-    unsigned int voffset = 0;
+    // faces without normals use the smoothed normals of their smoothing group, or their plane normal
+    std::vector<glm::vec3> smooth_normals;
+    std::vector<GLuint> corner_normals;
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    bool smoothed = generateSmoothNormals(_mesh, smooth_normals, corner_normals);
+    std::chrono::high_resolution_clock::time_point weld_start_time = std::chrono::high_resolution_clock::now();
+    double tangents_ms = std::chrono::duration<double, std::milli>(weld_start_time - start_time).count();
+
+    // the vertices are built from the streams of the mesh. Only the first corner of each unique vertex is kept while welding,
+    // and its vertex is built again when it is compared, so the vertex buffer is allocated once, at its final size.
+    // the tangents are generated after welding, only their handedness is part of the vertex here
+    auto buildVertex = [&](GLuint corner, VertexData& vertex)
+    {
+        unsigned long f = corner / 3;
+        int k = corner % 3;
+        const OBJFace& face = _mesh.faces[f];
+        const glm::vec3& position = _mesh.positions[face.vertex[k]];
+        glm::vec3 normal;
+        if (face.normal[k] != OBJ_NO_INDEX)
+            normal = _mesh.normals[face.normal[k]];
+        else if (smoothed && corner_normals[corner] != OBJ_NO_INDEX)
+            normal = smooth_normals[corner_normals[corner]];
+        else
+            normal = glm::normalize(_mesh.face_normals[f]);
+        glm::vec2 texcoord = (face.texcoord[k] == OBJ_NO_INDEX) ? glm::vec2(0,0) : _mesh.texcoords[face.texcoord[k]];
+
+        vertex.position[0] = position[0];
+        vertex.position[1] = position[1];
+        vertex.position[2] = position[2];
+        vertex.normal[0] = normal[0];
+        vertex.normal[1] = normal[1];
+        vertex.normal[2] = normal[2];
+        vertex.tangent[0] = 0;
+        vertex.tangent[1] = 0;
+        vertex.tangent[2] = 0;
+        vertex.tangent[3] = _mesh.face_tangents[f].w;
+        vertex.texcoord0[0] = texcoord[0];
+        vertex.texcoord0[1] = texcoord[1];
+        vertex.texcoord1[0] = 0;
+        vertex.texcoord1[1] = 0;
+        memset(vertex.padding, 0, sizeof(vertex.padding));
+    };
+
+    elements = new ElementGroup[num_elements];
+    std::vector<GLuint> indices(num_expanded);
+    std::vector<GLuint> first_corners;
+
+    // open addressing hash table of vertex ids, at most half full
+    size_t capacity = 1;
+    while (capacity < size_t(num_expanded) * 2)
+        capacity <<= 1;
+    std::vector<GLuint> table(capacity, VERTEX_WELD_EMPTY_SLOT);
+    flt inv_epsilon = (weld_epsilon > 0) ? flt(1) / weld_epsilon : flt(0);
+
+    unsigned int ioffset = 0;
     unsigned int eoffset = 0;
 
     for (unsigned int i=0; i<_mesh.num_elements; i++)
@@ -109,71 +325,217 @@ bool OGLMesh::loadToOpenGL(OBJMesh &_mesh, bool use_mipmaps)
 
         elements[eoffset].material_index = group.material_index;
         elements[eoffset].triangles = group.num_primitives;
-        elements[eoffset].start_index = voffset;
+        elements[eoffset].start_index = ioffset;
+        elements[eoffset].min_vertex = 0xFFFFFFFFu;
+        elements[eoffset].max_vertex = 0;
 
-        long curtangent = 0;
-        for (unsigned int j=0; j<(unsigned int)group.num_primitives; j++)
+        for (unsigned long f = group.first_primitive; f < group.first_primitive + group.num_primitives; f++)
         {
-            Triangle& tr = group.primitives[j];
             for (int k=0; k<3; k++)
             {
-                vertexdata[voffset].position[0] = tr.vertex[k][0];
-                vertexdata[voffset].position[1] = tr.vertex[k][1];
-                vertexdata[voffset].position[2] = tr.vertex[k][2];
-                vertexdata[voffset].normal[0] = tr.normal[k][0];
-                vertexdata[voffset].normal[1] = tr.normal[k][1];
-                vertexdata[voffset].normal[2] = tr.normal[k][2];
-                vertexdata[voffset].tangent[0] = tr.tangent[k][0];
-                vertexdata[voffset].tangent[1] = tr.tangent[k][1];
-                vertexdata[voffset].tangent[2] = tr.tangent[k][2];
-                vertexdata[voffset].texcoord0[0] = tr.texcoord[0][k][0];
-                vertexdata[voffset].texcoord0[1] = tr.texcoord[0][k][1];
-                vertexdata[voffset].texcoord1[0] = tr.texcoord[1][k][0];
-                vertexdata[voffset].texcoord1[1] = tr.texcoord[1][k][1];
-                indexdata[voffset] = voffset;
-                voffset++;
+                GLuint corner = GLuint(f * 3 + k);
+                VertexData vertex, other;
+                buildVertex(corner, vertex);
+
+                // find an identical vertex or add a new one
+                size_t slot = weldHash(vertex, inv_epsilon) & (capacity - 1);
+                GLuint id;
+                for (;;)
+                {
+                    id = table[slot];
+                    if (id == VERTEX_WELD_EMPTY_SLOT)
+                    {
+                        id = (GLuint)first_corners.size();
+                        first_corners.push_back(corner);
+                        table[slot] = id;
+                        break;
+                    }
+                    buildVertex(first_corners[id], other);
+                    if (weldEqual(other, vertex, inv_epsilon))
+                        break;
+                    slot = (slot + 1) & (capacity - 1);
+                }
+
+                indices[ioffset] = id;
+                elements[eoffset].min_vertex = glm::min(elements[eoffset].min_vertex, id);
+                elements[eoffset].max_vertex = glm::max(elements[eoffset].max_vertex, id);
+                ioffset++;
             }
-            num_total_vertices+=3;
             num_total_primitives++;
         }
-        elements[eoffset].end_index = glm::max(voffset-1, unsigned int(0));
+        if (group.num_primitives == 0)
+            elements[eoffset].min_vertex = 0;
+        elements[eoffset].end_index = glm::max(ioffset-1, unsigned int(0));
         eoffset++;
         num_total_elements++;
     }
+    num_vertexdata = (GLint)first_corners.size();
+    num_indexdata = ioffset;
+    num_total_vertices = num_vertexdata;
+    size_t smooth_memory = smooth_normals.capacity() * sizeof(glm::vec3) + corner_normals.capacity() * sizeof(GLuint);
+    size_t weld_memory = (table.size() + indices.size() + first_corners.capacity()) * sizeof(GLuint) + smooth_memory;
+    std::vector<GLuint>().swap(table);
+
+    // only the unique vertices are built
+    std::vector<VertexData> vertices(num_vertexdata);
+    for (GLint i = 0; i < num_vertexdata; ++i)
+        buildVertex(first_corners[i], vertices[i]);
+
+    // the groups cover the faces in order, so index i belongs to face i / 3
+    start_time = std::chrono::high_resolution_clock::now();
+    double weld_ms = std::chrono::duration<double, std::milli>(start_time - weld_start_time).count();
+    generateTangents(vertices.data(), num_vertexdata, indices.data(), num_indexdata, _mesh.face_tangents);
+    weld_start_time = std::chrono::high_resolution_clock::now();
+    tangents_ms += std::chrono::duration<double, std::milli>(weld_start_time - start_time).count();
+    weld_memory = glm::max(weld_memory, (indices.size() + first_corners.capacity() + num_vertexdata + 1 + num_indexdata) * sizeof(GLuint) + smooth_memory);
+
+#if INDEX_OPTIMIZATION
+    // the triangles of each group are ordered for the vertex cache and then by clusters for less overdraw (after the tangents,
+    // which need the faces in their original order), and the vertices are stored in the order the triangles first use them
+    VertexCacheStats original_stats;
+    memset(&original_stats, 0, sizeof(original_stats));
+    for (GLint i = 0; i < num_elements; ++i)
+    {
+        GLuint* group_indices = indices.data() + elements[i].start_index;
+        GLuint num_group_indices = elements[i].triangles * 3;
+        original_stats.add(analyzeVertexCache(group_indices, num_group_indices));
+        optimizeVertexCache(group_indices, num_group_indices);
+        optimizeOverdraw(group_indices, num_group_indices, vertices.data());
+    }
+    optimizeVertexFetch(vertices, indices.data(), num_indexdata);
+    for (GLint i = 0; i < num_elements; ++i)
+        setVertexRange(elements[i], indices.data());
+    start_time = std::chrono::high_resolution_clock::now();
+    double optimize_ms = std::chrono::duration<double, std::milli>(start_time - weld_start_time).count();
+    load_stats.add(LOAD_PHASE_OPTIMIZE, optimize_ms, 0, num_total_primitives);
+    weld_start_time = start_time;
+#endif
+
+    // the levels of detail use the vertices of the mesh, and their triangles follow its own in the index buffer
+    std::vector<SimplifiedLevel> levels;
+    std::vector<GLuint> group_triangles(num_elements);
+    for (GLint i = 0; i < num_elements; ++i)
+        group_triangles[i] = elements[i].triangles;
+    buildLevelsOfDetail(vertices.data(), indices.data(), group_triangles.data(), num_elements, levels);
+    num_lods = 1 + (GLint)levels.size();
+    ElementGroup* lod_elements = new ElementGroup[num_elements * num_lods];
+    memcpy(lod_elements, elements, num_elements * sizeof(ElementGroup));
+    SAFE_DELETE_ARRAY_POINTER(elements);
+    elements = lod_elements;
+    for (GLint l = 1; l < num_lods; ++l)
+    {
+        const SimplifiedLevel& level = levels[l - 1];
+        lod_errors[l] = level.error;
+        GLuint start = (GLuint)indices.size();
+        indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+        for (GLint i = 0; i < num_elements; ++i)
+        {
+            ElementGroup& element = elements[l * num_elements + i];
+            element.material_index = elements[i].material_index;
+            element.triangles = level.group_triangles[i];
+            element.start_index = start;
+            element.end_index = glm::max(start + element.triangles * 3, 1u) - 1;
+#if INDEX_OPTIMIZATION
+            optimizeVertexCache(indices.data() + start, element.triangles * 3);
+            optimizeOverdraw(indices.data() + start, element.triangles * 3, vertices.data());
+#endif
+            setVertexRange(element, indices.data());
+            start += element.triangles * 3;
+        }
+    }
+    num_indexdata = (GLint)indices.size();
+    start_time = std::chrono::high_resolution_clock::now();
+    double simplify_ms = std::chrono::duration<double, std::milli>(start_time - weld_start_time).count();
+    load_stats.add(LOAD_PHASE_SIMPLIFY, simplify_ms, 0, num_total_primitives);
+    weld_start_time = start_time;
+
+    // the vertices are encoded in the most compact format their attributes allow
+    vertex_format = getVertexFormat(chooseVertexFormat(vertices.data(), num_vertexdata, VERTEX_FORMAT_FLAGS));
+    if (vertex_format.flags & VERTEX_FORMAT_COMPACT)
+        getPositionBounds(vertices.data(), num_vertexdata, position_offset, position_scale);
+    vertexdata = new GLubyte[getVertexDataSize()];
+    encodeVertices(vertices.data(), num_vertexdata, vertex_format, position_offset, position_scale, vertexdata);
+    size_t built_memory = vertices.size() * sizeof(VertexData);
+    std::vector<VertexData>().swap(vertices);
+
+    // 16-bit indices when all the vertices can be addressed by them
+    if (num_vertexdata < OGLMESH_MAX_SHORT_INDEX_VERTICES)
+    {
+        index_type = GL_UNSIGNED_SHORT;
+        index_size = sizeof(GLushort);
+        indexdata = new GLubyte[num_indexdata * index_size];
+        GLushort* short_indices = (GLushort*)indexdata;
+        for (GLint i = 0; i < num_indexdata; ++i)
+            short_indices[i] = (GLushort)indices[i];
+    }
+    else
+    {
+        index_type = GL_UNSIGNED_INT;
+        index_size = sizeof(GLuint);
+        indexdata = new GLubyte[num_indexdata * index_size];
+        memcpy(indexdata, indices.data(), num_indexdata * index_size);
+    }
+
+    weld_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - weld_start_time).count();
+    load_stats.add(LOAD_PHASE_WELD, weld_ms, getVertexDataSize() + getIndexDataSize(), num_expanded);
+    load_stats.add(LOAD_PHASE_TANGENTS, tangents_ms, 0, num_vertexdata);
+
+    // the streams of the mesh, the welding buffers and the final buffers are alive at the same time (with the built vertices, while they are encoded)
+    size_t buffer_memory = getVertexDataSize() + num_indexdata * index_size + num_elements * num_lods * sizeof(ElementGroup);
+    _mesh.peak_memory = glm::max(_mesh.peak_memory, _mesh.getStreamMemory() + weld_memory + buffer_memory + built_memory);
 
-    if (num_vertexdata==0)
+    PrintToOutputWindow("%s: Welded %d vertices to %d (%.1f%%), using %d-bit indices. Vertex buffer: %.2f KB (%d bytes/vertex), index buffer: %.2f KB",
+        m_fileName.c_str(), num_expanded, num_vertexdata, 100.0 * num_vertexdata / num_expanded, index_size * 8,
+        getVertexDataSize() / 1024.0, vertex_format.stride, num_indexdata * index_size / 1024.0);
+    PrintToOutputWindow("%s: Generated the tangents%s of %d vertices in %.2f ms", m_fileName.c_str(), smoothed ? " and smoothed normals" : "", num_vertexdata, tangents_ms);
+    if (num_lods > 1)
     {
-        PrintToOutputWindow("No data in mesh to load to OpenGL. Should not get here. Exiting");
-        return false;
+        std::string triangles;
+        for (GLint l = 0; l < num_lods; ++l)
+        {
+            char level[64];
+            sprintf_s(level, sizeof(level), "%s%u (%.3g)", (l > 0) ? ", " : "", getNumTriangles(l), lod_errors[l]);
+            triangles += level;
+        }
+        PrintToOutputWindow("%s: Built %d levels of detail in %.2f ms. Triangles (error): %s", m_fileName.c_str(), num_lods - 1, simplify_ms, triangles.c_str());
     }
 
+    computeFootprints();
+    computeCacheStats();
+#if INDEX_OPTIMIZATION
+    VertexCacheStats optimized_stats;
+    memset(&optimized_stats, 0, sizeof(optimized_stats));
+    for (size_t i = 0; i < cache_stats.size(); ++i)
+        optimized_stats.add(cache_stats[i]);
+    PrintToOutputWindow("%s: Reordered the triangles and vertices in %.2f ms. ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f (FIFO cache of %d vertices)",
+        m_fileName.c_str(), optimize_ms, original_stats.acmr, optimized_stats.acmr, original_stats.atvr, optimized_stats.atvr, VERTEX_CACHE_SIZE);
+#endif
+    return true;
+}
+
+bool OGLMesh::uploadToOpenGL(bool upload_data)
+{
+    ScopedPhaseTimer timer(load_stats, LOAD_PHASE_UPLOAD, upload_data ? getVertexDataSize() + getIndexDataSize() : 0);
+
     glGenVertexArrays(1, &(vao));
     glBindVertexArray(vao);
 
     glGenBuffers(1, &(vbo));
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     if (!is_dynamic)
-        glBufferData(GL_ARRAY_BUFFER, num_vertexdata*sizeof(VertexData), vertexdata, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, getVertexDataSize(), upload_data ? vertexdata : nullptr, GL_STATIC_DRAW);
     else
-        glBufferData(GL_ARRAY_BUFFER, num_vertexdata*sizeof(VertexData), vertexdata, GL_STREAM_DRAW);
-
-    glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData),  (GLvoid*)(0));
-    glVertexAttribPointer((GLuint)1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData),  (GLvoid*)(3*sizeof(GLfloat)));
-    glVertexAttribPointer((GLuint)2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData),  (GLvoid*)(6*sizeof(GLfloat)));
-    glVertexAttribPointer((GLuint)3, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData),  (GLvoid*)(8*sizeof(GLfloat)));
-    glVertexAttribPointer((GLuint)4, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData),  (GLvoid*)(10*sizeof(GLfloat)));
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    glEnableVertexAttribArray(3);
-    glEnableVertexAttribArray(4);
+        glBufferData(GL_ARRAY_BUFFER, getVertexDataSize(), upload_data ? vertexdata : nullptr, GL_STREAM_DRAW);
+
+    // the attributes of the vertex format of the mesh (the ones it does not have are disabled)
+    setVertexAttributes(vertex_format);
 
     glGenBuffers(1, &(ibo));
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     if (!is_dynamic)
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_vertexdata*sizeof(GLuint), indexdata, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indexdata*index_size, upload_data ? indexdata : nullptr, GL_STATIC_DRAW);
     else
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_vertexdata*sizeof(GLuint), indexdata, GL_STREAM_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indexdata*index_size, upload_data ? indexdata : nullptr, GL_STREAM_DRAW);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -185,71 +547,158 @@ bool OGLMesh::loadToOpenGL(OBJMesh &_mesh, bool use_mipmaps)
     glDisableVertexAttribArray(4);
     glDisableVertexAttribArray(5);
 
-    loadTexturesToOpenGL(_mesh, use_mipmaps);
+    released = false;
+    return true;
+}
 
-    bool hasGLError = glError();
+void OGLMesh::uploadVertexData(size_t offset, size_t size)
+{
+    ScopedPhaseTimer timer(load_stats, LOAD_PHASE_UPLOAD, size);
 
-    if (hasGLError)
-    {
-        PrintToOutputWindow("An OpenGL error was generated while loading vertex data to the GPU. Skipping");
-        return false;
-    }
+    // GL_COPY_WRITE_BUFFER does not disturb the bindings of the VAOs
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, (const GLubyte*)vertexdata + offset);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
 
-    released = false;
+void OGLMesh::uploadIndexData(size_t offset, size_t size)
+{
+    ScopedPhaseTimer timer(load_stats, LOAD_PHASE_UPLOAD, size);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, indexdata + offset);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+bool OGLMesh::loadTexturesToOpenGL(bool use_mipmaps)
+{
+    decodeTextures(use_mipmaps);
+    size_t size;
+    while (uploadNextTexture((size_t)-1, size));
 
-    updated = true;
     return true;
 }
 
-bool OGLMesh::loadTexturesToOpenGL(OBJMesh& _mesh, bool use_mipmaps)
+void OGLMesh::setMaterials(std::vector<OBJMaterial*>& mesh_materials)
 {
-    std::string texture_path = m_path + "\\";
-    for (size_t i = 0; i < _mesh.materials.size(); ++i)
+    MaterialRegistry& registry = MaterialRegistry::getInstance();
+    materials.reserve(materials.size() + mesh_materials.size());
+    material_ids.reserve(material_ids.size() + mesh_materials.size());
+    for (size_t i = 0; i < mesh_materials.size(); ++i)
     {
-        OBJMaterial& mat = *_mesh.materials[i];
+        MaterialID id = registry.acquire(mesh_materials[i], m_path);
+        mesh_materials[i] = registry.getMaterial(id);
+        materials.push_back(mesh_materials[i]);
+        material_ids.push_back(id);
+    }
+}
 
-        // load diffuse texture
-        if (mat.m_diffuse_opacity_tex_file.size() > 0)
+void OGLMesh::decodeTextures(bool use_mipmaps)
+{
+    // gather the texture files of all the materials and decode them in parallel
+    struct TextureJob
+    {
+        const std::string*              filename;
+        Texture**                       texture;
+        bool                            use_mipmaps;
+        MATERIAL_MAP_TYPE               map_type;
+    };
+    std::vector<TextureJob> jobs;
+    std::vector<MaterialID> claimed, waiting;
+    MaterialRegistry& registry = MaterialRegistry::getInstance();
+    for (size_t i = 0; i < materials.size(); ++i)
+    {
+        // a material used more than once by this mesh is only claimed the first time
+        if (!registry.claimTextureDecode(material_ids[i]))
         {
-            mat.m_diffuse_opacity_tex = new Texture(texture_path + mat.m_diffuse_opacity_tex_file, use_mipmaps);
-            if (mat.m_diffuse_opacity_tex->loaded())
-            {
-                mat.m_diffuse_opacity_tex->GenerateTexture();
-                mat.m_diffuse_opacity_tex_loaded = true;
-            }
+            if (std::find(claimed.begin(), claimed.end(), material_ids[i]) == claimed.end())
+                waiting.push_back(material_ids[i]);
+            continue;
         }
-        // load emission texture
+        claimed.push_back(material_ids[i]);
+        OBJMaterial& mat = *materials[i];
+
+        // diffuse texture
+        if (mat.m_diffuse_opacity_tex_file.size() > 0)
+            jobs.push_back({ &mat.m_diffuse_opacity_tex_file, &mat.m_diffuse_opacity_tex, use_mipmaps, MPT_MATERIAL_MAP_DIFFUSE_OP });
+        // emission texture
         if (mat.m_emission_tex_file.size() > 0)
-        {
-            mat.m_emission_tex = new Texture(texture_path + mat.m_emission_tex_file, use_mipmaps);
-            if (mat.m_emission_tex->loaded())
-            {
-                mat.m_emission_tex->GenerateTexture();
-                mat.m_emission_tex_loaded = true;
-            }
-        }
-        // load normal texture
+            jobs.push_back({ &mat.m_emission_tex_file, &mat.m_emission_tex, use_mipmaps, MPT_MATERIAL_MAP_EMISSION });
+        // normal texture (its mipmaps are renormalized)
         if (mat.m_normal_tex_file.size() > 0)
-        {
-            mat.m_normal_tex = new Texture(texture_path + mat.m_normal_tex_file, false);
-            if (mat.m_normal_tex->loaded())
-            {
-                mat.m_normal_tex->GenerateTexture();
-                mat.m_normal_tex_loaded = true;
-            }
-        }
-        // load specular texture
+            jobs.push_back({ &mat.m_normal_tex_file, &mat.m_normal_tex, use_mipmaps, MPT_MATERIAL_MAP_NORMAL });
+        // specular texture
         if (mat.m_specular_gloss_tex_file.size() > 0)
-        {
-            mat.m_specular_gloss_tex = new Texture(texture_path + mat.m_specular_gloss_tex_file, false);
-            if (mat.m_specular_gloss_tex->loaded())
-            {
-                mat.m_specular_gloss_tex->GenerateTexture();
-                mat.m_specular_gloss_tex_loaded = true;
-            }
-        }
+            jobs.push_back({ &mat.m_specular_gloss_tex_file, &mat.m_specular_gloss_tex, false, MPT_MATERIAL_MAP_SPECULAR_GLOSS });
+    }
+
+    ScopedPhaseTimer timer(load_stats, LOAD_PHASE_TEXTURE_DECODE, 0, jobs.size());
+    std::string texture_path = m_path + "\\";
+    ThreadPool::getInstance().parallelFor(jobs.size(), [&jobs, &texture_path](size_t i)
+    {
+        *jobs[i].texture = TextureCache::getInstance().acquire(texture_path + *jobs[i].filename, jobs[i].use_mipmaps, jobs[i].map_type);
+    });
+
+    for (size_t i = 0; i < claimed.size(); ++i)
+        registry.finishTextureDecode(claimed[i]);
+    for (size_t i = 0; i < waiting.size(); ++i)
+        registry.waitTextureDecode(waiting[i]);
+
+    unsigned long long decoded_bytes = 0;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        Texture* texture = *jobs[i].texture;
+        if (texture->loaded())
+            decoded_bytes += (unsigned long long)texture->get_width() * texture->get_height() * (texture->get_bits() / 8);
+    }
+    timer.setBytes(decoded_bytes);
+}
+
+// find the next decoded texture that has not been uploaded yet
+static bool nextTexture(Texture* texture, bool& uploaded, Texture*& next, bool*& next_uploaded)
+{
+    if (uploaded || texture == nullptr || !texture->loaded())
+        return false;
+
+    // a texture shared with a material that has already uploaded it (an evicted one is restored when it is drawn)
+    if (texture->generated() || texture->get_residency().evicted)
+    {
+        uploaded = true;
+        return false;
+    }
+
+    next = texture;
+    next_uploaded = &uploaded;
+    return true;
+}
+
+bool OGLMesh::uploadNextTexture(size_t max_bytes, size_t& size)
+{
+    size = 0;
+    Texture* texture = nullptr;
+    bool* uploaded = nullptr;
+    for (size_t i = 0; i < materials.size() && texture == nullptr; ++i)
+    {
+        OBJMaterial& mat = *materials[i];
+        nextTexture(mat.m_diffuse_opacity_tex, mat.m_diffuse_opacity_tex_loaded, texture, uploaded) ||
+        nextTexture(mat.m_emission_tex, mat.m_emission_tex_loaded, texture, uploaded) ||
+        nextTexture(mat.m_normal_tex, mat.m_normal_tex_loaded, texture, uploaded) ||
+        nextTexture(mat.m_specular_gloss_tex, mat.m_specular_gloss_tex_loaded, texture, uploaded);
+
+        // the samplers of the maps uploaded so far (by this material, or by another one that shares the textures).
+        // When no texture is left every material has been through here
+        mat.resolveSamplers();
     }
+    if (texture == nullptr)
+        return false;
 
+    size_t texture_size = texture->get_upload_size();
+    if (texture_size > max_bytes)
+        return true;
+
+    ScopedPhaseTimer timer(load_stats, LOAD_PHASE_UPLOAD, texture_size, 1);
+    texture->GenerateTexture();
+    *uploaded = true;
+    size = texture_size;
     return true;
 }
 
@@ -278,11 +727,115 @@ void OGLMesh::release()
     released = true;
 }
 
+void OGLMesh::computeFootprints(void)
+{
+    footprints.assign(num_elements, ElementFootprint());
+    for (GLint i = 0; i < num_elements; ++i)
+    {
+        const ElementGroup& element = elements[i];
+        ElementFootprint& footprint = footprints[i];
+        glm::vec3 min_position(FLT_MAX), max_position(-FLT_MAX);
+        double area = 0.0, uv_area = 0.0;
+        for (GLuint t = 0; t < element.triangles; ++t)
+        {
+            VertexData a, b, c;
+            getVertex(getIndex(element.start_index + t * 3), a);
+            getVertex(getIndex(element.start_index + t * 3 + 1), b);
+            getVertex(getIndex(element.start_index + t * 3 + 2), c);
+            glm::vec3 pa(a.position[0], a.position[1], a.position[2]);
+            glm::vec3 pb(b.position[0], b.position[1], b.position[2]);
+            glm::vec3 pc(c.position[0], c.position[1], c.position[2]);
+            min_position = glm::min(min_position, glm::min(pa, glm::min(pb, pc)));
+            max_position = glm::max(max_position, glm::max(pa, glm::max(pb, pc)));
+
+            // twice the areas, which cancel out in the ratio
+            area += glm::length(glm::cross(pb - pa, pc - pa));
+            uv_area += fabs((b.texcoord0[0] - a.texcoord0[0]) * (c.texcoord0[1] - a.texcoord0[1]) -
+                            (c.texcoord0[0] - a.texcoord0[0]) * (b.texcoord0[1] - a.texcoord0[1]));
+        }
+
+        if (element.triangles == 0)
+            min_position = max_position = glm::vec3(0.0f);
+        footprint.center = (min_position + max_position) * 0.5f;
+        footprint.radius = glm::length(max_position - min_position) * 0.5f;
+        footprint.uv_density = (area > 0.0) ? (float)sqrt(uv_area / area) : 0.0f;
+    }
+
+    // the box around the spheres of the elements, and the sphere around it
+    glm::vec3 min_position(FLT_MAX), max_position(-FLT_MAX);
+    for (GLint i = 0; i < num_elements; ++i)
+    {
+        if (elements[i].triangles == 0)
+            continue;
+        min_position = glm::min(min_position, footprints[i].center - glm::vec3(footprints[i].radius));
+        max_position = glm::max(max_position, footprints[i].center + glm::vec3(footprints[i].radius));
+    }
+    if (min_position.x > max_position.x)
+        min_position = max_position = glm::vec3(0.0f);
+    bounds.center = (min_position + max_position) * 0.5f;
+    bounds.radius = glm::length(max_position - min_position) * 0.5f;
+    bounds.uv_density = 0.0f;
+}
+
+void OGLMesh::computeCacheStats(void)
+{
+    cache_stats.resize(num_elements);
+    std::vector<GLuint> group_indices;
+    for (GLint i = 0; i < num_elements; ++i)
+    {
+        const ElementGroup& element = elements[i];
+        group_indices.resize(element.triangles * 3);
+        for (GLuint k = 0; k < element.triangles * 3; ++k)
+            group_indices[k] = getIndex(element.start_index + k);
+        cache_stats[i] = analyzeVertexCache(group_indices.data(), (GLuint)group_indices.size());
+    }
+}
+
+glm::mat4x4 OGLMesh::getPositionMatrix(void) const
+{
+    if (!(vertex_format.flags & VERTEX_FORMAT_COMPACT))
+        return glm::mat4x4(1.0f);
+
+    glm::mat4x4 matrix(1.0f);
+    matrix[0][0] = position_scale.x;
+    matrix[1][1] = position_scale.y;
+    matrix[2][2] = position_scale.z;
+    matrix[3] = glm::vec4(position_offset, 1.0f);
+    return matrix;
+}
+
+GLuint OGLMesh::getNumTriangles(GLint lod) const
+{
+    GLuint triangles = 0;
+    const ElementGroup* lod_elements = getElements(lod);
+    for (GLint i = 0; i < num_elements; ++i)
+        triangles += lod_elements[i].triangles;
+    return triangles;
+}
+
+void OGLMesh::drawElement(GLint i, GLint lod) const
+{
+    const ElementGroup& element = elements[lod * num_elements + i];
+
+    // draw within a range in the index buffer
+    glDrawRangeElements(
+        GL_TRIANGLES,
+        element.min_vertex,
+        element.max_vertex,
+        element.triangles*3,
+        index_type,
+        (void*)(size_t(element.start_index)*index_size)
+        );
+}
+
 void OGLMesh::dump(void)
 {
     PrintToOutputWindow("Model info: %s", m_fileName.c_str());
     PrintToOutputWindow("\tNum of Elements : %lu\n", num_elements);
     PrintToOutputWindow("\tNum of Vertices : %lu", num_total_vertices);
+    for (size_t i = 0; i < cache_stats.size(); i++)
+        PrintToOutputWindow("\tElement %2d: %6u triangles, %6u vertices, ACMR %.3f, ATVR %.3f", (int)i,
+            cache_stats[i].triangles, cache_stats[i].vertices, cache_stats[i].acmr, cache_stats[i].atvr);
 
     PrintToOutputWindow("\n\tNum of Materials    : %lu\n", materials.size());
     for (unsigned int i = 0; i < materials.size(); i++)
@@ -21,9 +21,15 @@
 // includes ////////////////////////////////////////
 #include "OBJMaterial.h"    // - Header file for the OBJMaterial class
 #include "OBJLoader.h"      // - Header file for the OBJLoader class
+#include "MaterialRegistry.h" // - Header file for the MaterialRegistry class
+#include "ResidencyManager.h" // - Header file for the ResidencyManager class
+#include "VertexFormat.h"   // - Header file for the vertex formats
+#include "IndexOptimizer.h" // - Header file for the index optimization
+#include "MeshSimplifier.h" // - Header file for the mesh simplification
 #include "OGLMesh.h"        // - Header file for the OGLMesh class
 
 // defines /////////////////////////////////////////
+#define OGLMESH_MAX_SHORT_INDEX_VERTICES    65536   // meshes with fewer (unique) vertices use 16-bit indices
 
 
 // forward declarations ////////////////////////////
@@ -31,22 +37,34 @@
 
 // class declarations //////////////////////////////
 
+// a vertex as it is built. The vertex buffers hold it in the format of the mesh (see VertexFormat.h)
 struct VertexData
 {
     GLfloat position[3];    // offset:  0  size: 12
     GLfloat normal[3];      // offset: 12  size: 12
     GLfloat texcoord0[2];   // offset: 24  size:  8
     GLfloat texcoord1[2];   // offset: 32  size:  8
-    GLfloat tangent[3];     // offset: 40  size: 12
-    GLbyte  padding[12];    // offset: 52  size:  12
+    GLfloat tangent[4];     // offset: 40  size: 16 (w: handedness, the bitangent is cross(normal, tangent) * w)
+    GLbyte  padding[8];     // offset: 56  size:  8
 };                          // Total: 64 bytes/vertex (multiple of 32 bytes)
 
 struct ElementGroup
 {
-    GLuint start_index;
-    GLuint end_index;
+    GLuint start_index;         // first index of the group in the index buffer
+    GLuint end_index;           // last index of the group in the index buffer
     unsigned int material_index;
     unsigned int triangles;
+    GLuint min_vertex;          // smallest vertex referenced by the group (the range of glDrawRangeElements)
+    GLuint max_vertex;          // largest vertex referenced by the group
+};
+
+// the size of an element group on the screen and the density of its texture coordinates, from which the mipmap
+// levels its textures need are estimated
+struct ElementFootprint
+{
+    glm::vec3 center;           // bounding sphere of the triangles of the group, in object space
+    float radius;
+    float uv_density;           // texture coordinates per unit of length (the square root of the texture area over the surface area)
 };
 
 class OGLMesh
@@ -60,16 +78,33 @@ public:
     GLuint                                  vbo;
     GLuint                                  ibo;
     GLuint                                  vao;
-    ElementGroup *                          elements;
-    VertexData *                            vertexdata;
-    GLuint *                                indexdata;
+    ElementGroup *                          elements;           // num_elements groups for each level of detail (see getElements)
+    GLubyte *                               vertexdata;         // num_vertexdata vertices of vertex_format
+    GLubyte *                               indexdata;          // GLushort or GLuint indices, depending on index_type
     GLint                                   num_elements;
+    GLint                                   num_lods;           // the levels of detail, the first of which is the mesh itself
+    float                                   lod_errors[MESH_LOD_MAX_COUNT]; // the error of each level, in object space (see buildLevelsOfDetail)
     GLint                                   num_vertexdata;
-    std::vector<OBJMaterial*>               materials;
+    GLint                                   num_indexdata;
+    GLenum                                  index_type;         // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLuint                                  index_size;         // size of each index in bytes
+    flt                                     weld_epsilon;
+    VertexFormat                            vertex_format;
+    glm::vec3                               position_offset;    // the bounds of the positions of a compact vertex format (see getPositionMatrix)
+    glm::vec3                               position_scale;
+    MappedFile                              mapped_data;        // when loaded from a mesh cache, vertexdata and indexdata point in this file
+    bool                                    cached;             // the vertex and index data can be read again from the mesh cache
+    Residency                               residency;          // of the buffers (see ResidencyManager)
+    std::vector<OBJMaterial*>               materials;          // shared with the other meshes through the MaterialRegistry
+    std::vector<MaterialID>                 material_ids;       // global ID of each material
+    std::vector<ElementFootprint>           footprints;         // one per element group (see computeFootprints)
+    ElementFootprint                        bounds;             // of the whole mesh (its uv_density is not used)
+    std::vector<VertexCacheStats>           cache_stats;        // one per element group, of the indices as they are drawn (see computeCacheStats)
     bool                                    is_dynamic;
     unsigned int                            num_total_vertices;
     unsigned int                            num_total_primitives;
     unsigned int                            num_total_elements;
+    LoadStats                               load_stats;         // the phases of loading the mesh, accumulated since it was created
 
 
     // protected function declarations
@@ -91,19 +126,74 @@ public:
 
     // public function declarations
     virtual bool                            loadToOpenGL(OBJMesh& _mesh, bool use_mipmaps);
-    virtual bool                            loadTexturesToOpenGL(OBJMesh& _mesh, bool use_mipmaps);
+    // builds the (welded) vertex and index data of the mesh on the CPU and takes over its materials. No OpenGL calls are made
+    virtual bool                            buildVertexData(OBJMesh& _mesh);
+    // creates the VAO and the vertex and index buffers from the CPU data.
+    // if upload_data is false, the buffers are only allocated and are filled with uploadVertexData/uploadIndexData
+    virtual bool                            uploadToOpenGL(bool upload_data = true);
+    // upload a range (in bytes) of the CPU vertex/index data to the buffers created by uploadToOpenGL
+    void                                    uploadVertexData(size_t offset, size_t size);
+    void                                    uploadIndexData(size_t offset, size_t size);
+    // the buffers and the textures are uploaded: releases the CPU vertex and index data (unless the mesh is dynamic) and hands
+    // the mesh to the ResidencyManager. The bounds of the elements are kept (see computeFootprints)
+    void                                    finishUpload(void);
+    size_t                                  releaseCPUData(void);
+    // deletes the buffers of a mesh that can be read again from its cache. Returns the released bytes
+    size_t                                  evict(void);
+    // reads the vertex and index data of an evicted mesh from its cache and uploads them to new buffers
+    bool                                    restore(void);
+    // uploads the CPU data (built or read from a mesh cache) and loads the textures of the materials
+    virtual bool                            loadDataToOpenGL(bool use_mipmaps);
+    virtual bool                            loadTexturesToOpenGL(bool use_mipmaps);
+    // takes over the materials (the ones identical to materials of other meshes are deleted) and replaces them
+    // with the shared ones from the MaterialRegistry
+    void                                    setMaterials(std::vector<OBJMaterial*>& mesh_materials);
+    // reads the texture files of the materials. No OpenGL calls are made.
+    // the textures of a shared material are decoded by the first mesh that gets to them, the others wait for it
+    virtual void                            decodeTextures(bool use_mipmaps);
+    // creates the OpenGL texture of the next decoded texture, if its size is at most max_bytes.
+    // size is set to the uploaded bytes (0 if the texture did not fit). Returns false when all the textures are uploaded
+    virtual bool                            uploadNextTexture(size_t max_bytes, size_t& size);
     virtual void                            display();
     virtual void                            release();
     virtual void                            init();
     virtual void                            dump();
+    // draws an element group of a level of detail (the VAO must be bound)
+    void                                    drawElement(GLint i, GLint lod = 0) const;
+    // the bounds and the texture coordinate density of each element group (of the first level of detail), and the bounds of the mesh,
+    // from the CPU data. No OpenGL calls are made
+    void                                    computeFootprints(void);
+    // the post-transform vertex cache efficiency (ACMR and ATVR) of each element group, from the CPU index data
+    void                                    computeCacheStats(void);
 
     // get functions
     virtual unsigned long                   getNumPrimitives() const                {return num_total_primitives;}
     virtual unsigned long                   getNumVertices() const                  {return num_total_vertices;}
     virtual unsigned long                   getNumElements() const                  {return num_total_elements;}
     std::string&                            getFileName(void)                       {return m_fileName;}
+    size_t                                  getVertexDataSize(void) const           {return num_vertexdata * vertex_format.stride;}
+    size_t                                  getIndexDataSize(void) const            {return num_indexdata * index_size;}
+    // bytes of the vertex and index buffers
+    size_t                                  getGPUSize(void) const                  {return getVertexDataSize() + getIndexDataSize();}
+    bool                                    evictable(void) const                   {return cached && !is_dynamic;}
+    // the time, bytes and items of each phase of loading the mesh (parsing or cache read, welding, texture decoding, uploads)
+    LoadStats&                              getLoadStats(void)                      {return load_stats;}
+    const LoadStats&                        getLoadStats(void) const                {return load_stats;}
+    // the global ID of the material of an element group, e.g. for sorting the draws of several meshes by material
+    MaterialID                              getMaterialID(GLint i) const            {return material_ids[elements[i].material_index];}
+    GLuint                                  getIndex(GLint i) const                 {return (index_type == GL_UNSIGNED_SHORT) ? GLuint(((GLushort*)indexdata)[i]) : ((GLuint*)indexdata)[i];}
+    // the element groups of a level of detail. They have the materials of the ones of the mesh, in the same order
+    const ElementGroup*                     getElements(GLint lod) const            {return elements + lod * num_elements;}
+    GLuint                                  getNumTriangles(GLint lod) const;
+    // decodes a vertex of the CPU data
+    void                                    getVertex(GLint i, VertexData& vertex) const {decodeVertex(vertexdata + (size_t)i * vertex_format.stride, vertex_format, position_offset, position_scale, vertex);}
+    // moves the positions of a compact vertex format from [0, 1] to the bounds of the mesh. It is applied before the
+    // transformation of the mesh, and not to its normals (it is the identity for float positions)
+    glm::mat4x4                             getPositionMatrix(void) const;
 
     // set functions
+    // vertices whose attributes differ by less than epsilon are welded (0 welds identical vertices only)
+    void                                    setWeldEpsilon(flt epsilon)             {weld_epsilon = epsilon;}
 
 
 };
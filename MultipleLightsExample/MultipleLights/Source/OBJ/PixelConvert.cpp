@@ -0,0 +1,265 @@
+//----------------------------------------------------//
+//                                                    //
+// File: PixelConvert.cpp                             //
+// Conversion of the pixel formats of the TGA files   //
+// to the layouts the GPU uses natively               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "PixelConvert.h"   // - Header file for the pixel format conversions
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+#ifdef PIXEL_CONVERT_SSE2
+#include <emmintrin.h>      // - Header file for the SSE2 intrinsics
+#endif
+
+// defines /////////////////////////////////////////
+#define PIXEL_OPAQUE                0xFF000000u     // alpha of 255 in a BGRA8 pixel (read as a little endian unsigned int)
+
+// a 5 bit channel widened to 8 bits, as round(value * 255 / 31)
+static inline unsigned int widen5(unsigned int value)
+{
+    return (value * 527 + 23) >> 6;
+}
+
+// the channels of a 1-5-5-5 pixel, widened to 8 bits
+static inline unsigned int widenBGR5A1(unsigned int pixel, bool use_alpha)
+{
+    unsigned int a = (!use_alpha || (pixel & 0x8000)) ? 255 : 0;
+    return widen5(pixel & 0x1F) | (widen5((pixel >> 5) & 0x1F) << 8) | (widen5((pixel >> 10) & 0x1F) << 16) | (a << 24);
+}
+
+// colour * alpha / 255, rounded
+static inline unsigned int premultiply(unsigned int colour, unsigned int alpha)
+{
+    unsigned int x = colour * alpha + 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+unsigned int getPixelSize(PixelFormat format)
+{
+    switch (format)
+    {
+    case PIXEL_FORMAT_R8:       return 1;
+    case PIXEL_FORMAT_INDEX8:   return 1;
+    case PIXEL_FORMAT_BGR5A1:   return 2;
+    case PIXEL_FORMAT_BGR8:     return 3;
+    default:                    return 4;
+    }
+}
+
+unsigned int getConvertedPixelSize(PixelFormat format)
+{
+    return (format == PIXEL_FORMAT_R8) ? 1 : 4;
+}
+
+void convertRowBGR5A1ToBGRA8(const unsigned char* src, unsigned char* dst, unsigned int count, bool use_alpha)
+{
+    unsigned int i = 0;
+#ifdef PIXEL_CONVERT_SSE2
+    // 8 pixels at a time: each channel is isolated in 16 bit lanes, widened, and the lanes are interleaved back to 4 byte pixels
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i scale = _mm_set1_epi16(527);
+    const __m128i bias = _mm_set1_epi16(23);
+    const __m128i alpha_mask = use_alpha ? _mm_setzero_si128() : _mm_set1_epi16(0x00FF);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 2));
+        __m128i b = _mm_and_si128(v, mask5);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask5);
+        __m128i r = _mm_and_si128(_mm_srli_epi16(v, 10), mask5);
+        // the alpha bit becomes 0 or 0xFFFF, of which the low byte is kept
+        __m128i a = _mm_or_si128(_mm_and_si128(_mm_srai_epi16(v, 15), _mm_set1_epi16(0x00FF)), alpha_mask);
+        b = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, scale), bias), 6);
+        g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, scale), bias), 6);
+        r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, scale), bias), 6);
+        __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        __m128i ra = _mm_or_si128(r, _mm_slli_epi16(a, 8));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(dst + i * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        unsigned int pixel = widenBGR5A1(src[i * 2] | (src[i * 2 + 1] << 8), use_alpha);
+        memcpy(dst + i * 4, &pixel, 4);
+    }
+}
+
+void convertRowBGR8ToBGRA8(const unsigned char* src, unsigned char* dst, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef PIXEL_CONVERT_SSE2
+    // 4 pixels at a time from a 16 byte load (of which 12 bytes are used): the pixel k starts at byte 3k,
+    // so shifting the register by 3k bytes brings it to the low 4 bytes
+    const __m128i opaque = _mm_set1_epi32((int)PIXEL_OPAQUE);
+    for (; i + 6 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 3));
+        __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+        __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_unpacklo_epi64(p01, p23), opaque));
+    }
+#endif
+    // 4 byte loads read one byte past the pixel, so the last pixel is converted on its own
+    for (; i + 1 < count; ++i)
+    {
+        unsigned int pixel;
+        memcpy(&pixel, src + i * 3, 4);
+        pixel |= PIXEL_OPAQUE;
+        memcpy(dst + i * 4, &pixel, 4);
+    }
+    for (; i < count; ++i)
+    {
+        dst[i * 4]     = src[i * 3];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 255;
+    }
+}
+
+void convertRowIndex8ToBGRA8(const unsigned char* src, unsigned char* dst, unsigned int count, const unsigned int* palette)
+{
+    // SSE2 has no gather, the palette is read a pixel at a time
+    for (unsigned int i = 0; i < count; ++i)
+        memcpy(dst + i * 4, &palette[src[i]], 4);
+}
+
+void swizzleRowBGRA8(unsigned char* row, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef PIXEL_CONVERT_SSE2
+    // green and alpha stay, blue and red swap places
+    const __m128i ga_mask = _mm_set1_epi32((int)0xFF00FF00u);
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(row + i * 4));
+        __m128i ga = _mm_and_si128(v, ga_mask);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), byte_mask);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(v, byte_mask), 16);
+        _mm_storeu_si128((__m128i*)(row + i * 4), _mm_or_si128(ga, _mm_or_si128(r, b)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        unsigned char b = row[i * 4];
+        row[i * 4] = row[i * 4 + 2];
+        row[i * 4 + 2] = b;
+    }
+}
+
+void premultiplyRowBGRA8(unsigned char* row, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef PIXEL_CONVERT_SSE2
+    // 4 pixels at a time, in 16 bit lanes. The alpha of each pixel is copied to its colour lanes and 255 to its alpha lane
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colour_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(row + i * 4));
+        __m128i halves[2] = { _mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero) };
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_or_si128(_mm_and_si128(alpha, colour_mask), alpha_one);
+            __m128i x = _mm_add_epi16(_mm_mullo_epi16(halves[h], alpha), half);
+            halves[h] = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+        }
+        _mm_storeu_si128((__m128i*)(row + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        unsigned int alpha = row[i * 4 + 3];
+        row[i * 4]     = (unsigned char)premultiply(row[i * 4], alpha);
+        row[i * 4 + 1] = (unsigned char)premultiply(row[i * 4 + 1], alpha);
+        row[i * 4 + 2] = (unsigned char)premultiply(row[i * 4 + 2], alpha);
+    }
+}
+
+void mirrorRow(unsigned char* row, unsigned int count, unsigned int pixel_size)
+{
+    if (count < 2)
+        return;
+
+    unsigned char pixel[4];
+    unsigned char* left = row;
+    unsigned char* right = row + (count - 1) * pixel_size;
+    for (; left < right; left += pixel_size, right -= pixel_size)
+    {
+        memcpy(pixel, left, pixel_size);
+        memcpy(left, right, pixel_size);
+        memcpy(right, pixel, pixel_size);
+    }
+}
+
+void buildPaletteBGRA8(const unsigned char* colour_map, unsigned int entry_bits, unsigned int first, unsigned int num_entries, bool use_alpha, unsigned int* palette)
+{
+    unsigned int entry_size = (entry_bits + 7) / 8;
+    for (unsigned int index = 0; index < 256; ++index)
+    {
+        if (num_entries == 0)
+        {
+            palette[index] = PIXEL_OPAQUE;
+            continue;
+        }
+
+        unsigned int entry = (unsigned int)glm::clamp((int)index - (int)first, 0, (int)num_entries - 1);
+        const unsigned char* colour = colour_map + entry * entry_size;
+        if (entry_size == 2)
+            palette[index] = widenBGR5A1(colour[0] | (colour[1] << 8), use_alpha && entry_bits == 16);
+        else if (entry_size == 3)
+            palette[index] = colour[0] | (colour[1] << 8) | (colour[2] << 16) | PIXEL_OPAQUE;
+        else if (entry_size == 4)
+            memcpy(&palette[index], colour, 4);
+        else
+            palette[index] = PIXEL_OPAQUE;
+    }
+}
+
+void convertPixels(const unsigned char* src, PixelFormat src_format, unsigned int width, unsigned int height, unsigned int flags,
+                   const unsigned int* palette, unsigned char* dst, unsigned int num_threads)
+{
+    size_t src_row_size = (size_t)width * getPixelSize(src_format);
+    unsigned int dst_pixel_size = getConvertedPixelSize(src_format);
+    size_t dst_row_size = (size_t)width * dst_pixel_size;
+
+    // every row is written by a single task, and is converted while it is in the cache
+    size_t num_tasks = (height + PIXEL_CONVERT_ROWS_PER_TASK - 1) / PIXEL_CONVERT_ROWS_PER_TASK;
+    ThreadPool::getInstance().parallelFor(num_tasks, [&](size_t task)
+    {
+        unsigned int first = (unsigned int)(task * PIXEL_CONVERT_ROWS_PER_TASK);
+        unsigned int last = glm::min(first + PIXEL_CONVERT_ROWS_PER_TASK, height);
+        for (unsigned int y = first; y < last; ++y)
+        {
+            const unsigned char* src_row = src + ((flags & PIXEL_FLIP_ROWS) ? height - 1 - y : y) * src_row_size;
+            unsigned char* dst_row = dst + y * dst_row_size;
+            switch (src_format)
+            {
+            case PIXEL_FORMAT_INDEX8:   convertRowIndex8ToBGRA8(src_row, dst_row, width, palette); break;
+            case PIXEL_FORMAT_BGR5A1:   convertRowBGR5A1ToBGRA8(src_row, dst_row, width, (flags & PIXEL_ALPHA_BIT) != 0); break;
+            case PIXEL_FORMAT_BGR8:     convertRowBGR8ToBGRA8(src_row, dst_row, width); break;
+            default:                    memcpy(dst_row, src_row, dst_row_size); break;
+            }
+
+            if (flags & PIXEL_MIRROR_ROWS)
+                mirrorRow(dst_row, width, dst_pixel_size);
+            if (dst_pixel_size == 4 && (flags & PIXEL_SWIZZLE_RGBA))
+                swizzleRowBGRA8(dst_row, width);
+            if (dst_pixel_size == 4 && (flags & PIXEL_PREMULTIPLY_ALPHA))
+                premultiplyRowBGRA8(dst_row, width);
+        }
+    }, num_threads);
+}
+
+// eof ///////////////////////////////// PixelConvert
\ No newline at end of file
@@ -0,0 +1,79 @@
+//----------------------------------------------------//
+//                                                    //
+// File: PixelConvert.h                               //
+// Conversion of the pixel formats of the TGA files   //
+// to the layouts the GPU uses natively               //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef PIXELCONVERT_H
+#define PIXELCONVERT_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+
+
+// defines /////////////////////////////////////////
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define PIXEL_CONVERT_SSE2
+#endif
+
+#define PIXEL_CONVERT_ROWS_PER_TASK 64              // number of rows converted by each parallel task
+
+// the flags of convertPixels
+#define PIXEL_FLIP_ROWS             0x01            // the source rows are stored top to bottom
+#define PIXEL_MIRROR_ROWS           0x02            // the source pixels of a row are stored right to left
+#define PIXEL_SWIZZLE_RGBA          0x04            // the 4 byte pixels are written as RGBA instead of BGRA
+#define PIXEL_PREMULTIPLY_ALPHA     0x08            // the colour of the 4 byte pixels is multiplied by their alpha
+#define PIXEL_ALPHA_BIT             0x10            // the high bit of 1-5-5-5 pixels is alpha (otherwise they are opaque)
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+// the source formats. Everything is converted to BGRA8, except R8 which stays R8
+enum PixelFormat
+{
+    PIXEL_FORMAT_R8,                                // grey
+    PIXEL_FORMAT_INDEX8,                            // an index in a palette of BGRA8 colours
+    PIXEL_FORMAT_BGR5A1,                            // 16 bit little endian, A1 R5 G5 B5 from the high bit down
+    PIXEL_FORMAT_BGR8,
+    PIXEL_FORMAT_BGRA8
+};
+
+// bytes of a pixel of a format
+unsigned int getPixelSize(PixelFormat format);
+
+// bytes of a converted pixel of a format (1 for R8, 4 for the rest)
+unsigned int getConvertedPixelSize(PixelFormat format);
+
+// the kernels convert a row of count pixels. src and dst should not overlap, except for the ones working in place
+void convertRowBGR5A1ToBGRA8(const unsigned char* src, unsigned char* dst, unsigned int count, bool use_alpha);
+void convertRowBGR8ToBGRA8(const unsigned char* src, unsigned char* dst, unsigned int count);
+void convertRowIndex8ToBGRA8(const unsigned char* src, unsigned char* dst, unsigned int count, const unsigned int* palette);
+// in place: BGRA to RGBA (and back)
+void swizzleRowBGRA8(unsigned char* row, unsigned int count);
+// in place: colour * alpha / 255, rounded
+void premultiplyRowBGRA8(unsigned char* row, unsigned int count);
+// in place: reverses the order of the pixels
+void mirrorRow(unsigned char* row, unsigned int count, unsigned int pixel_size);
+
+// the 256 BGRA8 colours of the indices of a TGA colour map with entry_bits (15, 16, 24 or 32) bits per entry, whose first
+// entry is index first. Indices outside the colour map get the nearest entry,
+// and entries of any other depth are opaque black
+void buildPaletteBGRA8(const unsigned char* colour_map, unsigned int entry_bits, unsigned int first, unsigned int num_entries, bool use_alpha, unsigned int* palette);
+
+// converts width x height pixels of src_format to BGRA8 (R8 stays R8) in dst, with each row converted, flipped, mirrored, swizzled
+// and premultiplied in one pass as flags asks for. The rows are converted in parallel. palette is needed for PIXEL_FORMAT_INDEX8
+void convertPixels(const unsigned char* src, PixelFormat src_format, unsigned int width, unsigned int height, unsigned int flags,
+                   const unsigned int* palette, unsigned char* dst, unsigned int num_threads = 0);
+
+#endif //PIXELCONVERT_H
+
+// eof ///////////////////////////////// PixelConvert
\ No newline at end of file
@@ -0,0 +1,259 @@
+//----------------------------------------------------//
+//                                                    //
+// File: ResidencyManager.cpp                         //
+// ResidencyManager accounts the GPU memory of the    //
+// meshes and textures and keeps it within a budget   //
+// by evicting the ones drawn least recently          //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"         // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OGLMesh.h"            // - Header file for the OGLMesh class
+#include "Texture.h"            // - Header file for the Texture class
+#include "TextureArray.h"       // - Header file for the TextureArray class
+#include "ResidencyManager.h"   // - Header file for the ResidencyManager class
+
+#include <algorithm>            // - Header file for find and sort
+
+// Constructor
+ResidencyManager::ResidencyManager(void):
+    m_pool(RESIDENCY_NUM_THREADS + 1),
+    m_frame(0)
+{
+    memset(&m_counters, 0, sizeof(m_counters));
+    m_counters.budget = RESIDENCY_BUDGET;
+}
+
+// Destructor
+ResidencyManager::~ResidencyManager(void)
+{
+
+}
+
+// other functions
+ResidencyManager& ResidencyManager::getInstance(void)
+{
+    static ResidencyManager manager;
+    return manager;
+}
+
+void ResidencyManager::addMesh(OGLMesh* mesh, size_t freed_cpu_bytes)
+{
+    m_counters.freed_cpu_bytes += freed_cpu_bytes;
+    if (mesh->residency.tracked)
+        return;
+
+    // a resource that has not been drawn yet is as recent as the frame it was added in
+    mesh->residency.tracked = true;
+    mesh->residency.last_used = m_frame;
+    m_meshes.push_back(mesh);
+}
+
+void ResidencyManager::removeMesh(OGLMesh* mesh)
+{
+    std::vector<OGLMesh*>::iterator it = std::find(m_meshes.begin(), m_meshes.end(), mesh);
+    if (it != m_meshes.end())
+        m_meshes.erase(it);
+    mesh->residency.tracked = false;
+}
+
+void ResidencyManager::addTexture(Texture* texture)
+{
+    Residency& residency = texture->get_residency();
+    if (residency.tracked)
+        return;
+
+    residency.tracked = true;
+    residency.last_used = m_frame;
+    m_textures.push_back(texture);
+}
+
+void ResidencyManager::removeTexture(Texture* texture)
+{
+    // the texture is not deleted while a worker reads it
+    std::unordered_map<Texture*, std::future<void> >::iterator reload = m_reloads.find(texture);
+    if (reload != m_reloads.end())
+    {
+        reload->second.wait();
+        m_reloads.erase(reload);
+    }
+
+    std::vector<Texture*>::iterator it = std::find(m_textures.begin(), m_textures.end(), texture);
+    if (it != m_textures.end())
+        m_textures.erase(it);
+    texture->get_residency().tracked = false;
+}
+
+bool ResidencyManager::useMesh(OGLMesh* mesh)
+{
+    Residency& residency = mesh->residency;
+    residency.last_used = m_frame;
+    if (residency.evicted && !residency.failed)
+        residency.wanted = true;
+    return !residency.evicted;
+}
+
+bool ResidencyManager::useTexture(Texture* texture)
+{
+    Residency& residency = texture->get_residency();
+    residency.last_used = m_frame;
+    if (residency.evicted && !residency.failed)
+        residency.wanted = true;
+    return !residency.evicted;
+}
+
+void ResidencyManager::count(void)
+{
+    m_counters.mesh_bytes = m_counters.texture_bytes = m_counters.evicted_bytes = 0;
+    m_counters.num_evicted = 0;
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        if (m_meshes[i]->residency.evicted)
+        {
+            m_counters.evicted_bytes += m_meshes[i]->getGPUSize();
+            m_counters.num_evicted++;
+        }
+        else
+            m_counters.mesh_bytes += m_meshes[i]->getGPUSize();
+    }
+    for (size_t i = 0; i < m_textures.size(); ++i)
+    {
+        if (m_textures[i]->get_residency().evicted)
+        {
+            m_counters.evicted_bytes += m_textures[i]->get_uploaded_size();
+            m_counters.num_evicted++;
+        }
+        else
+            m_counters.texture_bytes += m_textures[i]->get_resident_size();
+    }
+    m_counters.array_bytes = TEXTURE_ARRAYS ? TextureArrays::getInstance().getSize() : 0;
+    m_counters.num_meshes = (unsigned int)m_meshes.size();
+    m_counters.num_textures = (unsigned int)m_textures.size();
+}
+
+size_t ResidencyManager::restore(size_t budget, bool first)
+{
+    size_t used = 0;
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        OGLMesh* mesh = m_meshes[i];
+        size_t size = mesh->getGPUSize();
+        if (!mesh->residency.wanted || (used + size > budget && !(first && used == 0)))
+            continue;
+
+        // a mesh whose cache has gone is not tried again
+        mesh->residency.wanted = false;
+        if (!mesh->restore())
+        {
+            mesh->residency.failed = true;
+            continue;
+        }
+        used += size;
+        m_counters.restores++;
+        m_counters.restored_bytes += size;
+    }
+
+    for (size_t i = 0; i < m_textures.size(); ++i)
+    {
+        Texture* texture = m_textures[i];
+        if (!texture->get_residency().wanted)
+            continue;
+
+        // the texture is read on a worker first, and only generated (within the budget) once it has been read
+        std::unordered_map<Texture*, std::future<void> >::iterator reload = m_reloads.find(texture);
+        if (reload == m_reloads.end())
+        {
+            m_reloads[texture] = m_pool.enqueue([texture] { texture->Reload(); });
+            continue;
+        }
+        size_t size = texture->get_uploaded_size();
+        if (reload->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+            (used + size > budget && !(first && used == 0)))
+            continue;
+        m_reloads.erase(reload);
+
+        texture->get_residency().wanted = false;
+        if (!texture->Restore())
+        {
+            texture->get_residency().failed = true;
+            continue;
+        }
+        used += texture->get_resident_size();
+        m_counters.restores++;
+        m_counters.restored_bytes += texture->get_resident_size();
+    }
+    return used;
+}
+
+size_t ResidencyManager::evict(void)
+{
+    size_t resident = getResidentBytes();
+    if (m_counters.budget == 0 || resident <= m_counters.budget)
+        return 0;
+
+    // the resources that can be evicted and have not been drawn lately, least recently drawn first
+    struct Candidate
+    {
+        unsigned int                    last_used;
+        OGLMesh*                        mesh;
+        Texture*                        texture;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        const Residency& residency = m_meshes[i]->residency;
+        if (!residency.evicted && m_meshes[i]->evictable() && m_frame - residency.last_used >= RESIDENCY_KEEP_FRAMES)
+            candidates.push_back({ residency.last_used, m_meshes[i], nullptr });
+    }
+    for (size_t i = 0; i < m_textures.size(); ++i)
+    {
+        const Residency& residency = m_textures[i]->get_residency();
+        if (!residency.evicted && m_frame - residency.last_used >= RESIDENCY_KEEP_FRAMES)
+            candidates.push_back({ residency.last_used, nullptr, m_textures[i] });
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.last_used < b.last_used; });
+
+    size_t evicted = 0;
+    for (size_t i = 0; i < candidates.size() && resident - evicted > m_counters.budget; ++i)
+    {
+        size_t size = (candidates[i].mesh != nullptr) ? candidates[i].mesh->evict() : candidates[i].texture->Evict();
+        if (size > 0)
+            m_counters.evictions++;
+        evicted += size;
+    }
+
+    // everything over the budget was drawn lately
+    if (resident - evicted > m_counters.budget)
+        m_counters.over_budget_frames++;
+    return evicted;
+}
+
+size_t ResidencyManager::update(size_t budget, bool first)
+{
+    size_t used = restore(budget, first);
+    count();
+    if (evict() > 0)
+        count();
+    m_frame++;
+    return used;
+}
+
+void ResidencyManager::print(void) const
+{
+    const ResidencyCounters& c = m_counters;
+    PrintToOutputWindow("GPU memory: %.2f MB of %.2f MB (meshes %.2f MB, textures %.2f MB, texture arrays %.2f MB)",
+        getResidentBytes() / (1024.0 * 1024.0), c.budget / (1024.0 * 1024.0), c.mesh_bytes / (1024.0 * 1024.0),
+        c.texture_bytes / (1024.0 * 1024.0), c.array_bytes / (1024.0 * 1024.0));
+    PrintToOutputWindow("Resources: %u meshes, %u textures, %u evicted (%.2f MB). Evictions: %llu, restores: %llu (%.2f MB), frames over budget: %u",
+        c.num_meshes, c.num_textures, c.num_evicted, c.evicted_bytes / (1024.0 * 1024.0), c.evictions, c.restores,
+        c.restored_bytes / (1024.0 * 1024.0), c.over_budget_frames);
+    PrintToOutputWindow("CPU copies of the vertex and index data released after their upload: %.2f MB", c.freed_cpu_bytes / (1024.0 * 1024.0));
+}
+
+// eof ///////////////////////////////// class ResidencyManager
\ No newline at end of file
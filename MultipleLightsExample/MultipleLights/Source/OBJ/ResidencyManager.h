@@ -0,0 +1,136 @@
+//----------------------------------------------------//
+//                                                    //
+// File: ResidencyManager.h                           //
+// ResidencyManager accounts the GPU memory of the    //
+// meshes and textures and keeps it within a budget   //
+// by evicting the ones drawn least recently          //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef RESIDENCYMANAGER_H
+#define RESIDENCYMANAGER_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+#include <unordered_map>
+
+// defines /////////////////////////////////////////
+#define RESIDENCY_BUDGET                (256 * 1024 * 1024) // bytes of vertex and index buffers and textures kept on the GPU (0 for no limit)
+#define RESIDENCY_KEEP_FRAMES           120                 // resources drawn within this many frames are never evicted
+#define RESIDENCY_NUM_THREADS           1                   // threads reading the evicted textures before they are restored (separate from the parallelFor pool)
+
+// forward declarations ////////////////////////////
+class OGLMesh;
+class Texture;
+
+// class declarations //////////////////////////////
+
+// the residency of a mesh or a texture. It is kept in the object, so that marking it as drawn is only a store
+struct Residency
+{
+    bool                                tracked;            // added to the ResidencyManager (on the OpenGL thread)
+    bool                                evicted;            // the GPU memory has been released. It is restored once it is drawn again
+    bool                                wanted;             // drawn while evicted
+    bool                                failed;             // could not be restored, and is not tried again
+    unsigned int                        last_used;          // the frame it was last drawn in
+
+    Residency(void): tracked(false), evicted(false), wanted(false), failed(false), last_used(0) {}
+};
+
+struct ResidencyCounters
+{
+    size_t                              budget;
+    size_t                              mesh_bytes;         // vertex and index buffers of the resident meshes
+    size_t                              texture_bytes;      // levels of the resident textures (of a streamed texture, the ones uploaded now)
+    size_t                              array_bytes;        // texture arrays, which are not evicted
+    size_t                              evicted_bytes;      // GPU bytes of the evicted meshes and textures, were they restored
+    unsigned long long                  freed_cpu_bytes;    // CPU copies of the vertex and index data released after their upload
+    unsigned int                        num_meshes;
+    unsigned int                        num_textures;
+    unsigned int                        num_evicted;
+    unsigned long long                  evictions;
+    unsigned long long                  restores;
+    unsigned long long                  restored_bytes;
+    unsigned int                        over_budget_frames; // frames that stayed over the budget, since all the resources were in use
+};
+
+// the meshes are evicted by deleting their buffers, and restored from their mesh cache (meshes without one are never evicted).
+// The textures are evicted by deleting their OpenGL texture, and restored by reading them again on a worker thread (the mipmap
+// cache holds their levels, so they are not built again) and generating them in a later update. The textures packed in arrays
+// are not evicted. update restores the resources drawn while evicted within the upload budget, and then evicts the ones drawn
+// least recently until the total is within the budget.
+// All the functions must be called on the OpenGL thread
+class ResidencyManager
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    std::vector<OGLMesh*>               m_meshes;
+    std::vector<Texture*>               m_textures;
+    ThreadPool                          m_pool;
+    std::unordered_map<Texture*, std::future<void> > m_reloads; // the evicted textures read on the workers, until they are restored
+    unsigned int                        m_frame;
+    ResidencyCounters                   m_counters;
+
+    // private function declarations
+    // Constructor
+    ResidencyManager(void);
+
+    // Destructor
+    ~ResidencyManager(void);
+
+    void                                count(void);
+    size_t                              restore(size_t budget, bool first);
+    size_t                              evict(void);
+
+public:
+    // public function declarations
+    static ResidencyManager&            getInstance(void);
+
+    // the mesh has been uploaded. The CPU bytes it released after the upload are counted
+    void                                addMesh(OGLMesh* mesh, size_t freed_cpu_bytes);
+    void                                removeMesh(OGLMesh* mesh);
+    // the texture has been generated (not packed in an array)
+    void                                addTexture(Texture* texture);
+    void                                removeTexture(Texture* texture);
+
+    // the mesh is drawn this frame. Returns false if it is evicted, in which case it is restored by a later update
+    bool                                useMesh(OGLMesh* mesh);
+    // the texture is sampled this frame. Returns false if it is evicted (it should not be sampled), in which case it is restored
+    // by a later update
+    bool                                useTexture(Texture* texture);
+
+    // call once per frame. Restores the resources drawn while evicted within the budget (bytes uploaded this frame; the first
+    // one is restored even if it is larger, when first is set), and evicts until the resident bytes are within the memory budget.
+    // Returns the bytes uploaded
+    size_t                              update(size_t budget, bool first);
+
+    void                                print(void) const;
+
+    // get functions
+    // the counters, as of the last update
+    const ResidencyCounters&            getCounters(void) const                         { return m_counters; }
+    size_t                              getResidentBytes(void) const                    { return m_counters.mesh_bytes + m_counters.texture_bytes + m_counters.array_bytes; }
+    size_t                              getBudget(void) const                           { return m_counters.budget; }
+
+    // set functions
+    void                                setBudget(size_t bytes)                         { m_counters.budget = bytes; }
+
+};
+
+#endif //RESIDENCYMANAGER_H
+
+// eof ///////////////////////////////// class ResidencyManager
\ No newline at end of file
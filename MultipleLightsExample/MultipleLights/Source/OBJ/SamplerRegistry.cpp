@@ -0,0 +1,150 @@
+//----------------------------------------------------//
+//                                                    //
+// File: SamplerRegistry.cpp                          //
+// SamplerRegistry holds the OpenGL sampler objects   //
+// that the material maps are sampled with, one for   //
+// each filter, wrap, anisotropy and compare mode     //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"         // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "SamplerRegistry.h"    // - Header file for the SamplerRegistry class
+
+// Constructor
+SamplerRegistry::SamplerRegistry(void):
+    m_quality(SAMPLER_DEFAULT_QUALITY),
+    m_max_anisotropy(0)
+{
+
+}
+
+// Destructor
+SamplerRegistry::~SamplerRegistry(void)
+{
+
+}
+
+// other functions
+SamplerRegistry& SamplerRegistry::getInstance(void)
+{
+    static SamplerRegistry registry;
+    return registry;
+}
+
+unsigned int SamplerRegistry::getKey(const SamplerDesc& desc)
+{
+    // the anisotropy only matters to the anisotropic filter
+    unsigned int anisotropy = (desc.filter == SAMPLER_FILTER_ANISOTROPIC) ? ((desc.anisotropy > 0) ? desc.anisotropy : SAMPLER_ANISOTROPY) : 0;
+    return (unsigned int)desc.filter | ((unsigned int)desc.wrap << 4) | ((desc.compare ? 1u : 0u) << 8) | ((desc.mipmaps ? 1u : 0u) << 9) |
+           (glm::min(anisotropy, 255u) << 16);
+}
+
+const char* SamplerRegistry::getQualityName(SamplerQuality quality)
+{
+    static const char* names[SAMPLER_QUALITY_COUNT] = { "bilinear", "trilinear", "anisotropic" };
+    return (quality < SAMPLER_QUALITY_COUNT) ? names[quality] : "unknown";
+}
+
+void SamplerRegistry::applyFilter(const Sampler& sampler)
+{
+    // the filter of the sampler, or the one of the quality tier
+    SamplerFilter filter = sampler.desc.filter;
+    unsigned int anisotropy = (sampler.desc.anisotropy > 0) ? sampler.desc.anisotropy : SAMPLER_ANISOTROPY;
+    if (filter == SAMPLER_FILTER_QUALITY)
+    {
+        filter = (m_quality == SAMPLER_QUALITY_BILINEAR) ? SAMPLER_FILTER_BILINEAR :
+                 (m_quality == SAMPLER_QUALITY_ANISOTROPIC) ? SAMPLER_FILTER_ANISOTROPIC : SAMPLER_FILTER_TRILINEAR;
+        anisotropy = SAMPLER_ANISOTROPY;
+    }
+
+    // without mipmaps the minification filter may not use them, or the textures would be incomplete
+    GLint min_filter = GL_LINEAR;
+    if (filter == SAMPLER_FILTER_NEAREST)
+        min_filter = sampler.desc.mipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
+    else if (filter == SAMPLER_FILTER_BILINEAR)
+        min_filter = sampler.desc.mipmaps ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR;
+    else
+        min_filter = sampler.desc.mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    glSamplerParameteri(sampler.gl_id, GL_TEXTURE_MIN_FILTER, min_filter);
+    glSamplerParameteri(sampler.gl_id, GL_TEXTURE_MAG_FILTER, (filter == SAMPLER_FILTER_NEAREST) ? GL_NEAREST : GL_LINEAR);
+
+    // set even when it is 1, since a tier may have raised it before
+    if (m_max_anisotropy > 1.0f)
+    {
+        float max_anisotropy = (filter == SAMPLER_FILTER_ANISOTROPIC) ? glm::min((float)anisotropy, m_max_anisotropy) : 1.0f;
+        glSamplerParameterf(sampler.gl_id, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_anisotropy);
+    }
+}
+
+GLuint SamplerRegistry::getSampler(const SamplerDesc& desc)
+{
+    unsigned int key = getKey(desc);
+    std::unordered_map<unsigned int, Sampler>::iterator it = m_samplers.find(key);
+    if (it != m_samplers.end())
+        return it->second.gl_id;
+
+    if (m_max_anisotropy == 0)
+    {
+        m_max_anisotropy = 1.0f;
+        if (GLEW_EXT_texture_filter_anisotropic)
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_max_anisotropy);
+    }
+
+    Sampler sampler;
+    sampler.desc = desc;
+    sampler.gl_id = 0;
+    glGenSamplers(1, &sampler.gl_id);
+    if (sampler.gl_id == 0)
+    {
+        PrintToOutputWindow("Could not create a sampler. The textures are sampled with their own parameters");
+        return 0;
+    }
+
+    GLint wrap = (desc.wrap == SAMPLER_WRAP_CLAMP) ? GL_CLAMP_TO_EDGE : (desc.wrap == SAMPLER_WRAP_MIRROR) ? GL_MIRRORED_REPEAT : GL_REPEAT;
+    glSamplerParameteri(sampler.gl_id, GL_TEXTURE_WRAP_S, wrap);
+    glSamplerParameteri(sampler.gl_id, GL_TEXTURE_WRAP_T, wrap);
+    glSamplerParameteri(sampler.gl_id, GL_TEXTURE_WRAP_R, wrap);
+    if (desc.compare)
+    {
+        glSamplerParameteri(sampler.gl_id, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glSamplerParameteri(sampler.gl_id, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+    applyFilter(sampler);
+
+    m_samplers[key] = sampler;
+    PrintToOutputWindow("Created sampler with id: %d (key 0x%x)", sampler.gl_id, key);
+    return sampler.gl_id;
+}
+
+void SamplerRegistry::setQuality(SamplerQuality quality)
+{
+    if (quality >= SAMPLER_QUALITY_COUNT || quality == m_quality)
+        return;
+
+    // the samplers stay bound to the units and the textures are not touched
+    m_quality = quality;
+    for (std::unordered_map<unsigned int, Sampler>::iterator it = m_samplers.begin(); it != m_samplers.end(); ++it)
+    {
+        if (it->second.desc.filter == SAMPLER_FILTER_QUALITY)
+            applyFilter(it->second);
+    }
+
+    if (quality == SAMPLER_QUALITY_ANISOTROPIC && m_max_anisotropy <= 1.0f)
+        PrintToOutputWindow("Texture filtering: %s (not supported, trilinear is used)", getQualityName(quality));
+    else
+        PrintToOutputWindow("Texture filtering: %s", getQualityName(quality));
+}
+
+void SamplerRegistry::release(void)
+{
+    for (std::unordered_map<unsigned int, Sampler>::iterator it = m_samplers.begin(); it != m_samplers.end(); ++it)
+        glDeleteSamplers(1, &it->second.gl_id);
+    m_samplers.clear();
+}
+
+// eof ///////////////////////////////// class SamplerRegistry
\ No newline at end of file
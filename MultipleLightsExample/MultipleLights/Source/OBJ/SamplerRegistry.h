@@ -0,0 +1,131 @@
+//----------------------------------------------------//
+//                                                    //
+// File: SamplerRegistry.h                            //
+// SamplerRegistry holds the OpenGL sampler objects   //
+// that the material maps are sampled with, one for   //
+// each filter, wrap, anisotropy and compare mode     //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef SAMPLERREGISTRY_H
+#define SAMPLERREGISTRY_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <unordered_map>
+
+// defines /////////////////////////////////////////
+#define SAMPLER_OBJECTS                 1                           // bind the samplers of the materials (0 samples with the parameters of the textures)
+#define SAMPLER_DEFAULT_QUALITY         SAMPLER_QUALITY_TRILINEAR   // the quality tier at startup
+#define SAMPLER_ANISOTROPY              8                           // max anisotropy of the anisotropic tier (clamped to what the device supports)
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+enum SamplerFilter
+{
+    SAMPLER_FILTER_QUALITY,             // follows the quality tier of the registry
+    SAMPLER_FILTER_NEAREST,             // the nearest texel of the nearest mipmap level
+    SAMPLER_FILTER_BILINEAR,            // linear within the nearest mipmap level
+    SAMPLER_FILTER_TRILINEAR,           // linear within and between the two nearest levels
+    SAMPLER_FILTER_ANISOTROPIC          // trilinear, with the anisotropy of the sampler
+};
+
+enum SamplerWrap
+{
+    SAMPLER_WRAP_REPEAT,
+    SAMPLER_WRAP_CLAMP,                 // to the edge
+    SAMPLER_WRAP_MIRROR
+};
+
+enum SamplerQuality
+{
+    SAMPLER_QUALITY_BILINEAR,
+    SAMPLER_QUALITY_TRILINEAR,
+    SAMPLER_QUALITY_ANISOTROPIC,
+    SAMPLER_QUALITY_COUNT
+};
+
+// how a map is sampled. Samplers with the same description are shared
+struct SamplerDesc
+{
+    SamplerFilter                       filter;
+    SamplerWrap                         wrap;
+    unsigned int                        anisotropy;         // of SAMPLER_FILTER_ANISOTROPIC (0 for SAMPLER_ANISOTROPY)
+    bool                                compare;            // depth comparison (GL_LEQUAL), for shadow maps
+    bool                                mipmaps;            // the textures have mipmaps (otherwise the minification filter does not use them)
+
+    SamplerDesc(SamplerFilter _filter = SAMPLER_FILTER_QUALITY, SamplerWrap _wrap = SAMPLER_WRAP_REPEAT, unsigned int _anisotropy = 0,
+                bool _compare = false, bool _mipmaps = true):
+        filter(_filter), wrap(_wrap), anisotropy(_anisotropy), compare(_compare), mipmaps(_mipmaps) {}
+};
+
+// the samplers are created on first use and never change their description. Those that follow the quality tier have their
+// filters set again by setQuality, so a tier is switched for the whole scene without touching a texture. The textures keep
+// their own parameters, which are used where no sampler is bound (the base and max level and the swizzle are always theirs).
+// All the functions must be called on the OpenGL thread
+class SamplerRegistry
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    struct Sampler
+    {
+        GLuint                          gl_id;
+        SamplerDesc                     desc;
+    };
+
+    // private variable declarations
+    std::unordered_map<unsigned int, Sampler> m_samplers;   // by the key of their description
+    SamplerQuality                      m_quality;
+    float                               m_max_anisotropy;   // of the device (1 without EXT_texture_filter_anisotropic, 0 until queried)
+
+    // private function declarations
+    // Constructor
+    SamplerRegistry(void);
+
+    // Destructor (there is no OpenGL context anymore, the samplers are deleted with release)
+    ~SamplerRegistry(void);
+
+    void                                applyFilter(const Sampler& sampler);
+
+public:
+    // public function declarations
+    static SamplerRegistry&             getInstance(void);
+
+    // a number that is the same for two descriptions if and only if they give the same sampler
+    static unsigned int                 getKey(const SamplerDesc& desc);
+    static const char*                  getQualityName(SamplerQuality quality);
+
+    // the sampler of the description, created if there is none yet
+    GLuint                              getSampler(const SamplerDesc& desc);
+
+    // sets the filters of the samplers that follow the quality tier
+    void                                setQuality(SamplerQuality quality);
+
+    // deletes the samplers (while the OpenGL context is current)
+    void                                release(void);
+
+    // get functions
+    SamplerQuality                      getQuality(void) const                          { return m_quality; }
+    unsigned int                        getNumSamplers(void) const                      { return (unsigned int)m_samplers.size(); }
+
+    // set functions
+
+};
+
+#endif //SAMPLERREGISTRY_H
+
+// eof ///////////////////////////////// class SamplerRegistry
\ No newline at end of file
@@ -15,11 +15,51 @@
 // includes ////////////////////////////////////////
 #include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
 #include "TGA.h"            // - Header file for the TGA class
+#include "PixelConvert.h"   // - Header file for the pixel format conversions
+
+#ifdef TGA_SSE2
+#include <emmintrin.h>      // - Header file for the SSE2 intrinsics
+#endif
+
+// fills count pixels of pixel_size bytes with the same pixel (a run-length packet)
+static inline void fillRun(unsigned char* dst, const unsigned char* pixel, unsigned int count, unsigned int pixel_size)
+{
+    unsigned int size = count * pixel_size;
+    if (size < 48)
+    {
+        for (unsigned int i = 0; i < size; i += pixel_size)
+            memcpy(dst + i, pixel, pixel_size);
+        return;
+    }
+
+    // 48 bytes hold a whole number of pixels of 1, 2, 3 and 4 bytes, so the run is written in blocks of 48 bytes
+    unsigned char pattern[48];
+    for (unsigned int i = 0; i < 48; i += pixel_size)
+        memcpy(pattern + i, pixel, pixel_size);
+
+    unsigned int offset = 0;
+#ifdef TGA_SSE2
+    const __m128i p0 = _mm_loadu_si128((const __m128i*)(pattern));
+    const __m128i p1 = _mm_loadu_si128((const __m128i*)(pattern + 16));
+    const __m128i p2 = _mm_loadu_si128((const __m128i*)(pattern + 32));
+    for (; offset + 48 <= size; offset += 48)
+    {
+        _mm_storeu_si128((__m128i*)(dst + offset), p0);
+        _mm_storeu_si128((__m128i*)(dst + offset + 16), p1);
+        _mm_storeu_si128((__m128i*)(dst + offset + 32), p2);
+    }
+#else
+    for (; offset + 48 <= size; offset += 48)
+        memcpy(dst + offset, pattern, 48);
+#endif
+    memcpy(dst + offset, pattern, size - offset);
+}
 
 // Constructor
 TGA::TGA():
 m_texture_info(),
-m_palette(NULL)
+m_palette(NULL),
+m_file()
 {
 
 }
@@ -27,108 +67,212 @@ m_palette(NULL)
 // Destructor
 TGA::~TGA()
 {
-    SAFE_DELETE(m_palette)
+    SAFE_DELETE_ARRAY_POINTER(m_palette)
+    unmapFile(m_file);
 }
 
 // other functions
-bool TGA::TGAError(std::string& error_msg, const char* msg, FILE* file)
+bool TGA::TGAError(std::string& error_msg, const char* msg)
 {
     error_msg += msg;
-    if(file != NULL) fclose(file);
+    unmapFile(m_file);
     return false;
 }
 
-bool TGA::Load(std::string& filename, unsigned char** texture_data, std::string& error_msg)
+void TGA::Unmap(void)
+{
+    unmapFile(m_file);
+}
+
+bool TGA::Load(std::string& filename, unsigned char** texture_data, std::string& error_msg, const unsigned char** mapped_data)
 {
-    FILE * file = NULL;
-
-    fopen_s(&file, filename.c_str(), "rb");
-
-    if (!file) return TGAError(error_msg, "Could not find file.", file);
-
-    if(fread(&m_identsize, sizeof(m_identsize), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_colourmaptype, sizeof(m_colourmaptype), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_imagetype, sizeof(m_imagetype), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_colourmapstart, sizeof(m_colourmapstart), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_colourmaplength, sizeof(m_colourmaplength), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_colourmapbits, sizeof(m_colourmapbits), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_xstart, sizeof(m_xstart), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_ystart, sizeof(m_ystart), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_width, sizeof(m_width), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_height, sizeof(m_height), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_bits, sizeof(m_bits), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
-    if(fread(&m_descriptor, sizeof(m_descriptor), 1, file) == 0)
-        return TGAError(error_msg, "Could not read TGA header", file);
+    // the file is mapped and the header is parsed from the mapping, nothing is read in between
+    if (!mapFile(filename, m_file))
+        return TGAError(error_msg, "Could not find file.");
+
+    const unsigned char* bytes = (const unsigned char*)m_file.data;
+    if (m_file.size < TGA_HEADER_SIZE)
+        return TGAError(error_msg, "Could not read TGA header");
+
+    // the fields of the header are little endian
+    m_identsize         = bytes[0];
+    m_colourmaptype     = bytes[1];
+    m_imagetype         = bytes[2];
+    m_colourmapstart    = (unsigned short)(bytes[3] | (bytes[4] << 8));
+    m_colourmaplength   = (unsigned short)(bytes[5] | (bytes[6] << 8));
+    m_colourmapbits     = bytes[7];
+    m_xstart            = (unsigned short)(bytes[8] | (bytes[9] << 8));
+    m_ystart            = (unsigned short)(bytes[10] | (bytes[11] << 8));
+    m_width             = (unsigned short)(bytes[12] | (bytes[13] << 8));
+    m_height            = (unsigned short)(bytes[14] | (bytes[15] << 8));
+    m_bits              = bytes[16];
+    m_descriptor        = bytes[17];
 
     if (m_imagetype != 1  && m_imagetype != 2  && m_imagetype != 3  && m_imagetype != 9 &&
         m_imagetype != 10 && m_imagetype != 11 && m_imagetype != 32 && m_imagetype != 33)
     {
-        if (m_imagetype == 0) return TGAError(error_msg, "No image available. TGA image type is 0.", file);
-        else return TGAError(error_msg, "Unsupported TGA image type. Supported image types are 1, 2, 3, 9, 10, 11, 32 and 33", file);
+        if (m_imagetype == 0) return TGAError(error_msg, "No image available. TGA image type is 0.");
+        else return TGAError(error_msg, "Unsupported TGA image type. Supported image types are 1, 2, 3, 9, 10, 11, 32 and 33");
     }
     if (m_bits !=8 && m_bits != 16 && m_bits != 24 && m_bits != 32)
-        return TGAError(error_msg, "Unsupported TGA pixel depth. Supported pixel depths are 8, 16, 24, and 32 bits", file);
+        return TGAError(error_msg, "Unsupported TGA pixel depth. Supported pixel depths are 8, 16, 24, and 32 bits");
     if (m_colourmaptype != 0 && m_colourmaptype != 1)
-        return TGAError(error_msg, "Unsupported TGA colour map type. Supported colour map types are 0 and 1", file);
+        return TGAError(error_msg, "Unsupported TGA colour map type. Supported colour map types are 0 and 1");
+    if (m_colourmaptype == 1 && m_colourmapbits != 15 && m_colourmapbits != 16 && m_colourmapbits != 24 && m_colourmapbits != 32)
+        return TGAError(error_msg, "Unsupported TGA colour map depth. Supported colour map depths are 15, 16, 24 and 32 bits");
+
+    if (m_imagetype == 32 || m_imagetype == 33)
+        return TGAError(error_msg, "Huffman and quadtree compressed TGA images (types 32 and 33) are not supported");
 
-    m_texture_info.size        = m_width * m_height * (m_bits / 8);
+    // the pixel format of the file
+    bool indexed = (m_imagetype == 1 || m_imagetype == 9);
+    if (indexed && (m_colourmaptype != 1 || m_bits != 8))
+        return TGAError(error_msg, "Indexed TGA images need a colour palette and 8 bit indices");
+    if ((m_imagetype == 3 || m_imagetype == 11) && m_bits != 8)
+        return TGAError(error_msg, "Unsupported TGA grey pixel depth. Supported grey pixel depth is 8 bits");
+    PixelFormat format = PIXEL_FORMAT_R8;
+    if (indexed)                format = PIXEL_FORMAT_INDEX8;
+    else if (m_bits == 16)      format = PIXEL_FORMAT_BGR5A1;
+    else if (m_bits == 24)      format = PIXEL_FORMAT_BGR8;
+    else if (m_bits == 32)      format = PIXEL_FORMAT_BGRA8;
+
+    unsigned int file_size     = m_width * m_height * (m_bits / 8);
+    m_texture_info.bits        = getConvertedPixelSize(format) * 8;
+    m_texture_info.size        = m_width * m_height * (m_texture_info.bits / 8);
 
     m_texture_info.dimensions    = 2;
     if (m_height <= 1) m_texture_info.dimensions = 1;
 
     if (m_texture_info.size < 1)
-        return TGAError(error_msg, "Could not read TGA header", file);
+        return TGAError(error_msg, "Could not read TGA header");
+
+    // the image ID field follows the header
+    size_t offset = TGA_HEADER_SIZE + m_identsize;
 
+    // the low bits of the descriptor are the number of alpha bits
+    bool use_alpha = (m_descriptor & 0x0F) != 0;
+    unsigned int palette[256];
     if (m_colourmaptype == 1)
     {
-        m_palette = new unsigned char[m_colourmaptype * m_colourmaplength];
-        if(fread(m_palette, 1, m_colourmaptype * m_colourmaplength, file) != (size_t)(m_colourmaptype * m_colourmaplength))
-            return TGAError(error_msg, "Could not read TGA colour palette", file);
+        // 15 and 16 bit entries are both stored in 2 bytes
+        unsigned int palette_size = m_colourmaplength * ((m_colourmapbits + 7) / 8);
+        if (offset + palette_size > m_file.size)
+            return TGAError(error_msg, "Could not read TGA colour palette");
+        m_palette = new unsigned char[palette_size];
+        memcpy(m_palette, bytes + offset, palette_size);
+        offset += palette_size;
+        buildPaletteBGRA8(m_palette, m_colourmapbits, m_colourmapstart, m_colourmaplength, use_alpha, palette);
     }
 
-    (*texture_data) = new unsigned char[m_texture_info.size];
+    unsigned int flags = 0;
+    if (m_descriptor & TGA_DESCRIPTOR_TOP)      flags |= PIXEL_FLIP_ROWS;
+    if (m_descriptor & TGA_DESCRIPTOR_RIGHT)    flags |= PIXEL_MIRROR_ROWS;
+    if (use_alpha)                              flags |= PIXEL_ALPHA_BIT;
+    // 8 bit grey and 32 bit BGRA pixels are uploaded as they are
+    bool native = (format == PIXEL_FORMAT_R8 || format == PIXEL_FORMAT_BGRA8);
 
-    if((*texture_data) == NULL)
-        return TGAError(error_msg, "Could not allocate memory for TGA image", file);
+    const unsigned char* pixels = bytes + offset;
+    size_t available = (offset < m_file.size) ? m_file.size - offset : 0;
 
-    if (m_imagetype == 1)
+    if (m_imagetype < 8)
     {
-        // Indexed
-        if(fread((*texture_data), 1, m_texture_info.size, file) != m_texture_info.size)
-            return TGAError(error_msg, "Could not read TGA image data", file);
+        if (available < file_size)
+            return TGAError(error_msg, "Could not read TGA image data");
 
-        for (unsigned char i = 0; i < m_texture_info.size; ++i)
-            (*texture_data)[i] = m_palette[(*texture_data)[i]];
+        // pixels in the order and the layout OpenGL expects are used from the mapping as they are
+        if (mapped_data != NULL && native && (flags & (PIXEL_FLIP_ROWS | PIXEL_MIRROR_ROWS)) == 0)
+        {
+            // one byte of each page is read, so that the file is read now (on the decoding thread) and not by the upload
+            volatile unsigned char touched = 0;
+            for (size_t i = 0; i < file_size; i += TGA_PAGE_SIZE)
+                touched += pixels[i];
+            (*mapped_data) = pixels;
+            return true;
+        }
+
+        // Indexed, RGB and grey: converted, flipped and mirrored in one pass
+        (*texture_data) = new unsigned char[m_texture_info.size];
+        convertPixels(pixels, format, m_width, m_height, flags, palette, (*texture_data));
     }
-    else if (m_imagetype == 2)
+    else if (m_imagetype  > 8 && native && (flags & PIXEL_MIRROR_ROWS) == 0)
     {
-        // RGB
-        if(fread((*texture_data), 1, m_texture_info.size, file) != m_texture_info.size)
-            return TGAError(error_msg, "Could not read TGA image data", file);
+        // RLE packed RGB and grey that need no conversion are decoded in place, and flipped while they are decoded
+        (*texture_data) = new unsigned char[m_texture_info.size];
+        if (!DecodeRLE(pixels, available, (*texture_data), (flags & PIXEL_FLIP_ROWS) != 0, error_msg))
+            return TGAError(error_msg, "");
     }
-    else if (m_imagetype == 3)
+    else if (m_imagetype  > 8)
     {
-        // Grey
-        if(fread((*texture_data), 1, m_texture_info.size, file) != m_texture_info.size)
-            return TGAError(error_msg, "Could not read TGA image data", file);
+        // RLE packed indexed, RGB and grey: decoded as they are stored, then converted, flipped and mirrored in one pass
+        unsigned char* decoded = new unsigned char[file_size];
+        if (!DecodeRLE(pixels, available, decoded, false, error_msg))
+        {
+            SAFE_DELETE_ARRAY_POINTER(decoded)
+            return TGAError(error_msg, "");
+        }
+        (*texture_data) = new unsigned char[m_texture_info.size];
+        convertPixels(decoded, format, m_width, m_height, flags, palette, (*texture_data));
+        SAFE_DELETE_ARRAY_POINTER(decoded)
     }
-    else if (m_imagetype  > 8)
+
+    // the pixels have been copied out of the mapping
+    unmapFile(m_file);
+
+    return true;
+}
+
+bool TGA::DecodeRLE(const unsigned char* packets, size_t size, unsigned char* texture_data, bool flip_rows, std::string& error_msg)
+{
+    unsigned int pixel_size = m_bits / 8;
+    unsigned int num_pixels = m_width * m_height;
+    size_t row_size = m_width * pixel_size;
+
+    // packets may run across rows, but not past the end of the image
+    const unsigned char* src = packets;
+    const unsigned char* src_end = packets + size;
+    unsigned int decoded = 0;
+    unsigned int x = 0, y = 0;
+    unsigned char* row = texture_data + (flip_rows ? m_height - 1 : 0) * row_size;
+    while (decoded < num_pixels && src < src_end)
     {
+        unsigned char header = *src++;
+        unsigned int count = glm::min((unsigned int)(header & 0x7F) + 1, num_pixels - decoded);
+        bool run = (header & TGA_RLE_PACKET_FLAG) != 0;
+        if (src + (run ? 1 : count) * pixel_size > src_end)
+            break;
 
+        while (count > 0)
+        {
+            unsigned int pixels = glm::min(count, (unsigned int)m_width - x);
+            if (run)
+            {
+                // one pixel repeated
+                fillRun(row + x * pixel_size, src, pixels, pixel_size);
+            }
+            else
+            {
+                // pixels stored as they are
+                memcpy(row + x * pixel_size, src, pixels * pixel_size);
+                src += pixels * pixel_size;
+            }
+            x += pixels;
+            count -= pixels;
+            decoded += pixels;
+            if (x == m_width && decoded < num_pixels)
+            {
+                x = 0;
+                ++y;
+                row = texture_data + (flip_rows ? m_height - 1 - y : y) * row_size;
+            }
+        }
+        if (run)
+            src += pixel_size;
     }
 
-    fclose(file);
-
+    if (decoded < num_pixels)
+    {
+        error_msg += "TGA image data is truncated";
+        return false;
+    }
     return true;
 }
\ No newline at end of file
@@ -18,10 +18,20 @@
 //using namespace
 
 // includes ////////////////////////////////////////
+// HelpLib.h should be included first (for MappedFile)
 
 
 // defines /////////////////////////////////////////
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TGA_SSE2
+#endif
 
+#define TGA_HEADER_SIZE         18
+#define TGA_PAGE_SIZE           4096                // the mapped pixels are touched once per page
+#define TGA_RLE_PACKET_FLAG     0x80                // the high bit of a packet header marks a run-length packet
+#define TGA_RLE_MAX_PACKET      128                 // pixels in a packet, at most
+#define TGA_DESCRIPTOR_RIGHT    0x10                // the pixels of a row are stored from right to left
+#define TGA_DESCRIPTOR_TOP      0x20                // the rows are stored from top to bottom
 
 // forward declarations ////////////////////////////
 
@@ -35,6 +45,7 @@ public:
     {
         unsigned int                    dimensions;
         unsigned int                    size;
+        unsigned int                    bits;               // bits per pixel of the loaded pixels: 8 (grey) or 32 (BGRA)
     };
 
     unsigned char                       m_identsize;          // size of ID field that follows 18 byte header (0 usually)
@@ -53,6 +64,7 @@ public:
     unsigned char                       m_descriptor;         // image descriptor bits (vh flip bits)
     unsigned char*                      m_palette;
     TEXTURE_INFO                        m_texture_info;
+    MappedFile                          m_file;             // the mapped file, while mapped_data of Load points in it
 
 public:
     // Constructor
@@ -62,8 +74,16 @@ public:
     ~TGA(void);
 
     // public function declarations
-    bool                                Load(std::string& filename, unsigned char** texture_data, std::string& error_msg);
-    bool                                TGAError(std::string& error_msg, const char* msg, FILE* file);
+    // loads a TGA file into texture_data (allocated with new[]) as 8 bit grey or 32 bit BGRA pixels, stored bottom to top and left to right.
+    // If mapped_data is given and the pixels need no conversion (uncompressed 8 or 32 bit pixels, bottom to top and left to right),
+    // texture_data is not allocated and mapped_data points to the pixels in the mapped file instead, which stays mapped until Unmap
+    // is called or the TGA is deleted
+    bool                                Load(std::string& filename, unsigned char** texture_data, std::string& error_msg, const unsigned char** mapped_data = NULL);
+    void                                Unmap(void);
+    bool                                TGAError(std::string& error_msg, const char* msg);
+    // decodes the run-length packets that follow the header (image types 9, 10 and 11) into texture_data, in the pixel format
+    // of the file. With flip_rows, the rows are stored bottom to top (they are stored top to bottom in the file)
+    bool                                DecodeRLE(const unsigned char* packets, size_t size, unsigned char* texture_data, bool flip_rows, std::string& error_msg);
 };
 
 #endif //TGA_H
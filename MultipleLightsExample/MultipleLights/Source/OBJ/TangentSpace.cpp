@@ -0,0 +1,205 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TangentSpace.cpp                             //
+// Batch generation of the smoothed normals and of    //
+// the tangents (with handedness) of a welded mesh    //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OBJLoader.h"      // - Header file for the OBJLoader class
+#include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "TangentSpace.h"   // - Header file for the tangent space generation
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+#ifdef TANGENT_SPACE_SSE2
+#include <emmintrin.h>      // - Header file for the SSE2 intrinsics
+#endif
+
+// defines /////////////////////////////////////////
+#define TANGENT_EMPTY_SLOT          0xFFFFFFFFu     // free slot of the smoothing hash table
+#define TANGENT_MIN_LENGTH2         1.0e-20f        // squared length below which a tangent is degenerate
+
+// any unit vector perpendicular to the normal, for vertices whose faces have no texture mapping
+static inline glm::vec3 perpendicularTangent(const glm::vec3& normal)
+{
+    glm::vec3 axis = (glm::abs(normal.x) < 0.9f) ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    glm::vec3 t = axis - normal * glm::dot(normal, axis);
+    return t / glm::length(t);
+}
+
+#ifdef TANGENT_SPACE_SSE2
+// dot product of the xyz of two vectors (their w must be 0), in all the lanes
+static inline __m128 dot3SSE2(__m128 a, __m128 b)
+{
+    __m128 m = _mm_mul_ps(a, b);
+    __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+static void orthonormalizeRange(VertexData* vertices, GLint first, GLint last, const GLuint* offsets, const GLuint* vertex_faces, const glm::vec4* face_tangents)
+{
+    const __m128 xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 zero = _mm_setzero_ps();
+
+    for (GLint v = first; v < last; ++v)
+    {
+        VertexData& vertex = vertices[v];
+
+        // the faces are gathered in 4 wide registers, w (the handedness of the face) is masked out at the end
+        __m128 sum = zero;
+        for (GLuint j = offsets[v]; j < offsets[v + 1]; ++j)
+            sum = _mm_add_ps(sum, _mm_loadu_ps(&face_tangents[vertex_faces[j]].x));
+        sum = _mm_and_ps(sum, xyz_mask);
+
+        // the normal is followed by texcoord0, which is masked out
+        __m128 n = _mm_and_ps(_mm_loadu_ps(vertex.normal), xyz_mask);
+        __m128 n_length2 = dot3SSE2(n, n);
+        if (_mm_cvtss_f32(n_length2) > 0)
+            n = _mm_div_ps(n, _mm_sqrt_ps(n_length2));
+
+        // Gram-Schmidt: remove the part along the normal and normalize
+        __m128 t = _mm_sub_ps(sum, _mm_mul_ps(n, dot3SSE2(n, sum)));
+        __m128 t_length2 = dot3SSE2(t, t);
+        if (_mm_cvtss_f32(t_length2) > TANGENT_MIN_LENGTH2)
+        {
+            t = _mm_div_ps(t, _mm_sqrt_ps(t_length2));
+        }
+        else
+        {
+            float normal[4];
+            _mm_storeu_ps(normal, n);
+            glm::vec3 p = perpendicularTangent(glm::vec3(normal[0], normal[1], normal[2]));
+            t = _mm_set_ps(0, p.z, p.y, p.x);
+        }
+
+        // keep the handedness in tangent[3]
+        __m128 old = _mm_loadu_ps(vertex.tangent);
+        _mm_storeu_ps(vertex.tangent, _mm_or_ps(_mm_and_ps(xyz_mask, t), _mm_andnot_ps(xyz_mask, old)));
+    }
+}
+#else
+static void orthonormalizeRange(VertexData* vertices, GLint first, GLint last, const GLuint* offsets, const GLuint* vertex_faces, const glm::vec4* face_tangents)
+{
+    for (GLint v = first; v < last; ++v)
+    {
+        VertexData& vertex = vertices[v];
+
+        glm::vec3 sum(0, 0, 0);
+        for (GLuint j = offsets[v]; j < offsets[v + 1]; ++j)
+            sum += glm::vec3(face_tangents[vertex_faces[j]]);
+
+        glm::vec3 n(vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+        flt n_length2 = glm::dot(n, n);
+        if (n_length2 > 0)
+            n /= glm::sqrt(n_length2);
+
+        // Gram-Schmidt: remove the part along the normal and normalize
+        glm::vec3 t = sum - n * glm::dot(n, sum);
+        flt t_length2 = glm::dot(t, t);
+        t = (t_length2 > TANGENT_MIN_LENGTH2) ? t / glm::sqrt(t_length2) : perpendicularTangent(n);
+
+        vertex.tangent[0] = t.x;
+        vertex.tangent[1] = t.y;
+        vertex.tangent[2] = t.z;
+    }
+}
+#endif
+
+// other functions
+bool generateSmoothNormals(const OBJMesh& mesh, std::vector<glm::vec3>& normals, std::vector<GLuint>& corner_normals)
+{
+    normals.clear();
+    corner_normals.clear();
+
+    size_t num_corners = 0;
+    for (unsigned long f = 0; f < mesh.num_primitives; ++f)
+    {
+        if (mesh.faces[f].normal[0] == OBJ_NO_INDEX && mesh.face_smoothing[f] != 0)
+            num_corners += 3;
+    }
+    if (num_corners == 0)
+        return false;
+
+    // open addressing hash table of (smoothing group, position) keys, at most half full
+    size_t capacity = 1;
+    while (capacity < num_corners * 2)
+        capacity <<= 1;
+    std::vector<GLuint> table(capacity, TANGENT_EMPTY_SLOT);
+    std::vector<unsigned long long> keys;
+    corner_normals.assign(mesh.num_primitives * 3, OBJ_NO_INDEX);
+
+    for (unsigned long f = 0; f < mesh.num_primitives; ++f)
+    {
+        const OBJFace& face = mesh.faces[f];
+        if (face.normal[0] != OBJ_NO_INDEX || mesh.face_smoothing[f] == 0)
+            continue;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned long long key = ((unsigned long long)mesh.face_smoothing[f] << 32) | face.vertex[k];
+            unsigned long long hash = key * 0x9E3779B97F4A7C15ull;
+            size_t slot = size_t(hash ^ (hash >> 32)) & (capacity - 1);
+            GLuint id;
+            for (;;)
+            {
+                id = table[slot];
+                if (id == TANGENT_EMPTY_SLOT)
+                {
+                    id = (GLuint)keys.size();
+                    keys.push_back(key);
+                    normals.push_back(glm::vec3(0, 0, 0));
+                    table[slot] = id;
+                    break;
+                }
+                if (keys[id] == key)
+                    break;
+                slot = (slot + 1) & (capacity - 1);
+            }
+            normals[id] += mesh.face_normals[f];
+            corner_normals[f * 3 + k] = id;
+        }
+    }
+
+    for (size_t i = 0; i < normals.size(); ++i)
+    {
+        flt length = glm::length(normals[i]);
+        normals[i] = (length > 0) ? normals[i] / length : glm::vec3(0, 1, 0);
+    }
+    return true;
+}
+
+void generateTangents(VertexData* vertices, GLint num_vertices, const GLuint* indices, GLint num_indices,
+                      const glm::vec4* face_tangents, unsigned int num_threads)
+{
+    // the faces of each vertex, in compressed rows: the faces of vertex v are vertex_faces[offsets[v]] up to vertex_faces[offsets[v + 1]]
+    std::vector<GLuint> offsets(num_vertices + 1, 0);
+    std::vector<GLuint> vertex_faces(num_indices);
+    for (GLint i = 0; i < num_indices; ++i)
+        offsets[indices[i] + 1]++;
+    for (GLint v = 0; v < num_vertices; ++v)
+        offsets[v + 1] += offsets[v];
+
+    // each row is filled using its start as a cursor, which moves the starts one row ahead. They are moved back afterwards
+    for (GLint i = 0; i < num_indices; ++i)
+        vertex_faces[offsets[indices[i]]++] = GLuint(i / 3);
+    for (GLint v = num_vertices; v > 0; --v)
+        offsets[v] = offsets[v - 1];
+    offsets[0] = 0;
+
+    // every vertex is written by a single task, so no synchronization is needed
+    size_t num_tasks = (num_vertices + TANGENT_VERTICES_PER_TASK - 1) / TANGENT_VERTICES_PER_TASK;
+    ThreadPool::getInstance().parallelFor(num_tasks, [&](size_t task)
+    {
+        GLint first = GLint(task * TANGENT_VERTICES_PER_TASK);
+        GLint last = glm::min(first + TANGENT_VERTICES_PER_TASK, num_vertices);
+        orthonormalizeRange(vertices, first, last, offsets.data(), vertex_faces.data(), face_tangents);
+    }, num_threads);
+}
+
+// eof ///////////////////////////////// TangentSpace
\ No newline at end of file
@@ -0,0 +1,50 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TangentSpace.h                               //
+// Batch generation of the smoothed normals and of    //
+// the tangents (with handedness) of a welded mesh    //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef TANGENTSPACE_H
+#define TANGENTSPACE_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+// HelpLib.h should be included first (for glm and the GL types)
+
+
+// defines /////////////////////////////////////////
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TANGENT_SPACE_SSE2
+#endif
+
+#define TANGENT_VERTICES_PER_TASK   4096            // number of vertices orthonormalized by each parallel task
+
+// forward declarations ////////////////////////////
+struct OBJMesh;
+struct VertexData;
+
+// class declarations //////////////////////////////
+
+// smoothed normals of the faces of a mesh that have no normals but belong to a smoothing group.
+// the normal of a corner is the sum of the area-weighted plane normals of all the faces of the same smoothing group
+// that use the same position (index), normalized. corner_normals receives the index in normals of each corner
+// (face * 3 + corner), or OBJ_NO_INDEX for the corners of the other faces.
+// returns false (and leaves both empty) if no face needs them
+bool generateSmoothNormals(const OBJMesh& mesh, std::vector<glm::vec3>& normals, std::vector<GLuint>& corner_normals);
+
+// tangents of the vertices of a welded mesh. Index i belongs to face i / 3.
+// the tangent of a vertex is the sum of the area-weighted tangents of the faces that use it, orthonormalized
+// against the normal of the vertex. The handedness of the vertices (in tangent[3]) is kept as it is
+void generateTangents(VertexData* vertices, GLint num_vertices, const GLuint* indices, GLint num_indices,
+                      const glm::vec4* face_tangents, unsigned int num_threads = 0);
+
+#endif //TANGENTSPACE_H
+
+// eof ///////////////////////////////// TangentSpace
\ No newline at end of file
@@ -16,15 +16,23 @@
 #include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
 #include "Texture.h"        // - Header file for the Texture class
 #include "TGA.h"            // - Header file for the TGA class
+#include "MipChain.h"       // - Header file for the mipmap generation
+#include "MipCache.h"       // - Header file for the MipCache class
+#include "BlockCompress.h"  // - Header file for the block compression
+#include "TextureStreamer.h" // - Header file for the TextureStreamer class
+#include "TextureArray.h"   // - Header file for the TextureArray class
+#include "ResidencyManager.h" // - Header file for the ResidencyManager class
 
 #define GL_BGR 0x80E0
 #define GL_BGRA 0x80E1
 
 // Constructor
-Texture::Texture(const std::string& filename, const bool build_mipmaps):
+Texture::Texture(const std::string& filename, const bool build_mipmaps, const MATERIAL_MAP_TYPE map_type):
+m_gl_texture_id(0),
 m_data_type(GL_UNSIGNED_BYTE),
 m_internal_format(GL_RGBA),
 m_data(NULL),
+m_mapped_data(NULL),
 m_tga(NULL),
 m_filename(filename),
 m_width(1),
@@ -34,12 +42,32 @@ m_bits(1),
 m_size(0),
 m_format(-1),
 m_build_mipmaps(build_mipmaps),
+m_map_type(map_type),
+m_mip_content(MIP_CONTENT_COLOUR),
+m_block_format(BLOCK_FORMAT_NONE),
+m_levels(),
+m_mip_data(NULL),
+m_mip_file(),
+m_streamed(false),
+m_base_level(0),
+m_mipmapped(false),
+m_array(nullptr),
+m_array_layer(0),
+m_uploaded_size(0),
+m_residency(),
 m_loaded(false),
 m_error_msg("")
 {
+    // normal maps are renormalized and the gloss of specular maps is not gamma corrected when they are filtered
+    if (m_map_type == MPT_MATERIAL_MAP_NORMAL)
+        m_mip_content = MIP_CONTENT_NORMAL;
+    else if (m_map_type == MPT_MATERIAL_MAP_SPECULAR_GLOSS)
+        m_mip_content = MIP_CONTENT_LINEAR;
 
     LoadTGA();
 
+    m_streamed = CanStream();
+
     if (!m_loaded)
         PrintToOutputWindow("Could not load texture: %s Error: %s", m_filename.c_str(), m_error_msg.c_str());
 }
@@ -48,7 +76,13 @@ m_error_msg("")
 // Destructor
 Texture::~Texture()
 {
-
+    // the decoded data of a texture that was never uploaded (the OpenGL texture is released with destroy)
+    if (m_streamed)
+        TextureStreamer::getInstance().removeTexture(this);
+    if (m_residency.tracked)
+        ResidencyManager::getInstance().removeTexture(this);
+    ReleaseData();
+    SAFE_DELETE(m_tga)
 }
 
 // other functions
@@ -57,11 +91,35 @@ void Texture::create()
 
 }
 
-void Texture::destroy()
+void Texture::ReleaseData(void)
 {
-    SAFE_DELETE(m_data)
+    SAFE_DELETE_ARRAY_POINTER(m_data)
+    m_mapped_data = NULL;
+    SAFE_DELETE_ARRAY_POINTER(m_mip_data)
+    m_levels.clear();
+    unmapFile(m_mip_file);
+    if (m_tga != NULL)
+        m_tga->Unmap();
+}
 
-    glDeleteTextures(1, &m_gl_texture_id);
+bool Texture::CanStream(void) const
+{
+    // textures whose levels are all small are uploaded whole, and so are the layers of the texture arrays
+    return TEXTURE_STREAMING && !TEXTURE_ARRAYS && m_loaded && m_build_mipmaps && get_resident_level() > 0;
+}
+
+void Texture::destroy()
+{
+    if (m_streamed)
+        TextureStreamer::getInstance().removeTexture(this);
+    if (m_residency.tracked)
+        ResidencyManager::getInstance().removeTexture(this);
+    ReleaseData();
+
+    if (m_array != nullptr)
+        TextureArrays::getInstance().removeTexture(this);
+    else
+        glDeleteTextures(1, &m_gl_texture_id);
 
     PrintToOutputWindow("Disposed texture with id: %d", m_gl_texture_id);
 
@@ -85,6 +143,18 @@ void Texture::UnbindTexture(void) const
 
 void Texture::GenerateTexture()
 {
+    // the levels are released below. The samplers of the materials need to know if there were any
+    m_mipmapped = m_build_mipmaps && !m_levels.empty();
+
+    // the texture is packed in the array of the textures of its map type, size and format instead
+    if (TEXTURE_ARRAYS && TextureArrays::getInstance().addTexture(this))
+    {
+        ReleaseData();
+        PrintToOutputWindow("Packed texture %s in layer %d of texture array with id: %d", m_filename.c_str(), m_array_layer, m_array->get_gl_id());
+        PrintToOutputWindow("Dimensions: width: %d, height: %d, size: %d KB", m_width, m_height, m_size);
+        return;
+    }
+
     // to create a texture we use the following:
     // Generate the OpenGL texture id
     glGenTextures(1, &m_gl_texture_id);
@@ -144,22 +214,38 @@ void Texture::GenerateTexture()
     // border specifies the width of the border if we use GL_TEXTURE_BORDER in glTexParameter. We do not use this, so 0.
     // format is the format of the texture as read from the TGA file. Usually GL_RGB, GL_BGRA, GL_RGBA and GL_BGRA are used
     // type is the data type of the pixel data. GL_UNSIGNED_BYTE is commonly used.
-    // pixels points to the texture data as read from the TGA file.
+    // pixels points to the texture data as read from the TGA file. Uncompressed files are not copied: pixels points in the mapped file then.
     // NOTE: There are many configurations for glTexImage2D. Consult the documentation for more information.
-    glTexImage2D(GL_TEXTURE_2D, 0, m_internal_format, m_width, m_height, 0, m_format, m_data_type, m_data);
+    if (m_levels.empty())
+        glTexImage2D(GL_TEXTURE_2D, 0, m_internal_format, m_width, m_height, 0, m_format, m_data_type, get_data());
+
+    // a streamed texture starts with its coarse levels. The finer ones are uploaded by the TextureStreamer when they are needed
+    m_base_level = m_streamed ? get_resident_level() : 0;
+    for (unsigned int level = m_base_level; level < m_levels.size(); ++level)
+        UploadLevel(level, m_levels[level]);
+
+    // a greyscale emission map compressed to its red channel is still sampled as grey
+    if (m_block_format == BLOCK_FORMAT_BC4 && m_bits == 32)
+    {
+        GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     // Use mipmapping for the texture minification filter
-    if (m_build_mipmaps)
+    // NOTE: the filters and the wrap mode are overridden by the sampler of the material map when SAMPLER_OBJECTS is set (see SamplerRegistry.h)
+    if (m_mipmapped)
     {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-        // glGenerateMipmap builds a series of prefiltered 2D texture maps of decreasing resolution.
+        // the series of prefiltered 2D texture maps of decreasing resolution has been built on the CPU (or read from the mipmap cache),
+        // so each level has been passed as it is and the driver has nothing to filter (glGenerateMipmap would box filter them on every load).
         // this helps the texture to look more smooth as we zoom out
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)m_base_level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)m_levels.size() - 1);
     }
     else
     {
@@ -167,12 +253,60 @@ void Texture::GenerateTexture()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     }
 
-    SAFE_DELETE(m_data)
+    // the decoded data, or the mapping of the file, is not needed anymore, unless the levels are streamed
+    m_uploaded_size = get_upload_size();
+    if (m_streamed)
+        TextureStreamer::getInstance().addTexture(this);
+    else
+        ReleaseData();
+    ResidencyManager::getInstance().addTexture(this);
 
     PrintToOutputWindow("Generated texture %s with id: %d", m_filename.c_str(), m_gl_texture_id);
     PrintToOutputWindow("Dimensions: width: %d, height: %d, size: %d KB", m_width, m_height, m_size);
 }
 
+size_t Texture::Evict(void)
+{
+    if (m_gl_texture_id == 0)
+        return 0;
+
+    size_t size = get_resident_size();
+    if (m_streamed)
+        TextureStreamer::getInstance().removeTexture(this);
+    ReleaseData();
+    glDeleteTextures(1, &m_gl_texture_id);
+    PrintToOutputWindow("Evicted texture %s with id: %d (%.2f KB)", m_filename.c_str(), m_gl_texture_id, size / 1024.0);
+
+    m_gl_texture_id = 0;
+    m_base_level = 0;
+    m_residency.evicted = true;
+    return size;
+}
+
+bool Texture::Reload(void)
+{
+    // the levels are read from the mipmap cache when there is one, so the image is not decoded or filtered again
+    SAFE_DELETE(m_tga)
+    m_loaded = false;
+    LoadTGA();
+    m_streamed = CanStream();
+    if (!m_loaded)
+        PrintToOutputWindow("Could not restore texture: %s Error: %s", m_filename.c_str(), m_error_msg.c_str());
+    return m_loaded;
+}
+
+bool Texture::Restore(void)
+{
+    if (!m_residency.evicted)
+        return true;
+    if (!m_loaded)
+        return false;
+
+    GenerateTexture();
+    m_residency.evicted = false;
+    return true;
+}
+
 bool Texture::read_error(char* text, FILE* File)
 {
     m_error_msg += text;
@@ -180,45 +314,278 @@ bool Texture::read_error(char* text, FILE* File)
     return false;
 }
 
+size_t Texture::get_upload_size(void) const
+{
+    if (m_levels.empty())
+        return (size_t)m_width * m_height * (m_bits / 8);
+    size_t size = 0;
+    for (unsigned int level = m_streamed ? get_resident_level() : 0; level < m_levels.size(); ++level)
+        size += get_level_size(level);
+    return size;
+}
+
+size_t Texture::get_level_size(unsigned int level) const
+{
+    return MipCache::getLevelSize(m_width, m_height, m_bits, m_block_format, level);
+}
+
+unsigned int Texture::get_resident_level(void) const
+{
+    unsigned int level = 0;
+    while (level + 1 < m_levels.size() &&
+           (getMipLevelWidth(m_width, level) > TEXTURE_RESIDENT_SIZE || getMipLevelHeight(m_height, level) > TEXTURE_RESIDENT_SIZE))
+        ++level;
+    return level;
+}
+
+size_t Texture::get_resident_size(void) const
+{
+    // the levels of a texture that is not streamed are released once it is generated
+    if (m_gl_texture_id == 0)
+        return 0;
+    if (!m_streamed)
+        return m_uploaded_size;
+    size_t size = 0;
+    for (unsigned int level = m_base_level; level < m_levels.size(); ++level)
+        size += get_level_size(level);
+    return size;
+}
+
+void Texture::UploadLevel(unsigned int level, const void* data)
+{
+    // compressed levels are passed with glCompressedTexImage2D, which takes the blocks as they are stored and the size of the level in bytes
+    GLsizei level_width = getMipLevelWidth(m_width, level), level_height = getMipLevelHeight(m_height, level);
+    if (m_block_format != BLOCK_FORMAT_NONE)
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, m_internal_format, level_width, level_height, 0,
+                               (GLsizei)get_level_size(level), data);
+    else
+        glTexImage2D(GL_TEXTURE_2D, level, m_internal_format, level_width, level_height, 0, m_format, m_data_type, data);
+}
+
+size_t Texture::StreamInLevel(GLuint unpack_buffer)
+{
+    if (!m_streamed || m_base_level == 0)
+        return 0;
+
+    glBindTexture(GL_TEXTURE_2D, m_gl_texture_id);
+    if (unpack_buffer != 0)
+    {
+        // with a pixel buffer object bound, the data pointer is an offset in it and the driver copies from it asynchronously
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+        UploadLevel(m_base_level - 1, NULL);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+        UploadLevel(m_base_level - 1, m_levels[m_base_level - 1]);
+    // the new level is used only once it is complete
+    m_base_level--;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)m_base_level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return get_level_size(m_base_level);
+}
+
+size_t Texture::EvictLevel(void)
+{
+    if (!m_streamed || m_base_level >= get_resident_level())
+        return 0;
+
+    glBindTexture(GL_TEXTURE_2D, m_gl_texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)m_base_level + 1);
+    // a level redefined with no pixels releases its memory (the levels below the base level do not affect completeness)
+    if (m_block_format != BLOCK_FORMAT_NONE)
+        glCompressedTexImage2D(GL_TEXTURE_2D, m_base_level, m_internal_format, 0, 0, 0, 0, NULL);
+    else
+        glTexImage2D(GL_TEXTURE_2D, m_base_level, m_internal_format, 0, 0, 0, m_format, m_data_type, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return get_level_size(m_base_level++);
+}
+
 void Texture::LoadTGA(void)
 {
     m_tga = new TGA();
 
     m_error_msg = "";
 
+    // the specular maps are not compressed, since BC1 would lose the gloss in their alpha and BC3 is as large as the source
+    bool compress = TEXTURE_BLOCK_COMPRESSION && m_map_type != MPT_MATERIAL_MAP_SPECULAR_GLOSS;
+
+    // the mipmaps and the blocks of the image may have been generated by a previous run, in which case the image is not decoded at all
+    unsigned long long source_hash = 0;
+    int seed = get_cache_seed(m_map_type, m_build_mipmaps);
+    bool hashed = (m_build_mipmaps || compress) && hashFile(m_filename, source_hash, seed);
+    if (hashed && LoadCachedLevels(seed, source_hash))
+        return;
+
     unsigned char** data = NULL;
 
     data = &m_data;
 
-    m_loaded = m_tga->Load(m_filename, data, m_error_msg);
+    m_loaded = m_tga->Load(m_filename, data, m_error_msg, &m_mapped_data);
 
     if (m_loaded == false) return;
 
-    if (m_tga->m_bits == 8)
+    m_width            = m_tga->m_width;
+    m_height        = m_tga->m_height;
+    m_bits            = m_tga->m_texture_info.bits;
+
+    // the textures packed in arrays share the size of their bucket
+    if (TEXTURE_ARRAYS)
+        ResampleToBucket();
+    if (m_build_mipmaps)
+        BuildMipmaps();
+    // the levels are only compressed if the first one is made of whole blocks, since older drivers reject partial ones
+    if (compress && m_width % 4 == 0 && m_height % 4 == 0)
+        CompressLevels();
+    SetFormat();
+
+    if (hashed && !m_levels.empty())
+        MipCache::writeLevels(m_filename, seed, source_hash, m_width, m_height, m_bits, TEXTURE_MIP_FILTER, m_mip_content, m_block_format, m_levels);
+}
+
+void Texture::SetFormat(void)
+{
+    // the TGA pixels are converted to layouts the GPU uses natively, so that the driver has nothing to convert
+    if (m_bits == 8)
     {
         m_format = GL_RED;
-        m_internal_format = GL_RED;
-    }
-    else if (m_tga->m_bits == 16 || m_tga->m_bits == 24)
-    {
-        m_format = GL_BGR;
-        m_internal_format = GL_RGB;
+        m_internal_format = GL_R8;
     }
-    else if (m_tga->m_bits == 32)
+    else
     {
         m_format = GL_BGRA;
-        m_internal_format = GL_RGBA;
+        m_internal_format = GL_RGBA8;
     }
 
-    m_width            = m_tga->m_width;
-    m_height        = m_tga->m_height;
-    m_bits            = m_tga->m_bits;
+    // the blocks are uploaded as they are
+    switch (m_block_format)
+    {
+    case BLOCK_FORMAT_BC1: m_internal_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+    case BLOCK_FORMAT_BC3: m_internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+    case BLOCK_FORMAT_BC4: m_internal_format = GL_COMPRESSED_RED_RGTC1; break;
+    case BLOCK_FORMAT_BC5: m_internal_format = GL_COMPRESSED_RG_RGTC2; break;
+    default: break;
+    }
 
-    unsigned int texture_size=  m_width * m_height * (m_bits / 8);
+    unsigned int texture_size = (m_block_format != BLOCK_FORMAT_NONE) ? (unsigned int)getCompressedSize(m_block_format, m_width, m_height) :
+                                                                        m_width * m_height * (m_bits / 8);
     texture_size /= 1024.0f;
 
     m_size = texture_size;
 
     m_dimensions    = 2;
     if (m_height <= 1) m_dimensions = 1;
+}
+
+int Texture::get_cache_seed(const MATERIAL_MAP_TYPE map_type, const bool build_mipmaps)
+{
+    // the map type decides the block format and whether the levels are compressed, and the texture arrays the size of the levels
+    bool compress = TEXTURE_BLOCK_COMPRESSION && map_type != MPT_MATERIAL_MAP_SPECULAR_GLOSS;
+    return 4 * (int)map_type + (compress ? 2 : 0) + (build_mipmaps ? 1 : 0) + (TEXTURE_ARRAYS ? 4 * MPT_MATERIAL_MAP_COUNT : 0);
+}
+
+bool Texture::LoadCachedLevels(int seed, unsigned long long source_hash)
+{
+    if (!MipCache::readLevels(m_filename, seed, source_hash, TEXTURE_MIP_FILTER, m_mip_content, m_build_mipmaps, m_mip_file, m_width, m_height, m_bits,
+                              m_block_format, m_levels))
+        return false;
+
+    m_loaded = true;
+    SetFormat();
+    return true;
+}
+
+void Texture::ResampleToBucket(void)
+{
+    unsigned int width = TextureArrays::getBucketSize(m_width), height = TextureArrays::getBucketSize(m_height);
+    if (width == m_width && height == m_height)
+        return;
+
+    // the resampled pixels replace the decoded ones (or the mapping of the file)
+    unsigned int pixel_size = m_bits / 8;
+    unsigned char* pixels = new unsigned char[(size_t)width * height * pixel_size];
+    resampleImage(get_data(), m_width, m_height, pixel_size, TEXTURE_MIP_FILTER, m_mip_content, width, height, pixels);
+    PrintToOutputWindow("Resampled texture %s from %dx%d to %dx%d", m_filename.c_str(), m_width, m_height, width, height);
+
+    SAFE_DELETE_ARRAY_POINTER(m_data)
+    m_mapped_data = NULL;
+    m_tga->Unmap();
+    m_data = pixels;
+    m_width = width;
+    m_height = height;
+}
+
+void Texture::BuildMipmaps(void)
+{
+    // level 0 stays where it is, the smaller levels are generated after it
+    unsigned int pixel_size = m_bits / 8;
+    size_t level_size = (size_t)m_width * m_height * pixel_size;
+    m_mip_data = new unsigned char[getMipChainSize(m_width, m_height, pixel_size) - level_size];
+    unsigned int num_levels = buildMipChain(get_data(), m_width, m_height, pixel_size, TEXTURE_MIP_FILTER, m_mip_content, m_mip_data);
+
+    m_levels.resize(num_levels);
+    m_levels[0] = get_data();
+    const unsigned char* level = m_mip_data;
+    for (unsigned int l = 1; l < num_levels; ++l)
+    {
+        m_levels[l] = level;
+        level += (size_t)getMipLevelWidth(m_width, l) * getMipLevelHeight(m_height, l) * pixel_size;
+    }
+}
+
+BlockFormat Texture::ChooseBlockFormat(void) const
+{
+    const unsigned char* pixels = get_data();
+    size_t num_pixels = (size_t)m_width * m_height;
+    switch (m_map_type)
+    {
+    case MPT_MATERIAL_MAP_DIFFUSE_OP:
+        // the alpha is kept only if some pixel is not opaque
+        if (m_bits == 8)
+            return BLOCK_FORMAT_BC4;
+        for (size_t i = 0; i < num_pixels; ++i)
+            if (pixels[i * 4 + 3] != 255)
+                return BLOCK_FORMAT_BC3;
+        return BLOCK_FORMAT_BC1;
+    case MPT_MATERIAL_MAP_NORMAL:
+        // x and y of a normal map (z is reconstructed as sqrt(1 - x^2 - y^2)), or the height of a bump map
+        return (m_bits == 8) ? BLOCK_FORMAT_BC4 : BLOCK_FORMAT_BC5;
+    case MPT_MATERIAL_MAP_EMISSION:
+        // an intensity is a single channel, a coloured emission map is not
+        if (m_bits == 32)
+            for (size_t i = 0; i < num_pixels; ++i)
+                if (pixels[i * 4] != pixels[i * 4 + 1] || pixels[i * 4 + 1] != pixels[i * 4 + 2] || pixels[i * 4 + 3] != 255)
+                    return BLOCK_FORMAT_BC1;
+        return BLOCK_FORMAT_BC4;
+    default:
+        return BLOCK_FORMAT_NONE;
+    }
+}
+
+void Texture::CompressLevels(void)
+{
+    m_block_format = ChooseBlockFormat();
+    if (m_block_format == BLOCK_FORMAT_NONE)
+        return;
+    if (m_levels.empty())
+        m_levels.push_back(get_data());
+
+    // all the levels are compressed to one buffer, which replaces the pixels
+    size_t size = 0;
+    for (unsigned int level = 0; level < m_levels.size(); ++level)
+        size += getCompressedSize(m_block_format, getMipLevelWidth(m_width, level), getMipLevelHeight(m_height, level));
+    unsigned char* blocks = new unsigned char[size];
+    unsigned char* level_blocks = blocks;
+    for (unsigned int level = 0; level < m_levels.size(); ++level)
+    {
+        unsigned int level_width = getMipLevelWidth(m_width, level), level_height = getMipLevelHeight(m_height, level);
+        compressImage(m_levels[level], level_width, level_height, m_bits / 8, m_block_format, level_blocks);
+        m_levels[level] = level_blocks;
+        level_blocks += getCompressedSize(m_block_format, level_width, level_height);
+    }
+
+    SAFE_DELETE_ARRAY_POINTER(m_data)
+    m_mapped_data = NULL;
+    SAFE_DELETE_ARRAY_POINTER(m_mip_data)
+    m_tga->Unmap();
+    m_mip_data = blocks;
 }
\ No newline at end of file
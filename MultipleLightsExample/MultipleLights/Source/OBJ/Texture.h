@@ -19,8 +19,17 @@
 
 // includes ////////////////////////////////////////
 #include "TGA.h"
+#include "MipChain.h"
+#include "BlockCompress.h"
+#include "OBJMaterial.h"
+#include "TextureArray.h"
+#include "ResidencyManager.h"
 
 // defines /////////////////////////////////////////
+#define TEXTURE_MIP_FILTER          MIP_FILTER_KAISER   // the filter of the mipmaps generated on the CPU
+#define TEXTURE_BLOCK_COMPRESSION   1                   // compress the diffuse, normal and emission maps to BC1/BC3/BC4/BC5 on the CPU
+#define TEXTURE_STREAMING           1                   // upload only the coarse levels of textures with mipmaps, and the rest when they are needed
+#define TEXTURE_RESIDENT_SIZE       64                  // levels of at most this width and height are always uploaded
 
 
 // forward declarations ////////////////////////////
@@ -43,6 +52,7 @@ private:
     int                                 m_data_type;
     unsigned int                        m_internal_format;
     unsigned char*                      m_data;
+    const unsigned char*                m_mapped_data;      // the pixels in the mapped file, when they are uploaded as they are
     TGA*                                m_tga;
     std::string                         m_filename;
     unsigned int                        m_width;
@@ -52,12 +62,36 @@ private:
     unsigned int                        m_size;
     int                                 m_format;
     bool                                m_build_mipmaps;
+    MATERIAL_MAP_TYPE                   m_map_type;         // the map of the material the texture is used as
+    MipContent                          m_mip_content;      // what the pixels hold, which decides how the mipmaps are filtered
+    BlockFormat                         m_block_format;     // the format the levels are compressed to, if any
+    std::vector<const unsigned char*>   m_levels;           // the pixels (or blocks) of each mipmap level (level 0 first), when they are built or compressed
+    unsigned char*                      m_mip_data;         // levels 1 and up when they are generated, or all the levels when they are compressed
+    MappedFile                          m_mip_file;         // all the levels, when they are read from the mipmap cache
+    bool                                m_streamed;         // the levels are kept after GenerateTexture, and the finer ones are uploaded by the TextureStreamer
+    unsigned int                        m_base_level;       // the finest level uploaded (GL_TEXTURE_BASE_LEVEL)
+    bool                                m_mipmapped;        // the texture was generated with mipmaps
+    TextureArray*                       m_array;            // the array the texture is packed in, instead of its own OpenGL texture
+    unsigned int                        m_array_layer;
+    size_t                              m_uploaded_size;    // bytes uploaded by GenerateTexture, since the levels are released after it
+    Residency                           m_residency;        // of the OpenGL texture (see ResidencyManager)
     bool                                m_loaded;
     std::string                         m_error_msg;
 
+    // private function declarations
+    void                                SetFormat(void);
+    bool                                LoadCachedLevels(int seed, unsigned long long source_hash);
+    void                                ResampleToBucket(void);
+    void                                BuildMipmaps(void);
+    BlockFormat                         ChooseBlockFormat(void) const;
+    void                                CompressLevels(void);
+    void                                UploadLevel(unsigned int level, const void* data);
+    void                                ReleaseData(void);
+    bool                                CanStream(void) const;
+
 public:
     // Constructor
-    Texture(const std::string& filename, const bool build_mipmaps = false);
+    Texture(const std::string& filename, const bool build_mipmaps = false, const MATERIAL_MAP_TYPE map_type = MPT_MATERIAL_MAP_DIFFUSE_OP);
 
     // Destructor
     ~Texture(void);
@@ -70,21 +104,63 @@ public:
     void                                create(void);
     void                                destroy(void);
     void                                GenerateTexture(void);
+    // deletes the OpenGL texture (not of a texture packed in an array) and releases the levels. Returns the released bytes
+    size_t                              Evict(void);
+    // reads an evicted texture again (from the mipmap cache, if it has one), without any OpenGL calls, so it can be done on a
+    // worker thread while the texture is not sampled. Returns false if it could not be read
+    bool                                Reload(void);
+    // generates an evicted texture that has been reloaded
+    bool                                Restore(void);
     void                                BindTexture(void) const;
     void                                UnbindTexture(void) const;
 
     // get functions
+    // the seed of the hash of the mipmap cache of a texture, from the settings its levels depend on (see MipCache::getCacheFileName)
+    static int                          get_cache_seed(const MATERIAL_MAP_TYPE map_type, const bool build_mipmaps);
     const int                           get_texture_gl_id(void) const                   { return m_gl_texture_id; }
-    const unsigned char*                get_data(void) const                            { return m_data; }
+    // the pixels to upload, decoded or in the mapped file
+    const unsigned char*                get_data(void) const                            { return (m_data != NULL) ? m_data : m_mapped_data; }
     const std::string&                  get_filename(void) const                        { return m_filename; }
     const unsigned int                  get_dimensions(void) const                      { return m_dimensions; }
     const unsigned int                  get_width(void) const                           { return m_width; }
     const unsigned int                  get_height(void) const                          { return m_height; }
     const unsigned int                  get_bits(void) const                            { return m_bits; }
     const unsigned int                  get_size(void) const                            { return m_size; }
+    MATERIAL_MAP_TYPE                   get_map_type(void) const                        { return m_map_type; }
+    unsigned int                        get_internal_format(void) const                 { return m_internal_format; }
+    int                                 get_format(void) const                          { return m_format; }
+    int                                 get_data_type(void) const                       { return m_data_type; }
+    // bytes uploaded by GenerateTexture (all the mipmap levels, when they are built on the CPU, and the blocks, when they are compressed)
+    size_t                              get_upload_size(void) const;
+    BlockFormat                         get_block_format(void) const                    { return m_block_format; }
+    unsigned int                        get_num_levels(void) const                      { return (unsigned int)m_levels.size(); }
+    size_t                              get_level_size(unsigned int level) const;
+    const unsigned char*                get_level_data(unsigned int level) const        { return m_levels[level]; }
+    bool                                streamed(void) const                            { return m_streamed; }
+    unsigned int                        get_base_level(void) const                      { return m_base_level; }
+    // the finest level that is always uploaded, the largest of at most TEXTURE_RESIDENT_SIZE
+    unsigned int                        get_resident_level(void) const;
+    // bytes of the levels uploaded now
+    size_t                              get_resident_size(void) const;
+    size_t                              get_uploaded_size(void) const                   { return m_uploaded_size; }
+    Residency&                          get_residency(void)                             { return m_residency; }
+
+    // uploads the level finer than the base level of a streamed texture and makes it the base level. Returns the uploaded bytes.
+    // The level is read from the start of unpack_buffer (a pixel buffer object holding it), or from the level data if it is 0
+    size_t                              StreamInLevel(GLuint unpack_buffer = 0);
+    // releases the base level of a streamed texture (if it is not always resident) and makes the next one the base level.
+    // Returns the released bytes
+    size_t                              EvictLevel(void);
     bool                                loaded(void) const                              { return m_loaded; }
+    // the OpenGL texture has been created, or the texture has been packed in an array (by GenerateTexture)
+    bool                                generated(void) const                           { return m_gl_texture_id != 0 || m_array != nullptr; }
+    // the texture was generated with its mipmap levels, so it can be sampled with a mipmap minification filter
+    bool                                mipmapped(void) const                           { return m_mipmapped; }
+    TextureArray*                       get_array(void) const                           { return m_array; }
+    unsigned int                        get_array_layer(void) const                     { return m_array_layer; }
 
     // set functions
+    void                                set_array(TextureArray* array, unsigned int layer) { m_array = array; m_array_layer = layer; }
 };
 
 #endif //TEXTURE_H
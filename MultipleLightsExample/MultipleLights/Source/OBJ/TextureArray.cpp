@@ -0,0 +1,267 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureArray.cpp                             //
+// TextureArray packs the textures of a map type with //
+// the same size and format in the layers of a        //
+// GL_TEXTURE_2D_ARRAY, so that the elements that use //
+// them are drawn without binding their textures      //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "Texture.h"        // - Header file for the Texture class
+#include "MipCache.h"       // - Header file for the MipCache class
+#include "TextureArray.h"   // - Header file for the TextureArray class
+
+#include <algorithm>        // - Header file for find
+
+// Constructor
+TextureArray::TextureArray(const Texture* texture, unsigned int num_layers):
+    m_gl_texture_id(0),
+    m_map_type(texture->get_map_type()),
+    m_width(texture->get_width()),
+    m_height(texture->get_height()),
+    m_num_levels(glm::max(texture->get_num_levels(), 1u)),
+    m_bits(texture->get_bits()),
+    m_block_format(texture->get_block_format()),
+    m_internal_format(texture->get_internal_format()),
+    m_format(texture->get_format()),
+    m_data_type(texture->get_data_type()),
+    m_used(num_layers, false),
+    m_num_used(0)
+{
+    m_gl_texture_id = allocate(num_layers);
+    PrintToOutputWindow("Created texture array with id: %d (%dx%d, %d levels, %d layers, %.2f KB)", m_gl_texture_id, m_width, m_height,
+        m_num_levels, num_layers, get_size() / 1024.0);
+}
+
+// Destructor
+TextureArray::~TextureArray(void)
+{
+
+}
+
+// other functions
+size_t TextureArray::getLevelSize(unsigned int level) const
+{
+    return MipCache::getLevelSize(m_width, m_height, m_bits, m_block_format, level);
+}
+
+size_t TextureArray::get_size(void) const
+{
+    size_t size = 0;
+    for (unsigned int level = 0; level < m_num_levels; ++level)
+        size += getLevelSize(level) * m_used.size();
+    return size;
+}
+
+GLuint TextureArray::allocate(unsigned int num_layers)
+{
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+
+    // each level holds all the layers. The pixels are uploaded by addLayer
+    for (unsigned int level = 0; level < m_num_levels; ++level)
+    {
+        GLsizei level_width = getMipLevelWidth(m_width, level), level_height = getMipLevelHeight(m_height, level);
+        if (m_block_format != BLOCK_FORMAT_NONE)
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, m_internal_format, level_width, level_height, num_layers, 0,
+                                   (GLsizei)(getLevelSize(level) * num_layers), NULL);
+        else
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, m_internal_format, level_width, level_height, num_layers, 0, m_format, m_data_type, NULL);
+    }
+
+    // the same parameters as a texture of the layers (see Texture::GenerateTexture), also overridden by the samplers of the materials
+    if (m_block_format == BLOCK_FORMAT_BC4 && m_bits == 32)
+    {
+        GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (m_num_levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)m_num_levels - 1);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return id;
+}
+
+bool TextureArray::grow(void)
+{
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    unsigned int old_layers = get_num_layers();
+    unsigned int num_layers = glm::min(old_layers * 2, (unsigned int)max_layers);
+    if (!GLEW_ARB_copy_image || num_layers <= old_layers)
+        return false;
+
+    // the layers are copied on the GPU, so the textures do not have to be kept on the CPU
+    GLuint id = allocate(num_layers);
+    for (unsigned int level = 0; level < m_num_levels; ++level)
+        glCopyImageSubData(m_gl_texture_id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                           getMipLevelWidth(m_width, level), getMipLevelHeight(m_height, level), old_layers);
+    glDeleteTextures(1, &m_gl_texture_id);
+    m_gl_texture_id = id;
+    m_used.resize(num_layers, false);
+
+    PrintToOutputWindow("Grew texture array to id: %d (%d layers, %.2f KB)", m_gl_texture_id, num_layers, get_size() / 1024.0);
+    return true;
+}
+
+bool TextureArray::matches(const Texture* texture) const
+{
+    return texture->get_map_type() == m_map_type && texture->get_width() == m_width && texture->get_height() == m_height &&
+           glm::max(texture->get_num_levels(), 1u) == m_num_levels && texture->get_bits() == m_bits &&
+           texture->get_block_format() == m_block_format && texture->get_internal_format() == m_internal_format;
+}
+
+int TextureArray::addLayer(const Texture* texture)
+{
+    std::vector<bool>::iterator free_layer = std::find(m_used.begin(), m_used.end(), false);
+    if (free_layer == m_used.end())
+    {
+        // the new layers follow the used ones
+        unsigned int old_layers = get_num_layers();
+        if (!grow())
+            return -1;
+        free_layer = m_used.begin() + old_layers;
+    }
+    unsigned int layer = (unsigned int)(free_layer - m_used.begin());
+
+    // a texture without mipmaps that is not compressed has no levels, only its pixels
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_gl_texture_id);
+    for (unsigned int level = 0; level < m_num_levels; ++level)
+    {
+        GLsizei level_width = getMipLevelWidth(m_width, level), level_height = getMipLevelHeight(m_height, level);
+        const void* data = (texture->get_num_levels() > 0) ? texture->get_level_data(level) : texture->get_data();
+        if (m_block_format != BLOCK_FORMAT_NONE)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, level_width, level_height, 1, m_internal_format,
+                                      (GLsizei)getLevelSize(level), data);
+        else
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, level_width, level_height, 1, m_format, m_data_type, data);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_used[layer] = true;
+    m_num_used++;
+    return (int)layer;
+}
+
+void TextureArray::removeLayer(unsigned int layer)
+{
+    if (layer >= m_used.size() || !m_used[layer])
+        return;
+    m_used[layer] = false;
+    m_num_used--;
+}
+
+void TextureArray::release(void)
+{
+    if (m_gl_texture_id != 0)
+        glDeleteTextures(1, &m_gl_texture_id);
+    m_gl_texture_id = 0;
+}
+
+// Constructor
+TextureArrays::TextureArrays(void)
+{
+
+}
+
+// Destructor
+TextureArrays::~TextureArrays(void)
+{
+    for (size_t i = 0; i < m_arrays.size(); ++i)
+        SAFE_DELETE(m_arrays[i]);
+}
+
+TextureArrays& TextureArrays::getInstance(void)
+{
+    static TextureArrays arrays;
+    return arrays;
+}
+
+unsigned int TextureArrays::getBucketSize(unsigned int size)
+{
+    // the power of two below the size, or the one above it if it is nearer in scale (a 1440x720 texture becomes 1024x512)
+    unsigned int lower = 1;
+    while (lower * 2 <= size)
+        lower *= 2;
+    return ((unsigned long long)size * size > 2ull * lower * lower) ? lower * 2 : lower;
+}
+
+bool TextureArrays::addTexture(Texture* texture)
+{
+    if (!texture->loaded() || getBucketSize(texture->get_width()) != texture->get_width() ||
+        getBucketSize(texture->get_height()) != texture->get_height())
+        return false;
+
+    // the first array of the size and format with a free layer, or that can grow
+    TextureArray* array = nullptr;
+    int layer = -1;
+    unsigned int num_layers = 0;
+    for (size_t i = 0; i < m_arrays.size() && layer < 0; ++i)
+    {
+        if (!m_arrays[i]->matches(texture))
+            continue;
+        array = m_arrays[i];
+        layer = array->addLayer(texture);
+        num_layers = glm::max(num_layers, array->get_num_layers());
+    }
+
+    // a new array takes TEXTURE_ARRAY_FIRST_SIZE bytes, or twice the layers of the last full one (when the arrays cannot grow)
+    if (layer < 0)
+    {
+        size_t layer_size = glm::max(texture->get_upload_size(), (size_t)1);
+        GLint max_layers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+        num_layers = glm::max(2 * num_layers, (unsigned int)glm::max(TEXTURE_ARRAY_FIRST_SIZE / layer_size, (size_t)1));
+        num_layers = glm::min(num_layers, (unsigned int)glm::max(max_layers, 1));
+        array = new TextureArray(texture, num_layers);
+        m_arrays.push_back(array);
+        layer = array->addLayer(texture);
+    }
+
+    texture->set_array(array, (unsigned int)layer);
+    return true;
+}
+
+void TextureArrays::removeTexture(Texture* texture)
+{
+    TextureArray* array = texture->get_array();
+    if (array == nullptr)
+        return;
+
+    array->removeLayer(texture->get_array_layer());
+    texture->set_array(nullptr, 0);
+    if (array->get_num_used() > 0)
+        return;
+
+    m_arrays.erase(std::find(m_arrays.begin(), m_arrays.end(), array));
+    array->release();
+    SAFE_DELETE(array);
+}
+
+void TextureArrays::release(void)
+{
+    for (size_t i = 0; i < m_arrays.size(); ++i)
+        m_arrays[i]->release();
+}
+
+size_t TextureArrays::getSize(void) const
+{
+    size_t size = 0;
+    for (size_t i = 0; i < m_arrays.size(); ++i)
+        size += m_arrays[i]->get_size();
+    return size;
+}
+
+// eof ///////////////////////////////// class TextureArray
\ No newline at end of file
@@ -0,0 +1,149 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureArray.h                               //
+// TextureArray packs the textures of a map type with //
+// the same size and format in the layers of a        //
+// GL_TEXTURE_2D_ARRAY, so that the elements that use //
+// them are drawn without binding their textures      //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef TEXTUREARRAY_H
+#define TEXTUREARRAY_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include "OBJMaterial.h"
+#include "BlockCompress.h"
+
+// defines /////////////////////////////////////////
+#define TEXTURE_ARRAYS                  0                   // pack the textures in texture arrays (the textures are resampled to power of two sizes, and are not streamed)
+#define TEXTURE_ARRAY_FIRST_SIZE        (2 * 1024 * 1024)   // bytes of a new array (at least one layer). A full array is copied to one of twice as many layers
+#define TEXTURE_ARRAY_UNIT_OFFSET       4                   // the texture unit of the array of a map is that of its texture plus this
+
+// forward declarations ////////////////////////////
+class Texture;
+
+// class declarations //////////////////////////////
+
+// the layers of an array share the map type, the width, height and number of levels, the internal format and the bits per pixel
+// of the source (a greyscale and a colour emission map compressed to BC4 are sampled differently). Each level is allocated
+// for all the layers at once, and the levels of a texture are uploaded to its layer with glTexSubImage3D.
+// All the functions must be called on the OpenGL thread
+class TextureArray
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    GLuint                              m_gl_texture_id;
+    MATERIAL_MAP_TYPE                   m_map_type;
+    unsigned int                        m_width;
+    unsigned int                        m_height;
+    unsigned int                        m_num_levels;
+    unsigned int                        m_bits;
+    BlockFormat                         m_block_format;
+    unsigned int                        m_internal_format;
+    int                                 m_format;
+    int                                 m_data_type;
+    std::vector<bool>                   m_used;             // the layers that hold a texture (the size is the number of layers)
+    unsigned int                        m_num_used;
+
+    // private function declarations
+    GLuint                              allocate(unsigned int num_layers);
+    bool                                grow(void);
+    size_t                              getLevelSize(unsigned int level) const;
+
+public:
+    // Constructor (an array of num_layers layers of the size and format of texture, which is not added to it)
+    TextureArray(const Texture* texture, unsigned int num_layers);
+
+    // Destructor (the OpenGL texture is deleted with release)
+    ~TextureArray(void);
+
+    // public function declarations
+
+    // the texture has the size and format of the layers
+    bool                                matches(const Texture* texture) const;
+
+    // uploads the levels of the texture to a free layer. If there is none, the array is grown when ARB_copy_image is supported.
+    // Returns the layer, or -1 if the array is full (another array should be used)
+    int                                 addLayer(const Texture* texture);
+
+    // the layer can be reused
+    void                                removeLayer(unsigned int layer);
+
+    // deletes the OpenGL texture (while the OpenGL context is current)
+    void                                release(void);
+
+    // get functions
+    GLuint                              get_gl_id(void) const                           { return m_gl_texture_id; }
+    unsigned int                        get_num_layers(void) const                      { return (unsigned int)m_used.size(); }
+    unsigned int                        get_num_used(void) const                        { return m_num_used; }
+    // bytes of all the layers, used or not
+    size_t                              get_size(void) const;
+
+    // set functions
+
+};
+
+// the texture arrays of all the textures. Textures of the same map type, size and format share an array, so the draws of a pass
+// bind as many arrays as there are size buckets in the scene, instead of the textures of every element
+class TextureArrays
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    std::vector<TextureArray*>          m_arrays;
+
+    // private function declarations
+    // Constructor
+    TextureArrays(void);
+
+    // Destructor (there is no OpenGL context anymore, only the objects are released)
+    ~TextureArrays(void);
+
+public:
+    // public function declarations
+    static TextureArrays&               getInstance(void);
+
+    // the size a texture is resampled to, so that it shares an array with more textures: the nearest power of two
+    static unsigned int                 getBucketSize(unsigned int size);
+
+    // packs the texture in an array, instead of creating an OpenGL texture for it. Returns false if its size is not a power of
+    // two, in which case it is uploaded on its own
+    bool                                addTexture(Texture* texture);
+
+    // frees the layer of the texture. The array is deleted when it has no textures left
+    void                                removeTexture(Texture* texture);
+
+    // deletes the OpenGL textures of all the arrays (while the OpenGL context is current)
+    void                                release(void);
+
+    // get functions
+    unsigned int                        getNumArrays(void) const                        { return (unsigned int)m_arrays.size(); }
+    size_t                              getSize(void) const;
+
+    // set functions
+
+};
+
+#endif //TEXTUREARRAY_H
+
+// eof ///////////////////////////////// class TextureArray
\ No newline at end of file
@@ -0,0 +1,196 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureCache.cpp                             //
+// TextureCache shares the decoded and uploaded       //
+// textures across all the materials that use the     //
+// same image file                                    //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "Texture.h"        // - Header file for the Texture class
+#include "TextureCache.h"   // - Header file for the TextureCache class
+#include "TextureStreamer.h" // - Header file for the TextureStreamer class
+#include "ResidencyManager.h" // - Header file for the ResidencyManager class
+#include "TextureArray.h"   // - Header file for the TextureArray class
+
+#include <cctype>           // - Header file for tolower
+
+// Constructor
+TextureCache::TextureCache(void) :
+    m_decodes(0),
+    m_acquires(0)
+{
+    // the streamer, the residency manager and the texture arrays are created first, so that they are destroyed after the cached
+    // textures that unregister from them
+    TextureStreamer::getInstance();
+    ResidencyManager::getInstance();
+    TextureArrays::getInstance();
+}
+
+// Destructor
+TextureCache::~TextureCache(void)
+{
+    // there is no OpenGL context anymore, only the CPU data is released
+    for (std::unordered_map<const Texture*, Entry*>::iterator it = m_textures.begin(); it != m_textures.end(); ++it)
+    {
+        SAFE_DELETE(it->second->texture);
+        SAFE_DELETE(it->second);
+    }
+}
+
+// other functions
+TextureCache& TextureCache::getInstance(void)
+{
+    static TextureCache cache;
+    return cache;
+}
+
+std::string TextureCache::getCanonicalPath(const std::string& filename)
+{
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= filename.size())
+    {
+        size_t end = filename.find_first_of("\\/", begin);
+        if (end == std::string::npos)
+            end = filename.size();
+        std::string part = filename.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (part.empty() || part == ".")
+            continue;
+        if (part == ".." && !parts.empty() && parts.back() != "..")
+            parts.pop_back();
+        else
+            parts.push_back(part);
+    }
+
+    std::string path = (!filename.empty() && (filename[0] == '\\' || filename[0] == '/')) ? "\\" : "";
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        if (i > 0)
+            path += '\\';
+        path += parts[i];
+    }
+    // file names are not case sensitive on Windows
+    for (size_t i = 0; i < path.size(); ++i)
+        path[i] = (char)tolower((unsigned char)path[i]);
+    return path;
+}
+
+Texture* TextureCache::referenceLocked(Entry* entry, std::unique_lock<std::mutex>& lock)
+{
+    entry->references++;
+    // the first user may still be decoding it
+    m_decoded.wait(lock, [entry] { return entry->decoded; });
+    return entry->texture;
+}
+
+Texture* TextureCache::acquire(const std::string& filename, bool build_mipmaps, MATERIAL_MAP_TYPE map_type)
+{
+    std::string path_key = getCanonicalPath(filename) + "|" + std::to_string((int)map_type) + (build_mipmaps ? "|mipmaps" : "");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_acquires++;
+    std::unordered_map<std::string, Entry*>::iterator path = m_paths.find(path_key);
+    if (path != m_paths.end())
+        return referenceLocked(path->second, lock);
+    lock.unlock();
+
+    // a path seen for the first time may still be a copy of a cached file. The mipmap settings and the map type are part
+    // of the key, since the OpenGL textures differ
+    unsigned long long content_key = 0;
+    bool hashed = hashFile(filename, content_key, (build_mipmaps ? 1 : 0) + 2 * (int)map_type);
+
+    lock.lock();
+    path = m_paths.find(path_key);
+    if (path != m_paths.end())
+        return referenceLocked(path->second, lock);
+    std::unordered_map<unsigned long long, Entry*>::iterator content = hashed ? m_contents.find(content_key) : m_contents.end();
+    if (content != m_contents.end())
+    {
+        m_paths[path_key] = content->second;
+        return referenceLocked(content->second, lock);
+    }
+
+    // the other users of the texture wait for this thread to decode it
+    Entry* entry = new Entry();
+    entry->texture = nullptr;
+    entry->content_key = content_key;
+    entry->references = 1;
+    entry->decoded = false;
+    m_paths[path_key] = entry;
+    if (hashed)
+        m_contents[content_key] = entry;
+    m_decodes++;
+    lock.unlock();
+
+    Texture* texture = new Texture(filename, build_mipmaps, map_type);
+
+    lock.lock();
+    entry->texture = texture;
+    entry->decoded = true;
+    m_textures[texture] = entry;
+    lock.unlock();
+    m_decoded.notify_all();
+    return texture;
+}
+
+void TextureCache::release(Texture* texture)
+{
+    if (texture == nullptr)
+        return;
+
+    Entry* entry = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unordered_map<const Texture*, Entry*>::iterator it = m_textures.find(texture);
+        if (it == m_textures.end() || --it->second->references > 0)
+            return;
+
+        entry = it->second;
+        m_textures.erase(it);
+        std::unordered_map<unsigned long long, Entry*>::iterator content = m_contents.find(entry->content_key);
+        if (content != m_contents.end() && content->second == entry)
+            m_contents.erase(content);
+        // all the paths that led to this texture
+        for (std::unordered_map<std::string, Entry*>::iterator path = m_paths.begin(); path != m_paths.end(); )
+        {
+            if (path->second == entry)
+                path = m_paths.erase(path);
+            else
+                ++path;
+        }
+    }
+
+    if (texture->generated())
+        texture->destroy();
+    SAFE_DELETE(texture);
+    SAFE_DELETE(entry);
+}
+
+unsigned int TextureCache::getNumTextures(void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return (unsigned int)m_textures.size();
+}
+
+unsigned long long TextureCache::getNumDecodes(void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_decodes;
+}
+
+unsigned long long TextureCache::getNumAcquires(void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_acquires;
+}
+
+// eof ///////////////////////////////// class TextureCache
\ No newline at end of file
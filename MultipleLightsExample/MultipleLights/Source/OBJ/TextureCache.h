@@ -0,0 +1,104 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureCache.h                               //
+// TextureCache shares the decoded and uploaded       //
+// textures across all the materials that use the     //
+// same image file                                    //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <string>
+#include "OBJMaterial.h"
+
+// defines /////////////////////////////////////////
+
+
+// forward declarations ////////////////////////////
+class Texture;
+
+// class declarations //////////////////////////////
+
+// the process-wide set of textures. A texture is found by its canonical path and, for a path seen for the first time,
+// by the hash of the contents of its file, so copies of the same image under different names are decoded once as well.
+// textures are reference counted: each acquire is matched by a release, and the last release deletes the texture and
+// its OpenGL texture (so it should be made on the OpenGL thread). Thread-safe
+class TextureCache
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    struct Entry
+    {
+        Texture*                        texture;
+        unsigned long long              content_key;        // hash of the file contents and of the mipmap settings
+        unsigned int                    references;
+        bool                            decoded;            // false while a thread decodes the texture
+    };
+
+    // private variable declarations
+    std::mutex                          m_mutex;
+    std::condition_variable             m_decoded;
+    std::unordered_map<std::string, Entry*> m_paths;        // canonical path (and mipmap settings) -> texture
+    std::unordered_map<unsigned long long, Entry*> m_contents; // content key -> texture
+    std::unordered_map<const Texture*, Entry*> m_textures;
+    unsigned long long                  m_decodes;          // number of files decoded
+    unsigned long long                  m_acquires;
+
+    // private function declarations
+    Texture*                            referenceLocked(Entry* entry, std::unique_lock<std::mutex>& lock);
+
+public:
+    // Constructor
+    TextureCache(void);
+
+    // Destructor (deletes the decoded data of the textures that are still referenced)
+    ~TextureCache(void);
+
+    // public function declarations
+
+    // the process-wide cache
+    static TextureCache&                getInstance(void);
+
+    // the texture of a file, decoded on the calling thread if no other material has acquired it yet.
+    // the texture may fail to load (see Texture::loaded). Never returns nullptr. map_type is the map of the material the
+    // file is used as, which decides how the mipmaps are filtered and how the texture is compressed
+    Texture*                            acquire(const std::string& filename, bool build_mipmaps, MATERIAL_MAP_TYPE map_type);
+
+    // releases a texture returned by acquire. nullptr is ignored
+    void                                release(Texture* texture);
+
+    // lower case, with backslashes, without repeated separators and with the . and .. parts resolved
+    static std::string                  getCanonicalPath(const std::string& filename);
+
+    // get functions
+    // number of textures in the cache
+    unsigned int                        getNumTextures(void);
+    // number of files decoded, and number of acquires (the files that would be decoded without the cache)
+    unsigned long long                  getNumDecodes(void);
+    unsigned long long                  getNumAcquires(void);
+
+    // set functions
+
+};
+
+#endif //TEXTURECACHE_H
+
+// eof ///////////////////////////////// class TextureCache
\ No newline at end of file
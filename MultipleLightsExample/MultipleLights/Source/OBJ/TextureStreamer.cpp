@@ -0,0 +1,192 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureStreamer.cpp                          //
+// TextureStreamer uploads the finer mipmap levels of //
+// the textures when they are needed on the screen    //
+// and releases them when they are not                //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "Texture.h"        // - Header file for the Texture class
+#include "TGA.h"            // - Header file for the TGA class
+#include "TextureStreamer.h" // - Header file for the TextureStreamer class
+
+#include <algorithm>        // - Header file for sort
+
+// Constructor
+TextureStreamer::TextureStreamer(void):
+    m_pool(TEXTURE_STREAMER_NUM_THREADS + 1),
+    m_ring(m_pool),
+    m_frame(0),
+    m_streamed_bytes(0),
+    m_evicted_bytes(0)
+{
+
+}
+
+// Destructor
+TextureStreamer::~TextureStreamer(void)
+{
+    for (std::unordered_map<const Texture*, Entry*>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if (it->second->prefetch.valid())
+            it->second->prefetch.wait();
+        SAFE_DELETE(it->second);
+    }
+}
+
+// other functions
+TextureStreamer& TextureStreamer::getInstance(void)
+{
+    static TextureStreamer streamer;
+    return streamer;
+}
+
+void TextureStreamer::addTexture(Texture* texture)
+{
+    if (m_entries.find(texture) != m_entries.end())
+        return;
+
+    Entry* entry = new Entry();
+    entry->texture = texture;
+    for (unsigned int level = 0; level < MIP_CHAIN_MAX_LEVELS; ++level)
+        entry->needed_frame[level] = -1;
+    entry->prefetch_level = 0;
+    m_entries[texture] = entry;
+}
+
+void TextureStreamer::removeTexture(Texture* texture)
+{
+    std::unordered_map<const Texture*, Entry*>::iterator it = m_entries.find(texture);
+    if (it == m_entries.end())
+        return;
+
+    // the worker may still be reading the pages of the texture, or copying a level into the ring
+    if (it->second->prefetch.valid())
+        it->second->prefetch.wait();
+    m_ring.cancel(texture);
+    SAFE_DELETE(it->second);
+    m_entries.erase(it);
+}
+
+void TextureStreamer::init(void)
+{
+    m_ring.init();
+}
+
+void TextureStreamer::release(void)
+{
+    m_ring.release();
+}
+
+void TextureStreamer::requestLevel(Texture* texture, float uv_per_pixel)
+{
+    std::unordered_map<const Texture*, Entry*>::iterator it = m_entries.find(texture);
+    if (it == m_entries.end())
+        return;
+
+    // the level sampled where a pixel covers this many texels (the finer of the two levels blended by trilinear filtering)
+    float texels_per_pixel = uv_per_pixel * glm::max(texture->get_width(), texture->get_height());
+    unsigned int level = (texels_per_pixel > 1.0f) ? (unsigned int)floor(log2(texels_per_pixel)) : 0;
+    level = glm::min(level, texture->get_num_levels() - 1);
+    it->second->needed_frame[level] = m_frame;
+}
+
+unsigned int TextureStreamer::getWantedLevel(const Entry* entry) const
+{
+    // the finest level needed lately. The always resident levels are never released
+    unsigned int resident_level = entry->texture->get_resident_level();
+    for (unsigned int level = 0; level < resident_level; ++level)
+    {
+        if (entry->needed_frame[level] >= 0 && m_frame - entry->needed_frame[level] < TEXTURE_STREAMER_KEEP_FRAMES)
+            return level;
+    }
+    return resident_level;
+}
+
+bool TextureStreamer::prefetchLevel(Entry* entry, unsigned int level)
+{
+    if (entry->prefetch.valid() && entry->prefetch_level == level)
+        return entry->prefetch.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+    // the previous prefetch is done by now, since its level was uploaded
+    if (entry->prefetch.valid())
+        entry->prefetch.wait();
+
+    // one byte of each page is read, so that the level is in memory when it is uploaded
+    const unsigned char* data = entry->texture->get_level_data(level);
+    size_t size = entry->texture->get_level_size(level);
+    entry->prefetch_level = level;
+    entry->prefetch = m_pool.enqueue([data, size]
+    {
+        volatile unsigned char touched = 0;
+        for (size_t i = 0; i < size; i += TGA_PAGE_SIZE)
+            touched += data[i];
+    });
+    return false;
+}
+
+size_t TextureStreamer::update(size_t budget, bool first)
+{
+    m_evicted_bytes = 0;
+
+    // the levels copied into the ring since the last frame are uploaded first. They were counted in the budget when queued
+    m_ring.update();
+    m_streamed_bytes = 0;
+
+    // the levels that are not needed anymore are released at once
+    std::vector<std::pair<unsigned int, Entry*> > missing;
+    for (std::unordered_map<const Texture*, Entry*>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        Entry* entry = it->second;
+        unsigned int wanted_level = getWantedLevel(entry);
+        while (entry->texture->get_base_level() < wanted_level)
+            m_evicted_bytes += entry->texture->EvictLevel();
+        if (entry->texture->get_base_level() > wanted_level)
+            missing.push_back(std::make_pair(entry->texture->get_base_level() - wanted_level, entry));
+    }
+
+    // one level of each texture per frame, the textures that are furthest from the level they need first
+    std::sort(missing.begin(), missing.end(),
+        [](const std::pair<unsigned int, Entry*>& a, const std::pair<unsigned int, Entry*>& b) { return a.first > b.first; });
+    for (size_t i = 0; i < missing.size(); ++i)
+    {
+        Entry* entry = missing[i].second;
+        if (m_ring.isQueued(entry->texture))
+            continue;
+
+        // a smaller level of another texture may still fit
+        unsigned int level = entry->texture->get_base_level() - 1;
+        size_t size = entry->texture->get_level_size(level);
+        if (m_streamed_bytes + size > budget && !(first && m_streamed_bytes == 0))
+            continue;
+
+        // through the ring if it has a free slot, otherwise next frame. Levels that do not fit in a slot are uploaded from client memory
+        if (m_ring.isAvailable() && size <= TEXTURE_UPLOAD_RING_SLOT_SIZE)
+        {
+            if (m_ring.queueLevel(entry->texture))
+                m_streamed_bytes += size;
+        }
+        else if (prefetchLevel(entry, level))
+            m_streamed_bytes += entry->texture->StreamInLevel();
+    }
+
+    m_frame++;
+    return m_streamed_bytes;
+}
+
+size_t TextureStreamer::getResidentBytes(void) const
+{
+    size_t size = 0;
+    for (std::unordered_map<const Texture*, Entry*>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        size += it->second->texture->get_resident_size();
+    return size;
+}
+
+// eof ///////////////////////////////// class TextureStreamer
\ No newline at end of file
@@ -0,0 +1,115 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureStreamer.h                            //
+// TextureStreamer uploads the finer mipmap levels of //
+// the textures when they are needed on the screen    //
+// and releases them when they are not                //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+#include "MipChain.h"
+#include "TextureUploadRing.h" // - Header file for the TextureUploadRing class
+
+#include <unordered_map>
+
+// defines /////////////////////////////////////////
+#define TEXTURE_STREAMER_NUM_THREADS    1           // threads copying the levels before they are uploaded (separate from the parallelFor pool)
+#define TEXTURE_STREAMER_KEEP_FRAMES    120         // a level that has not been needed for this many frames is released
+
+// forward declarations ////////////////////////////
+class Texture;
+
+// class declarations //////////////////////////////
+
+// the textures with mipmaps start with their coarse levels uploaded (see Texture::get_resident_level). Each frame the renderer
+// requests the level each texture needs from the size of the geometry using it on the screen, and update uploads the finer
+// levels within a byte budget and releases the ones that have not been needed for a while. A level is copied into the
+// TextureUploadRing on a worker thread and uploaded from there in a later frame, so the OpenGL thread waits neither for the
+// disk nor for the copy of the driver. The levels larger than a slot of the ring have their pages read on the worker and
+// are uploaded from client memory.
+// All the functions must be called on the OpenGL thread
+class TextureStreamer
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    struct Entry
+    {
+        Texture*                        texture;
+        int                             needed_frame[MIP_CHAIN_MAX_LEVELS];  // the last frame each level was the finest one needed (-1 never)
+        unsigned int                    prefetch_level;     // the level whose pages are read on the worker (valid if prefetch is)
+        std::future<void>               prefetch;
+    };
+
+    // private variable declarations
+    ThreadPool                          m_pool;
+    TextureUploadRing                   m_ring;
+    std::unordered_map<const Texture*, Entry*> m_entries;
+    int                                 m_frame;
+    size_t                              m_streamed_bytes;   // in the last update
+    size_t                              m_evicted_bytes;    // in the last update
+
+    // private function declarations
+    unsigned int                        getWantedLevel(const Entry* entry) const;
+    bool                                prefetchLevel(Entry* entry, unsigned int level);
+
+public:
+    // Constructor
+    TextureStreamer(void);
+
+    // Destructor (waits for the running prefetches and copies)
+    ~TextureStreamer(void);
+
+    // public function declarations
+
+    // the process-wide streamer
+    static TextureStreamer&             getInstance(void);
+
+    // called by the textures that stream their levels, once they are generated and before they are destroyed
+    void                                addTexture(Texture* texture);
+    void                                removeTexture(Texture* texture);
+
+    // create and delete the buffers of the upload ring (while the OpenGL context is current)
+    void                                init(void);
+    void                                release(void);
+
+    // the texture is drawn in this frame where a pixel covers uv_per_pixel units of its texture coordinates.
+    // The finest level requested in a frame is kept. Textures that do not stream are ignored
+    void                                requestLevel(Texture* texture, float uv_per_pixel);
+
+    // call once per frame. Uploads the levels copied into the ring since the last frame, releases the levels that are not
+    // needed anymore and starts uploading the needed ones within budget bytes, the textures that are furthest from the level
+    // they need first (if first is set, a level larger than the budget is uploaded on its own). Returns the bytes started
+    size_t                              update(size_t budget, bool first);
+
+    // get functions
+    unsigned int                        getNumTextures(void) const                      {return (unsigned int)m_entries.size();}
+    // bytes of the levels of all the streamed textures that are uploaded now
+    size_t                              getResidentBytes(void) const;
+    size_t                              getStreamedBytes(void) const                    {return m_streamed_bytes;}
+    size_t                              getEvictedBytes(void) const                     {return m_evicted_bytes;}
+    const TextureUploadRing&            getUploadRing(void) const                       {return m_ring;}
+
+    // set functions
+
+};
+
+#endif //TEXTURESTREAMER_H
+
+// eof ///////////////////////////////// class TextureStreamer
\ No newline at end of file
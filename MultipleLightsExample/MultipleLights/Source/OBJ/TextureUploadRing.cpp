@@ -0,0 +1,257 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureUploadRing.cpp                        //
+// TextureUploadRing copies texture levels into a     //
+// ring of pixel buffer objects on a worker thread    //
+// and uploads them from there, so that the OpenGL    //
+// thread does not wait for the copy of the driver    //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"         // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "Texture.h"            // - Header file for the Texture class
+#include "TextureUploadRing.h"  // - Header file for the TextureUploadRing class
+
+// Constructor
+TextureUploadRing::TextureUploadRing(ThreadPool& pool):
+    m_pool(pool),
+    m_next(0),
+    m_created(false),
+    m_failed(!TEXTURE_UPLOAD_RING),
+    m_persistent(false),
+    m_issued_bytes(0),
+    m_total_bytes(0),
+    m_full(0)
+{
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        m_slots[i].buffer = 0;
+        m_slots[i].mapped = nullptr;
+        m_slots[i].fence = 0;
+        m_slots[i].texture = nullptr;
+        m_slots[i].level = 0;
+        m_slots[i].size = 0;
+        m_slots[i].state = UPLOAD_SLOT_FREE;
+    }
+}
+
+// Destructor
+TextureUploadRing::~TextureUploadRing(void)
+{
+    // the workers may still write to the buffers
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        if (m_slots[i].copy.valid())
+            m_slots[i].copy.wait();
+    }
+}
+
+// other functions
+bool TextureUploadRing::init(void)
+{
+    if (m_created || m_failed)
+        return !m_failed;
+
+    m_created = true;
+    m_persistent = GLEW_ARB_buffer_storage != 0;
+
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        Slot& slot = m_slots[i];
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        if (m_persistent)
+        {
+            // the buffer stays mapped while the GPU reads from it. Coherent, so the writes of the workers need no flush
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, TEXTURE_UPLOAD_RING_SLOT_SIZE, NULL, flags);
+            slot.mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, TEXTURE_UPLOAD_RING_SLOT_SIZE, flags);
+        }
+        else
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, TEXTURE_UPLOAD_RING_SLOT_SIZE, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (slot.buffer == 0 || (m_persistent && slot.mapped == nullptr))
+        {
+            PrintToOutputWindow("Could not create the texture upload ring. Uploading the texture levels from client memory");
+            release();
+            m_failed = true;
+            return false;
+        }
+    }
+
+    PrintToOutputWindow("Created the texture upload ring: %d buffers of %.2f KB (%s)", TEXTURE_UPLOAD_RING_SLOTS,
+        TEXTURE_UPLOAD_RING_SLOT_SIZE / 1024.0, m_persistent ? "persistently mapped" : "mapped per upload");
+    return true;
+}
+
+void TextureUploadRing::release(void)
+{
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        Slot& slot = m_slots[i];
+        if (slot.copy.valid())
+            slot.copy.wait();
+        if (slot.fence != 0)
+            glDeleteSync(slot.fence);
+        if (slot.mapped != nullptr)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        if (slot.buffer != 0)
+            glDeleteBuffers(1, &slot.buffer);
+        slot.buffer = 0;
+        slot.mapped = nullptr;
+        slot.fence = 0;
+        slot.texture = nullptr;
+        slot.state = UPLOAD_SLOT_FREE;
+    }
+    m_created = false;
+}
+
+bool TextureUploadRing::isFenceSignalled(Slot& slot)
+{
+    // the driver is not flushed here. The fence is checked again next frame
+    GLenum result = glClientWaitSync(slot.fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+    slot.state = UPLOAD_SLOT_FREE;
+    return true;
+}
+
+bool TextureUploadRing::mapSlot(Slot& slot)
+{
+    if (m_persistent)
+        return true;
+
+    // the fence of the last upload from the buffer has been signalled, so the driver does not need to synchronize
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    slot.mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slot.size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return slot.mapped != nullptr;
+}
+
+void TextureUploadRing::unmapSlot(Slot& slot)
+{
+    if (m_persistent || slot.mapped == nullptr)
+        return;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    slot.mapped = nullptr;
+}
+
+bool TextureUploadRing::queueLevel(Texture* texture)
+{
+    if (m_failed || texture->get_base_level() == 0)
+        return false;
+
+    unsigned int level = texture->get_base_level() - 1;
+    size_t size = texture->get_level_size(level);
+    if (size > TEXTURE_UPLOAD_RING_SLOT_SIZE)
+        return false;
+
+    if (!m_created && !init())
+        return false;
+
+    // the slots are used in order, so the oldest upload is the one checked
+    Slot& slot = m_slots[m_next];
+    if (slot.state == UPLOAD_SLOT_COPYING || (slot.state == UPLOAD_SLOT_IN_FLIGHT && !isFenceSignalled(slot)))
+    {
+        m_full++;
+        return false;
+    }
+
+    slot.texture = texture;
+    slot.level = level;
+    slot.size = size;
+    if (!mapSlot(slot))
+    {
+        PrintToOutputWindow("Could not map the texture upload buffer. Uploading the texture levels from client memory");
+        release();
+        m_failed = true;
+        return false;
+    }
+
+    // the copy also reads the pages of the level from the file, off the OpenGL thread
+    unsigned char* destination = slot.mapped;
+    const unsigned char* source = texture->get_level_data(level);
+    slot.copy = m_pool.enqueue([destination, source, size] { memcpy(destination, source, size); });
+    slot.state = UPLOAD_SLOT_COPYING;
+    m_next = (m_next + 1) % TEXTURE_UPLOAD_RING_SLOTS;
+    return true;
+}
+
+size_t TextureUploadRing::update(void)
+{
+    m_issued_bytes = 0;
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        Slot& slot = m_slots[i];
+        if (slot.state == UPLOAD_SLOT_IN_FLIGHT)
+        {
+            isFenceSignalled(slot);
+            continue;
+        }
+        if (slot.state != UPLOAD_SLOT_COPYING || slot.copy.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+
+        slot.copy.get();
+        unmapSlot(slot);
+
+        // the texture may have been destroyed, or may not need the level anymore
+        if (slot.texture == nullptr || slot.texture->get_base_level() != slot.level + 1)
+        {
+            slot.texture = nullptr;
+            slot.state = UPLOAD_SLOT_FREE;
+            continue;
+        }
+
+        // the upload reads from the buffer when the GPU gets to it. The fence tells when the buffer can be written again
+        m_issued_bytes += slot.texture->StreamInLevel(slot.buffer);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.texture = nullptr;
+        slot.state = UPLOAD_SLOT_IN_FLIGHT;
+    }
+
+    m_total_bytes += m_issued_bytes;
+    return m_issued_bytes;
+}
+
+void TextureUploadRing::cancel(const Texture* texture)
+{
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        Slot& slot = m_slots[i];
+        if (slot.texture != texture)
+            continue;
+        // the worker reads the data of the texture
+        if (slot.copy.valid())
+            slot.copy.wait();
+        slot.texture = nullptr;
+    }
+}
+
+bool TextureUploadRing::isQueued(const Texture* texture) const
+{
+    for (unsigned int i = 0; i < TEXTURE_UPLOAD_RING_SLOTS; ++i)
+    {
+        if (m_slots[i].state == UPLOAD_SLOT_COPYING && m_slots[i].texture == texture)
+            return true;
+    }
+    return false;
+}
+
+// eof ///////////////////////////////// class TextureUploadRing
\ No newline at end of file
@@ -0,0 +1,125 @@
+//----------------------------------------------------//
+//                                                    //
+// File: TextureUploadRing.h                          //
+// TextureUploadRing copies texture levels into a     //
+// ring of pixel buffer objects on a worker thread    //
+// and uploads them from there, so that the OpenGL    //
+// thread does not wait for the copy of the driver    //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef TEXTUREUPLOADRING_H
+#define TEXTUREUPLOADRING_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include "../ThreadPool.h"  // - Header file for the ThreadPool class
+
+// defines /////////////////////////////////////////
+#define TEXTURE_UPLOAD_RING             1                   // upload the streamed levels through the ring (0 uploads them from client memory)
+#define TEXTURE_UPLOAD_RING_SLOTS       4                   // levels that can be copied or in flight at a time
+#define TEXTURE_UPLOAD_RING_SLOT_SIZE   (4 * 1024 * 1024)   // bytes of each pixel buffer object (larger levels are uploaded from client memory)
+
+// forward declarations ////////////////////////////
+class Texture;
+
+// class declarations //////////////////////////////
+
+enum UploadSlotState
+{
+    UPLOAD_SLOT_FREE,
+    UPLOAD_SLOT_COPYING,        // a worker copies the level into the buffer
+    UPLOAD_SLOT_IN_FLIGHT       // the upload has been issued and the fence has not been signalled yet
+};
+
+// each slot is a pixel buffer object of TEXTURE_UPLOAD_RING_SLOT_SIZE bytes. With ARB_buffer_storage the buffers are mapped
+// once (persistent and coherent) for the lifetime of the ring, otherwise each one is mapped when a copy starts and unmapped
+// before its upload. A slot is reused once the fence placed after its upload has been signalled, so the buffer is never
+// written while the GPU reads it.
+// All the functions must be called on the OpenGL thread
+class TextureUploadRing
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    struct Slot
+    {
+        GLuint                          buffer;
+        unsigned char*                  mapped;             // the buffer, while it is mapped
+        GLsync                          fence;              // valid while in flight
+        std::future<void>               copy;               // valid while copying
+        Texture*                        texture;            // nullptr if the texture was destroyed while copying
+        unsigned int                    level;
+        size_t                          size;
+        UploadSlotState                 state;
+    };
+
+    // private variable declarations
+    ThreadPool&                         m_pool;
+    Slot                                m_slots[TEXTURE_UPLOAD_RING_SLOTS];
+    unsigned int                        m_next;             // the next slot to fill, in ring order
+    bool                                m_created;
+    bool                                m_failed;           // the buffers could not be created, levels are not queued
+    bool                                m_persistent;
+    size_t                              m_issued_bytes;     // in the last update
+    unsigned long long                  m_total_bytes;
+    unsigned int                        m_full;             // times a level was not queued because the next slot was in use
+
+    // private function declarations
+    bool                                isFenceSignalled(Slot& slot);
+    bool                                mapSlot(Slot& slot);
+    void                                unmapSlot(Slot& slot);
+
+public:
+    // Constructor (the copies are made on the threads of pool)
+    TextureUploadRing(ThreadPool& pool);
+
+    // Destructor (waits for the running copies. The buffers are deleted with release)
+    ~TextureUploadRing(void);
+
+    // public function declarations
+
+    // creates the buffers (while the OpenGL context is current). Otherwise they are created by the first queueLevel,
+    // which may take a while if the driver commits their memory at once
+    bool                                init(void);
+
+    // deletes the buffers (while the OpenGL context is current)
+    void                                release(void);
+
+    // starts copying the level finer than the base level of a streamed texture into the next slot. The texture is updated
+    // by a later update, once the copy is done. Returns false if the level does not fit in a slot, the next slot is in use,
+    // or the buffers could not be created (the level should be uploaded from client memory, or tried again next frame)
+    bool                                queueLevel(Texture* texture);
+
+    // uploads the levels whose copy is done and recycles the slots whose upload the GPU has finished.
+    // Returns the bytes uploaded. A level whose texture has since released the next coarser level is dropped
+    size_t                              update(void);
+
+    // the texture is about to be destroyed. Waits for its copies, and drops its pending uploads
+    void                                cancel(const Texture* texture);
+
+    // get functions
+    bool                                isQueued(const Texture* texture) const;
+    bool                                isAvailable(void) const                         {return !m_failed;}
+    bool                                isPersistent(void) const                        {return m_persistent;}
+    size_t                              getIssuedBytes(void) const                      {return m_issued_bytes;}
+    unsigned long long                  getTotalBytes(void) const                       {return m_total_bytes;}
+    unsigned int                        getNumFull(void) const                          {return m_full;}
+
+    // set functions
+
+};
+
+#endif //TEXTUREUPLOADRING_H
+
+// eof ///////////////////////////////// class TextureUploadRing
\ No newline at end of file
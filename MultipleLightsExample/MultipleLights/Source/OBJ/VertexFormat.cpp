@@ -0,0 +1,290 @@
+//----------------------------------------------------//
+//                                                    //
+// File: VertexFormat.cpp                             //
+// Descriptors of the layouts of the vertex buffers,  //
+// and the encoding of the built vertices into them   //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "../HelpLib.h"     // - Library for including GL libraries, checking for OpenGL errors, writing to Output window, etc.
+#include "OGLMesh.h"        // - Header file for the OGLMesh class
+#include "VertexFormat.h"   // - Header file for the vertex formats
+
+#include <cfloat>           // - Header file for FLT_MAX
+
+// half float with round to nearest even. Values out of its range become infinite or zero
+static GLushort floatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned int sign = (bits >> 16) & 0x8000u;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    unsigned int mantissa = bits & 0x7FFFFFu;
+    if (exponent >= 31)
+        return (GLushort)(sign | 0x7C00u);
+    if (exponent < -10)
+        return (GLushort)sign;
+
+    // a subnormal half keeps the implicit one among the bits of its mantissa. A rounding that carries over
+    // the mantissa goes to the next exponent, which is the next half value too
+    unsigned int shift = 13;
+    unsigned int half = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+    if (exponent <= 0)
+    {
+        mantissa |= 0x800000u;
+        shift = (unsigned int)(14 - exponent);
+        half = sign | (mantissa >> shift);
+    }
+    unsigned int rest = mantissa & ((1u << shift) - 1), middle = 1u << (shift - 1);
+    if (rest > middle || (rest == middle && (half & 1)))
+        half++;
+    return (GLushort)half;
+}
+
+static float halfToFloat(GLushort half)
+{
+    unsigned int exponent = (half >> 10) & 0x1F, mantissa = half & 0x3FFu;
+    float value = (exponent == 0) ? ldexpf((float)mantissa, -24) :
+                  (exponent == 31) ? FLT_MAX : ldexpf((float)(mantissa | 0x400u), (int)exponent - 25);
+    return (half & 0x8000u) ? -value : value;
+}
+
+static GLshort floatToSnorm16(float value)
+{
+    return (GLshort)floor(glm::clamp(value, -1.0f, 1.0f) * 32767.0f + 0.5f);
+}
+
+static GLushort floatToUnorm16(float value)
+{
+    return (GLushort)floor(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+// the unit vector projected on the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one
+static glm::vec2 encodeOctahedral(const glm::vec3& v)
+{
+    float sum = fabs(v.x) + fabs(v.y) + fabs(v.z);
+    if (sum <= 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec2 p = glm::vec2(v.x, v.y) / sum;
+    if (v.z < 0.0f)
+        p = glm::vec2((1.0f - fabs(p.y)) * ((p.x >= 0.0f) ? 1.0f : -1.0f), (1.0f - fabs(p.x)) * ((p.y >= 0.0f) ? 1.0f : -1.0f));
+    return p;
+}
+
+// the same as decodeOctahedral in SpotLight.vert
+static glm::vec3 decodeOctahedral(const glm::vec2& p)
+{
+    glm::vec3 v(p.x, p.y, 1.0f - fabs(p.x) - fabs(p.y));
+    if (v.z < 0.0f)
+        v = glm::vec3((1.0f - fabs(p.y)) * ((p.x >= 0.0f) ? 1.0f : -1.0f), (1.0f - fabs(p.x)) * ((p.y >= 0.0f) ? 1.0f : -1.0f), v.z);
+    return glm::normalize(v);
+}
+
+VertexFormat getVertexFormat(unsigned int flags)
+{
+    VertexFormat format;
+    memset(&format, 0, sizeof(format));
+    format.flags = flags;
+
+    bool compact = (flags & VERTEX_FORMAT_COMPACT) != 0;
+    GLenum texcoord_type = (flags & VERTEX_FORMAT_HALF_TEXCOORDS) ? GL_HALF_FLOAT : GL_FLOAT;
+    GLuint texcoord_size = (flags & VERTEX_FORMAT_HALF_TEXCOORDS) ? 2 * sizeof(GLushort) : 2 * sizeof(GLfloat);
+
+    GLuint offset = 0;
+    auto add = [&](VertexAttributeLocation location, GLint components, GLenum type, GLboolean normalized, GLuint size)
+    {
+        VertexAttribute& attribute = format.attributes[location];
+        attribute.components = components;
+        attribute.type = type;
+        attribute.normalized = normalized;
+        attribute.offset = offset;
+        offset += size;
+    };
+    if (compact)
+    {
+        add(VERTEX_ATTRIBUTE_POSITION, 4, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(GLushort));
+        add(VERTEX_ATTRIBUTE_NORMAL, 2, GL_SHORT, GL_TRUE, 2 * sizeof(GLshort));
+    }
+    else
+    {
+        add(VERTEX_ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat));
+        add(VERTEX_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat));
+    }
+    add(VERTEX_ATTRIBUTE_TEXCOORD0, 2, texcoord_type, GL_FALSE, texcoord_size);
+    if (flags & VERTEX_FORMAT_TEXCOORD1)
+        add(VERTEX_ATTRIBUTE_TEXCOORD1, 2, texcoord_type, GL_FALSE, texcoord_size);
+    if (compact)
+        add(VERTEX_ATTRIBUTE_TANGENT, 2, GL_SHORT, GL_TRUE, 2 * sizeof(GLshort));
+    else
+        add(VERTEX_ATTRIBUTE_TANGENT, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat));
+
+    format.stride = (flags == VERTEX_FORMAT_TEXCOORD1) ? (GLuint)sizeof(VertexData) : offset;
+    return format;
+}
+
+unsigned int chooseVertexFormat(const VertexData* vertices, GLint num_vertices, unsigned int allowed_flags)
+{
+    bool half_texcoords = true, texcoord1 = false;
+    for (GLint i = 0; i < num_vertices; ++i)
+    {
+        const VertexData& vertex = vertices[i];
+        for (int k = 0; k < 2; ++k)
+        {
+            half_texcoords = half_texcoords && fabs(vertex.texcoord0[k]) <= VERTEX_HALF_TEXCOORD_MAX && fabs(vertex.texcoord1[k]) <= VERTEX_HALF_TEXCOORD_MAX;
+            texcoord1 = texcoord1 || vertex.texcoord1[k] != 0.0f;
+        }
+    }
+
+    unsigned int flags = allowed_flags & VERTEX_FORMAT_COMPACT;
+    if (half_texcoords)
+        flags |= allowed_flags & VERTEX_FORMAT_HALF_TEXCOORDS;
+    // without any of the other flags the vertices are kept as they are built
+    if (texcoord1 || flags == 0)
+        flags |= VERTEX_FORMAT_TEXCOORD1;
+    return flags;
+}
+
+void getPositionBounds(const VertexData* vertices, GLint num_vertices, glm::vec3& position_offset, glm::vec3& position_scale)
+{
+    glm::vec3 min_position(FLT_MAX), max_position(-FLT_MAX);
+    for (GLint i = 0; i < num_vertices; ++i)
+    {
+        glm::vec3 position(vertices[i].position[0], vertices[i].position[1], vertices[i].position[2]);
+        min_position = glm::min(min_position, position);
+        max_position = glm::max(max_position, position);
+    }
+    if (num_vertices == 0)
+        min_position = max_position = glm::vec3(0.0f);
+
+    // a flat mesh has a scale of 0 along its normal
+    position_offset = min_position;
+    position_scale = max_position - min_position;
+}
+
+void encodeVertices(const VertexData* vertices, GLint num_vertices, const VertexFormat& format,
+                    const glm::vec3& position_offset, const glm::vec3& position_scale, GLubyte* data)
+{
+    if (format.flags == VERTEX_FORMAT_TEXCOORD1)
+    {
+        memcpy(data, vertices, num_vertices * sizeof(VertexData));
+        return;
+    }
+
+    glm::vec3 inv_scale;
+    for (int k = 0; k < 3; ++k)
+        inv_scale[k] = (position_scale[k] > 0.0f) ? 1.0f / position_scale[k] : 0.0f;
+
+    const VertexAttribute* attributes = format.attributes;
+    for (GLint i = 0; i < num_vertices; ++i)
+    {
+        const VertexData& vertex = vertices[i];
+        GLubyte* out = data + (size_t)i * format.stride;
+        if (format.flags & VERTEX_FORMAT_COMPACT)
+        {
+            GLushort* position = (GLushort*)(out + attributes[VERTEX_ATTRIBUTE_POSITION].offset);
+            for (int k = 0; k < 3; ++k)
+                position[k] = floatToUnorm16((vertex.position[k] - position_offset[k]) * inv_scale[k]);
+            position[3] = (vertex.tangent[3] < 0.0f) ? 0 : 0xFFFF;
+
+            glm::vec2 normal = encodeOctahedral(glm::vec3(vertex.normal[0], vertex.normal[1], vertex.normal[2]));
+            glm::vec2 tangent = encodeOctahedral(glm::vec3(vertex.tangent[0], vertex.tangent[1], vertex.tangent[2]));
+            GLshort* encoded_normal = (GLshort*)(out + attributes[VERTEX_ATTRIBUTE_NORMAL].offset);
+            GLshort* encoded_tangent = (GLshort*)(out + attributes[VERTEX_ATTRIBUTE_TANGENT].offset);
+            for (int k = 0; k < 2; ++k)
+            {
+                encoded_normal[k] = floatToSnorm16(normal[k]);
+                encoded_tangent[k] = floatToSnorm16(tangent[k]);
+            }
+        }
+        else
+        {
+            memcpy(out + attributes[VERTEX_ATTRIBUTE_POSITION].offset, vertex.position, sizeof(vertex.position));
+            memcpy(out + attributes[VERTEX_ATTRIBUTE_NORMAL].offset, vertex.normal, sizeof(vertex.normal));
+            memcpy(out + attributes[VERTEX_ATTRIBUTE_TANGENT].offset, vertex.tangent, sizeof(vertex.tangent));
+        }
+
+        for (int set = 0; set < 2; ++set)
+        {
+            const VertexAttribute& attribute = attributes[VERTEX_ATTRIBUTE_TEXCOORD0 + set];
+            const GLfloat* texcoord = (set == 0) ? vertex.texcoord0 : vertex.texcoord1;
+            if (attribute.components == 0)
+                continue;
+            if (attribute.type == GL_HALF_FLOAT)
+            {
+                GLushort* half_texcoord = (GLushort*)(out + attribute.offset);
+                half_texcoord[0] = floatToHalf(texcoord[0]);
+                half_texcoord[1] = floatToHalf(texcoord[1]);
+            }
+            else
+                memcpy(out + attribute.offset, texcoord, 2 * sizeof(GLfloat));
+        }
+    }
+}
+
+void decodeVertex(const GLubyte* data, const VertexFormat& format, const glm::vec3& position_offset, const glm::vec3& position_scale,
+                  VertexData& vertex)
+{
+    memset(&vertex, 0, sizeof(vertex));
+    const VertexAttribute* attributes = format.attributes;
+    if (format.flags & VERTEX_FORMAT_COMPACT)
+    {
+        const GLushort* position = (const GLushort*)(data + attributes[VERTEX_ATTRIBUTE_POSITION].offset);
+        for (int k = 0; k < 3; ++k)
+            vertex.position[k] = position_offset[k] + position_scale[k] * (position[k] / 65535.0f);
+
+        const GLshort* encoded_normal = (const GLshort*)(data + attributes[VERTEX_ATTRIBUTE_NORMAL].offset);
+        const GLshort* encoded_tangent = (const GLshort*)(data + attributes[VERTEX_ATTRIBUTE_TANGENT].offset);
+        glm::vec3 normal = decodeOctahedral(glm::max(glm::vec2(encoded_normal[0], encoded_normal[1]) / 32767.0f, glm::vec2(-1.0f)));
+        glm::vec3 tangent = decodeOctahedral(glm::max(glm::vec2(encoded_tangent[0], encoded_tangent[1]) / 32767.0f, glm::vec2(-1.0f)));
+        for (int k = 0; k < 3; ++k)
+        {
+            vertex.normal[k] = normal[k];
+            vertex.tangent[k] = tangent[k];
+        }
+        vertex.tangent[3] = (position[3] != 0) ? 1.0f : -1.0f;
+    }
+    else
+    {
+        memcpy(vertex.position, data + attributes[VERTEX_ATTRIBUTE_POSITION].offset, sizeof(vertex.position));
+        memcpy(vertex.normal, data + attributes[VERTEX_ATTRIBUTE_NORMAL].offset, sizeof(vertex.normal));
+        memcpy(vertex.tangent, data + attributes[VERTEX_ATTRIBUTE_TANGENT].offset, sizeof(vertex.tangent));
+    }
+
+    for (int set = 0; set < 2; ++set)
+    {
+        const VertexAttribute& attribute = attributes[VERTEX_ATTRIBUTE_TEXCOORD0 + set];
+        GLfloat* texcoord = (set == 0) ? vertex.texcoord0 : vertex.texcoord1;
+        if (attribute.components == 0)
+            continue;
+        if (attribute.type == GL_HALF_FLOAT)
+        {
+            const GLushort* half_texcoord = (const GLushort*)(data + attribute.offset);
+            texcoord[0] = halfToFloat(half_texcoord[0]);
+            texcoord[1] = halfToFloat(half_texcoord[1]);
+        }
+        else
+            memcpy(texcoord, data + attribute.offset, 2 * sizeof(GLfloat));
+    }
+}
+
+void setVertexAttributes(const VertexFormat& format)
+{
+    for (GLuint location = 0; location < VERTEX_ATTRIBUTE_COUNT; ++location)
+    {
+        const VertexAttribute& attribute = format.attributes[location];
+        if (attribute.components == 0)
+        {
+            glDisableVertexAttribArray(location);
+            continue;
+        }
+        glVertexAttribPointer(location, attribute.components, attribute.type, attribute.normalized, format.stride, (GLvoid*)(size_t)attribute.offset);
+        glEnableVertexAttribArray(location);
+    }
+}
+
+// eof ///////////////////////////////// VertexFormat
\ No newline at end of file
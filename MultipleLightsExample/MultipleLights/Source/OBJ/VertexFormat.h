@@ -0,0 +1,97 @@
+//----------------------------------------------------//
+//                                                    //
+// File: VertexFormat.h                               //
+// Descriptors of the layouts of the vertex buffers,  //
+// and the encoding of the built vertices into them   //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+// HelpLib.h should be included first (for glm and the GL types)
+
+
+// defines /////////////////////////////////////////
+#define VERTEX_FORMAT_FLAGS         (VERTEX_FORMAT_COMPACT | VERTEX_FORMAT_HALF_TEXCOORDS)  // the encodings the meshes may use (0 keeps the float layout of VertexData)
+#define VERTEX_HALF_TEXCOORD_MAX    2.0f            // half float texture coordinates are used if all of them are within [-max, max] (off by at most 1/2048 there)
+
+// forward declarations ////////////////////////////
+struct VertexData;
+
+// class declarations //////////////////////////////
+
+enum VertexFormatFlags
+{
+    VERTEX_FORMAT_COMPACT           = 1,    // 16-bit positions within the bounds of the mesh, octahedral 16-bit normals and tangents
+    VERTEX_FORMAT_HALF_TEXCOORDS    = 2,    // half float texture coordinates
+    VERTEX_FORMAT_TEXCOORD1         = 4     // the second set of texture coordinates (dropped when they are all zero)
+};
+
+// the attribute locations of the shaders
+enum VertexAttributeLocation
+{
+    VERTEX_ATTRIBUTE_POSITION,
+    VERTEX_ATTRIBUTE_NORMAL,
+    VERTEX_ATTRIBUTE_TEXCOORD0,
+    VERTEX_ATTRIBUTE_TEXCOORD1,
+    VERTEX_ATTRIBUTE_TANGENT,
+    VERTEX_ATTRIBUTE_COUNT
+};
+
+struct VertexAttribute
+{
+    GLint                               components;         // 0 if the format does not have the attribute (the shaders read (0, 0, 0, 1) then)
+    GLenum                              type;
+    GLboolean                           normalized;
+    GLuint                              offset;
+};
+
+// the attributes follow each other in the order of VertexData, each one 4-byte aligned:
+//                  float                               compact
+// position         3 floats                            4 unsigned shorts: xyz within the bounds, w the handedness of the tangent (0 or 1)
+// normal           3 floats                            2 shorts: octahedral
+// texcoord0/1      2 floats, or 2 halfs
+// tangent          4 floats (w: handedness)            2 shorts: octahedral
+// so a vertex takes 20 bytes when it is compact with half texture coordinates, 24 with both sets, and 64 with none of the flags
+// (the float layout with both sets keeps the padding of VertexData, and is stored as it is built).
+// The positions of a compact vertex are in [0, 1] after they are fetched, and are moved to the bounds of the mesh by the
+// transformation of the mesh (see OGLMesh::getPositionMatrix). Only the normals have to be decoded by the shaders
+struct VertexFormat
+{
+    unsigned int                        flags;
+    GLuint                              stride;
+    VertexAttribute                     attributes[VERTEX_ATTRIBUTE_COUNT];
+};
+
+// the layout of a combination of the flags
+VertexFormat getVertexFormat(unsigned int flags);
+
+// the flags of the allowed ones that the vertices can be encoded with: half texture coordinates only if they are within
+// VERTEX_HALF_TEXCOORD_MAX, and the second set only if it is used
+unsigned int chooseVertexFormat(const VertexData* vertices, GLint num_vertices, unsigned int allowed_flags);
+
+// the bounds of the positions, as the offset and the scale that move [0, 1] to them
+void getPositionBounds(const VertexData* vertices, GLint num_vertices, glm::vec3& position_offset, glm::vec3& position_scale);
+
+// encodes the vertices to the format (num_vertices * format.stride bytes)
+void encodeVertices(const VertexData* vertices, GLint num_vertices, const VertexFormat& format,
+                    const glm::vec3& position_offset, const glm::vec3& position_scale, GLubyte* data);
+
+// decodes a vertex of the format (the normals and the tangents are normalized again)
+void decodeVertex(const GLubyte* data, const VertexFormat& format, const glm::vec3& position_offset, const glm::vec3& position_scale,
+                  VertexData& vertex);
+
+// sets and enables the attributes of the format in the bound VAO, for the bound vertex buffer, and disables the ones it does not have
+void setVertexAttributes(const VertexFormat& format);
+
+#endif //VERTEXFORMAT_H
+
+// eof ///////////////////////////////// VertexFormat
\ No newline at end of file
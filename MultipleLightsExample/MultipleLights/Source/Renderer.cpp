@@ -17,6 +17,12 @@
 
 #include "OBJ/OBJLoader.h"  // - Header file for the OBJ Loader
 #include "OBJ/OGLMesh.h"    // - Header file for the OGL mesh
+#include "OBJ/MeshStreamer.h" // - Header file for the background mesh loader
+#include "OBJ/TextureStreamer.h" // - Header file for the streamed texture levels
+#include "OBJ/TextureArray.h" // - Header file for the texture arrays
+#include "OBJ/SamplerRegistry.h" // - Header file for the samplers of the materials
+#include "OBJ/ResidencyManager.h" // - Header file for the GPU memory budget
+#include "FrameStats.h"     // - Header file for the frame times
 #include "ShaderGLSL.h"     // - Header file for GLSL objects
 #include "Light.h"          // - Header file for Lights
 #include "Shaders.h"        // - Header file for all the shaders
@@ -48,15 +54,22 @@ glm::vec3 world_translate;
 // Rendering mode
 int rendering_mode = GL_FILL;
 
+// viewport height in pixels (set in Resize)
+int viewport_height = 1;
+
 // OBJ models
 OGLMesh* groundwhiteMesh;
 OGLMesh* lightSourceMesh;
-OGLMesh* sphereMapMesh;
-OGLMesh* sphereEarthMesh;
-OGLMesh* treasureMesh;
-OGLMesh* skeletonMesh;
-OGLMesh* skeletonGroundMesh;
 OGLMesh* knossosMesh;
+// streamed OBJ models (the light source mesh is drawn in their place until they are loaded)
+MeshStreamer* mesh_streamer;
+MeshRequest* sphereMapMesh;
+MeshRequest* sphereEarthMesh;
+MeshRequest* treasureMesh;
+MeshRequest* skeletonMesh;
+MeshRequest* skeletonGroundMesh;
+// the frame times while uploading (set TEXTURE_UPLOAD_RING to 0 in TextureUploadRing.h to compare with uploads from client memory)
+FrameStats frame_stats;
 
 // Scene graph nodes
 Root* root;
@@ -216,8 +229,8 @@ void SceneGraphExampleInit()
     sphere1_transform = new TransformNode("sphere1_transform");
     sphere2_transform = new TransformNode("sphere2_transform");
     ground_geom = new GeometryNode("ground_geom", groundwhiteMesh);
-    sphere1_geom = new GeometryNode("sphere1_geom", sphereEarthMesh);
-    sphere2_geom = new GeometryNode("sphere2_geom", sphereMapMesh);
+    sphere1_geom = new GeometryNode("sphere1_geom", sphereEarthMesh, lightSourceMesh);
+    sphere2_geom = new GeometryNode("sphere2_geom", sphereMapMesh, lightSourceMesh);
 
     // construct the render tree
     root->AddChild(world_transform);
@@ -278,9 +291,9 @@ void SceneGraphExample2Init()
     ground_transform = new TransformNode("ground_transform");
     skeleton_transform = new TransformNode("skeleton_transform");
     treasure_transform = new TransformNode("treasure_transform");
-    ground_geom = new GeometryNode("ground_geom", skeletonGroundMesh);
-    skeleton_geom = new GeometryNode("skeleton_geom", skeletonMesh);
-    treasure_geom = new GeometryNode("treasure_geom", treasureMesh);
+    ground_geom = new GeometryNode("ground_geom", skeletonGroundMesh, lightSourceMesh);
+    skeleton_geom = new GeometryNode("skeleton_geom", skeletonMesh, lightSourceMesh);
+    treasure_geom = new GeometryNode("treasure_geom", treasureMesh, lightSourceMesh);
 
     // construct the render tree
     root->AddChild(world_transform);
@@ -317,18 +330,33 @@ bool LoadObjModels()
 {
     OBJLoader* objLoader = new OBJLoader();
 
-    // for all scenes
-    lightSourceMesh = objLoader->loadMesh("light_source.obj", "..\\..\\Data\\Other", true);
-    groundwhiteMesh = objLoader->loadMesh("plane_white.obj", "..\\..\\Data\\Other", true);
+    // the scene meshes are loaded in the background while the scene is drawn.
+    // they are requested first, so that they load at the same time as the meshes below
+    mesh_streamer = new MeshStreamer();
+    // the buffers the streamed texture levels are uploaded through, created now rather than while the scene is drawn
+    TextureStreamer::getInstance().init();
 
     // for scene 1
-    sphereMapMesh = objLoader->loadMesh("sphere_map.obj", "..\\..\\Data\\Other", true);
-    sphereEarthMesh = objLoader->loadMesh("sphere_earth.obj", "..\\..\\Data\\Other", true);
+    sphereMapMesh = mesh_streamer->requestMesh("sphere_map.obj", "..\\..\\Data\\Other", true);
+    sphereEarthMesh = mesh_streamer->requestMesh("sphere_earth.obj", "..\\..\\Data\\Other", true);
 
     // for scene 2
-    skeletonGroundMesh = objLoader->loadMesh("terrain.obj", "..\\..\\Data\\Other", true);
-    treasureMesh = objLoader->loadMesh("treasure.obj", "..\\..\\Data\\Pirates", true);
-    skeletonMesh = objLoader->loadMesh("skeleton.obj", "..\\..\\Data\\Pirates", true);
+    skeletonGroundMesh = mesh_streamer->requestMesh("terrain.obj", "..\\..\\Data\\Other", true);
+    treasureMesh = mesh_streamer->requestMesh("treasure.obj", "..\\..\\Data\\Pirates", true);
+    skeletonMesh = mesh_streamer->requestMesh("skeleton.obj", "..\\..\\Data\\Pirates", true);
+
+    // for all scenes (needed before the first frame). These are parsed and their textures are decoded in parallel,
+    // only the OpenGL uploads happen one after another
+    std::vector<std::string> filenames, paths;
+    std::vector<OGLMesh*> meshes;
+    filenames.push_back("light_source.obj");    paths.push_back("..\\..\\Data\\Other");
+    filenames.push_back("plane_white.obj");     paths.push_back("..\\..\\Data\\Other");
+    objLoader->loadMeshes(filenames, paths, true, meshes);
+    lightSourceMesh = meshes[0];
+    groundwhiteMesh = meshes[1];
+
+    if (lightSourceMesh == nullptr)
+        return false;
 
     return true;
 }
@@ -378,6 +406,8 @@ bool CreateShaders()
     // these are for the samplers
     ambient_light_shader->uniform_sampler_diffuse = glGetUniformLocation(ambient_light_shader->program_id, "uniform_sampler_diffuse");
     ambient_light_shader->uniform_has_sampler_diffuse = glGetUniformLocation(ambient_light_shader->program_id, "uniform_has_sampler_diffuse");
+    ambient_light_shader->uniform_sampler_diffuse_array = glGetUniformLocation(ambient_light_shader->program_id, "uniform_sampler_diffuse_array");
+    ambient_light_shader->uniform_layer_diffuse = glGetUniformLocation(ambient_light_shader->program_id, "uniform_layer_diffuse");
 
     // Spotlight light shader
     // This is used for rendering geometry using a spotlight shader
@@ -397,6 +427,7 @@ bool CreateShaders()
     spotlight_shader->uniform_light_color = glGetUniformLocation(spotlight_shader->program_id, "uniform_light_color");
     spotlight_shader->uniform_light_position_ecs = glGetUniformLocation(spotlight_shader->program_id, "uniform_light_position_ecs");
     spotlight_shader->uniform_light_direction_ecs = glGetUniformLocation(spotlight_shader->program_id, "uniform_light_direction_ecs");
+    spotlight_shader->uniform_compact_vertices = glGetUniformLocation(spotlight_shader->program_id, "uniform_compact_vertices");
 
     // these are for the samplers
     spotlight_shader->uniform_sampler_diffuse = glGetUniformLocation(spotlight_shader->program_id, "uniform_sampler_diffuse");
@@ -407,6 +438,14 @@ bool CreateShaders()
     spotlight_shader->uniform_has_sampler_normal = glGetUniformLocation(spotlight_shader->program_id, "uniform_has_sampler_normal");
     spotlight_shader->uniform_has_sampler_specular = glGetUniformLocation(spotlight_shader->program_id, "uniform_has_sampler_specular");
     spotlight_shader->uniform_has_sampler_emission = glGetUniformLocation(spotlight_shader->program_id, "uniform_has_sampler_emission");
+    spotlight_shader->uniform_sampler_diffuse_array = glGetUniformLocation(spotlight_shader->program_id, "uniform_sampler_diffuse_array");
+    spotlight_shader->uniform_sampler_normal_array = glGetUniformLocation(spotlight_shader->program_id, "uniform_sampler_normal_array");
+    spotlight_shader->uniform_sampler_specular_array = glGetUniformLocation(spotlight_shader->program_id, "uniform_sampler_specular_array");
+    spotlight_shader->uniform_sampler_emission_array = glGetUniformLocation(spotlight_shader->program_id, "uniform_sampler_emission_array");
+    spotlight_shader->uniform_layer_diffuse = glGetUniformLocation(spotlight_shader->program_id, "uniform_layer_diffuse");
+    spotlight_shader->uniform_layer_normal = glGetUniformLocation(spotlight_shader->program_id, "uniform_layer_normal");
+    spotlight_shader->uniform_layer_specular = glGetUniformLocation(spotlight_shader->program_id, "uniform_layer_specular");
+    spotlight_shader->uniform_layer_emission = glGetUniformLocation(spotlight_shader->program_id, "uniform_layer_emission");
 
     // all shaders loaded OK
     return true;
@@ -415,6 +454,11 @@ bool CreateShaders()
 // Render function. Every time our window has to be drawn, this is called.
 void Render(void)
 {
+    frame_stats.beginFrame();
+
+    // upload the meshes loaded in the background and the texture levels requested in the last frame (within the per-frame budget)
+    mesh_streamer->update();
+
     // Set the rendering mode
     glPolygonMode(GL_FRONT_AND_BACK, rendering_mode);
 
@@ -438,6 +482,9 @@ void Render(void)
 
     SceneGraphDraw();
 
+    // the time spent on the frame, not counting the wait for the swap
+    frame_stats.endFrame(mesh_streamer->getUploadedBytes() + TextureStreamer::getInstance().getUploadRing().getIssuedBytes());
+
     // Remember that we are using double-buffering, all the drawing we just did
     // took place in the "hidden" back-buffer. Calling glutSwapBuffers makes the
     // back buffer "visible".
@@ -449,7 +496,11 @@ void Render(void)
 // Release all memory allocated by pointers using new
 void ReleaseGLUT()
 {
-
+    // wait for any meshes that are still loading
+    SAFE_DELETE(mesh_streamer);
+    TextureStreamer::getInstance().release();
+    TextureArrays::getInstance().release();
+    SamplerRegistry::getInstance().release();
 }
 
 void DrawSpotLightSource(SpotLight* _spotlight)
@@ -476,11 +527,15 @@ void SceneGraphDraw()
     // USE SCENE GRAPH
     root->SetViewMat(world_to_camera_matrix);
     root->SetProjectionMat(perspective_projection_matrix);
+    root->SetViewportHeight(viewport_height);
 
     // world transformations
     world_transform->SetTranslation(world_translate.x, world_translate.y, world_translate.z);
     world_transform->SetRotation(world_rotate_x, 0.0f, 1.0f, 0.0f);
 
+    // the geometry nodes request the texture levels they need for this view (uploaded by the next mesh_streamer->update)
+    root->Update();
+
     // the logic is behind rendering the scene using different lights is:
     // render the scene once for each light source and add them together using blending
     // where the glBlendFunc is set to additive. This is because lights are additive in nature.
@@ -560,6 +615,28 @@ void Keyboard(unsigned char key, int x, int y)
     case 'F':
         eye.y -= 1.0f;
         break;
+    case 'q':
+    case 'Q':
+        // the next texture filtering tier (bilinear, trilinear, anisotropic) for all the textures
+        {
+            SamplerRegistry& samplers = SamplerRegistry::getInstance();
+            samplers.setQuality((SamplerQuality)((samplers.getQuality() + 1) % SAMPLER_QUALITY_COUNT));
+        }
+        break;
+    case 'm':
+    case 'M':
+        // the GPU memory of the meshes and textures, and the evictions that kept it within the budget
+        ResidencyManager::getInstance().print();
+        break;
+    case 'l':
+    case 'L':
+        // draw the meshes themselves, or the levels of detail whose error on the screen is within ROOT_LOD_ERROR_PIXELS
+        if (root != nullptr)
+        {
+            root->SetLODErrorPixels((root->GetLODErrorPixels() > 0.0f) ? 0.0f : ROOT_LOD_ERROR_PIXELS);
+            PrintToOutputWindow("Levels of detail: %s", (root->GetLODErrorPixels() > 0.0f) ? "on" : "off");
+        }
+        break;
     case 27: // escape
         glutLeaveMainLoop();
         return;
@@ -668,6 +745,7 @@ void Resize(int width, int height)
     // Typically, this is the size of the window
     // This information will be used for the viewport transformation
     glViewport(0, 0, width, height);
+    viewport_height = height;
     // -------------------------------------------------------------------------------------------------//
 
 
@@ -695,6 +773,10 @@ void Resize(int width, int height)
 // This is used to draw the light sources using an emissive color parameter
 void DrawLightSource(OGLMesh* mesh, glm::mat4x4& object_to_world_transform, glm::vec3& light_emissive_color)
 {
+    // an evicted mesh is skipped until its buffers are restored
+    if (!ResidencyManager::getInstance().useMesh(mesh))
+        return;
+
     // bind the VAO
     glBindVertexArray(mesh->vao);
 
@@ -711,7 +793,9 @@ void DrawLightSource(OGLMesh* mesh, glm::mat4x4& object_to_world_transform, glm:
     glUseProgram(basic_geometry_shader->program_id);
 
     // pass any global shader parameters (independent of material attributes)
-    glUniformMatrix4fv(basic_geometry_shader->uniform_m, 1, false, &M[0][0]);
+    // (the positions of compact vertices are moved to the bounds of the mesh first)
+    glm::mat4x4 MP = M * mesh->getPositionMatrix();
+    glUniformMatrix4fv(basic_geometry_shader->uniform_m, 1, false, &MP[0][0]);
     glUniformMatrix4fv(basic_geometry_shader->uniform_v, 1, false, &V[0][0]);
     glUniformMatrix4fv(basic_geometry_shader->uniform_p, 1, false, &P[0][0]);
 
@@ -732,14 +816,7 @@ void DrawLightSource(OGLMesh* mesh, glm::mat4x4& object_to_world_transform, glm:
         glUniform4f(basic_geometry_shader->uniform_material_color, cur_material.m_diffuse[0], cur_material.m_diffuse[1], cur_material.m_diffuse[2], cur_material.m_opacity);
 
         // draw within a range in the index buffer
-        glDrawRangeElements(
-            GL_TRIANGLES,
-            mesh->elements[i].start_index,
-            mesh->elements[i].start_index+mesh->elements[i].triangles*3,
-            mesh->elements[i].triangles*3,
-            GL_UNSIGNED_INT,
-            (void*)(mesh->elements[i].start_index*sizeof(GLuint))
-            );
+        mesh->drawElement(i);
     }
 
     glBindVertexArray(0);
@@ -20,8 +20,12 @@
 #include "GeometryNode.h"       // - Header file for the GeometryNode class
 #include "Root.h"               // - Header file for the Root class
 #include "../OBJ/OGLMesh.h"     // - Header file for the OGLMesh class
+#include "../OBJ/MeshStreamer.h" // - Header file for the MeshStreamer class
 #include "../OBJ/OBJMaterial.h" // - Header file for the OBJMaterial class
 #include "../OBJ/Texture.h"     // - Header file for the Texture class
+#include "../OBJ/TextureStreamer.h" // - Header file for the TextureStreamer class
+#include "../OBJ/TextureArray.h" // - Header file for the TextureArray class
+#include "../OBJ/ResidencyManager.h" // - Header file for the ResidencyManager class
 #include "../ShaderGLSL.h"      // - Header file for GLSL objects
 
 // defines /////////////////////////////////////////
@@ -30,6 +34,18 @@ GeometryNode::GeometryNode(const char* name, OGLMesh* ogl_mesh):
 Node(name)
 {
     m_ogl_mesh = ogl_mesh;
+    m_mesh_request = nullptr;
+    m_placeholder_mesh = nullptr;
+    m_lod = 0;
+}
+
+GeometryNode::GeometryNode(const char* name, MeshRequest* mesh_request, OGLMesh* placeholder_mesh):
+Node(name)
+{
+    m_ogl_mesh = nullptr;
+    m_mesh_request = mesh_request;
+    m_placeholder_mesh = placeholder_mesh;
+    m_lod = 0;
 }
 
 GeometryNode::~GeometryNode()
@@ -40,22 +56,122 @@ GeometryNode::~GeometryNode()
 void GeometryNode::Update()
 {
     Node::Update();
+
+    if (m_ogl_mesh != nullptr)
+        RequestTextureLevels(m_ogl_mesh);
+
+    // the placeholder is drawn with its own levels of detail until the streamed mesh is ready
+    OGLMesh* mesh = (m_ogl_mesh != nullptr) ? m_ogl_mesh : (m_mesh_request != nullptr) ? m_placeholder_mesh : nullptr;
+    if (mesh != nullptr)
+        SelectLevelOfDetail(mesh);
+}
+
+bool GeometryNode::GetScreenScale(glm::mat4x4& MV, float& scale, float& pixels_per_unit, float& near_distance)
+{
+    MV = m_root->GetViewMat() * GetTransform();
+    glm::mat4x4& P = m_root->GetProjectionMat();
+
+    // the largest scale of the object to eye transformation
+    scale = glm::max(glm::length(glm::vec3(MV[0])), glm::max(glm::length(glm::vec3(MV[1])), glm::length(glm::vec3(MV[2]))));
+    // pixels covered by one unit at distance one from the eye, and the near plane distance
+    pixels_per_unit = P[1][1] * 0.5f * m_root->GetViewportHeight();
+    near_distance = P[3][2] / (P[2][2] - 1.0f);
+    return scale > 0.0f && pixels_per_unit > 0.0f;
+}
+
+void GeometryNode::SelectLevelOfDetail(OGLMesh* mesh)
+{
+    glm::mat4x4 MV;
+    float scale, pixels_per_unit, near_distance;
+    float max_error = m_root->GetLODErrorPixels();
+    if (mesh->num_lods <= 1 || max_error <= 0.0f || !GetScreenScale(MV, scale, pixels_per_unit, near_distance))
+    {
+        m_lod = 0;
+        return;
+    }
+
+    // the nearest point of the bounding sphere of the mesh gives the largest error on the screen. A mesh behind the eye keeps its level
+    glm::vec4 center_ecs = MV * glm::vec4(mesh->bounds.center, 1.0f);
+    float radius = mesh->bounds.radius * scale;
+    if (-center_ecs.z + radius <= 0.0f)
+        return;
+    float distance = glm::max(-center_ecs.z - radius, near_distance);
+    float pixels_per_error = scale * pixels_per_unit / distance;
+
+    // a finer level is selected as soon as the error of the current one is too large, but a coarser one only when its error is
+    // well within the one allowed, so that a mesh near the distance where two levels switch does not alternate between them
+    GLint lod = glm::min(m_lod, mesh->num_lods - 1);
+    while (lod > 0 && mesh->lod_errors[lod] * pixels_per_error > max_error)
+        lod--;
+    while (lod + 1 < mesh->num_lods && mesh->lod_errors[lod + 1] * pixels_per_error <= max_error * (1.0f - GEOMETRY_LOD_HYSTERESIS))
+        lod++;
+    m_lod = lod;
+}
+
+void GeometryNode::RequestTextureLevels(OGLMesh* mesh)
+{
+    glm::mat4x4 MV;
+    float scale, pixels_per_unit, near_distance;
+    if (!GetScreenScale(MV, scale, pixels_per_unit, near_distance))
+        return;
+
+    TextureStreamer& streamer = TextureStreamer::getInstance();
+    for (GLint i = 0; i < mesh->num_elements && i < (GLint)mesh->footprints.size(); i++)
+    {
+        if (mesh->elements[i].triangles == 0)
+            continue;
+
+        // the nearest point of the bounding sphere gives the largest size on the screen. Elements behind the eye are skipped
+        const ElementFootprint& footprint = mesh->footprints[i];
+        glm::vec4 center_ecs = MV * glm::vec4(footprint.center, 1.0f);
+        float radius = footprint.radius * scale;
+        if (-center_ecs.z + radius <= 0.0f)
+            continue;
+        float distance = glm::max(-center_ecs.z - radius, near_distance);
+        float uv_per_pixel = footprint.uv_density * distance / (scale * pixels_per_unit);
+
+        OBJMaterial& cur_material = *mesh->materials[mesh->elements[i].material_index];
+        if (cur_material.m_diffuse_opacity_tex != nullptr)
+            streamer.requestLevel(cur_material.m_diffuse_opacity_tex, uv_per_pixel);
+        if (cur_material.m_normal_tex != nullptr)
+            streamer.requestLevel(cur_material.m_normal_tex, uv_per_pixel);
+        if (cur_material.m_specular_gloss_tex != nullptr)
+            streamer.requestLevel(cur_material.m_specular_gloss_tex, uv_per_pixel);
+        if (cur_material.m_emission_tex != nullptr)
+            streamer.requestLevel(cur_material.m_emission_tex, uv_per_pixel);
+    }
 }
 
 void GeometryNode::Draw(int shader_type)
 {
-    if (m_ogl_mesh == nullptr)
+    // switch to the streamed mesh as soon as it is ready
+    if (m_ogl_mesh == nullptr && m_mesh_request != nullptr)
+    {
+        m_ogl_mesh = m_mesh_request->getMesh();
+        if (m_ogl_mesh != nullptr || m_mesh_request->getState() == MESH_REQUEST_FAILED)
+            m_mesh_request = nullptr;
+    }
+
+    OGLMesh* mesh = (m_ogl_mesh != nullptr) ? m_ogl_mesh : (m_mesh_request != nullptr) ? m_placeholder_mesh : nullptr;
+    if (mesh == nullptr)
+        return;
+
+    // an evicted mesh is skipped until its buffers are restored
+    if (!ResidencyManager::getInstance().useMesh(mesh))
         return;
 
+    // the level of detail selected for the view, made coarser for the passes that allow it (the mesh may have changed since)
+    int lod = glm::clamp(m_lod + m_root->GetLODBias(shader_type), 0, mesh->num_lods - 1);
+
     // SHADER TYPE 0 - use spotlight shader
     // SHADER TYPE 1 - use ambient light shader
     if (shader_type == 0)
     {
-        DrawUsingSpotLight();
+        DrawUsingSpotLight(mesh, lod);
     }
     else if (shader_type == 1)
     {
-        DrawUsingAmbientight();
+        DrawUsingAmbientight(mesh, lod);
     }
 }
 
@@ -64,7 +180,7 @@ void GeometryNode::Init()
     Node::Init();
 }
 
-void GeometryNode::DrawUsingSpotLight()
+void GeometryNode::DrawUsingSpotLight(OGLMesh* mesh, int lod)
 {
     // get the world transformation (hierarchically)
     glm::mat4x4& M = GetTransform();
@@ -85,9 +201,12 @@ void GeometryNode::DrawUsingSpotLight()
     glUseProgram(shader->program_id);
 
     // pass any global shader parameters (independent of material attributes)
-    glUniformMatrix4fv(shader->uniform_m, 1, false, &M[0][0]);
+    // (the positions of compact vertices are moved to the bounds of the mesh first, and their normals are decoded by the shader)
+    glm::mat4x4 MP = M * mesh->getPositionMatrix();
+    glUniformMatrix4fv(shader->uniform_m, 1, false, &MP[0][0]);
     glUniformMatrix4fv(shader->uniform_v, 1, false, &V[0][0]);
     glUniformMatrix4fv(shader->uniform_p, 1, false, &P[0][0]);
+    glUniform1i(shader->uniform_compact_vertices, (mesh->vertex_format.flags & VERTEX_FORMAT_COMPACT) ? 1 : 0);
 
     // LIGHT CALCULATIONS
     // we need
@@ -110,18 +229,35 @@ void GeometryNode::DrawUsingSpotLight()
     // the light color is passed as a uniform vec3
     glUniform3f(shader->uniform_light_color, light->m_color.x, light->m_color.y, light->m_color.z);
 
+    // send the samplers as uniforms
+    // sampler 0 is the diffuse texture, 1 is the normal texture, etc (same as below)
+    // the textures packed in texture arrays are sampled from the arrays bound to units 4 to 7 instead
+    glUniform1i(shader->uniform_sampler_diffuse, 0);
+    glUniform1i(shader->uniform_sampler_normal, 1);
+    glUniform1i(shader->uniform_sampler_specular, 2);
+    glUniform1i(shader->uniform_sampler_emission, 3);
+    glUniform1i(shader->uniform_sampler_diffuse_array, TEXTURE_ARRAY_UNIT_OFFSET + 0);
+    glUniform1i(shader->uniform_sampler_normal_array, TEXTURE_ARRAY_UNIT_OFFSET + 1);
+    glUniform1i(shader->uniform_sampler_specular_array, TEXTURE_ARRAY_UNIT_OFFSET + 2);
+    glUniform1i(shader->uniform_sampler_emission_array, TEXTURE_ARRAY_UNIT_OFFSET + 3);
+
+    // the arrays and the samplers bound to the units of the maps, which stay bound for the elements that follow
+    unsigned int bound_arrays[MPT_MATERIAL_MAP_COUNT] = { 0, 0, 0, 0 };
+    unsigned int bound_samplers[MPT_MATERIAL_MAP_COUNT] = { 0, 0, 0, 0 };
+
     // bind the VAO
-    glBindVertexArray(m_ogl_mesh->vao);
+    glBindVertexArray(mesh->vao);
 
-    // loop through all the elements
-    for (GLint i=0; i < m_ogl_mesh->num_elements; i++)
+    // loop through all the elements (of the level of detail)
+    const ElementGroup* elements = mesh->getElements(lod);
+    for (GLint i=0; i < mesh->num_elements; i++)
     {
-        if (m_ogl_mesh->elements[i].triangles==0)
+        if (elements[i].triangles==0)
             continue;
 
         // Material and texture goes here.
-        int mtrIdx = m_ogl_mesh->elements[i].material_index;
-        OBJMaterial& cur_material = *m_ogl_mesh->materials[mtrIdx];
+        int mtrIdx = elements[i].material_index;
+        OBJMaterial& cur_material = *mesh->materials[mtrIdx];
 
         // use the material color
         glUniform4f(shader->uniform_material_color, cur_material.m_diffuse[0], cur_material.m_diffuse[1], cur_material.m_diffuse[2], cur_material.m_opacity);
@@ -132,78 +268,59 @@ void GeometryNode::DrawUsingSpotLight()
         // Second: pass a uniform to the shader for each texture to be used as a "sampler".
         // On the GPU side, you just need to access the texture by using the sampler uniform you created in the C++ side
 
+        // the layers of the textures in their arrays (-1 for a texture that is bound on its own)
+        GLint layer_diffuse = -1, layer_normal = -1, layer_specular = -1, layer_emission = -1;
+
+        // an evicted texture is not sampled until it is restored
+        ResidencyManager& residency = ResidencyManager::getInstance();
+        bool has_diffuse = cur_material.m_diffuse_opacity_tex_loaded && residency.useTexture(cur_material.m_diffuse_opacity_tex);
+        bool has_normal = cur_material.m_normal_tex_loaded && residency.useTexture(cur_material.m_normal_tex);
+        bool has_specular = cur_material.m_specular_gloss_tex_loaded && residency.useTexture(cur_material.m_specular_gloss_tex);
+        bool has_emission = cur_material.m_emission_tex_loaded && residency.useTexture(cur_material.m_emission_tex);
+
         // check if diffuse texture is present
+        // the diffuse texture is bound to texture unit 0 (or its array to unit 4)
         if (!cur_material.m_diffuse_opacity_tex_file.empty())
-        {
-            // activate texture unit 0 for the diffuse texture
-            glActiveTexture(GL_TEXTURE0);
-            // bind the diffuse texture to the active texture unit
-            // the first parameter is the target. for 2D textures we use GL_TEXTURE_2D
-            // the second parameter is the value that was returned from glGenTextures
-            glBindTexture(GL_TEXTURE_2D, cur_material.m_diffuse_opacity_tex->get_texture_gl_id());
-        }
+            layer_diffuse = BindMapTexture(cur_material.m_diffuse_opacity_tex, cur_material.m_samplers[MPT_MATERIAL_MAP_DIFFUSE_OP], 0, bound_arrays, bound_samplers);
 
         // check if normal texture is present
+        // the normal texture is bound to texture unit 1 (or its array to unit 5)
         if (!cur_material.m_normal_tex_file.empty())
-        {
-            // activate texture unit 1 for the normal texture
-            glActiveTexture(GL_TEXTURE1);
-            // bind the normal texture to the active texture unit
-            // the first parameter is the target. for 2D textures we use GL_TEXTURE_2D
-            // the second parameter is the value that was returned from glGenTextures
-            glBindTexture(GL_TEXTURE_2D, cur_material.m_normal_tex->get_texture_gl_id());
-        }
+            layer_normal = BindMapTexture(cur_material.m_normal_tex, cur_material.m_samplers[MPT_MATERIAL_MAP_NORMAL], 1, bound_arrays, bound_samplers);
 
         // check if specular texture is present
+        // the specular texture is bound to texture unit 2 (or its array to unit 6)
         if (!cur_material.m_specular_gloss_tex_file.empty())
-        {
-            // activate texture unit 2 for the specular texture
-            glActiveTexture(GL_TEXTURE2);
-            // bind the specular texture to the active texture unit
-            // the first parameter is the target. for 2D textures we use GL_TEXTURE_2D
-            // the second parameter is the value that was returned from glGenTextures
-            glBindTexture(GL_TEXTURE_2D, cur_material.m_specular_gloss_tex->get_texture_gl_id());
-        }
+            layer_specular = BindMapTexture(cur_material.m_specular_gloss_tex, cur_material.m_samplers[MPT_MATERIAL_MAP_SPECULAR_GLOSS], 2, bound_arrays, bound_samplers);
 
-        // check if specular texture is present
+        // check if emission texture is present
+        // the emission texture is bound to texture unit 3 (or its array to unit 7)
         if (!cur_material.m_emission_tex_file.empty())
-        {
-            // activate texture unit 3 for the emission texture
-            glActiveTexture(GL_TEXTURE3);
-            // bind the emission texture to the active texture unit
-            // the first parameter is the target. for 2D textures we use GL_TEXTURE_2D
-            // the second parameter is the value that was returned from glGenTextures
-            glBindTexture(GL_TEXTURE_2D, cur_material.m_emission_tex->get_texture_gl_id());
-        }
+            layer_emission = BindMapTexture(cur_material.m_emission_tex, cur_material.m_samplers[MPT_MATERIAL_MAP_EMISSION], 3, bound_arrays, bound_samplers);
 
-        // now send the samplers as uniforms
-        // sampler 0 is the diffuse texture, 1 is the normal texture, etc (same as above)
-        glUniform1i(shader->uniform_sampler_diffuse, 0);
-        glUniform1i(shader->uniform_sampler_normal, 1);
-        glUniform1i(shader->uniform_sampler_specular, 2);
-        glUniform1i(shader->uniform_sampler_emission, 3);
+        // the layers select the texture in the array of each map
+        glUniform1i(shader->uniform_layer_diffuse, layer_diffuse);
+        glUniform1i(shader->uniform_layer_normal, layer_normal);
+        glUniform1i(shader->uniform_layer_specular, layer_specular);
+        glUniform1i(shader->uniform_layer_emission, layer_emission);
 
         // also pass parameters to check within the shader if a texture exists
         // this is important because if we do not check this, the glsl function "texture" will return
         // the value vec3(0,0,0) if a texture does not exist, causing the whole object to be black
-        glUniform1i(shader->uniform_has_sampler_diffuse, cur_material.m_diffuse_opacity_tex_loaded);
-        glUniform1i(shader->uniform_has_sampler_normal, cur_material.m_normal_tex_loaded);
-        glUniform1i(shader->uniform_has_sampler_specular, cur_material.m_specular_gloss_tex_loaded);
-        glUniform1i(shader->uniform_has_sampler_emission, cur_material.m_emission_tex_loaded);
+        glUniform1i(shader->uniform_has_sampler_diffuse, has_diffuse);
+        glUniform1i(shader->uniform_has_sampler_normal, has_normal);
+        glUniform1i(shader->uniform_has_sampler_specular, has_specular);
+        glUniform1i(shader->uniform_has_sampler_emission, has_emission);
 
         // draw within a range in the index buffer
-        glDrawRangeElements(
-            GL_TRIANGLES,
-            m_ogl_mesh->elements[i].start_index,
-            m_ogl_mesh->elements[i].start_index+m_ogl_mesh->elements[i].triangles*3,
-            m_ogl_mesh->elements[i].triangles*3,
-            GL_UNSIGNED_INT,
-            (void*)(m_ogl_mesh->elements[i].start_index*sizeof(GLuint))
-            );
+        mesh->drawElement(i, lod);
 
         // set the texture units to not point to any textures
         // if we do not do this, then the texture units will point to the bound textures
         // until we set them again
+        // with texture arrays the units are left bound for the next elements, and are set after the last one (as are the samplers)
+        if (TEXTURE_ARRAYS)
+            continue;
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, 0);
         glActiveTexture(GL_TEXTURE1);
@@ -214,11 +331,13 @@ void GeometryNode::DrawUsingSpotLight()
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    UnbindMapTextures(4, bound_arrays, bound_samplers);
+
     glBindVertexArray(0);
     glUseProgram(0);
 }
 
-void GeometryNode::DrawUsingAmbientight()
+void GeometryNode::DrawUsingAmbientight(OGLMesh* mesh, int lod)
 {
     // get the world transformation (hierarchically)
     glm::mat4x4& M = GetTransform();
@@ -237,25 +356,37 @@ void GeometryNode::DrawUsingAmbientight()
     glUseProgram(shader->program_id);
 
     // pass any global shader parameters (independent of material attributes)
-    glUniformMatrix4fv(shader->uniform_m, 1, false, &M[0][0]);
+    // (the positions of compact vertices are moved to the bounds of the mesh first)
+    glm::mat4x4 MP = M * mesh->getPositionMatrix();
+    glUniformMatrix4fv(shader->uniform_m, 1, false, &MP[0][0]);
     glUniformMatrix4fv(shader->uniform_v, 1, false, &V[0][0]);
     glUniformMatrix4fv(shader->uniform_p, 1, false, &P[0][0]);
 
     // the light color is passed as a uniform vec3
     glUniform4f(shader->uniform_ambient_light_color, ambient_light_color.x, ambient_light_color.y, ambient_light_color.z, 1.0f);
 
+    // send the sampler as a uniform
+    // sampler 0 is the diffuse texture, and the diffuse textures packed in texture arrays are sampled from the array bound to unit 4
+    glUniform1i(shader->uniform_sampler_diffuse, 0);
+    glUniform1i(shader->uniform_sampler_diffuse_array, TEXTURE_ARRAY_UNIT_OFFSET + 0);
+
+    // the array and the sampler bound to the unit of the diffuse map, which stay bound for the elements that follow
+    unsigned int bound_arrays[1] = { 0 };
+    unsigned int bound_samplers[1] = { 0 };
+
     // bind the VAO
-    glBindVertexArray(m_ogl_mesh->vao);
+    glBindVertexArray(mesh->vao);
 
-    // loop through all the elements
-    for (GLint i=0; i < m_ogl_mesh->num_elements; i++)
+    // loop through all the elements (of the level of detail)
+    const ElementGroup* elements = mesh->getElements(lod);
+    for (GLint i=0; i < mesh->num_elements; i++)
     {
-        if (m_ogl_mesh->elements[i].triangles==0)
+        if (elements[i].triangles==0)
             continue;
 
         // Material and texture goes here.
-        int mtrIdx = m_ogl_mesh->elements[i].material_index;
-        OBJMaterial& cur_material = *m_ogl_mesh->materials[mtrIdx];
+        int mtrIdx = elements[i].material_index;
+        OBJMaterial& cur_material = *mesh->materials[mtrIdx];
 
         // use the material color
         glUniform4f(shader->uniform_material_color, cur_material.m_diffuse[0], cur_material.m_diffuse[1], cur_material.m_diffuse[2], cur_material.m_opacity);
@@ -267,43 +398,91 @@ void GeometryNode::DrawUsingAmbientight()
         // On the GPU side, you just need to access the texture by using the sampler uniform you created in the C++ side
 
         // check if diffuse texture is present
+        // the diffuse texture is bound to texture unit 0 (or its array to unit 4)
+        // an evicted texture is not sampled until it is restored
+        GLint layer_diffuse = -1;
+        bool has_diffuse = cur_material.m_diffuse_opacity_tex_loaded &&
+                           ResidencyManager::getInstance().useTexture(cur_material.m_diffuse_opacity_tex);
         if (!cur_material.m_diffuse_opacity_tex_file.empty())
-        {
-            // activate texture unit 0 for the diffuse texture
-            glActiveTexture(GL_TEXTURE0);
-            // bind the diffuse texture to the active texture unit
-            // the first parameter is the target. for 2D textures we use GL_TEXTURE_2D
-            // the second parameter is the value that was returned from glGenTextures
-            glBindTexture(GL_TEXTURE_2D, cur_material.m_diffuse_opacity_tex->get_texture_gl_id());
-        }
+            layer_diffuse = BindMapTexture(cur_material.m_diffuse_opacity_tex, cur_material.m_samplers[MPT_MATERIAL_MAP_DIFFUSE_OP], 0, bound_arrays, bound_samplers);
 
-        // now send the samplers as uniforms
-        // sampler 0 is the diffuse texture, 1 is the normal texture, etc (same as above)
-        glUniform1i(shader->uniform_sampler_diffuse, 0);
+        // the layer selects the texture in the array (-1 for a texture that is bound on its own)
+        glUniform1i(shader->uniform_layer_diffuse, layer_diffuse);
 
         // also pass parameters to check within the shader if a texture exists
         // this is important because if we do not check this, the glsl function "texture" will return
         // the value vec3(0,0,0) if a texture does not exist, causing the whole object to be black
-        glUniform1i(shader->uniform_has_sampler_diffuse, cur_material.m_diffuse_opacity_tex_loaded);
+        glUniform1i(shader->uniform_has_sampler_diffuse, has_diffuse);
 
         // draw within a range in the index buffer
-        glDrawRangeElements(
-            GL_TRIANGLES,
-            m_ogl_mesh->elements[i].start_index,
-            m_ogl_mesh->elements[i].start_index+m_ogl_mesh->elements[i].triangles*3,
-            m_ogl_mesh->elements[i].triangles*3,
-            GL_UNSIGNED_INT,
-            (void*)(m_ogl_mesh->elements[i].start_index*sizeof(GLuint))
-            );
+        mesh->drawElement(i, lod);
         // set the texture units to not point to any textures
         // if we do not do this, then the texture units will point to the bound textures
         // until we set them again
+        // with texture arrays the unit is left bound for the next elements, and is set after the last one (as is the sampler)
+        if (TEXTURE_ARRAYS)
+            continue;
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    UnbindMapTextures(1, bound_arrays, bound_samplers);
+
     glBindVertexArray(0);
     glUseProgram(0);
 }
 
+int GeometryNode::BindMapTexture(const Texture* texture, GLuint sampler, unsigned int unit, unsigned int* bound_arrays, unsigned int* bound_samplers)
+{
+    // the sampler overrides the filters and the wrap mode of the texture. It is bound to both units of the map, whichever the texture is bound to
+    if (bound_samplers[unit] != sampler)
+    {
+        glBindSampler(unit, sampler);
+        glBindSampler(TEXTURE_ARRAY_UNIT_OFFSET + unit, sampler);
+        bound_samplers[unit] = sampler;
+    }
+
+    TextureArray* array = texture->get_array();
+    if (array == nullptr)
+    {
+        // activate the texture unit of the map
+        glActiveTexture(GL_TEXTURE0 + unit);
+        // bind the texture to the active texture unit
+        // the first parameter is the target. for 2D textures we use GL_TEXTURE_2D
+        // the second parameter is the value that was returned from glGenTextures
+        glBindTexture(GL_TEXTURE_2D, texture->get_texture_gl_id());
+        return -1;
+    }
+
+    // the arrays have their own target, so they are bound to other units than the textures
+    if (bound_arrays[unit] != array->get_gl_id())
+    {
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT_OFFSET + unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array->get_gl_id());
+        bound_arrays[unit] = array->get_gl_id();
+    }
+    return (int)texture->get_array_layer();
+}
+
+void GeometryNode::UnbindMapTextures(unsigned int num_maps, const unsigned int* bound_arrays, const unsigned int* bound_samplers)
+{
+    for (unsigned int unit = 0; unit < num_maps; ++unit)
+    {
+        // other draws sample with the parameters of their textures
+        if (bound_samplers[unit] != 0)
+        {
+            glBindSampler(unit, 0);
+            glBindSampler(TEXTURE_ARRAY_UNIT_OFFSET + unit, 0);
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        if (bound_arrays[unit] == 0)
+            continue;
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT_OFFSET + unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+
 // eof ///////////////////////////////// class GeometryNode
\ No newline at end of file
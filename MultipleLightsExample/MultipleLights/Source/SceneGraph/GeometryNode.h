@@ -24,7 +24,7 @@
 #include "Node.h"
 
 // defines /////////////////////////////////////////
-
+#define GEOMETRY_LOD_HYSTERESIS     0.25f           // a coarser level of detail is selected when its error is this much below the one allowed
 
 // forward declarations ////////////////////////////
 
@@ -35,6 +35,9 @@ class GeometryNode: public Node
 protected:
     // protected variable declarations
     class OGLMesh*                      m_ogl_mesh;
+    class MeshRequest*                  m_mesh_request;     // a streamed mesh. m_ogl_mesh is set when it is ready
+    class OGLMesh*                      m_placeholder_mesh; // drawn until the streamed mesh is ready
+    int                                 m_lod;              // the level of detail of the mesh selected for the current view
 
     // protected function declarations
 
@@ -43,13 +46,29 @@ private:
 
 
     // private function declarations
-    void                                DrawUsingAmbientight();
-    void                                DrawUsingSpotLight();
+    void                                DrawUsingAmbientight(class OGLMesh* mesh, int lod);
+    void                                DrawUsingSpotLight(class OGLMesh* mesh, int lod);
+    // the object to eye transformation and its largest scale, the pixels covered by one unit at distance one from the eye, and
+    // the near plane distance, for the size of the mesh on the screen. Returns false if the mesh has no size on the screen
+    bool                                GetScreenScale(glm::mat4x4& MV, float& scale, float& pixels_per_unit, float& near_distance);
+    // selects the coarsest level of detail of the mesh whose error on the screen is within the one allowed by the root
+    void                                SelectLevelOfDetail(class OGLMesh* mesh);
+    // tell the TextureStreamer which texture levels the elements of the mesh need, from their size on the screen
+    void                                RequestTextureLevels(class OGLMesh* mesh);
+    // binds the texture of a material map to the texture unit of the map, or the array it is packed in to the array unit of the map
+    // (unless the array is bound there already, by a previous element), and the sampler of the map to both units (unless it is bound
+    // already). Returns the layer of the texture, or -1 if it is not in an array
+    int                                 BindMapTexture(const class Texture* texture, GLuint sampler, unsigned int unit, unsigned int* bound_arrays,
+                                                       unsigned int* bound_samplers);
+    // unbinds the textures of the maps, and the arrays and samplers that were bound by BindMapTexture, after the last element
+    void                                UnbindMapTextures(unsigned int num_maps, const unsigned int* bound_arrays, const unsigned int* bound_samplers);
 
 
 public:
     // Constructor
     GeometryNode(const char* name, class OGLMesh* ogl_mesh);
+    // a node for a mesh loaded by the MeshStreamer. The placeholder (if any) is drawn until the mesh is ready
+    GeometryNode(const char* name, class MeshRequest* mesh_request, class OGLMesh* placeholder_mesh);
 
     // Destructor
     ~GeometryNode(void);
@@ -32,6 +32,10 @@ GroupNode("root")
 {
     m_parent = nullptr;
     m_root = this;
+    m_viewport_height = 1;
+    m_lod_error_pixels = ROOT_LOD_ERROR_PIXELS;
+    for (int i = 0; i < ROOT_SHADER_TYPES; i++)
+        m_lod_bias[i] = 0;
     m_basic_geometry_shader = nullptr;
     m_spotlight_shader = nullptr;
     m_ambient_light_shader = nullptr;
@@ -25,6 +25,8 @@
 #include "../Light.h"
 
 // defines /////////////////////////////////////////
+#define ROOT_SHADER_TYPES           4               // the shader types the nodes can be drawn with (0 is the spotlight and 1 the ambient light shader)
+#define ROOT_LOD_ERROR_PIXELS       1.0f            // the error on the screen the level of detail a mesh is drawn with may have
 
 
 // forward declarations ////////////////////////////
@@ -38,6 +40,9 @@ protected:
     // protected variable declarations
     glm::mat4x4                         m_view_mat;
     glm::mat4x4                         m_projection_mat;
+    int                                 m_viewport_height;  // in pixels, for the size of the nodes on the screen
+    float                               m_lod_error_pixels; // the error on the screen of the levels of detail of the meshes (0 draws the meshes themselves)
+    int                                 m_lod_bias[ROOT_SHADER_TYPES]; // the levels coarser than the selected one each shader type draws, e.g. for a shadow pass
  
     SpotLight*                          m_spotlight;
 
@@ -74,10 +79,18 @@ public:
     // get functions
     glm::mat4x4&                        GetViewMat(void)                                {return m_view_mat;}
     glm::mat4x4&                        GetProjectionMat(void)                          {return m_projection_mat;}
+    int                                 GetViewportHeight(void)                         {return m_viewport_height;}
+    float                               GetLODErrorPixels(void)                         {return m_lod_error_pixels;}
+    int                                 GetLODBias(int shader_type)                     {return (shader_type >= 0 && shader_type < ROOT_SHADER_TYPES) ? m_lod_bias[shader_type] : 0;}
 
     // set functions
     void                                SetViewMat(glm::mat4x4& mat)                    {m_view_mat = mat;}
     void                                SetProjectionMat(glm::mat4x4& mat)              {m_projection_mat = mat;}
+    void                                SetViewportHeight(int height)                   {m_viewport_height = (height > 0) ? height : 1;}
+    void                                SetLODErrorPixels(float pixels)                 {m_lod_error_pixels = (pixels > 0.0f) ? pixels : 0.0f;}
+    // the passes that affect the image less (such as the depth of a shadow map) can be drawn with coarser levels. The passes that
+    // share the depth buffer (such as the lights, which are added on the ambient light pass) must have the same bias
+    void                                SetLODBias(int shader_type, int bias)           {if (shader_type >= 0 && shader_type < ROOT_SHADER_TYPES) m_lod_bias[shader_type] = bias;}
 
     // set light functions
     void                                SetActiveSpotlight(SpotLight* light)            {m_spotlight = light;}
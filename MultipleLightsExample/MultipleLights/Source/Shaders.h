@@ -53,6 +53,10 @@ public:
     // these uniforms will be the samplers
     GLint uniform_sampler_diffuse;
     GLint uniform_has_sampler_diffuse;
+
+    // the sampler of the texture arrays, and the layer of the texture in it
+    GLint uniform_sampler_diffuse_array;
+    GLint uniform_layer_diffuse;
 };
 
 // spot light shader
@@ -69,6 +73,7 @@ public:
     GLint uniform_light_color;
     GLint uniform_light_position_ecs;
     GLint uniform_light_direction_ecs;
+    GLint uniform_compact_vertices;
 
     // these uniforms will be the samplers
     GLint uniform_sampler_diffuse;
@@ -79,6 +84,16 @@ public:
     GLint uniform_has_sampler_normal;
     GLint uniform_has_sampler_specular;
     GLint uniform_has_sampler_emission;
+
+    // the samplers of the texture arrays, and the layers of the textures in them
+    GLint uniform_sampler_diffuse_array;
+    GLint uniform_sampler_normal_array;
+    GLint uniform_sampler_specular_array;
+    GLint uniform_sampler_emission_array;
+    GLint uniform_layer_diffuse;
+    GLint uniform_layer_normal;
+    GLint uniform_layer_specular;
+    GLint uniform_layer_emission;
 };
 
 #endif //SHADERS_H
@@ -0,0 +1,146 @@
+//----------------------------------------------------//
+//                                                    //
+// File: ThreadPool.cpp                               //
+// ThreadPool runs tasks on a fixed set of worker     //
+// threads (one per core by default)                  //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+
+// includes ////////////////////////////////////////
+#include "ThreadPool.h"     // - Header file for the ThreadPool class
+
+#include <memory>           // - Header file for shared_ptr
+#include <algorithm>        // - Header file for min/max
+
+// shared state of a parallelFor call.
+// it is kept alive by the helper tasks, so that a task that starts after the loop has finished does no harm
+struct ParallelForState
+{
+    std::function<void(size_t)>         body;
+    size_t                              count;
+    std::atomic<size_t>                 next;
+    std::atomic<unsigned int>           active;
+    std::mutex                          mutex;
+    std::condition_variable             done;
+
+    // consume indices until none are left
+    void run()
+    {
+        size_t i;
+        while ((i = next++) < count)
+            body(i);
+    }
+};
+
+// Constructor
+ThreadPool::ThreadPool(unsigned int num_threads):
+    m_stop(false)
+{
+    if (num_threads == 0)
+        num_threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    // the calling thread also works during parallelFor, so one worker less is needed
+    for (unsigned int i = 1; i < num_threads; ++i)
+        m_workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+// Destructor
+ThreadPool::~ThreadPool(void)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (size_t i = 0; i < m_workers.size(); ++i)
+        m_workers[i].join();
+}
+
+// other functions
+ThreadPool& ThreadPool::getInstance(void)
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop(void)
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty())
+                return;
+            task = m_tasks.front();
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+std::future<void> ThreadPool::enqueue(const std::function<void()>& task)
+{
+    std::shared_ptr<std::packaged_task<void()> > packaged = std::make_shared<std::packaged_task<void()> >(task);
+    std::future<void> result = packaged->get_future();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_tasks.push_back([packaged] { (*packaged)(); });
+    }
+    m_condition.notify_one();
+    return result;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body, unsigned int max_threads)
+{
+    if (count == 0)
+        return;
+
+    // number of helper tasks (the calling thread is not counted)
+    size_t helpers = m_workers.size();
+    if (max_threads > 0)
+        helpers = (max_threads > 1) ? (std::min)(helpers, size_t(max_threads - 1)) : 0;
+    helpers = (std::min)(helpers, count - 1);
+
+    if (helpers == 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+            body(i);
+        return;
+    }
+
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+    state->body = body;
+    state->count = count;
+    state->next = 0;
+    state->active = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            m_tasks.push_back([state]
+            {
+                state->active++;
+                state->run();
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->active--;
+                state->done.notify_all();
+            });
+        }
+    }
+    m_condition.notify_all();
+
+    // the calling thread works as well. When it runs out of indices, it only waits for the helpers that
+    // have already picked an index. Helper tasks that have not started yet will find no work left,
+    // so waiting on them is not needed (and could deadlock when called from within a task)
+    state->run();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->active == 0; });
+}
+
+// eof ///////////////////////////////// class ThreadPool
\ No newline at end of file
@@ -0,0 +1,85 @@
+//----------------------------------------------------//
+//                                                    //
+// File: ThreadPool.h                                 //
+// ThreadPool runs tasks on a fixed set of worker     //
+// threads (one per core by default)                  //
+//                                                    //
+// These files are provided as part of the BSc course //
+// of Computer Graphics at the Athens University of   //
+// Economics and Business (AUEB)                      //
+//                                                    //
+//----------------------------------------------------//
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#pragma once
+//using namespace
+
+// includes ////////////////////////////////////////
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <vector>
+#include <atomic>
+
+// defines /////////////////////////////////////////
+
+
+// forward declarations ////////////////////////////
+
+
+// class declarations //////////////////////////////
+
+class ThreadPool
+{
+protected:
+    // protected variable declarations
+
+
+    // protected function declarations
+
+
+private:
+    // private variable declarations
+    std::vector<std::thread>            m_workers;
+    std::deque<std::function<void()> >  m_tasks;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_condition;
+    bool                                m_stop;
+
+    // private function declarations
+    void                                workerLoop(void);
+
+public:
+    // Constructor (0 threads means one per core)
+    ThreadPool(unsigned int num_threads = 0);
+
+    // Destructor
+    ~ThreadPool(void);
+
+    // public function declarations
+
+    // queue a task. Worker threads should not wait on the returned future, since this may block the pool
+    std::future<void>                   enqueue(const std::function<void()>& task);
+
+    // run body(i) for every i in [0, count) using the workers and the calling thread
+    // max_threads limits the number of threads used (0 means all of them)
+    // it is safe to call this from within a task
+    void                                parallelFor(size_t count, const std::function<void(size_t)>& body, unsigned int max_threads = 0);
+
+    // the process-wide pool
+    static ThreadPool&                  getInstance(void);
+
+    // get functions (the number of threads includes the calling thread)
+    unsigned int                        getNumThreads(void) const               {return (unsigned int)m_workers.size() + 1;}
+
+    // set functions
+
+};
+
+#endif //THREADPOOL_H
+
+// eof ///////////////////////////////// class ThreadPool
\ No newline at end of file